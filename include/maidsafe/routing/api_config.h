@@ -19,6 +19,8 @@
 #ifndef MAIDSAFE_ROUTING_API_CONFIG_H_
 #define MAIDSAFE_ROUTING_API_CONFIG_H_
 
+#include <chrono>
+#include <cstdint>
 #include <functional>
 #include <string>
 #include <vector>
@@ -79,6 +81,23 @@ typedef std::function<void(const std::vector<NodeInfo>& /*new_close_nodes*/)>
 typedef std::function<void(std::shared_ptr<MatrixChange> /*matrix_change*/)>
     MatrixChangedFunctor;
 
+// One node a traced message passed through.  IDs are shortened to their first few bytes.
+struct TraceHop {
+  TraceHop() : node_id_prefix(), received(), queue_wait(0), processing(0), next_hop_prefix() {}
+  std::string node_id_prefix;
+  std::chrono::system_clock::time_point received;
+  // Time spent queued before being handled, then being handled until sent on.
+  std::chrono::microseconds queue_wait, processing;
+  // Connection ID the message was sent on to, empty at the last hop.
+  std::string next_hop_prefix;
+};
+
+// Fires when the response to a traced request arrives, with the request's ID and every hop taken
+// by the request and then the response, in order.  Providing it enables tracing of one in every
+// Parameters::message_trace_interval requests sent by this node.
+typedef std::function<void(int32_t /*message_id*/, const std::vector<TraceHop>& /*hops*/)>
+    MessageTraceFunctor;
+
 // This functor fires when routing table size is over greedy limit. The furthest unnecessary
 // node in routing table is dropped. Unnecessary is defined as a node who does not have us in
 // it clsoest nodes.
@@ -117,7 +136,8 @@ struct Functors {
         matrix_changed(),
         set_public_key(),
         request_public_key(),
-        new_bootstrap_endpoint() {}
+        new_bootstrap_endpoint(),
+        message_trace() {}
 
   MessageAndCachingFunctors message_and_caching;
   TypedMessageAndCachingFunctor typed_message_and_caching;
@@ -127,6 +147,7 @@ struct Functors {
   GivePublicKeyFunctor set_public_key;
   RequestPublicKeyFunctor request_public_key;
   NewBootstrapEndpointFunctor new_bootstrap_endpoint;
+  MessageTraceFunctor message_trace;
 };
 
 }  // namespace routing
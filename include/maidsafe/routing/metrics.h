@@ -0,0 +1,113 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_ROUTING_METRICS_H_
+#define MAIDSAFE_ROUTING_METRICS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace maidsafe {
+
+namespace routing {
+
+struct HistogramSnapshot {
+  HistogramSnapshot() : count(0), sum(0), max(0), buckets() {}
+  // Lower bound of the bucket holding the sample at 'fraction' (0.0 to 1.0) of the way through the
+  // recorded samples, in order.  Zero if nothing has been recorded.
+  uint64_t Percentile(double fraction) const;
+
+  uint64_t count, sum, max;
+  // (lower bound, count) of each bucket holding any samples, in increasing order.
+  std::vector<std::pair<uint64_t, uint64_t>> buckets;
+};
+
+// Lock-free histogram of non-negative values.  As in HdrHistogram, each power of two is split into
+// 2^kSubBucketBits linear buckets, so a value is placed within 1/8th of its size without any
+// configured range.
+class Histogram {
+ public:
+  Histogram();
+  void Record(uint64_t value);
+  HistogramSnapshot Snapshot() const;
+
+ private:
+  static const int kSubBucketBits = 3;
+  static const size_t kSubBucketCount = size_t(1) << kSubBucketBits;
+  static const size_t kBucketCount = (64 - kSubBucketBits + 1) * kSubBucketCount;
+
+  Histogram(const Histogram&);
+  Histogram& operator=(const Histogram&);
+  static size_t BucketIndex(uint64_t value);
+  static uint64_t BucketLowerBound(size_t index);
+
+  std::atomic<uint64_t> counts_[kBucketCount];
+  std::atomic<uint64_t> count_, sum_, max_;
+};
+
+// Point in time copy of a node's routing metrics, returned by Routing::GetMetrics.
+struct RoutingMetrics {
+  RoutingMetrics()
+      : messages_received(),
+        messages_sent(),
+        bytes_sent(),
+        messages_forwarded(0),
+        messages_delivered(0),
+        messages_dropped(),
+        send_retries(0),
+        timer_timeouts(0),
+        nodes_added(0),
+        nodes_dropped(0),
+        matrix_changes_notified(0),
+        route_cache_hits(0),
+        route_cache_misses(0),
+        hop_counts(),
+        response_latency_us(),
+        matrix_update_sizes() {}
+
+  // Keyed by message type.  Node level messages all have the same type, and unknown types are
+  // counted under 0.
+  std::map<int32_t, uint64_t> messages_received, messages_sent;
+  // Serialised size of the messages sent, keyed as messages_sent.
+  std::map<int32_t, uint64_t> bytes_sent;
+  // Messages passed on towards their destination, and messages handled as their destination.
+  uint64_t messages_forwarded, messages_delivered;
+  std::map<std::string, uint64_t> messages_dropped;  // keyed by reason
+  uint64_t send_retries, timer_timeouts, nodes_added, nodes_dropped;
+  // MatrixChange notifications passed to the matrix_changed functor.
+  uint64_t matrix_changes_notified;
+  // Next hop lookups answered from, and missing, the route cache.
+  uint64_t route_cache_hits, route_cache_misses;
+  // Hops taken by messages delivered to this node.
+  HistogramSnapshot hop_counts;
+  // Time from sending a request to each of its responses, in microseconds.
+  HistogramSnapshot response_latency_us;
+  // Number of entries in each group matrix update received from a connected peer.
+  HistogramSnapshot matrix_update_sizes;
+};
+
+}  // namespace routing
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_ROUTING_METRICS_H_
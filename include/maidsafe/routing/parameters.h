@@ -19,20 +19,37 @@
 #ifndef MAIDSAFE_ROUTING_PARAMETERS_H_
 #define MAIDSAFE_ROUTING_PARAMETERS_H_
 
+#include <atomic>
 #include <chrono>
 #include <cstdint>
 #include "boost/date_time/posix_time/posix_time_duration.hpp"
+#include "boost/filesystem/path.hpp"
 
 
 namespace maidsafe {
 
 namespace routing {
 
+// Selects which of the nodes relaying a cacheable response keep a copy of its data.
+enum class CachingPolicy : int32_t {
+  // Every node the response passes through.
+  kAllHops = 0,
+  // Only the first Parameters::caching_hops nodes after the responding node, i.e. the last hops
+  // of the original request's route towards the content.
+  kNearestHops = 1,
+  // Probabilistically, halving the chance for each bit of XOR distance this node is further from
+  // the content than the nearest node in the message's route history.
+  kDistanceWeighted = 2
+};
+
 struct Parameters {
  public:
   // Thread count for use of asio::io_service
   static uint16_t thread_count;
   static uint16_t num_chunks_to_cache;
+  // Max number of recently missed cacheable gets remembered, and for how long.
+  static uint16_t negative_cache_size;
+  static std::chrono::steady_clock::duration negative_cache_ttl;
   static uint16_t closest_nodes_size;
   static uint16_t node_group_size;
   static uint16_t proximity_factor;
@@ -46,9 +63,15 @@ struct Parameters {
   static std::chrono::seconds find_node_interval;
   static std::chrono::seconds recovery_time_lag;
   static boost::posix_time::time_duration re_bootstrap_time_lag;
+  // Number of best ranked bootstrap endpoints tried one at a time, before the rest are tried
+  // together.
+  static uint16_t ranked_bootstrap_attempts;
   static boost::posix_time::time_duration find_close_node_interval;
   static uint16_t find_node_repeats_per_num_requested;
   static uint16_t maximum_find_close_node_failures;
+  // Number of FindNodes requests a node lookup keeps outstanding, and how long each may take.
+  static uint16_t lookup_parallelism;
+  static std::chrono::steady_clock::duration lookup_request_timeout;
   static uint16_t max_route_history;
   static uint16_t hops_to_live;
   static uint16_t greedy_fraction;
@@ -56,10 +79,56 @@ struct Parameters {
   static uint16_t routing_table_ready_to_response;
   static uint16_t accepted_distance_tolerance;
   static boost::posix_time::time_duration connect_rpc_prune_timeout;
+  // Max number of connect handshakes this node runs at once, and how long each is allowed before
+  // its slot is reused.
+  static uint16_t max_connect_attempts_in_flight;
+  // Worker threads checking and making signatures on connect success acks (zero does this inline),
+  // how many queued jobs each takes at once, and how many verified signatures are remembered.
+  static uint16_t signature_verification_threads;
+  static uint16_t signature_verification_batch_size;
+  static uint16_t verified_signature_cache_size;
+  // Whether connect success acks without a signature, as sent by older nodes, are accepted.
+  static bool accept_unsigned_connect_acks;
+  // Number of nodes whose last validated public key is remembered, so that re-adding them after a
+  // drop doesn't validate the same key again.
+  static uint16_t validated_public_key_cache_size;
+  // Defaults for each node's Tuning: number of destinations whose chosen next hop is remembered
+  // until the routing table or group matrix next changes (zero disables the cache), and the number
+  // of leading bytes of a destination ID under which its next hop is remembered.
+  static uint16_t route_cache_size;
+  static uint16_t route_cache_prefix_length;
+  static std::chrono::steady_clock::duration connect_attempt_timeout;
+  // While connect attempts are queued or running, how often they are checked for timeouts and for
+  // candidates the routing table no longer needs.
+  static std::chrono::steady_clock::duration connect_attempt_check_interval;
+  // Time allowed between a Connect exchange and the acknowledgement carrying the session secret.
+  static std::chrono::steady_clock::duration session_handshake_timeout;
+  // Group and matrix changes arising within this long of the first are notified together.  Zero
+  // notifies each change immediately.
+  static boost::posix_time::time_duration group_change_coalescing_window;
   static bool append_maidsafe_endpoints;
   static bool append_maidsafe_local_endpoints;
   static bool append_local_live_port_endpoint;
   static bool caching;
+  static CachingPolicy caching_policy;
+  static uint16_t caching_hops;
+  // Root of the on-disk cache tier, which is disabled if empty.  Each node uses a subdirectory
+  // named after its ID, holding up to max_cache_segments files of cache_segment_size bytes.
+  static boost::filesystem::path cache_directory;
+  static uint32_t cache_segment_size;
+  static uint16_t max_cache_segments;
+  // Directory holding each vault's routing table snapshot, which is disabled if empty.  A snapshot
+  // is written this often and on shutdown, and its peers are reconnected to first on the next Join.
+  static boost::filesystem::path routing_table_snapshot_directory;
+  static boost::posix_time::time_duration routing_table_snapshot_interval;
+  // Routing log statements below this maidsafe::log level are skipped without evaluating their
+  // arguments.  Raised to the level the logger is configured to show for routing when a node is
+  // created.  Building with ROUTING_NO_VERBOSE_LOGS removes kVerbose statements entirely.
+  static std::atomic<int> log_level;
+  // One in this many requests sent is traced when a message trace functor is provided.  A traced
+  // message records at most max_trace_hops hops.
+  static uint16_t message_trace_interval;
+  static uint16_t max_trace_hops;
 
  private:
   Parameters();
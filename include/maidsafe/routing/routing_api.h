@@ -45,6 +45,8 @@
 #include "maidsafe/passport/types.h"
 
 #include "maidsafe/routing/api_config.h"
+#include "maidsafe/routing/metrics.h"
+#include "maidsafe/routing/tuning.h"
 
 
 namespace maidsafe {
@@ -52,6 +54,7 @@ namespace maidsafe {
 namespace routing {
 
 struct NodeInfo;
+class Runtime;
 
 namespace test { class GenericNode; }
 
@@ -81,7 +84,19 @@ class Routing {
     asymm::Keys keys;
     keys.private_key = fob.private_key();
     keys.public_key = fob.public_key();
-    InitialisePimpl(detail::is_client<FobType>::value, NodeId(fob.name()->string()), keys);
+    InitialisePimpl(detail::is_client<FobType>::value, NodeId(fob.name()->string()), keys,
+                    std::shared_ptr<Runtime>());
+  }
+
+  // As above, but running on the threads of 'runtime', which may be shared with other Routing
+  // objects in this process, rather than on threads of its own.
+  template<typename FobType>
+  Routing(const FobType& fob, std::shared_ptr<Runtime> runtime) : pimpl_() {
+    asymm::Keys keys;
+    keys.private_key = fob.private_key();
+    keys.public_key = fob.public_key();
+    InitialisePimpl(detail::is_client<FobType>::value, NodeId(fob.name()->string()), keys,
+                    runtime);
   }
 
   // Joins the network. Valid method for requesting public key must be provided by the functor,
@@ -161,6 +176,18 @@ class Routing {
   // Returns a number between 0 to 100 representing % network health w.r.t. number of connections
   int network_status();
 
+  // Returns a snapshot of this node's message, drop, churn and latency counts since construction
+  RoutingMetrics GetMetrics();
+
+  // Returns this node's current timeouts, retry policy and cache budgets, initially copied from
+  // Parameters on construction.
+  Tuning GetTuning() const;
+
+  // Replaces this node's tuning while it runs, e.g. as GetTuning() with some values changed.  New
+  // values apply from the next request, timer or cache entry which reads them.  Throws, leaving
+  // the current values, if any timeout or interval isn't positive.
+  void SetTuning(const Tuning& tuning);
+
   // Returns the group matrix
   std::vector<NodeInfo> ClosestNodes();
 
@@ -178,7 +205,8 @@ class Routing {
   Routing& operator=(const Routing&);
   void InitialisePimpl(bool client_mode,
                        const NodeId& node_id,
-                       const asymm::Keys& keys);
+                       const asymm::Keys& keys,
+                       std::shared_ptr<Runtime> runtime);
 
   class Impl;
   std::shared_ptr<Impl> pimpl_;
@@ -187,6 +215,9 @@ class Routing {
 template<>
 Routing::Routing(const NodeId& node_id);
 
+template<>
+Routing::Routing(const NodeId& node_id, std::shared_ptr<Runtime> runtime);
+
 template <>
 void Routing::Send(const SingleToSingleMessage& message);
 template <>
@@ -0,0 +1,61 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_ROUTING_RUNTIME_H_
+#define MAIDSAFE_ROUTING_RUNTIME_H_
+
+#include <cstdint>
+
+#include "maidsafe/common/asio_service.h"
+
+#include "maidsafe/routing/parameters.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+// Threads shared by several Routing objects in one process.  On its own, each Routing object runs
+// two asio threads which carry its received messages, its timers and its response timeouts; those
+// constructed with the same Runtime instead run that work on this one pool, so those two threads
+// per node are replaced by thread_count in total.  Each Routing object keeps the Runtime alive,
+// and waits on destruction for any of its own work still queued on the pool.
+//
+// The pool doesn't cover every thread a node uses.  Each node still has its own rudp connections,
+// with rudp's threads, and its own Parameters::signature_verification_threads workers for signing
+// and checking connect acks (if that is 0, this is done inline on the calling thread instead).
+class Runtime {
+ public:
+  explicit Runtime(uint16_t thread_count = Parameters::thread_count);
+  ~Runtime();
+  AsioService& asio_service() { return asio_service_; }
+  uint16_t thread_count() const { return kThreadCount_; }
+
+ private:
+  Runtime(const Runtime&);
+  Runtime& operator=(const Runtime&);
+
+  const uint16_t kThreadCount_;
+  AsioService asio_service_;
+};
+
+}  // namespace routing
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_ROUTING_RUNTIME_H_
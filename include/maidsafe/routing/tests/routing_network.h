@@ -62,6 +62,7 @@ bool is_ready(std::future<Future>& f) {
 }
 
 struct NodeInfoAndPrivateKey;
+class SimulatedNetwork;
 
 enum ExpectedNodeType {
   kExpectVault,
@@ -139,6 +140,8 @@ class GenericNode {
   void SetMatrixChangeFunctor(MatrixChangedFunctor group_matrix_functor);
 
   void PostTaskToAsioService(std::function<void()> functor);
+  // Connects this node over 'network' rather than rudp.  Must be called before joining.
+  void UseSimulatedNetwork(SimulatedNetwork& network);
   rudp::NatType nat_type();
   std::string SerializeRoutingTable();
 
@@ -178,6 +181,9 @@ class GenericNetwork {
   virtual ~GenericNetwork();
 
   bool ValidateRoutingTables() const;
+  // If set before SetUp, all nodes connect over 'simulated_network' rather than rudp.  It should
+  // be started, as routing's own timers run in real time.
+  void set_simulated_network(std::shared_ptr<SimulatedNetwork> simulated_network);
   virtual void SetUp();
   virtual void TearDown();
   void SetUpNetwork(const size_t& total_number_vaults,
@@ -198,6 +204,8 @@ class GenericNetwork {
   void AddNode(const bool& client_mode, const rudp::NatType& nat_type);
   void AddNode(const bool& client_mode, const bool& has_symmetric_nat);
   bool RemoveNode(const NodeId& node_id);
+  // A copy of nodes_ which is safe to take while another thread adds or removes nodes.
+  std::vector<NodePtr> Nodes() const;
   bool WaitForNodesToJoin();
   void Validate(const NodeId& node_id, GivePublicKeyFunctor give_public_key) const;
   void SetNodeValidationFunctor(NodePtr node);
@@ -261,6 +269,7 @@ class GenericNetwork {
   std::map<NodeId, asymm::PublicKey> public_keys_;
   uint16_t client_index_;
   bool nat_info_available_;
+  std::shared_ptr<SimulatedNetwork> simulated_network_;
 
  public:
   std::vector<NodePtr> nodes_;
@@ -19,6 +19,7 @@
 #ifndef MAIDSAFE_ROUTING_TIMER_H_
 #define MAIDSAFE_ROUTING_TIMER_H_
 
+#include <atomic>
 #include <condition_variable>
 #include <chrono>
 #include <cstdint>
@@ -36,6 +37,8 @@
 #include "maidsafe/common/log.h"
 #include "maidsafe/common/utils.h"
 
+#include "maidsafe/routing/metrics.h"
+
 
 namespace maidsafe {
 
@@ -66,6 +69,10 @@ class Timer {
   // Invokes the response functor for the indicated task.  Throws if the indicated task doesn't
   // exist.
   void AddResponse(TaskId task_id, const Response& response);
+  // Time from adding a task to each of its responses, in microseconds.
+  const Histogram& response_latency() const { return response_latency_; }
+  // Number of tasks which expired before all their responses arrived.
+  uint64_t timed_out_count() const { return timed_out_count_; }
 
   friend class test::TimerTest;
 
@@ -81,6 +88,7 @@ class Timer {
     std::unique_ptr<boost::asio::steady_timer> timer;
     ResponseFunctor functor;
     int outstanding_response_count;
+    std::chrono::steady_clock::time_point added;
 
    private:
     Task() MAIDSAFE_DELETE;
@@ -99,6 +107,8 @@ class Timer {
   std::mutex mutex_;
   std::condition_variable cond_var_;
   std::map<TaskId, Task> tasks_;
+  Histogram response_latency_;
+  std::atomic<uint64_t> timed_out_count_;
 };
 
 
@@ -111,19 +121,22 @@ Timer<Response>::Task::Task(boost::asio::io_service& io_service,
                             int expected_response_count)
     : timer(new boost::asio::steady_timer(io_service, timeout)),
       functor(functor_in),
-      outstanding_response_count(expected_response_count) {}
+      outstanding_response_count(expected_response_count),
+      added(std::chrono::steady_clock::now()) {}
 
 template<typename Response>
 Timer<Response>::Task::Task(Task&& other)
     : timer(std::move(other.timer)),
       functor(std::move(other.functor)),
-      outstanding_response_count(std::move(other.outstanding_response_count)) {}
+      outstanding_response_count(std::move(other.outstanding_response_count)),
+      added(std::move(other.added)) {}
 
 template<typename Response>
 typename Timer<Response>::Task& Timer<Response>::Task::operator=(Task&& other) {
   timer = std::move(other.timer);
   functor = std::move(other.functor);
   outstanding_response_count = std::move(other.outstanding_response_count);
+  added = std::move(other.added);
   return *this;
 }
 
@@ -133,7 +146,9 @@ Timer<Response>::Timer(AsioService& asio_service)
       new_task_id_(RandomInt32()),
       mutex_(),
       cond_var_(),
-      tasks_() {}
+      tasks_(),
+      response_latency_(),
+      timed_out_count_(0) {}
 
 template<typename Response>
 Timer<Response>::~Timer() {
@@ -167,6 +182,18 @@ template<typename Response>
 void Timer<Response>::FinishTask(TaskId task_id, const boost::system::error_code& error) {
   int outstanding_response_count(0);
   ResponseFunctor functor;
+  switch (error.value()) {
+    case boost::system::errc::success:  // Task's timer has expired
+      LOG(kWarning) << "Timed out waiting for task " << task_id;
+      ++timed_out_count_;
+      break;
+    case boost::asio::error::operation_aborted:  // Cancelled via CancelTask
+      LOG(kInfo) << "Cancelled task " << task_id;
+      break;
+    default:
+      LOG(kError) << "Error waiting for task " << task_id << " - " << error.message();
+  }
+  boost::asio::io_service& service(asio_service_.service());
   {
     std::lock_guard<std::mutex> lock(mutex_);
     auto itr(tasks_.find(task_id));
@@ -182,23 +209,13 @@ void Timer<Response>::FinishTask(TaskId task_id, const boost::system::error_code
     }
 
     tasks_.erase(itr);
-  }
-
-  cond_var_.notify_one();
-
-  switch (error.value()) {
-    case boost::system::errc::success:  // Task's timer has expired
-      LOG(kWarning) << "Timed out waiting for task " << task_id;
-      break;
-    case boost::asio::error::operation_aborted:  // Cancelled via CancelTask
-      LOG(kInfo) << "Cancelled task " << task_id;
-      break;
-    default:
-      LOG(kError) << "Error waiting for task " << task_id << " - " << error.message();
+    // Notified under the lock, as the destructor may finish as soon as the lock is released.  No
+    // member is used after this.
+    cond_var_.notify_one();
   }
 
   for (int i(0); i != outstanding_response_count; ++i)
-    asio_service_.service().dispatch([=] { functor(Response()); });
+    service.dispatch([=] { functor(Response()); });
 }
 
 template<typename Response>
@@ -223,6 +240,9 @@ void Timer<Response>::AddResponse(TaskId task_id, const Response& response) {
       ThrowError(CommonErrors::invalid_parameter);
     }
     assert(itr->second.outstanding_response_count > 0);
+    response_latency_.Record(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - itr->second.added).count()));
     --(itr->second.outstanding_response_count);
     if (itr->second.outstanding_response_count == 0)
       itr->second.timer->cancel();  // Invokes 'FinishTask'
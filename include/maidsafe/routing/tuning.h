@@ -0,0 +1,60 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_ROUTING_TUNING_H_
+#define MAIDSAFE_ROUTING_TUNING_H_
+
+#include <chrono>
+#include <cstdint>
+
+#include "boost/date_time/posix_time/posix_time_duration.hpp"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+// The subset of Parameters of which each Routing object keeps its own copy, and which may be
+// replaced while it runs (see Routing::SetTuning).  A default-constructed Tuning holds the current
+// values of the Parameters of the same names.  A node's thread count is set by the Runtime it is
+// constructed with.
+struct Tuning {
+  Tuning();
+
+  // Timeouts.  response_timeout replaces Parameters::default_response_timeout.
+  std::chrono::steady_clock::duration response_timeout;
+  std::chrono::seconds find_node_interval;
+  std::chrono::seconds recovery_time_lag;
+  boost::posix_time::time_duration re_bootstrap_time_lag;
+  boost::posix_time::time_duration find_close_node_interval;
+  // Retry policy: failed FindNodes attempts while joining before bootstrapping again.
+  uint16_t maximum_find_close_node_failures;
+  // Cache budgets: recently missed cacheable gets remembered, and for how long.
+  uint16_t negative_cache_size;
+  std::chrono::steady_clock::duration negative_cache_ttl;
+  // Destinations whose next hop is remembered (zero disables the route cache), and the number of
+  // leading bytes of a destination ID under which its next hop is remembered.
+  uint16_t route_cache_size;
+  uint16_t route_cache_prefix_length;
+};
+
+}  // namespace routing
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_ROUTING_TUNING_H_
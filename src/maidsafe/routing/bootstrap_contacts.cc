@@ -0,0 +1,138 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/routing/bootstrap_contacts.h"
+
+#include <algorithm>
+#include <string>
+#include <tuple>
+
+#include "boost/filesystem/operations.hpp"
+
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/routing/routing.pb.h"
+#include "maidsafe/routing/utils.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+BootstrapContacts::BootstrapContacts() : mutex_(), records_() {}
+
+void BootstrapContacts::AddResult(const boost::asio::ip::udp::endpoint& endpoint,
+                                  bool success,
+                                  std::chrono::steady_clock::duration latency) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Record& record(records_[endpoint]);
+  ++record.attempts;
+  if (!success)
+    return;
+  // Moving average weighting the latest result by a quarter.
+  if (record.successes++ == 0)
+    record.average_latency = latency;
+  else
+    record.average_latency += (latency - record.average_latency) / 4;
+}
+
+std::vector<boost::asio::ip::udp::endpoint> BootstrapContacts::Rank(
+    std::vector<boost::asio::ip::udp::endpoint> endpoints) const {
+  typedef std::tuple<double, std::chrono::steady_clock::duration> Score;
+  std::map<boost::asio::ip::udp::endpoint, Score> scores;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& endpoint : endpoints) {
+      auto itr(records_.find(endpoint));
+      Record record(itr == records_.end() ? Record() : itr->second);
+      // Smoothed so an untried endpoint scores 0.5, and a single result isn't taken as certain.
+      double success_rate((record.successes + 1.0) / (record.attempts + 2.0));
+      scores[endpoint] = Score(-success_rate, record.average_latency);
+    }
+  }
+  std::stable_sort(endpoints.begin(), endpoints.end(),
+                   [&scores] (const boost::asio::ip::udp::endpoint& lhs,
+                              const boost::asio::ip::udp::endpoint& rhs) {
+                     return scores.at(lhs) < scores.at(rhs);
+                   });
+  return endpoints;
+}
+
+bool BootstrapContacts::Write(const boost::filesystem::path& path) const {
+  protobuf::BootstrapContactRecords pb_records;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& record : records_) {
+      protobuf::BootstrapContactRecord* pb_record(pb_records.add_records());
+      SetProtobufEndpoint(record.first, pb_record->mutable_endpoint());
+      pb_record->set_attempts(record.second.attempts);
+      pb_record->set_successes(record.second.successes);
+      pb_record->set_average_latency(std::chrono::duration_cast<std::chrono::microseconds>(
+          record.second.average_latency).count());
+    }
+  }
+  std::string serialised_records;
+  if (!pb_records.SerializeToString(&serialised_records)) {
+    LOG(kError) << "Could not serialise bootstrap contact records.";
+    return false;
+  }
+  boost::filesystem::path temp_path(path);
+  temp_path += ".tmp";
+  if (!WriteFile(temp_path, serialised_records)) {
+    LOG(kError) << "Could not write bootstrap contact records to " << temp_path;
+    return false;
+  }
+  boost::system::error_code error_code;
+  boost::filesystem::rename(temp_path, path, error_code);
+  if (error_code) {
+    LOG(kError) << "Could not replace bootstrap contact records " << path << ": "
+                << error_code.message();
+    boost::filesystem::remove(temp_path, error_code);
+    return false;
+  }
+  return true;
+}
+
+bool BootstrapContacts::Read(const boost::filesystem::path& path) {
+  boost::system::error_code error_code;
+  if (!boost::filesystem::exists(path, error_code))
+    return false;
+  std::string serialised_records;
+  protobuf::BootstrapContactRecords pb_records;
+  if (!ReadFile(path, &serialised_records) || !pb_records.ParseFromString(serialised_records)) {
+    LOG(kWarning) << "Could not read bootstrap contact records " << path;
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& pb_record : pb_records.records()) {
+    boost::asio::ip::udp::endpoint endpoint(GetEndpointFromProtobuf(pb_record.endpoint()));
+    if (endpoint.address().is_unspecified() || pb_record.successes() > pb_record.attempts())
+      continue;
+    Record& record(records_[endpoint]);
+    record.attempts = pb_record.attempts();
+    record.successes = pb_record.successes();
+    record.average_latency = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::microseconds(pb_record.average_latency()));
+  }
+  return true;
+}
+
+}  // namespace routing
+
+}  // namespace maidsafe
@@ -0,0 +1,74 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_ROUTING_BOOTSTRAP_CONTACTS_H_
+#define MAIDSAFE_ROUTING_BOOTSTRAP_CONTACTS_H_
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "boost/asio/ip/udp.hpp"
+#include "boost/filesystem/path.hpp"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+// Record of how each bootstrap endpoint has performed, used to try first those most likely to
+// answer, and answer quickly.
+class BootstrapContacts {
+ public:
+  BootstrapContacts();
+  void AddResult(const boost::asio::ip::udp::endpoint& endpoint,
+                 bool success,
+                 std::chrono::steady_clock::duration latency);
+  // Orders by success rate, then by average handshake latency.  Endpoints not yet tried rank
+  // behind those which have mostly succeeded and ahead of those which have mostly failed.  Ties
+  // keep their original order.
+  std::vector<boost::asio::ip::udp::endpoint> Rank(
+      std::vector<boost::asio::ip::udp::endpoint> endpoints) const;
+  // Writes the records to a temporary file which is then renamed over 'path'.
+  bool Write(const boost::filesystem::path& path) const;
+  // Replaces the records of any endpoints held in the file at 'path'.
+  bool Read(const boost::filesystem::path& path);
+
+ private:
+  struct Record {
+    Record() : attempts(0), successes(0), average_latency() {}
+    uint32_t attempts;
+    uint32_t successes;
+    // Over successful attempts only.
+    std::chrono::steady_clock::duration average_latency;
+  };
+
+  BootstrapContacts(const BootstrapContacts&);
+  BootstrapContacts& operator=(const BootstrapContacts&);
+
+  mutable std::mutex mutex_;
+  std::map<boost::asio::ip::udp::endpoint, Record> records_;
+};
+
+}  // namespace routing
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_ROUTING_BOOTSTRAP_CONTACTS_H_
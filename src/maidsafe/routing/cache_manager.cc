@@ -18,6 +18,13 @@
 
 #include "maidsafe/routing/cache_manager.h"
 
+#include <algorithm>
+#include <string>
+
+#include "maidsafe/common/crypto.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/routing/live_tuning.h"
 #include "maidsafe/routing/network_utils.h"
 #include "maidsafe/routing/parameters.h"
 #include "maidsafe/routing/routing.pb.h"
@@ -28,11 +35,54 @@ namespace maidsafe {
 
 namespace routing {
 
-CacheManager::CacheManager(const NodeId& node_id, NetworkUtils &network)
+namespace {
+
+uint16_t CommonLeadingBits(const std::string& lhs, const std::string& rhs) {
+  assert(lhs.size() == rhs.size());
+  uint16_t common_bits(0);
+  for (size_t index(0); index != lhs.size(); ++index) {
+    unsigned char difference(static_cast<unsigned char>(lhs[index] ^ rhs[index]));
+    if (difference == 0) {
+      common_bits += 8;
+      continue;
+    }
+    while ((difference & 0x80) == 0) {
+      difference = static_cast<unsigned char>(difference << 1);
+      ++common_bits;
+    }
+    break;
+  }
+  return common_bits;
+}
+
+}  // unnamed namespace
+
+CacheManager::CacheManager(const NodeId& node_id,
+                           NetworkUtils &network,
+                           Timer<std::string>& timer,
+                           const LiveTuning& tuning)
     : kNodeId_(node_id),
       network_(network),
+      timer_(timer),
+      tuning_(tuning),
       message_received_functor_(),
-      store_cache_data_() {}
+      store_cache_data_(),
+      mutex_(),
+      recent_misses_(),
+      pending_gets_(),
+      persistent_cache_() {
+  if (Parameters::cache_directory.empty())
+    return;
+  try {
+    persistent_cache_.reset(new PersistentCache(
+        Parameters::cache_directory / kNodeId_.ToStringEncoded(NodeId::kHex),
+        Parameters::cache_segment_size, Parameters::max_cache_segments));
+  }
+  catch(const std::exception& e) {
+    LOG(kError) << "Failed to open on-disk cache in " << Parameters::cache_directory << ": "
+                << e.what();
+  }
+}
 
 void CacheManager::InitialiseFunctors(MessageReceivedFunctor message_received_functor,
                                       StoreCacheDataFunctor store_cache_data) {
@@ -44,8 +94,23 @@ void CacheManager::InitialiseFunctors(MessageReceivedFunctor message_received_fu
 
 void CacheManager::AddToCache(const protobuf::Message& message) {
   assert(!message.request());
+  if (persistent_cache_) {
+    // The cache name is set by the sender, so only content-addressed data is kept on disk, under
+    // the hash of its content.
+    std::string name(crypto::Hash<crypto::SHA512>(message.data(0)).string());
+    if (!message.has_cache_name() || message.cache_name() == name)
+      persistent_cache_->Put(name, message.data(0));
+    else
+      LOG(kVerbose) << "Not keeping " << HexSubstr(message.cache_name()) << " on disk, as its "
+                    << "name doesn't match its content";
+  }
   if (store_cache_data_)
     store_cache_data_(message.data(0));
+  // Gets for the name can now be answered from the cache.
+  if (message.has_cache_name()) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    recent_misses_.erase(message.cache_name());
+  }
 }
 // FIXME(Prakash)
 void CacheManager::HandleGetFromCache(protobuf::Message& message) {
@@ -53,6 +118,17 @@ void CacheManager::HandleGetFromCache(protobuf::Message& message) {
   assert(IsCacheableGet(message));
   assert(kNodeId_.string() != message.source_id());
   assert(kNodeId_.string() != message.destination_id());
+  if (IsRecentMiss(message.destination_id())) {
+    LOG(kVerbose) << "Recent cache miss for " << HexSubstr(message.destination_id())
+                  << ", passing on the original request";
+    return ForwardRequest(message);
+  }
+  std::string data;
+  if (persistent_cache_ && persistent_cache_->Get(message.destination_id(), data) &&
+      crypto::Hash<crypto::SHA512>(data).string() == message.destination_id()) {
+    LOG(kVerbose) << "Responding from on-disk cache for " << HexSubstr(message.destination_id());
+    return SendResponse(message, data);
+  }
   if (message_received_functor_) {
     if (IsRequest(message)) {
       LOG(kVerbose) << " [" << DebugId(kNodeId_) << "] rcvd : "
@@ -62,36 +138,11 @@ void CacheManager::HandleGetFromCache(protobuf::Message& message) {
       ReplyFunctor response_functor = [=](const std::string& reply_message) {
           if (reply_message.empty()) {
             LOG(kVerbose) << "No cache available, passing on the original request";
-            return network_.SendToClosestNode(message);
+            AddRecentMiss(message.destination_id());
+            return ForwardRequest(message);
           }
-
           //  Responding with cached response
-          protobuf::Message message_out;
-          message_out.set_request(false);
-          message_out.set_hops_to_live(Parameters::hops_to_live);
-          message_out.set_destination_id(message.source_id());
-          message_out.set_type(message.type());
-          message_out.set_direct(true);
-          message_out.clear_data();
-          message_out.set_client_node(message.client_node());
-          message_out.set_routing_message(message.routing_message());
-          message_out.add_data(reply_message);
-          message_out.set_last_id(kNodeId_.string());
-          message_out.set_source_id(kNodeId_.string());
-          if (message.has_cacheable())
-            message_out.set_cacheable(message.cacheable());
-          if (message.has_id())
-            message_out.set_id(message.id());
-          else
-            LOG(kInfo) << "Message to be sent back had no ID.";
-
-          if (message.has_relay_id())
-            message_out.set_relay_id(message.relay_id());
-
-          if (message.has_relay_connection_id()) {
-            message_out.set_relay_connection_id(message.relay_connection_id());
-          }
-          network_.SendToClosestNode(message_out);
+          SendResponse(message, reply_message);
       };
 
       if (message_received_functor_)
@@ -100,6 +151,188 @@ void CacheManager::HandleGetFromCache(protobuf::Message& message) {
   }
 }
 
+bool CacheManager::HandleCoalescedResponse(const protobuf::Message& message) {
+  if (IsRequest(message) || !IsCacheablePut(message) ||
+      message.destination_id() != kNodeId_.string() || message.data_size() == 0)
+    return false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (std::find_if(pending_gets_.begin(), pending_gets_.end(),
+                     [&message](const std::pair<const std::string, PendingGet>& pending) {
+                       return pending.second.id == message.id();
+                     }) == pending_gets_.end()) {
+      return false;
+    }
+  }
+  LOG(kVerbose) << " [" << DebugId(kNodeId_) << "] rcvd response for coalesced requests  (id: "
+                << message.id() << ")";
+  try {
+    timer_.AddResponse(message.id(), message.data(0));
+  }
+  catch(const maidsafe_error& error) {
+    LOG(kWarning) << "Coalesced get " << message.id() << " already finished: " << error.what();
+  }
+  return true;
+}
+
+std::string CacheManager::PendingGetKey(const protobuf::Message& message) {
+  return message.destination_id() + std::to_string(message.type()) + ":" + message.cache_name();
+}
+
+void CacheManager::ForwardRequest(const protobuf::Message& message) {
+  // Only direct gets are coalesced, as group gets expect a response from each group member.
+  if (!IsDirect(message))
+    return network_.SendToClosestNode(message);
+
+  protobuf::Message forward(message);
+  std::string key(PendingGetKey(message));
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto itr(pending_gets_.find(key));
+    if (itr != pending_gets_.end()) {
+      LOG(kVerbose) << "Get for " << HexSubstr(message.destination_id())
+                    << " already in flight, holding request  (id: " << message.id() << ")";
+      itr->second.requests.push_back(message);
+      return;
+    }
+    // The request is sent on as this node's own, so the response comes back here to be fanned
+    // out to every requester waiting on it.  The timer task can't complete before the entry is
+    // added, as its functor takes mutex_.
+    PendingGet pending;
+    pending.id = timer_.AddTask(tuning_.Get()->response_timeout,
+                                [this, key](std::string data) { FinishPendingGet(key, data); },
+                                1);
+    pending.requests.push_back(message);
+    pending_gets_[key] = pending;
+    forward.set_id(pending.id);
+  }
+  forward.set_source_id(kNodeId_.string());
+  forward.set_client_node(false);
+  forward.clear_relay_id();
+  forward.clear_relay_connection_id();
+  network_.SendToClosestNode(forward);
+}
+
+void CacheManager::FinishPendingGet(const std::string& key, const std::string& data) {
+  std::vector<protobuf::Message> requests;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto itr(pending_gets_.find(key));
+    if (itr == pending_gets_.end())
+      return;
+    requests.swap(itr->second.requests);
+    pending_gets_.erase(itr);
+  }
+  if (data.empty()) {
+    LOG(kVerbose) << "No response for " << requests.size()
+                  << " coalesced requests, passing each on by itself";
+    for (const auto& request : requests)
+      network_.SendToClosestNode(request);
+    return;
+  }
+  for (const auto& request : requests)
+    SendResponse(request, data);
+}
+
+void CacheManager::SendResponse(const protobuf::Message& request, const std::string& data) {
+  protobuf::Message message_out;
+  message_out.set_request(false);
+  message_out.set_hops_to_live(Parameters::hops_to_live);
+  message_out.set_destination_id(request.source_id());
+  message_out.set_type(request.type());
+  message_out.set_direct(true);
+  message_out.clear_data();
+  message_out.set_client_node(request.client_node());
+  message_out.set_routing_message(request.routing_message());
+  message_out.add_data(data);
+  message_out.set_last_id(kNodeId_.string());
+  message_out.set_source_id(kNodeId_.string());
+  message_out.set_cacheable(static_cast<int32_t>(Cacheable::kPut));
+  message_out.set_cache_name(request.destination_id());
+  if (request.has_id())
+    message_out.set_id(request.id());
+  else
+    LOG(kInfo) << "Message to be sent back had no ID.";
+
+  if (request.has_relay_id())
+    message_out.set_relay_id(request.relay_id());
+
+  if (request.has_relay_connection_id()) {
+    message_out.set_relay_connection_id(request.relay_connection_id());
+  }
+  network_.SendToClosestNode(message_out);
+}
+
+bool CacheManager::IsRecentMiss(const std::string& name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto itr(recent_misses_.find(name));
+  if (itr == recent_misses_.end())
+    return false;
+  if (itr->second > std::chrono::steady_clock::now())
+    return true;
+  recent_misses_.erase(itr);
+  return false;
+}
+
+void CacheManager::AddRecentMiss(const std::string& name) {
+  std::shared_ptr<const Tuning> tuning(tuning_.Get());
+  if (tuning->negative_cache_size == 0)
+    return;
+  auto now(std::chrono::steady_clock::now());
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (recent_misses_.size() >= tuning->negative_cache_size &&
+      recent_misses_.find(name) == recent_misses_.end()) {
+    for (auto itr(recent_misses_.begin()); itr != recent_misses_.end();) {
+      if (itr->second <= now)
+        itr = recent_misses_.erase(itr);
+      else
+        ++itr;
+    }
+    if (recent_misses_.size() >= tuning->negative_cache_size) {
+      recent_misses_.erase(std::min_element(
+          recent_misses_.begin(), recent_misses_.end(),
+          [](const std::pair<const std::string, std::chrono::steady_clock::time_point>& lhs,
+             const std::pair<const std::string, std::chrono::steady_clock::time_point>& rhs) {
+            return lhs.second < rhs.second;
+          }));
+    }
+  }
+  recent_misses_[name] = now + tuning->negative_cache_ttl;
+}
+
+bool CacheManager::ShouldCache(const protobuf::Message& message) const {
+  assert(IsCacheablePut(message));
+  switch (Parameters::caching_policy) {
+    case CachingPolicy::kAllHops:
+      return true;
+    case CachingPolicy::kNearestHops: {
+      // The responder and every relaying node append themselves to the route history, so its size
+      // is this node's hop count from the responder until the history starts being truncated.
+      int hops(message.route_history_size());
+      return (hops < Parameters::max_route_history) && (hops <= Parameters::caching_hops);
+    }
+    case CachingPolicy::kDistanceWeighted: {
+      // Without the content name, the responder's ID stands in for it as the responder is in the
+      // content's close group.
+      const std::string& content_name(CheckId(message.cache_name()) ? message.cache_name() :
+                                                                      message.source_id());
+      uint16_t this_node_common_bits(CommonLeadingBits(kNodeId_.string(), content_name));
+      uint16_t nearest_hop_common_bits(0);
+      for (const auto& hop : message.route_history()) {
+        if (hop != content_name && hop != kNodeId_.string() && CheckId(hop))
+          nearest_hop_common_bits = std::max(nearest_hop_common_bits,
+                                             CommonLeadingBits(hop, content_name));
+      }
+      if (this_node_common_bits >= nearest_hop_common_bits)
+        return true;
+      uint16_t extra_bits(nearest_hop_common_bits - this_node_common_bits);
+      return (extra_bits < 32) && ((RandomUint32() % (1U << extra_bits)) == 0);
+    }
+    default:
+      return true;
+  }
+}
+
 }  // namespace routing
 
 }  // namespace maidsafe
@@ -19,36 +19,85 @@
 #ifndef MAIDSAFE_ROUTING_CACHE_MANAGER_H_
 #define MAIDSAFE_ROUTING_CACHE_MANAGER_H_
 
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "maidsafe/routing/api_config.h"
+#include "maidsafe/routing/persistent_cache.h"
+#include "maidsafe/routing/routing.pb.h"
+#include "maidsafe/routing/timer.h"
 
 namespace maidsafe {
 
 namespace routing {
 
-namespace protobuf { class Message; }
+namespace test {
+  class CacheManagerTest_BEH_CoalesceCacheableGets_Test;
+  class CacheManagerTest_BEH_ExpireCoalescedGets_Test;
+}
 
+class LiveTuning;
 class NetworkUtils;
 
 class CacheManager {
  public:
-  CacheManager(const NodeId& node_id, NetworkUtils &network);
+  CacheManager(const NodeId& node_id,
+               NetworkUtils &network,
+               Timer<std::string>& timer,
+               const LiveTuning& tuning);
 
   void InitialiseFunctors(MessageReceivedFunctor message_received_functor,
                           StoreCacheDataFunctor store_cache_data);
   void AddToCache(const protobuf::Message& message);
   void HandleGetFromCache(protobuf::Message& message);
+  // Returns true if |message| is the response to a get forwarded on behalf of coalesced requests,
+  // in which case it has been sent on to each of those requesters.
+  bool HandleCoalescedResponse(const protobuf::Message& message);
+  // Applies Parameters::caching_policy to decide whether this node keeps a copy of a cacheable
+  // response it is relaying.
+  bool ShouldCache(const protobuf::Message& message) const;
+
+  friend class test::CacheManagerTest_BEH_CoalesceCacheableGets_Test;
+  friend class test::CacheManagerTest_BEH_ExpireCoalescedGets_Test;
 
  private:
   CacheManager(const CacheManager&);
   CacheManager(const CacheManager&&);
   CacheManager& operator=(const CacheManager&);
 
+  struct PendingGet {
+    PendingGet() : id(0), requests() {}
+    TaskId id;
+    std::vector<protobuf::Message> requests;
+  };
+
+  // Gets are only coalesced if they are for the same data type and name at the same destination.
+  static std::string PendingGetKey(const protobuf::Message& message);
+  void ForwardRequest(const protobuf::Message& message);
+  // Called with the response to the forwarded get, or with an empty string if none arrived in
+  // time, in which case each held request is sent on by itself.
+  void FinishPendingGet(const std::string& key, const std::string& data);
+  void SendResponse(const protobuf::Message& request, const std::string& data);
+  bool IsRecentMiss(const std::string& name);
+  void AddRecentMiss(const std::string& name);
+
   const NodeId kNodeId_;
   NetworkUtils& network_;
+  Timer<std::string>& timer_;
+  const LiveTuning& tuning_;
   MessageReceivedFunctor message_received_functor_;
   StoreCacheDataFunctor store_cache_data_;
+  std::mutex mutex_;
+  // Content names which recently missed in the local cache, mapped to their expiry time.
+  std::map<std::string, std::chrono::steady_clock::time_point> recent_misses_;
+  // In-flight gets forwarded by this node, keyed by PendingGetKey.  Each is held until its timer
+  // task completes.
+  std::map<std::string, PendingGet> pending_gets_;
+  std::unique_ptr<PersistentCache> persistent_cache_;
 };
 
 }  // namespace routing
@@ -18,6 +18,9 @@
 
 #include "maidsafe/routing/client_routing_table.h"
 
+#include <algorithm>
+#include <functional>
+
 #include "maidsafe/common/log.h"
 
 #include "maidsafe/routing/node_info.h"
@@ -37,6 +40,8 @@ typedef boost::asio::ip::udp::endpoint Endpoint;
 ClientRoutingTable::ClientRoutingTable(const NodeId& node_id)
     : kNodeId_(node_id),
       nodes_(),
+      node_id_index_(),
+      connection_id_index_(),
       mutex_() {}
 
 bool ClientRoutingTable::AddNode(NodeInfo& node, const NodeId& furthest_close_node_id) {
@@ -55,7 +60,7 @@ bool ClientRoutingTable::AddOrCheckNode(NodeInfo& node,
   std::lock_guard<std::mutex> lock(mutex_);
   if (CheckRangeForNodeToBeAdded(node, furthest_close_node_id, add)) {
     if (add) {
-      nodes_.push_back(node);
+      Insert(node);
       LOG(kInfo) << "Added to ClientRoutingTable :" << DebugId(node.node_id);
       LOG(kVerbose) << PrintClientRoutingTable();
     }
@@ -67,48 +72,37 @@ bool ClientRoutingTable::AddOrCheckNode(NodeInfo& node,
 std::vector<NodeInfo> ClientRoutingTable::DropNodes(const NodeId &node_to_drop) {
   std::vector<NodeInfo> nodes_info;
   std::lock_guard<std::mutex> lock(mutex_);
-  uint16_t i(0);
-  while (i < nodes_.size()) {
-    if (nodes_.at(i).node_id == node_to_drop) {
-      nodes_info.push_back(nodes_.at(i));
-      nodes_.erase(nodes_.begin() + i);
-    } else {
-      ++i;
-    }
-  }
+  std::vector<size_t> positions;
+  auto range(node_id_index_.equal_range(node_to_drop));
+  for (auto itr(range.first); itr != range.second; ++itr)
+    positions.push_back(itr->second);
+  // Erasing from the back keeps the remaining positions valid.
+  std::sort(positions.begin(), positions.end(), std::greater<size_t>());
+  for (auto position : positions)
+    nodes_info.push_back(Erase(position));
   return nodes_info;
 }
 
 NodeInfo ClientRoutingTable::DropConnection(const NodeId& connection_to_drop) {
-  NodeInfo node_info;
   std::lock_guard<std::mutex> lock(mutex_);
-  for (auto it = nodes_.begin(); it != nodes_.end(); ++it) {
-    if ((*it).connection_id == connection_to_drop) {
-      node_info = *it;
-      nodes_.erase(it);
-      break;
-    }
-  }
-  return node_info;
+  auto itr(connection_id_index_.find(connection_to_drop));
+  if (itr == connection_id_index_.end())
+    return NodeInfo();
+  return Erase(itr->second);
 }
 
 std::vector<NodeInfo> ClientRoutingTable::GetNodesInfo(const NodeId& node_id) const {
   std::vector<NodeInfo> nodes_info;
   std::lock_guard<std::mutex> lock(mutex_);
-  for (auto it = nodes_.begin(); it != nodes_.end(); ++it) {
-    if ((*it).node_id == node_id)
-      nodes_info.push_back(*it);
-  }
+  auto range(node_id_index_.equal_range(node_id));
+  for (auto itr(range.first); itr != range.second; ++itr)
+    nodes_info.push_back(nodes_.at(itr->second));
   return nodes_info;
 }
 
 bool ClientRoutingTable::Contains(const NodeId& node_id) const {
   std::lock_guard<std::mutex> lock(mutex_);
-  return std::find_if(nodes_.begin(),
-                      nodes_.end(),
-                      [node_id](const NodeInfo& node_info) {
-                        return node_info.node_id == node_id;
-                      }) != nodes_.end();
+  return node_id_index_.find(node_id) != node_id_index_.end();
 }
 
 bool ClientRoutingTable::IsConnected(const NodeId& node_id) const {
@@ -132,11 +126,7 @@ bool ClientRoutingTable::CheckValidParameters(const NodeInfo& node) const {
 
 bool ClientRoutingTable::CheckParametersAreUnique(const NodeInfo& node) const {
   // If we already have a duplicate endpoint return false
-  if (std::find_if(nodes_.begin(),
-                   nodes_.end(),
-                   [node](const NodeInfo& node_info) {
-                     return (node_info.connection_id == node.connection_id);
-                   }) != nodes_.end()) {
+  if (connection_id_index_.find(node.connection_id) != connection_id_index_.end()) {
     LOG(kInfo) << "Already have node with this connection_id.";
     return false;
   }
@@ -179,6 +169,42 @@ bool ClientRoutingTable::IsThisNodeInRange(const NodeId& node_id,
   return (furthest_close_node_id ^ kNodeId_) > (node_id ^ kNodeId_);
 }
 
+void ClientRoutingTable::Insert(const NodeInfo& node) {
+  nodes_.push_back(node);
+  AddToIndices(node, nodes_.size() - 1);
+}
+
+NodeInfo ClientRoutingTable::Erase(size_t position) {
+  NodeInfo erased_node(nodes_.at(position));
+  RemoveFromIndices(erased_node, position);
+  const size_t kLast(nodes_.size() - 1);
+  if (position != kLast) {
+    RemoveFromIndices(nodes_.at(kLast), kLast);
+    nodes_.at(position) = nodes_.at(kLast);
+    AddToIndices(nodes_.at(position), position);
+  }
+  nodes_.pop_back();
+  return erased_node;
+}
+
+void ClientRoutingTable::AddToIndices(const NodeInfo& node, size_t position) {
+  node_id_index_.insert(std::make_pair(node.node_id, position));
+  connection_id_index_[node.connection_id] = position;
+}
+
+void ClientRoutingTable::RemoveFromIndices(const NodeInfo& node, size_t position) {
+  auto range(node_id_index_.equal_range(node.node_id));
+  for (auto itr(range.first); itr != range.second; ++itr) {
+    if (itr->second == position) {
+      node_id_index_.erase(itr);
+      break;
+    }
+  }
+  auto itr(connection_id_index_.find(node.connection_id));
+  if (itr != connection_id_index_.end() && itr->second == position)
+    connection_id_index_.erase(itr);
+}
+
 std::string ClientRoutingTable::PrintClientRoutingTable() {
   auto rt(nodes_);
   std::string s = "\n\n[" + DebugId(kNodeId_) +
@@ -20,6 +20,7 @@
 #define MAIDSAFE_ROUTING_CLIENT_ROUTING_TABLE_H_
 
 #include <cstdint>
+#include <map>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -74,6 +75,10 @@ class ClientRoutingTable {
                                   const NodeId& furthest_close_node_id,
                                   const bool& add) const;
   bool IsThisNodeInRange(const NodeId& node_id, const NodeId& furthest_close_node_id) const;
+  void Insert(const NodeInfo& node);
+  NodeInfo Erase(size_t position);
+  void AddToIndices(const NodeInfo& node, size_t position);
+  void RemoveFromIndices(const NodeInfo& node, size_t position);
   std::string PrintClientRoutingTable();
 
   friend class test::BasicClientRoutingTableTest;
@@ -81,6 +86,10 @@ class ClientRoutingTable {
 
   const NodeId kNodeId_;
   std::vector<NodeInfo> nodes_;
+  // Positions in nodes_, by node ID (a client may have several connections) and by connection ID.
+  // Ordered, as NodeId compares its bytes in place but only hands them out as a copy.
+  std::multimap<NodeId, size_t> node_id_index_;
+  std::map<NodeId, size_t> connection_id_index_;
   mutable std::mutex mutex_;
 };
 
@@ -0,0 +1,188 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/routing/connection_manager.h"
+
+#include <algorithm>
+#include <iterator>
+#include <tuple>
+
+#include "maidsafe/common/log.h"
+
+#include "maidsafe/routing/node_info.h"
+#include "maidsafe/routing/parameters.h"
+#include "maidsafe/routing/routing_table.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+ConnectionManager::ConnectionManager(RoutingTable& routing_table, Timer<std::string>& timer,
+                                     ConnectFunctor connect_functor)
+    : routing_table_(routing_table),
+      timer_(timer),
+      connect_functor_(connect_functor),
+      mutex_(),
+      queue_(),
+      in_flight_(),
+      checked_version_(routing_table_.version()),
+      check_scheduled_(false),
+      check_due_() {
+  assert(connect_functor_);
+}
+
+void ConnectionManager::Add(const NodeId& candidate) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (in_flight_.count(candidate) != 0 ||
+        std::find(queue_.begin(), queue_.end(), candidate) != queue_.end() ||
+        Redundant(candidate))
+      return;
+    queue_.push_back(candidate);
+  }
+  Dispatch();
+}
+
+void ConnectionManager::Complete(const NodeId& peer) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (in_flight_.erase(peer) == 0)
+      return;
+  }
+  Dispatch();
+}
+
+size_t ConnectionManager::in_flight() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return in_flight_.size();
+}
+
+size_t ConnectionManager::queued() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return queue_.size();
+}
+
+void ConnectionManager::Dispatch() {
+  for (;;) {
+    NodeId candidate;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      Prune(lock);
+      if (queue_.empty() || in_flight_.size() >= Parameters::max_connect_attempts_in_flight) {
+        ScheduleCheck(lock);
+        return;
+      }
+      auto best(BestCandidate(lock));
+      candidate = *best;
+      queue_.erase(best);
+      in_flight_[candidate] = std::chrono::steady_clock::now();
+    }
+    // The functor sends over the network, so must not be called holding mutex_.
+    if (!connect_functor_(candidate)) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      in_flight_.erase(candidate);
+    }
+  }
+}
+
+void ConnectionManager::Check() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    check_scheduled_ = false;
+    // Before it is due, the task can only have been cancelled by the Timer being destroyed.
+    if (std::chrono::steady_clock::now() < check_due_)
+      return;
+  }
+  Dispatch();
+}
+
+void ConnectionManager::ScheduleCheck(std::unique_lock<std::mutex>& lock) {
+  assert(lock.owns_lock());
+  static_cast<void>(lock);
+  if (check_scheduled_ || (queue_.empty() && in_flight_.empty()))
+    return;
+  check_scheduled_ = true;
+  check_due_ = std::chrono::steady_clock::now() + Parameters::connect_attempt_check_interval;
+  timer_.AddTask(Parameters::connect_attempt_check_interval,
+                 [this](std::string) { Check(); },
+                 1);
+}
+
+bool ConnectionManager::Redundant(const NodeId& node_id) const {
+  NodeInfo node_info;
+  node_info.node_id = node_id;
+  return !routing_table_.CheckNode(node_info);
+}
+
+void ConnectionManager::Prune(std::unique_lock<std::mutex>& lock) {
+  assert(lock.owns_lock());
+  static_cast<void>(lock);
+  uint64_t version(routing_table_.version());
+  bool table_changed(version != checked_version_);
+  checked_version_ = version;
+  if (table_changed) {
+    queue_.erase(std::remove_if(queue_.begin(),
+                                queue_.end(),
+                                [this] (const NodeId& node_id) { return Redundant(node_id); }),
+                 queue_.end());
+  }
+
+  auto now(std::chrono::steady_clock::now());
+  for (auto itr(in_flight_.begin()); itr != in_flight_.end();) {
+    if (now - itr->second > Parameters::connect_attempt_timeout) {
+      LOG(kVerbose) << "Connect attempt to " << DebugId(itr->first) << " timed out.";
+      itr = in_flight_.erase(itr);
+    } else if (table_changed && Redundant(itr->first)) {
+      LOG(kVerbose) << "Connect attempt to " << DebugId(itr->first) << " no longer needed.";
+      itr = in_flight_.erase(itr);
+    } else {
+      ++itr;
+    }
+  }
+}
+
+std::vector<NodeId>::iterator ConnectionManager::BestCandidate(
+    std::unique_lock<std::mutex>& lock) {
+  assert(lock.owns_lock());
+  static_cast<void>(lock);
+  assert(!queue_.empty());
+  const NodeId kNodeId(routing_table_.kNodeId());
+  const NodeId kFurthestCloseNode(
+      routing_table_.GetNthClosestNode(kNodeId, Parameters::closest_nodes_size).node_id);
+  // Lower is better: outside close group, then bucket occupancy.
+  auto rank([&] (const NodeId& node_id) {
+    return std::make_tuple(!NodeId::CloserToTarget(node_id, kFurthestCloseNode, kNodeId),
+                           routing_table_.BucketOccupancy(node_id));
+  });
+  auto best(queue_.begin());
+  auto best_rank(rank(*best));
+  for (auto itr(std::next(queue_.begin())); itr != queue_.end(); ++itr) {
+    auto itr_rank(rank(*itr));
+    if (itr_rank < best_rank ||
+        (itr_rank == best_rank && NodeId::CloserToTarget(*itr, *best, kNodeId))) {
+      best = itr;
+      best_rank = itr_rank;
+    }
+  }
+  return best;
+}
+
+}  // namespace routing
+
+}  // namespace maidsafe
@@ -0,0 +1,87 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_ROUTING_CONNECTION_MANAGER_H_
+#define MAIDSAFE_ROUTING_CONNECTION_MANAGER_H_
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "maidsafe/common/node_id.h"
+
+#include "maidsafe/routing/timer.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+class RoutingTable;
+
+// Queues candidate peers and runs at most Parameters::max_connect_attempts_in_flight connect
+// handshakes at once.  Candidates which would join the close group go first, then those filling
+// the emptiest buckets, closest first.  A queued or running attempt is dropped as soon as the
+// routing table would no longer make space for the candidate.  Attempts not completed within
+// Parameters::connect_attempt_timeout release their slot.  While there are queued or running
+// attempts, a Timer task rechecks them every Parameters::connect_attempt_check_interval.
+class ConnectionManager {
+ public:
+  // Returns true if a connect request was sent to the candidate.
+  typedef std::function<bool(const NodeId& /*candidate*/)> ConnectFunctor;
+
+  // The check task refers to this object, so 'timer' must be destroyed first.
+  ConnectionManager(RoutingTable& routing_table, Timer<std::string>& timer,
+                    ConnectFunctor connect_functor);
+  void Add(const NodeId& candidate);
+  // Called once the handshake with 'peer' has finished, successfully or not.
+  void Complete(const NodeId& peer);
+  size_t in_flight() const;
+  size_t queued() const;
+
+ private:
+  ConnectionManager(const ConnectionManager&);
+  ConnectionManager& operator=(const ConnectionManager&);
+  void Dispatch();
+  void Check();
+  void ScheduleCheck(std::unique_lock<std::mutex>& lock);
+  bool Redundant(const NodeId& node_id) const;
+  void Prune(std::unique_lock<std::mutex>& lock);
+  std::vector<NodeId>::iterator BestCandidate(std::unique_lock<std::mutex>& lock);
+
+  RoutingTable& routing_table_;
+  Timer<std::string>& timer_;
+  ConnectFunctor connect_functor_;
+  mutable std::mutex mutex_;
+  std::vector<NodeId> queue_;
+  std::map<NodeId, std::chrono::steady_clock::time_point> in_flight_;
+  // Routing table version all of queue_ and in_flight_ were last checked against.  Candidates are
+  // checked as they are added, so all are only rechecked once the routing table has changed.
+  uint64_t checked_version_;
+  bool check_scheduled_;
+  std::chrono::steady_clock::time_point check_due_;
+};
+
+}  // namespace routing
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_ROUTING_CONNECTION_MANAGER_H_
@@ -18,7 +18,9 @@
 
 #include "maidsafe/routing/group_change_handler.h"
 
+#include <set>
 #include <string>
+#include <utility>
 #include <vector>
 #include <algorithm>
 
@@ -38,12 +40,27 @@ namespace maidsafe {
 
 namespace routing {
 
+namespace {
+
+// Whether |sequence| is later than |last|, allowing for the sequence wrapping.
+bool IsLater(uint32_t sequence, uint32_t last) {
+  return static_cast<int32_t>(sequence - last) > 0;
+}
+
+}  // unnamed namespace
+
 GroupChangeHandler::GroupChangeHandler(RoutingTable& routing_table,
                                        ClientRoutingTable& client_routing_table,
                                        NetworkUtils& network)
   : routing_table_(routing_table),
     client_routing_table_(client_routing_table),
-    network_(network) {}
+    network_(network),
+    mutex_(),
+    last_closest_nodes_(),
+    last_update_recipients_(),
+    update_sequence_(0),
+    peer_update_sequences_(),
+    delta_capable_peers_() {}
 
 GroupChangeHandler::~GroupChangeHandler() {}
 
@@ -54,6 +71,13 @@ void GroupChangeHandler::ClosestNodesUpdate(protobuf::Message& message) {
     message.Clear();
     return;
   }
+  HandleClosestNodesUpdate(message);
+  // The update is never passed on, whether or not it was used.
+  if (!routing_table_.client_mode())
+    message.Clear();
+}
+
+void GroupChangeHandler::HandleClosestNodesUpdate(const protobuf::Message& message) {
   protobuf::ClosestNodesUpdate closest_node_update;
   if (!closest_node_update.ParseFromString(message.data(0))) {
     LOG(kError) << "No Data.";
@@ -65,19 +89,96 @@ void GroupChangeHandler::ClosestNodesUpdate(protobuf::Message& message) {
     return;
   }
 
-  std::vector<NodeInfo> closest_nodes;
+  NodeId node_id(closest_node_update.node());
+  if (closest_node_update.accepts_delta() && routing_table_.Contains(node_id)) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    delta_capable_peers_.insert(node_id);
+  }
+  if (closest_node_update.resync()) {
+    SendFullClosestNodesUpdate(node_id);
+  } else if (closest_node_update.delta()) {
+    HandleClosestNodesUpdateDelta(node_id, closest_node_update);
+  } else {
+    std::vector<NodeInfo> closest_nodes;
+    NodeInfo node_info;
+    for (const auto& basic_info : closest_node_update.nodes_info()) {
+      if (CheckId(basic_info.node_id())) {
+        node_info.node_id = NodeId(basic_info.node_id());
+        node_info.rank = basic_info.rank();
+        closest_nodes.push_back(node_info);
+      }
+    }
+    assert(!closest_nodes.empty());
+    if (closest_node_update.has_sequence()) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto itr(peer_update_sequences_.find(node_id));
+      if (itr != peer_update_sequences_.end() &&
+          !IsLater(closest_node_update.sequence(), itr->second)) {
+        LOG(kVerbose) << DebugId(routing_table_.kNodeId()) << " ignoring stale update from "
+                      << DebugId(node_id);
+        return;
+      }
+      peer_update_sequences_[node_id] = closest_node_update.sequence();
+    }
+    UpdateGroupChange(node_id, closest_nodes);
+  }
+}
+
+void GroupChangeHandler::HandleClosestNodesUpdateDelta(
+    const NodeId& node_id,
+    const protobuf::ClosestNodesUpdate& closest_node_update) {
+  if (!routing_table_.Contains(node_id)) {
+    LOG(kVerbose) << DebugId(routing_table_.kNodeId()) << " ignoring delta update from "
+                  << DebugId(node_id);
+    return;
+  }
+  bool in_sequence(false);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto itr(peer_update_sequences_.find(node_id));
+    if (itr != peer_update_sequences_.end()) {
+      uint32_t expected(itr->second + 1 == 0 ? 1 : itr->second + 1);
+      if (closest_node_update.sequence() == expected) {
+        itr->second = expected;
+        in_sequence = true;
+      } else if (!IsLater(closest_node_update.sequence(), itr->second)) {
+        LOG(kVerbose) << DebugId(routing_table_.kNodeId()) << " ignoring repeated delta update "
+                      << closest_node_update.sequence() << " from " << DebugId(node_id);
+        return;
+      }
+    }
+  }
+  if (!in_sequence) {
+    LOG(kInfo) << DebugId(routing_table_.kNodeId()) << " missed update from " << DebugId(node_id)
+               << ", requesting resync.";
+    SendClosestNodesUpdateResync(node_id);
+    return;
+  }
+
+  std::vector<NodeInfo> added_nodes;
   NodeInfo node_info;
-  for (const auto& basic_info : closest_node_update.nodes_info()) {
+  for (const auto& basic_info : closest_node_update.added_nodes()) {
     if (CheckId(basic_info.node_id())) {
       node_info.node_id = NodeId(basic_info.node_id());
       node_info.rank = basic_info.rank();
-      closest_nodes.push_back(node_info);
+      added_nodes.push_back(node_info);
     }
   }
-  assert(!closest_nodes.empty());
-  UpdateGroupChange(NodeId(closest_node_update.node()), closest_nodes);
-  if (!routing_table_.client_mode())
-    message.Clear();
+  std::vector<NodeId> removed_nodes;
+  for (const auto& removed_node : closest_node_update.removed_nodes()) {
+    if (CheckId(removed_node))
+      removed_nodes.push_back(NodeId(removed_node));
+  }
+  LOG(kVerbose) << DebugId(routing_table_.kNodeId()) << " UpdateGroupChange (delta) for "
+                << DebugId(node_id) << " added: " << added_nodes.size()
+                << " removed: " << removed_nodes.size();
+  if (!routing_table_.GroupPatchFromConnectedPeer(node_id, added_nodes, removed_nodes)) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      peer_update_sequences_.erase(node_id);
+    }
+    SendClosestNodesUpdateResync(node_id);
+  }
 }
 
 void GroupChangeHandler::UpdateGroupChange(const NodeId& node_id,
@@ -107,15 +208,94 @@ void GroupChangeHandler::SendClosestNodesUpdateRpcs(std::vector<NodeInfo> closes
   // clients are also notified of changes in connected close nodes
   for (auto& client : client_routing_table_.nodes_)
     update_subscribers.push_back(client);
-  for (auto itr(update_subscribers.begin()); itr != update_subscribers.end(); ++itr) {
+
+  std::vector<std::pair<NodeInfo, protobuf::Message>> closest_nodes_update_rpcs;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<NodeInfo> added_nodes;
+    for (const auto& node_info : closest_nodes) {
+      if (std::find_if(last_closest_nodes_.begin(),
+                       last_closest_nodes_.end(),
+                       [&node_info] (const NodeInfo& last_node_info) {
+                         return last_node_info.node_id == node_info.node_id &&
+                                last_node_info.rank == node_info.rank;
+                       }) == last_closest_nodes_.end())
+        added_nodes.push_back(node_info);
+    }
+    std::vector<NodeId> removed_nodes;
+    for (const auto& last_node_info : last_closest_nodes_) {
+      if (std::find_if(closest_nodes.begin(),
+                       closest_nodes.end(),
+                       [&last_node_info] (const NodeInfo& node_info) {
+                         return node_info.node_id == last_node_info.node_id;
+                       }) == closest_nodes.end())
+        removed_nodes.push_back(last_node_info.node_id);
+    }
+    bool changed(!added_nodes.empty() || !removed_nodes.empty());
+    if (changed && ++update_sequence_ == 0)
+      ++update_sequence_;
+    last_closest_nodes_ = closest_nodes;
+    // A delta no smaller than the full list saves nothing.
+    bool send_delta(added_nodes.size() + removed_nodes.size() < closest_nodes.size());
+
+    std::set<NodeId> update_recipients;
+    for (const auto& subscriber : update_subscribers) {
+      update_recipients.insert(subscriber.node_id);
+      bool accepts_delta(send_delta && delta_capable_peers_.count(subscriber.node_id) != 0);
+      if (last_update_recipients_.count(subscriber.node_id) == 0 || (changed && !accepts_delta)) {
+        closest_nodes_update_rpcs.push_back(std::make_pair(subscriber, rpcs::ClosestNodesUpdate(
+            subscriber.node_id, routing_table_.kNodeId(), closest_nodes, update_sequence_)));
+      } else if (changed) {
+        closest_nodes_update_rpcs.push_back(std::make_pair(subscriber,
+            rpcs::ClosestNodesUpdateDelta(subscriber.node_id, routing_table_.kNodeId(),
+                                          added_nodes, removed_nodes, update_sequence_)));
+      }
+    }
+    last_update_recipients_.swap(update_recipients);
+  }
+
+  for (auto& closest_nodes_update_rpc : closest_nodes_update_rpcs) {
     LOG(kVerbose) << "["  << DebugId(routing_table_.kNodeId())
-                  << "] Sending update to: " << DebugId(itr->node_id);
-    protobuf::Message closest_nodes_update_rpc(
-        rpcs::ClosestNodesUpdate(itr->node_id, routing_table_.kNodeId(), closest_nodes));
-    network_.SendToDirect(closest_nodes_update_rpc, itr->node_id, itr->connection_id);
+                  << "] Sending update to: " << DebugId(closest_nodes_update_rpc.first.node_id);
+    network_.SendToDirect(closest_nodes_update_rpc.second, closest_nodes_update_rpc.first.node_id,
+                          closest_nodes_update_rpc.first.connection_id);
   }
 }
 
+void GroupChangeHandler::SendClosestNodesUpdateResync(const NodeId& node_id) {
+  NodeInfo node_info;
+  if (!GetNodeInfo(node_id, node_info))
+    return;
+  protobuf::Message closest_nodes_update_rpc(
+      rpcs::ClosestNodesUpdateResync(node_id, routing_table_.kNodeId()));
+  network_.SendToDirect(closest_nodes_update_rpc, node_info.node_id, node_info.connection_id);
+}
+
+void GroupChangeHandler::SendFullClosestNodesUpdate(const NodeId& node_id) {
+  NodeInfo node_info;
+  if (!GetNodeInfo(node_id, node_info))
+    return;
+  protobuf::Message closest_nodes_update_rpc;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (last_closest_nodes_.empty())
+      return;
+    closest_nodes_update_rpc = rpcs::ClosestNodesUpdate(node_id, routing_table_.kNodeId(),
+                                                        last_closest_nodes_, update_sequence_);
+    last_update_recipients_.insert(node_id);
+  }
+  LOG(kVerbose) << "["  << DebugId(routing_table_.kNodeId())
+                << "] Resyncing update to: " << DebugId(node_id);
+  network_.SendToDirect(closest_nodes_update_rpc, node_info.node_id, node_info.connection_id);
+}
+
+void GroupChangeHandler::PeerRemoved(const NodeId& node_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  peer_update_sequences_.erase(node_id);
+  delta_capable_peers_.erase(node_id);
+  last_update_recipients_.erase(node_id);
+}
+
 bool GroupChangeHandler::GetNodeInfo(const NodeId& node_id, const NodeId& connection_id,
                                      NodeInfo& out_node_info) {
   if (routing_table_.GetNodeInfo(node_id, out_node_info))
@@ -130,6 +310,16 @@ bool GroupChangeHandler::GetNodeInfo(const NodeId& node_id, const NodeId& connec
   return false;
 }
 
+bool GroupChangeHandler::GetNodeInfo(const NodeId& node_id, NodeInfo& out_node_info) {
+  if (routing_table_.GetNodeInfo(node_id, out_node_info))
+    return true;
+  auto nodes_info(client_routing_table_.GetNodesInfo(node_id));
+  if (nodes_info.empty())
+    return false;
+  out_node_info = nodes_info.front();
+  return true;
+}
+
 }  // namespace routing
 
 }  // namespace maidsafe
@@ -19,6 +19,10 @@
 #ifndef MAIDSAFE_ROUTING_GROUP_CHANGE_HANDLER_H_
 #define MAIDSAFE_ROUTING_GROUP_CHANGE_HANDLER_H_
 
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
 #include <vector>
 
 #include "maidsafe/common/node_id.h"
@@ -34,6 +38,7 @@ namespace routing {
 
 namespace test {
   class GenericNode;
+  class GroupChangeHandlerTest;
 }
 
 class RoutingTable;
@@ -51,18 +56,37 @@ class GroupChangeHandler {
   void UpdateGroupChange(const NodeId& node_id, std::vector<NodeInfo> close_nodes);
   void ClosestNodesUpdate(protobuf::Message& message);
   void SendSubscribeRpc(const bool& subscribe, const NodeInfo& node_info);
+  // Forgets what is known of a peer which has left the routing table.
+  void PeerRemoved(const NodeId& node_id);
 
   friend class test::GenericNode;
+  friend class test::GroupChangeHandlerTest;
  private:
   GroupChangeHandler(const GroupChangeHandler&);
   GroupChangeHandler& operator=(const GroupChangeHandler&);
 
   void Subscribe(const NodeId& node_id, const NodeId& connection_id);
   bool GetNodeInfo(const NodeId& node_id, const NodeId& connection_id, NodeInfo& out_node_info);
+  bool GetNodeInfo(const NodeId& node_id, NodeInfo& out_node_info);
+  void HandleClosestNodesUpdate(const protobuf::Message& message);
+  void HandleClosestNodesUpdateDelta(const NodeId& node_id,
+                                     const protobuf::ClosestNodesUpdate& closest_node_update);
+  void SendClosestNodesUpdateResync(const NodeId& node_id);
+  void SendFullClosestNodesUpdate(const NodeId& node_id);
 
   RoutingTable& routing_table_;
   ClientRoutingTable& client_routing_table_;
   NetworkUtils& network_;
+  std::mutex mutex_;
+  // Sender side: the close nodes and recipients of the last update, and its sequence number.
+  // Recipients of the last update are sent a delta, anyone else the full list.
+  std::vector<NodeInfo> last_closest_nodes_;
+  std::set<NodeId> last_update_recipients_;
+  uint32_t update_sequence_;
+  // Receiver side: the sequence number last applied for each peer's row.
+  std::map<NodeId, uint32_t> peer_update_sequences_;
+  // Peers which have said they understand delta updates.  Any other peer is sent the full list.
+  std::set<NodeId> delta_capable_peers_;
 };
 
 }  // namespace routing
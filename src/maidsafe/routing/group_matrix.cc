@@ -28,6 +28,7 @@
 #include "maidsafe/routing/parameters.h"
 #include "maidsafe/routing/node_info.h"
 #include "maidsafe/routing/return_codes.h"
+#include "maidsafe/routing/routing_log.h"
 #include "maidsafe/routing/utils.h"
 
 namespace maidsafe {
@@ -45,7 +46,8 @@ GroupMatrix::GroupMatrix(const NodeId& this_node_id, bool client_mode)
 
 std::shared_ptr<MatrixChange> GroupMatrix::AddConnectedPeer(const NodeInfo& node_info) {
   std::vector<NodeId> old_unique_ids(GetUniqueNodeIds());
-  LOG(kVerbose) << DebugId(kNodeId_) << " AddConnectedPeer : " << DebugId(node_info.node_id);
+  ROUTING_LOG(kVerbose) << DebugId(kNodeId_) << " AddConnectedPeer : "
+                        << DebugId(node_info.node_id);
   auto node_id(node_info.node_id);
   auto found(std::find_if(matrix_.begin(),
                           matrix_.end(),
@@ -53,7 +55,7 @@ std::shared_ptr<MatrixChange> GroupMatrix::AddConnectedPeer(const NodeInfo& node
                             return info.begin()->node_id == node_id;
                           }));
   if (found != matrix_.end()) {
-    LOG(kWarning) << "Already Added in matrix";
+    ROUTING_LOG(kWarning) << "Already Added in matrix";
     return std::make_shared<MatrixChange>(MatrixChange(kNodeId_, old_unique_ids, old_unique_ids));
   }
   matrix_.push_back(std::vector<NodeInfo>(1, node_info));
@@ -127,10 +129,10 @@ void GroupMatrix::GetBetterNodeForSendingMessage(const NodeId& target_node_id,
       }
     }
   }
-  LOG(kVerbose) << "[" << DebugId(kNodeId_)
-                << "]\ttarget: " << DebugId(target_node_id)
-                << "\tfound node in matrix: " << DebugId(closest_id)
-                << "\treccommend sending to: " << DebugId(current_closest_peer.node_id);
+  ROUTING_LOG(kVerbose) << "[" << DebugId(kNodeId_)
+                        << "]\ttarget: " << DebugId(target_node_id)
+                        << "\tfound node in matrix: " << DebugId(closest_id)
+                        << "\treccommend sending to: " << DebugId(current_closest_peer.node_id);
 }
 
 void GroupMatrix::GetBetterNodeForSendingMessage(const NodeId& target_node_id,
@@ -151,10 +153,10 @@ void GroupMatrix::GetBetterNodeForSendingMessage(const NodeId& target_node_id,
       }
     }
   }
-  LOG(kVerbose) << "[" << DebugId(kNodeId_)
-                << "]\ttarget: " << DebugId(target_node_id)
-                << "\tfound node in matrix: " << DebugId(closest_id)
-                << "\treccommend sending to: " << DebugId(current_closest_peer_id);
+  ROUTING_LOG(kVerbose) << "[" << DebugId(kNodeId_)
+                        << "]\ttarget: " << DebugId(target_node_id)
+                        << "\tfound node in matrix: " << DebugId(closest_id)
+                        << "\treccommend sending to: " << DebugId(current_closest_peer_id);
 }
 
 std::vector<NodeInfo> GroupMatrix::GetAllConnectedPeersFor(const NodeId& target_id) {
@@ -176,24 +178,27 @@ bool GroupMatrix::IsThisNodeGroupLeader(const NodeId& target_id, NodeId& connect
   if (client_mode_)
     return false;
 
-  LOG(kVerbose) << " Destination " << DebugId(target_id) << " kNodeId " << DebugId(kNodeId_);
+  ROUTING_LOG(kVerbose) << " Destination " << DebugId(target_id) << " kNodeId "
+                        << DebugId(kNodeId_);
   bool is_group_leader = true;
   if (unique_nodes_.empty()) {
     is_group_leader = true;
     return true;
   }
 
-  std::string log("unique_nodes_ for " + DebugId(kNodeId_) + " are ");
-  for (const auto& node : unique_nodes_) {
-    log += DebugId(node.node_id) + ", ";
+  if (ROUTING_LOG_ENABLED(kVerbose)) {
+    std::string log("unique_nodes_ for " + DebugId(kNodeId_) + " are ");
+    for (const auto& node : unique_nodes_) {
+      log += DebugId(node.node_id) + ", ";
+    }
+    ROUTING_LOG(kVerbose) << log;
   }
-  LOG(kVerbose) << log;
 
   for (const auto& node : unique_nodes_) {
     if (node.node_id == target_id)
       continue;
     if (NodeId::CloserToTarget(node.node_id, kNodeId_, target_id)) {
-      LOG(kVerbose) << DebugId(node.node_id) << " could be leader";
+      ROUTING_LOG(kVerbose) << DebugId(node.node_id) << " could be leader";
       is_group_leader = false;
       break;
     }
@@ -297,8 +302,8 @@ std::shared_ptr<MatrixChange> GroupMatrix::UpdateFromConnectedPeer(
   }
 
   if (group_itr == matrix_.end()) {
-    LOG(kWarning) << "Peer Node : " << DebugId(peer)
-                  << " is not in closest group of this node.";
+    ROUTING_LOG(kWarning) << "Peer Node : " << DebugId(peer)
+                          << " is not in closest group of this node.";
     return std::make_shared<MatrixChange>(MatrixChange(kNodeId_, old_unique_ids, old_unique_ids));
   }
 
@@ -315,6 +320,51 @@ std::shared_ptr<MatrixChange> GroupMatrix::UpdateFromConnectedPeer(
   return std::make_shared<MatrixChange>(MatrixChange(kNodeId_, old_unique_ids, GetUniqueNodeIds()));
 }
 
+std::shared_ptr<MatrixChange> GroupMatrix::PatchFromConnectedPeer(
+    const NodeId& peer,
+    const std::vector<NodeInfo>& added,
+    const std::vector<NodeId>& removed,
+    const std::vector<NodeId>& old_unique_ids) {
+  if (peer.IsZero()) {
+    assert(false && "Invalid peer node id.");
+    return nullptr;
+  }
+  auto group_itr(std::find_if(matrix_.begin(),
+                              matrix_.end(),
+                              [peer] (const std::vector<NodeInfo>& row) {
+                                return row.begin()->node_id == peer;
+                              }));
+  if (group_itr == matrix_.end()) {
+    ROUTING_LOG(kVerbose) << "Peer Node : " << DebugId(peer) << " has no row to patch.";
+    return nullptr;
+  }
+
+  // The first entry of a row is the peer itself and is never patched.
+  for (const auto& node_id : removed) {
+    group_itr->erase(std::remove_if(group_itr->begin() + 1,
+                                    group_itr->end(),
+                                    [&node_id] (const NodeInfo& node_info) {
+                                      return node_info.node_id == node_id;
+                                    }), group_itr->end());
+  }
+  for (const auto& node_info : added) {
+    auto entry_itr(std::find_if(group_itr->begin() + 1,
+                                group_itr->end(),
+                                [&node_info] (const NodeInfo& entry) {
+                                  return entry.node_id == node_info.node_id;
+                                }));
+    if (entry_itr != group_itr->end())
+      *entry_itr = node_info;
+    else
+      group_itr->push_back(node_info);
+  }
+  assert(group_itr->size() <= Parameters::max_routing_table_size);
+
+  Prune();
+  UpdateUniqueNodeList();
+  return std::make_shared<MatrixChange>(MatrixChange(kNodeId_, old_unique_ids, GetUniqueNodeIds()));
+}
+
 bool GroupMatrix::GetRow(const NodeId& row_id, std::vector<NodeInfo>& row_entries) {
   if (row_id.IsZero()) {
     assert(false && "Invalid node id.");
@@ -453,7 +503,7 @@ void GroupMatrix::Prune() {
       peers_to_remove.push_back(node_id);
   }
   for (auto& peer : peers_to_remove) {
-    LOG(kInfo) << DebugId(kNodeId_) << " matrix conected removes " << DebugId(peer);
+    ROUTING_LOG(kInfo) << DebugId(kNodeId_) << " matrix conected removes " << DebugId(peer);
     matrix_.erase(std::remove_if(matrix_.begin(),
                                  matrix_.end(),
                                  [peer] (const std::vector<NodeInfo>& row) {
@@ -473,7 +523,7 @@ void GroupMatrix::PrintGroupMatrix() {
       output.append(DebugId((*group_itr).at(i).node_id));
     }
   }
-  LOG(kVerbose) << output;
+  ROUTING_LOG(kVerbose) << output;
 }
 
 }  // namespace routing
@@ -76,6 +76,12 @@ class GroupMatrix {
   std::shared_ptr<MatrixChange> UpdateFromConnectedPeer(const NodeId& peer,
                                        const std::vector<NodeInfo>& nodes,
                                        const std::vector<NodeId>& old_unique_ids);
+  // Patches peer's row in place with a delta update.  Entries in added replace any entry with the
+  // same ID.  Returns nullptr if peer has no row, in which case a full update is needed.
+  std::shared_ptr<MatrixChange> PatchFromConnectedPeer(const NodeId& peer,
+                                                       const std::vector<NodeInfo>& added,
+                                                       const std::vector<NodeId>& removed,
+                                                       const std::vector<NodeId>& old_unique_ids);
   bool IsRowEmpty(const NodeInfo& node_info);
   bool GetRow(const NodeId& row_id, std::vector<NodeInfo>& row_entries);
   std::vector<NodeInfo> GetUniqueNodes() const;
@@ -0,0 +1,147 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_ROUTING_HANDLER_TRACKER_H_
+#define MAIDSAFE_ROUTING_HANDLER_TRACKER_H_
+
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+namespace maidsafe {
+
+namespace routing {
+
+// Counts the handlers an object has queued on an AsioService whose threads may outlive it, so that
+// the object can wait for them all to be run or discarded before its members are destroyed.  A
+// handler is counted from being wrapped until its last copy is destroyed, so one which asio drops
+// unrun (e.g. on a stopped service) is released too.
+//
+// WaitForAll mustn't be called from one of the tracker's own handlers, e.g. by a Routing object
+// whose last reference is released inside a functor it called, as that handler can't finish while
+// it waits.  Each thread counts the tracked handlers it is running, so such a call asserts, and in
+// release builds waits only for the tracker's other handlers rather than deadlocking.
+class HandlerTracker {
+ public:
+  template <typename Handler>
+  class TrackedHandler;
+
+  HandlerTracker() : mutex_(), condition_(), pending_(0) {}
+  template <typename Handler>
+  TrackedHandler<Handler> Wrap(Handler handler);
+  // Blocks until no handler wrapped by this tracker remains, other than any running on this thread.
+  void WaitForAll() {
+    size_t depth(RunningDepth());
+    assert(depth == 0 &&
+           "HandlerTracker::WaitForAll called from one of its own handlers, which would deadlock; "
+           "the owner is probably being destroyed from a callback it made");
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this, depth] { return pending_ <= depth; });
+  }
+  size_t pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pending_;
+  }
+
+ private:
+  class Token {
+   public:
+    explicit Token(HandlerTracker& tracker) : tracker_(tracker) {
+      std::lock_guard<std::mutex> lock(tracker_.mutex_);
+      ++tracker_.pending_;
+    }
+    ~Token() {
+      std::lock_guard<std::mutex> lock(tracker_.mutex_);
+      if (--tracker_.pending_ == 0)
+        tracker_.condition_.notify_all();
+    }
+
+   private:
+    Token(const Token&);
+    Token& operator=(const Token&);
+    HandlerTracker& tracker_;
+  };
+
+  // Marks a tracked handler as running on this thread for its lifetime.
+  class RunningScope {
+   public:
+    explicit RunningScope(const HandlerTracker& tracker) : tracker_(tracker) {
+      Running().push_back(&tracker_);
+    }
+    ~RunningScope() { Running().pop_back(); }
+
+   private:
+    RunningScope(const RunningScope&);
+    RunningScope& operator=(const RunningScope&);
+    const HandlerTracker& tracker_;
+  };
+
+  HandlerTracker(const HandlerTracker&);
+  HandlerTracker& operator=(const HandlerTracker&);
+
+  // The trackers whose handlers this thread is running, innermost last.
+  static std::vector<const HandlerTracker*>& Running() {
+    static thread_local std::vector<const HandlerTracker*> running;
+    return running;
+  }
+  size_t RunningDepth() const {
+    const std::vector<const HandlerTracker*>& running(Running());
+    return static_cast<size_t>(std::count(running.begin(), running.end(), this));
+  }
+
+  mutable std::mutex mutex_;
+  std::condition_variable condition_;
+  size_t pending_;
+};
+
+template <typename Handler>
+class HandlerTracker::TrackedHandler {
+ public:
+  TrackedHandler(Handler handler, const HandlerTracker& tracker, std::shared_ptr<Token> token)
+      : handler_(handler), tracker_(&tracker), token_(token) {}
+  void operator()() {
+    RunningScope scope(*tracker_);
+    handler_();
+  }
+  template <typename Argument>
+  void operator()(const Argument& argument) {
+    RunningScope scope(*tracker_);
+    handler_(argument);
+  }
+
+ private:
+  Handler handler_;
+  const HandlerTracker* tracker_;
+  std::shared_ptr<Token> token_;
+};
+
+template <typename Handler>
+HandlerTracker::TrackedHandler<Handler> HandlerTracker::Wrap(Handler handler) {
+  return TrackedHandler<Handler>(handler, *this, std::make_shared<Token>(*this));
+}
+
+}  // namespace routing
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_ROUTING_HANDLER_TRACKER_H_
@@ -0,0 +1,53 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/routing/live_tuning.h"
+
+#include <atomic>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+LiveTuning::LiveTuning() : current_(std::make_shared<Tuning>()) {}
+
+std::shared_ptr<const Tuning> LiveTuning::Get() const {
+  return std::atomic_load(&current_);
+}
+
+void LiveTuning::Set(const Tuning& tuning) {
+  if (tuning.response_timeout <= std::chrono::steady_clock::duration::zero() ||
+      tuning.find_node_interval <= std::chrono::seconds::zero() ||
+      tuning.recovery_time_lag <= std::chrono::seconds::zero() ||
+      tuning.re_bootstrap_time_lag <= boost::posix_time::time_duration() ||
+      tuning.find_close_node_interval <= boost::posix_time::time_duration() ||
+      tuning.negative_cache_ttl <= std::chrono::steady_clock::duration::zero()) {
+    LOG(kError) << "Invalid tuning: timeouts and intervals must be positive";
+    ThrowError(CommonErrors::invalid_parameter);
+  }
+  std::shared_ptr<const Tuning> updated(std::make_shared<Tuning>(tuning));
+  std::atomic_store(&current_, updated);
+}
+
+}  // namespace routing
+
+}  // namespace maidsafe
@@ -0,0 +1,53 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_ROUTING_LIVE_TUNING_H_
+#define MAIDSAFE_ROUTING_LIVE_TUNING_H_
+
+#include <memory>
+
+#include "maidsafe/routing/tuning.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+// Holds a node's Tuning so that it can be replaced while other threads read it.  Readers take a
+// snapshot, an immutable Tuning shared with the holder, which costs an atomic reference count
+// increment and stays consistent for as long as it is held.
+class LiveTuning {
+ public:
+  LiveTuning();
+  std::shared_ptr<const Tuning> Get() const;
+  // Throws CommonErrors::invalid_parameter, leaving the current values, if any timeout or interval
+  // in 'tuning' isn't positive.
+  void Set(const Tuning& tuning);
+
+ private:
+  LiveTuning(const LiveTuning&);
+  LiveTuning& operator=(const LiveTuning&);
+
+  std::shared_ptr<const Tuning> current_;
+};
+
+}  // namespace routing
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_ROUTING_LIVE_TUNING_H_
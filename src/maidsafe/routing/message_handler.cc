@@ -26,11 +26,13 @@
 #include "maidsafe/routing/client_routing_table.h"
 #include "maidsafe/routing/group_change_handler.h"
 #include "maidsafe/routing/message.h"
+#include "maidsafe/routing/metrics_registry.h"
 #include "maidsafe/routing/network_utils.h"
 #include "maidsafe/routing/routing.pb.h"
 #include "maidsafe/routing/routing_table.h"
 #include "maidsafe/routing/service.h"
 #include "maidsafe/routing/remove_furthest_node.h"
+#include "maidsafe/routing/routing_log.h"
 #include "maidsafe/routing/utils.h"
 
 
@@ -78,7 +80,8 @@ MessageHandler::MessageHandler(RoutingTable& routing_table,
                                Timer<std::string>& timer,
                                RemoveFurthestNode& remove_furthest_node,
                                GroupChangeHandler& group_change_handler,
-                               NetworkStatistics& network_statistics)
+                               NetworkStatistics& network_statistics,
+                               const LiveTuning& tuning)
     : routing_table_(routing_table),
       client_routing_table_(client_routing_table),
       network_statistics_(network_statistics),
@@ -87,13 +90,15 @@ MessageHandler::MessageHandler(RoutingTable& routing_table,
       group_change_handler_(group_change_handler),
       cache_manager_(routing_table_.client_mode() ? nullptr :
                                                     (new CacheManager(routing_table_.kNodeId(),
-                                                                      network_))),
+                                                                      network_, timer,
+                                                                      tuning))),
       timer_(timer),
       response_handler_(new ResponseHandler(routing_table, client_routing_table, network_,
-                                            group_change_handler)),
+                                            group_change_handler, timer)),
       service_(new Service(routing_table, client_routing_table, network_)),
       message_received_functor_(),
-      typed_message_received_functors_() {}
+      typed_message_received_functors_(),
+      message_trace_functor_() {}
 
 void MessageHandler::HandleRoutingMessage(protobuf::Message& message) {
   bool request(message.request());
@@ -147,19 +152,19 @@ void MessageHandler::HandleNodeLevelMessageForThisNode(protobuf::Message& messag
       (routing_table_.client_mode() &&
       (routing_table_.Contains(NodeId(message.source_id())) ||
        routing_table_.kNodeId().string() == message.source_id())))) {
-    LOG(kSuccess) << " [" << DebugId(routing_table_.kNodeId()) << "] rcvd : "
-                  << MessageTypeString(message) << " from "
-                  << HexSubstr(message.source_id())
-                  << "   (id: " << message.id() << ")  --NodeLevel--";
+    ROUTING_LOG(kSuccess) << " [" << DebugId(routing_table_.kNodeId()) << "] rcvd : "
+                          << MessageTypeString(message) << " from "
+                          << HexSubstr(message.source_id())
+                          << "   (id: " << message.id() << ")  --NodeLevel--";
     ReplyFunctor response_functor = [=](const std::string& reply_message) {
         if (reply_message.empty()) {
-          LOG(kInfo) << "Empty response for message id :" << message.id();
+          ROUTING_LOG(kInfo) << "Empty response for message id :" << message.id();
           return;
         }
-        LOG(kSuccess) << " [" << DebugId(routing_table_.kNodeId()) << "] repl : "
-                      << MessageTypeString(message) << " from "
-                      << HexSubstr(message.source_id())
-                      << "   (id: " << message.id() << ")  --NodeLevel Replied--";
+        ROUTING_LOG(kSuccess) << " [" << DebugId(routing_table_.kNodeId()) << "] repl : "
+                              << MessageTypeString(message) << " from "
+                              << HexSubstr(message.source_id())
+                              << "   (id: " << message.id() << ")  --NodeLevel Replied--";
         protobuf::Message message_out;
         message_out.set_request(false);
         message_out.set_hops_to_live(Parameters::hops_to_live);
@@ -172,10 +177,19 @@ void MessageHandler::HandleNodeLevelMessageForThisNode(protobuf::Message& messag
         message_out.add_data(reply_message);
         message_out.set_last_id(routing_table_.kNodeId().string());
         message_out.set_source_id(routing_table_.kNodeId().string());
-        if (message.has_id())
+        if (message.trace()) {
+          message_out.set_trace(true);
+          message_out.mutable_trace_hops()->CopyFrom(message.trace_hops());
+        }
+        if (IsCacheableGet(message)) {
+          message_out.set_cacheable(static_cast<int32_t>(Cacheable::kPut));
+          message_out.set_cache_name(message.destination_id());
+        }
+        if (message.has_id()) {
           message_out.set_id(message.id());
-        else
-          LOG(kInfo) << "Message to be sent back had no ID.";
+        } else {
+          ROUTING_LOG(kInfo) << "Message to be sent back had no ID.";
+        }
 
         if (message.has_relay_id())
           message_out.set_relay_id(message.relay_id());
@@ -191,7 +205,7 @@ void MessageHandler::HandleNodeLevelMessageForThisNode(protobuf::Message& messag
         if (routing_table_.kNodeId().string() != message_out.destination_id()) {
           network_.SendToClosestNode(message_out);
         } else {
-          LOG(kInfo) << "Sending response to self." << " id: " << message.id();
+          ROUTING_LOG(kInfo) << "Sending response to self." << " id: " << message.id();
           HandleMessage(message_out);
         }
     };
@@ -200,16 +214,18 @@ void MessageHandler::HandleNodeLevelMessageForThisNode(protobuf::Message& messag
     else
       InvokeTypedMessageReceivedFunctor(message);  // typed message received
   } else if (IsResponse(message)) {  // response
-    LOG(kInfo) << "[" << DebugId(routing_table_.kNodeId()) << "] rcvd : "
-               << MessageTypeString(message) << " from "
-               << HexSubstr(message.source_id())
-               << "   (id: " << message.id() << ")  --NodeLevel--";
+    ROUTING_LOG(kInfo) << "[" << DebugId(routing_table_.kNodeId()) << "] rcvd : "
+                       << MessageTypeString(message) << " from "
+                       << HexSubstr(message.source_id())
+                       << "   (id: " << message.id() << ")  --NodeLevel--";
+    if (message.trace() && message_trace_functor_)
+      message_trace_functor_(message.id(), GetTraceHops(message));
     try {
       if (!message.has_id() || message.data_size() == 1)
         ThrowError(CommonErrors::parsing_error);
       timer_.AddResponse(message.id(), message.data(0));
     } catch(const maidsafe_error& e) {
-      LOG(kError) << e.what();
+      ROUTING_LOG(kError) << e.what();
       return;
     }
     if (message.has_average_distace())
@@ -223,7 +239,8 @@ void MessageHandler::HandleMessageForThisNode(protobuf::Message& message) {
   if (RelayDirectMessageIfNeeded(message))
     return;
 
-  LOG(kVerbose) << "Message for this node." << " id: " << message.id();
+  ROUTING_LOG(kVerbose) << "Message for this node." << " id: " << message.id();
+  network_statistics_.metrics().MessageDelivered(message);
   if (IsRoutingMessage(message))
     HandleRoutingMessage(message);
   else
@@ -231,9 +248,9 @@ void MessageHandler::HandleMessageForThisNode(protobuf::Message& message) {
 }
 
 void MessageHandler::HandleMessageAsClosestNode(protobuf::Message& message) {
-  LOG(kVerbose) << "This node is in closest proximity to this message destination ID [ "
-                <<  HexSubstr(message.destination_id())
-                << " ]." << " id: " << message.id();
+  ROUTING_LOG(kVerbose) << "This node is in closest proximity to this message destination ID [ "
+                        <<  HexSubstr(message.destination_id())
+                        << " ]." << " id: " << message.id();
   if (IsDirect(message)) {
     return HandleDirectMessageAsClosestNode(message);
   } else {
@@ -254,13 +271,15 @@ void MessageHandler::HandleDirectMessageAsClosestNode(protobuf::Message& message
       message.set_visited(true);
       return network_.SendToClosestNode(message);
     } else {
-      LOG(kWarning) << "Dropping message. This node ["
-                    << DebugId(routing_table_.kNodeId())
-                    << "] is the closest but is not connected to destination node ["
-                    << HexSubstr(message.destination_id()) << "], Src ID: "
-                    << HexSubstr(message.source_id())
-                    << ", Relay ID: " << HexSubstr(message.relay_id()) << " id: " << message.id()
-                    << PrintMessage(message);
+      ROUTING_LOG(kWarning) << "Dropping message. This node ["
+                            << DebugId(routing_table_.kNodeId())
+                            << "] is the closest but is not connected to destination node ["
+                            << HexSubstr(message.destination_id()) << "], Src ID: "
+                            << HexSubstr(message.source_id())
+                            << ", Relay ID: " << HexSubstr(message.relay_id())
+                            << " id: " << message.id()
+                            << PrintMessage(message);
+      network_statistics_.metrics().MessageDropped(MetricsRegistry::DropReason::kNoRoute);
       return;
     }
   } else {
@@ -279,7 +298,7 @@ void MessageHandler::HandleGroupMessageAsClosestNode(protobuf::Message& message)
   // This node is not closest to the destination node for non-direct message.
   if (!routing_table_.IsThisNodeClosestTo(NodeId(message.destination_id()), !IsDirect(message)) &&
       !have_node_with_group_id) {
-    LOG(kInfo) << "This node is not closest, passing it on." << " id: " << message.id();
+    ROUTING_LOG(kInfo) << "This node is not closest, passing it on." << " id: " << message.id();
     // if (IsCacheableRequest(message))
     //   return HandleCacheLookup(message);  // forwarding message is done by cache manager
     // else if (IsCacheableResponse(message))
@@ -319,7 +338,7 @@ void MessageHandler::HandleGroupMessageAsClosestNode(protobuf::Message& message)
   // This node is closest so will send to all replicant nodes
   uint16_t replication(static_cast<uint16_t>(message.replication()));
   if ((replication < 1) || (replication > Parameters::node_group_size)) {
-    LOG(kError) << "Dropping invalid non-direct message." << " id: " << message.id();
+    ROUTING_LOG(kError) << "Dropping invalid non-direct message." << " id: " << message.id();
     return;
   }
 
@@ -347,13 +366,14 @@ void MessageHandler::HandleGroupMessageAsClosestNode(protobuf::Message& message)
 
   for (const auto& i : close_from_matrix)
     group_members+=std::string("[" + DebugId(i.node_id) +"]");
-  LOG(kInfo) << "Group nodes for group_id " << HexSubstr(group_id) << " : "
-             << group_members;
+  ROUTING_LOG(kInfo) << "Group nodes for group_id " << HexSubstr(group_id) << " : "
+                     << group_members;
 
   for (const auto& i : close_from_matrix) {
-    LOG(kInfo) << "[" << DebugId(own_node_id) << "] - "
-               << "Replicating message to : " << HexSubstr(i.node_id.string())
-               << " [ group_id : " << HexSubstr(group_id)  << "]" << " id: " << message.id();
+    ROUTING_LOG(kInfo) << "[" << DebugId(own_node_id) << "] - "
+                       << "Replicating message to : " << HexSubstr(i.node_id.string())
+                       << " [ group_id : " << HexSubstr(group_id)  << "]"
+                       << " id: " << message.id();
     message.set_destination_id(i.node_id.string());
     NodeInfo node;
     if (routing_table_.GetNodeInfo(i.node_id, node)) {
@@ -366,10 +386,10 @@ void MessageHandler::HandleGroupMessageAsClosestNode(protobuf::Message& message)
   message.set_destination_id(routing_table_.kNodeId().string());
 
   if (IsRoutingMessage(message)) {
-    LOG(kVerbose) << "HandleGroupMessageAsClosestNode if, msg id: " << message.id();
+    ROUTING_LOG(kVerbose) << "HandleGroupMessageAsClosestNode if, msg id: " << message.id();
     HandleRoutingMessage(message);
   } else {
-    LOG(kVerbose) << "HandleGroupMessageAsClosestNode else, msg id: " << message.id();
+    ROUTING_LOG(kVerbose) << "HandleGroupMessageAsClosestNode else, msg id: " << message.id();
     HandleNodeLevelMessageForThisNode(message);
   }
 }
@@ -380,16 +400,20 @@ void MessageHandler::HandleMessageAsFarNode(protobuf::Message& message) {
       !message.direct() &&
       !message.visited())
     message.set_visited(true);
-  LOG(kVerbose) << "[" << DebugId(routing_table_.kNodeId())
-                << "] is not in closest proximity to this message destination ID [ "
-                <<  HexSubstr(message.destination_id())
-                <<" ]; sending on." << " id: " << message.id();
+  ROUTING_LOG(kVerbose) << "[" << DebugId(routing_table_.kNodeId())
+                        << "] is not in closest proximity to this message destination ID [ "
+                        <<  HexSubstr(message.destination_id())
+                        <<" ]; sending on." << " id: " << message.id();
+  network_statistics_.metrics().Increment(MetricsRegistry::Counter::kForwarded);
   network_.SendToClosestNode(message);
 }
 
 void MessageHandler::HandleMessage(protobuf::Message& message) {
   if (!ValidateMessage(message)) {
-    LOG(kWarning) << "Validate message failed." << " id: " << message.id();
+    ROUTING_LOG(kWarning) << "Validate message failed." << " id: " << message.id();
+    network_statistics_.metrics().MessageDropped(
+        message.hops_to_live() > 0 ? MetricsRegistry::DropReason::kInvalidMessage :
+                                     MetricsRegistry::DropReason::kHopsExhausted);
     assert((message.hops_to_live() > 0) &&
            "Message has traversed maximum number of hops allowed");
     return;
@@ -402,6 +426,8 @@ void MessageHandler::HandleMessage(protobuf::Message& message) {
     return HandleCacheLookup(message);  // forwarding message is done by cache manager
   if (IsValidCacheablePut(message))
     StoreCacheCopy(message);  //  Upper layer should take this on seperate thread
+  if (cache_manager_ && cache_manager_->HandleCoalescedResponse(message))
+    return;
 
   // If group message request to self id
   if (IsGroupMessageRequestToSelfId(message))
@@ -417,8 +443,9 @@ void MessageHandler::HandleMessage(protobuf::Message& message) {
 
   // Invalid source id, unknown message
   if (NodeId(message.source_id()).IsZero()) {
-    LOG(kWarning) << "Stray message dropped, need valid source ID for processing."
-                  << " id: " << message.id();
+    ROUTING_LOG(kWarning) << "Stray message dropped, need valid source ID for processing."
+                          << " id: " << message.id();
+    network_statistics_.metrics().MessageDropped(MetricsRegistry::DropReason::kInvalidMessage);
     return;
   }
 
@@ -450,22 +477,22 @@ void MessageHandler::HandleMessageForNonRoutingNodes(protobuf::Message& message)
   if (IsRequest(message) &&
       (!message.client_node() ||
        (message.source_id() != message.destination_id()))) {
-    LOG(kWarning) << "This node ["
-                  << DebugId(routing_table_.kNodeId())
-                  << " Dropping message as non-client to client message not allowed."
-                  << PrintMessage(message);
+    ROUTING_LOG(kWarning) << "This node ["
+                          << DebugId(routing_table_.kNodeId())
+                          << " Dropping message as non-client to client message not allowed."
+                          << PrintMessage(message);
     return;
   }
-  LOG(kInfo) << "This node has message destination in its ClientRoutingTable. Dest id : "
-             << HexSubstr(message.destination_id()) << " message id: " << message.id();
+  ROUTING_LOG(kInfo) << "This node has message destination in its ClientRoutingTable. Dest id : "
+                     << HexSubstr(message.destination_id()) << " message id: " << message.id();
   return network_.SendToClosestNode(message);
 }
 
 void MessageHandler::HandleRelayRequest(protobuf::Message& message) {
   assert(!message.has_source_id());
   if ((message.destination_id() == routing_table_.kNodeId().string()) && IsRequest(message)) {
-    LOG(kVerbose) << "Relay request with this node's ID as destination ID"
-                  << " id: " << message.id();
+    ROUTING_LOG(kVerbose) << "Relay request with this node's ID as destination ID"
+                          << " id: " << message.id();
     // If group message request to this node's id sent by relay requester node
     if ((message.destination_id() == routing_table_.kNodeId().string()) &&
         message.request() && !message.direct()) {
@@ -501,13 +528,15 @@ void MessageHandler::HandleDirectRelayRequestMessageAsClosestNode(protobuf::Mess
       message.set_source_id(routing_table_.kNodeId().string());
       return network_.SendToClosestNode(message);
     } else {
-      LOG(kWarning) << "Dropping message. This node ["
-                    << DebugId(routing_table_.kNodeId())
-                    << "] is the closest but is not connected to destination node ["
-                    << HexSubstr(message.destination_id()) << "], Src ID: "
-                    << HexSubstr(message.source_id())
-                    << ", Relay ID: " << HexSubstr(message.relay_id()) << " id: " << message.id()
-                    << PrintMessage(message);
+      ROUTING_LOG(kWarning) << "Dropping message. This node ["
+                            << DebugId(routing_table_.kNodeId())
+                            << "] is the closest but is not connected to destination node ["
+                            << HexSubstr(message.destination_id()) << "], Src ID: "
+                            << HexSubstr(message.source_id())
+                            << ", Relay ID: " << HexSubstr(message.relay_id())
+                            << " id: " << message.id()
+                            << PrintMessage(message);
+      network_statistics_.metrics().MessageDropped(MetricsRegistry::DropReason::kNoRoute);
       return;
     }
   } else {
@@ -521,7 +550,7 @@ void MessageHandler::HandleGroupRelayRequestMessageAsClosestNode(protobuf::Messa
   // This node is not closest to the destination node for non-direct message.
   if (!routing_table_.IsThisNodeClosestTo(NodeId(message.destination_id()), !IsDirect(message)) &&
       !have_node_with_group_id) {
-    LOG(kInfo) << "This node is not closest, passing it on." << " id: " << message.id();
+    ROUTING_LOG(kInfo) << "This node is not closest, passing it on." << " id: " << message.id();
     message.set_source_id(routing_table_.kNodeId().string());
     return network_.SendToClosestNode(message);
   }
@@ -540,7 +569,7 @@ void MessageHandler::HandleGroupRelayRequestMessageAsClosestNode(protobuf::Messa
   // This node is closest so will send to all replicant nodes
   uint16_t replication(static_cast<uint16_t>(message.replication()));
   if ((replication < 1) || (replication > Parameters::node_group_size)) {
-    LOG(kError) << "Dropping invalid non-direct message." << " id: " << message.id();
+    ROUTING_LOG(kError) << "Dropping invalid non-direct message." << " id: " << message.id();
     return;
   }
 
@@ -557,13 +586,14 @@ void MessageHandler::HandleGroupRelayRequestMessageAsClosestNode(protobuf::Messa
 
   for (const auto& i : close)
     group_members+=std::string("[" + DebugId(i) +"]");
-  LOG(kInfo) << "Group members for group_id " << HexSubstr(group_id) << " are: "
-             << group_members;
+  ROUTING_LOG(kInfo) << "Group members for group_id " << HexSubstr(group_id) << " are: "
+                     << group_members;
   // This node relays back the responses
   message.set_source_id(routing_table_.kNodeId().string());
   for (const auto& i : close) {
-    LOG(kInfo) << "Replicating message to : " << HexSubstr(i.string())
-               << " [ group_id : " << HexSubstr(group_id)  << "]" << " id: " << message.id();
+    ROUTING_LOG(kInfo) << "Replicating message to : " << HexSubstr(i.string())
+                       << " [ group_id : " << HexSubstr(group_id)  << "]"
+                       << " id: " << message.id();
     message.set_destination_id(i.string());
     NodeInfo node;
     if (routing_table_.GetNodeInfo(i, node)) {
@@ -583,7 +613,7 @@ void MessageHandler::HandleGroupRelayRequestMessageAsClosestNode(protobuf::Messa
 bool MessageHandler::IsRelayResponseForThisNode(protobuf::Message& message) {
   if (IsRoutingMessage(message) && message.has_relay_id() &&
       (message.relay_id() == routing_table_.kNodeId().string())) {
-    LOG(kVerbose) << "Relay response through alternative route";
+    ROUTING_LOG(kVerbose) << "Relay response through alternative route";
     return true;
   } else {
     return false;
@@ -600,8 +630,8 @@ bool MessageHandler::RelayDirectMessageIfNeeded(protobuf::Message& message) {
   // Only direct responses need to be relayed
   if ((message.destination_id() != message.relay_id()) && IsResponse(message)) {
     message.clear_destination_id();  // to allow network util to identify it as relay message
-    LOG(kVerbose) << "Relaying response to " << HexSubstr(message.relay_id())
-                  << " id: " << message.id();
+    ROUTING_LOG(kVerbose) << "Relaying response to " << HexSubstr(message.relay_id())
+                          << " id: " << message.id();
     network_.SendToClosestNode(message);
     return true;
   } else {  // not a relay message response, its for this node
@@ -613,13 +643,13 @@ bool MessageHandler::RelayDirectMessageIfNeeded(protobuf::Message& message) {
 void MessageHandler::HandleClientMessage(protobuf::Message& message) {
   assert(routing_table_.client_mode() && "Only client node should handle client messages");
   if (message.source_id().empty()) {  // No relays allowed on client.
-    LOG(kWarning) << "Stray message at client node. No relays allowed."
-                  << " id: " << message.id();
+    ROUTING_LOG(kWarning) << "Stray message at client node. No relays allowed."
+                          << " id: " << message.id();
     return;
   }
   if (IsRoutingMessage(message)) {
-    LOG(kVerbose) << "Client Routing Response for " << DebugId(routing_table_.kNodeId())
-                  << " from " << HexSubstr(message.source_id()) << " id: " << message.id();
+    ROUTING_LOG(kVerbose) << "Client Routing Response for " << DebugId(routing_table_.kNodeId())
+                          << " from " << HexSubstr(message.source_id()) << " id: " << message.id();
     HandleRoutingMessage(message);
   } else if ((message.destination_id() == routing_table_.kNodeId().string())) {
     HandleNodeLevelMessageForThisNode(message);
@@ -639,7 +669,8 @@ void MessageHandler::HandleGroupMessageToSelfId(protobuf::Message& message) {
   assert(message.destination_id() == routing_table_.kNodeId().string());
   assert(message.request());
   assert(!message.direct());
-  LOG(kInfo) << "Sending group message to self id. Passing on to the closest peer to replicate";
+  ROUTING_LOG(kInfo) << "Sending group message to self id. Passing on to the closest peer to "
+                     << "replicate";
   network_.SendToClosestNode(message);
 }
 
@@ -681,6 +712,15 @@ void MessageHandler::set_request_public_key_functor(
   service_->set_request_public_key_functor(request_public_key_functor);
 }
 
+void MessageHandler::set_message_trace_functor(MessageTraceFunctor message_trace_functor) {
+  message_trace_functor_ = message_trace_functor;
+}
+
+void MessageHandler::ConnectToPeers(const std::vector<NodeId>& peers,
+                                    const std::map<NodeId, std::string>& public_key_digests) {
+  response_handler_->ConnectToPeers(peers, public_key_digests);
+}
+
 void MessageHandler::HandleCacheLookup(protobuf::Message& message) {
   assert(!routing_table_.client_mode());
   assert(IsCacheableGet(message));
@@ -702,7 +742,7 @@ bool MessageHandler::IsValidCacheableGet(const protobuf::Message& message) {
 bool MessageHandler::IsValidCacheablePut(const protobuf::Message& message) {
   // TODO(Prakash): need to differentiate between typed and un typed api
   return (IsNodeLevelMessage(message) && Parameters::caching && !routing_table_.client_mode() &&
-          IsCacheablePut(message) && !IsRequest(message));
+          IsCacheablePut(message) && !IsRequest(message) && cache_manager_->ShouldCache(message));
 }
 
 }  // namespace routing
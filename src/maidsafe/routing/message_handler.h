@@ -19,7 +19,9 @@
 #ifndef MAIDSAFE_ROUTING_MESSAGE_HANDLER_H_
 #define MAIDSAFE_ROUTING_MESSAGE_HANDLER_H_
 
+#include <map>
 #include <string>
+#include <vector>
 
 #include "maidsafe/rudp/managed_connections.h"
 
@@ -61,6 +63,7 @@ class RoutingTable;
 class RemoveFurthestNode;
 class GroupChangeHandler;
 class NetworkStatistics;
+class LiveTuning;
 
 
 enum class MessageType : int32_t {
@@ -84,11 +87,15 @@ class MessageHandler {
                  Timer<std::string>& timer,
                  RemoveFurthestNode& remove_node,
                  GroupChangeHandler& group_change_handler,
-                 NetworkStatistics& network_statistics);
+                 NetworkStatistics& network_statistics,
+                 const LiveTuning& tuning);
   void HandleMessage(protobuf::Message& message);
   void set_typed_message_and_caching_functor(TypedMessageAndCachingFunctor functors);
   void set_message_and_caching_functor(MessageAndCachingFunctors functors);
   void set_request_public_key_functor(RequestPublicKeyFunctor request_public_key_functor);
+  void set_message_trace_functor(MessageTraceFunctor message_trace_functor);
+  void ConnectToPeers(const std::vector<NodeId>& peers,
+                      const std::map<NodeId, std::string>& public_key_digests);
 
  private:
   MessageHandler(const MessageHandler&);
@@ -135,6 +142,7 @@ class MessageHandler {
   std::shared_ptr<Service> service_;
   MessageReceivedFunctor message_received_functor_;
   detail::TypedMessageRecievedFunctors typed_message_received_functors_;
+  MessageTraceFunctor message_trace_functor_;
 };
 
 }  // namespace routing
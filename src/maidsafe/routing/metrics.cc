@@ -0,0 +1,90 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/routing/metrics.h"
+
+#include <algorithm>
+
+
+namespace maidsafe {
+
+namespace routing {
+
+uint64_t HistogramSnapshot::Percentile(double fraction) const {
+  if (count == 0 || buckets.empty())
+    return 0;
+  fraction = std::min(std::max(fraction, 0.0), 1.0);
+  uint64_t rank(static_cast<uint64_t>(fraction * static_cast<double>(count - 1)));
+  uint64_t seen(0);
+  for (const auto& bucket : buckets) {
+    seen += bucket.second;
+    if (rank < seen)
+      return bucket.first;
+  }
+  return buckets.back().first;
+}
+
+Histogram::Histogram() : count_(0), sum_(0), max_(0) {
+  for (auto& count : counts_)
+    count.store(0, std::memory_order_relaxed);
+}
+
+void Histogram::Record(uint64_t value) {
+  counts_[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(value, std::memory_order_relaxed);
+  uint64_t max(max_.load(std::memory_order_relaxed));
+  while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {}
+}
+
+HistogramSnapshot Histogram::Snapshot() const {
+  HistogramSnapshot snapshot;
+  for (size_t i(0); i != kBucketCount; ++i) {
+    uint64_t count(counts_[i].load(std::memory_order_relaxed));
+    if (count != 0) {
+      snapshot.buckets.push_back(std::make_pair(BucketLowerBound(i), count));
+      snapshot.count += count;
+    }
+  }
+  snapshot.sum = sum_.load(std::memory_order_relaxed);
+  snapshot.max = max_.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+size_t Histogram::BucketIndex(uint64_t value) {
+  if (value < kSubBucketCount)
+    return static_cast<size_t>(value);
+  int exponent(0);  // position of the highest set bit
+  for (int shift(32); shift != 0; shift /= 2) {
+    if (value >> (exponent + shift))
+      exponent += shift;
+  }
+  size_t sub_bucket((value >> (exponent - kSubBucketBits)) & (kSubBucketCount - 1));
+  return (exponent - kSubBucketBits + 1) * kSubBucketCount + sub_bucket;
+}
+
+uint64_t Histogram::BucketLowerBound(size_t index) {
+  if (index < kSubBucketCount)
+    return index;
+  size_t group(index / kSubBucketCount), sub_bucket(index % kSubBucketCount);
+  return static_cast<uint64_t>(kSubBucketCount + sub_bucket) << (group - 1);
+}
+
+}  // namespace routing
+
+}  // namespace maidsafe
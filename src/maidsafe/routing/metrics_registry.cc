@@ -0,0 +1,145 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/routing/metrics_registry.h"
+
+#include <functional>
+#include <string>
+#include <thread>
+
+#include "maidsafe/routing/message_handler.h"
+#include "maidsafe/routing/parameters.h"
+#include "maidsafe/routing/routing.pb.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace {
+
+const char* const kDropReasonNames[] = {
+  "parse_failure",
+  "authentication_failure",
+  "invalid_message",
+  "hops_exhausted",
+  "no_route"
+};
+
+}  // unnamed namespace
+
+MetricsRegistry::MetricsRegistry() : hop_counts_(), matrix_update_sizes_() {
+  static_assert(sizeof(kDropReasonNames) / sizeof(kDropReasonNames[0]) == kDropReasonCount,
+                "Every drop reason needs a name.");
+  for (auto& shard : shards_) {
+    for (auto& slot : shard.slots)
+      slot.store(0, std::memory_order_relaxed);
+  }
+}
+
+void MetricsRegistry::Increment(Counter counter) {
+  Add(static_cast<size_t>(counter));
+}
+
+void MetricsRegistry::MessageReceived(const protobuf::Message& message) {
+  Add(kCounterCount + kDropReasonCount + TypeSlot(message.type()));
+}
+
+void MetricsRegistry::MessageSent(const protobuf::Message& message, size_t bytes) {
+  size_t type_slot(TypeSlot(message.type()));
+  Add(kCounterCount + kDropReasonCount + kMessageTypeSlots + type_slot);
+  Add(kCounterCount + kDropReasonCount + 2 * kMessageTypeSlots + type_slot, bytes);
+}
+
+void MetricsRegistry::MessageDropped(DropReason reason) {
+  Add(kCounterCount + static_cast<size_t>(reason));
+}
+
+void MetricsRegistry::MessageDelivered(const protobuf::Message& message) {
+  Add(static_cast<size_t>(Counter::kDelivered));
+  if (message.has_hops_to_live() && message.hops_to_live() < Parameters::hops_to_live)
+    hop_counts_.Record(static_cast<uint64_t>(Parameters::hops_to_live - message.hops_to_live()));
+}
+
+void MetricsRegistry::MatrixUpdated(size_t entry_count) {
+  matrix_update_sizes_.Record(static_cast<uint64_t>(entry_count));
+}
+
+RoutingMetrics MetricsRegistry::Snapshot() const {
+  RoutingMetrics metrics;
+  metrics.messages_forwarded = Total(static_cast<size_t>(Counter::kForwarded));
+  metrics.messages_delivered = Total(static_cast<size_t>(Counter::kDelivered));
+  metrics.send_retries = Total(static_cast<size_t>(Counter::kSendRetries));
+  metrics.nodes_added = Total(static_cast<size_t>(Counter::kNodesAdded));
+  metrics.nodes_dropped = Total(static_cast<size_t>(Counter::kNodesDropped));
+  metrics.matrix_changes_notified = Total(static_cast<size_t>(Counter::kMatrixChangesNotified));
+  metrics.route_cache_hits = Total(static_cast<size_t>(Counter::kRouteCacheHits));
+  metrics.route_cache_misses = Total(static_cast<size_t>(Counter::kRouteCacheMisses));
+  for (size_t i(0); i != kDropReasonCount; ++i) {
+    uint64_t total(Total(kCounterCount + i));
+    if (total != 0)
+      metrics.messages_dropped[kDropReasonNames[i]] = total;
+  }
+  for (size_t i(0); i != kMessageTypeSlots; ++i) {
+    uint64_t received(Total(kCounterCount + kDropReasonCount + i));
+    if (received != 0)
+      metrics.messages_received[SlotType(i)] = received;
+    uint64_t sent(Total(kCounterCount + kDropReasonCount + kMessageTypeSlots + i));
+    if (sent != 0) {
+      metrics.messages_sent[SlotType(i)] = sent;
+      metrics.bytes_sent[SlotType(i)] =
+          Total(kCounterCount + kDropReasonCount + 2 * kMessageTypeSlots + i);
+    }
+  }
+  metrics.hop_counts = hop_counts_.Snapshot();
+  metrics.matrix_update_sizes = matrix_update_sizes_.Snapshot();
+  return metrics;
+}
+
+void MetricsRegistry::Add(size_t slot, uint64_t amount) {
+  size_t shard(std::hash<std::thread::id>()(std::this_thread::get_id()) % kShardCount);
+  shards_[shard].slots[slot].fetch_add(amount, std::memory_order_relaxed);
+}
+
+uint64_t MetricsRegistry::Total(size_t slot) const {
+  uint64_t total(0);
+  for (const auto& shard : shards_)
+    total += shard.slots[slot].load(std::memory_order_relaxed);
+  return total;
+}
+
+size_t MetricsRegistry::TypeSlot(int32_t type) {
+  if (type >= static_cast<int32_t>(MessageType::kPing) &&
+      type <= static_cast<int32_t>(MessageType::kGetGroup))
+    return static_cast<size_t>(type - 1);
+  if (type == static_cast<int32_t>(MessageType::kNodeLevel))
+    return kMessageTypeSlots - 2;
+  return kMessageTypeSlots - 1;
+}
+
+int32_t MetricsRegistry::SlotType(size_t type_slot) {
+  if (type_slot < kMessageTypeSlots - 2)
+    return static_cast<int32_t>(type_slot + 1);
+  if (type_slot == kMessageTypeSlots - 2)
+    return static_cast<int32_t>(MessageType::kNodeLevel);
+  return 0;
+}
+
+}  // namespace routing
+
+}  // namespace maidsafe
@@ -0,0 +1,99 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_ROUTING_METRICS_REGISTRY_H_
+#define MAIDSAFE_ROUTING_METRICS_REGISTRY_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "maidsafe/routing/metrics.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace protobuf { class Message; }
+
+// A node's routing metrics.  Counters are spread over a few cache-line-sized shards, picked by
+// thread, so threads counting the same event rarely contend; all updates are relaxed atomics.
+class MetricsRegistry {
+ public:
+  enum class Counter {
+    kForwarded,
+    kDelivered,
+    kSendRetries,
+    kNodesAdded,
+    kNodesDropped,
+    kMatrixChangesNotified,
+    kRouteCacheHits,
+    kRouteCacheMisses,
+    kCount
+  };
+  enum class DropReason {
+    kParseFailure,
+    kAuthenticationFailure,
+    kInvalidMessage,
+    kHopsExhausted,
+    kNoRoute,
+    kCount
+  };
+
+  MetricsRegistry();
+  void Increment(Counter counter);
+  void MessageReceived(const protobuf::Message& message);
+  // 'bytes' is the size of the message as sent, including any authentication.
+  void MessageSent(const protobuf::Message& message, size_t bytes);
+  void MessageDropped(DropReason reason);
+  // Records a message delivered to this node, and the hops it took.
+  void MessageDelivered(const protobuf::Message& message);
+  void MatrixUpdated(size_t entry_count);
+  // Everything except the Timer's figures, which Routing adds.
+  RoutingMetrics Snapshot() const;
+
+ private:
+  // Routing message types 1 to 8 by type, then node level, then anything else.
+  static const size_t kMessageTypeSlots = 10;
+  static const size_t kCounterCount = static_cast<size_t>(Counter::kCount);
+  static const size_t kDropReasonCount = static_cast<size_t>(DropReason::kCount);
+  // Slots for received, sent and bytes sent per message type follow the counters and drops.
+  static const size_t kSlotCount = kCounterCount + kDropReasonCount + 3 * kMessageTypeSlots;
+  static const size_t kShardCount = 8;
+  static const size_t kCacheLineSize = 64;
+  struct Shard {
+    std::atomic<uint64_t> slots[kSlotCount];
+    char padding[kCacheLineSize - (kSlotCount * sizeof(uint64_t)) % kCacheLineSize];
+  };
+
+  MetricsRegistry(const MetricsRegistry&);
+  MetricsRegistry& operator=(const MetricsRegistry&);
+  void Add(size_t slot, uint64_t amount = 1);
+  uint64_t Total(size_t slot) const;
+  static size_t TypeSlot(int32_t type);
+  static int32_t SlotType(size_t type_slot);
+
+  Shard shards_[kShardCount];
+  Histogram hop_counts_, matrix_update_sizes_;
+};
+
+}  // namespace routing
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_ROUTING_METRICS_REGISTRY_H_
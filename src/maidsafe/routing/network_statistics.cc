@@ -31,7 +31,8 @@ NetworkStatistics::NetworkStatistics(const NodeId& node_id)
     :  mutex_(),
        kNodeId_(node_id),
        distance_(),
-       network_distance_data_() {}
+       network_distance_data_(),
+       metrics_() {}
 
 void NetworkStatistics::UpdateLocalAverageDistance(std::vector<NodeId>& unique_nodes) {
   if (unique_nodes.size() < Parameters::node_group_size)
@@ -82,6 +83,10 @@ NodeId NetworkStatistics::GetDistance() {
   return distance_;
 }
 
+MetricsRegistry& NetworkStatistics::metrics() {
+  return metrics_;
+}
+
 }  // namespace routing
 
 }  // namespace maidsafe
@@ -24,6 +24,7 @@
 #include "maidsafe/common/crypto.h"
 
 #include "maidsafe/common/node_id.h"
+#include "maidsafe/routing/metrics_registry.h"
 #include "maidsafe/routing/node_info.h"
 
 
@@ -43,6 +44,7 @@ class NetworkStatistics {
   void UpdateNetworkAverageDistance(const NodeId& distance);
   bool EstimateInGroup(const NodeId& sender_id, const NodeId& info_id);
   NodeId GetDistance();
+  MetricsRegistry& metrics();
 
   friend class test::NetworkStatisticsTest_BEH_AverageDistance_Test;
   friend class test::NetworkStatisticsTest_BEH_IsIdInGroupRange_Test;
@@ -59,6 +61,7 @@ class NetworkStatistics {
   const NodeId kNodeId_;
   NodeId distance_;
   NetworkDistanceData network_distance_data_;
+  MetricsRegistry metrics_;
 };
 
 }  // namespace routing
@@ -18,6 +18,9 @@
 
 #include "maidsafe/routing/network_utils.h"
 
+#include <algorithm>
+#include <chrono>
+
 #include "boost/date_time/posix_time/posix_time_config.hpp"
 
 #include "maidsafe/common/log.h"
@@ -26,9 +29,11 @@
 
 #include "maidsafe/routing/bootstrap_file_handler.h"
 #include "maidsafe/routing/client_routing_table.h"
+#include "maidsafe/routing/metrics_registry.h"
 #include "maidsafe/routing/parameters.h"
 #include "maidsafe/routing/return_codes.h"
 #include "maidsafe/routing/routing.pb.h"
+#include "maidsafe/routing/routing_log.h"
 #include "maidsafe/routing/routing_table.h"
 #include "maidsafe/routing/utils.h"
 
@@ -51,13 +56,19 @@ NetworkUtils::NetworkUtils(RoutingTable& routing_table, ClientRoutingTable& clie
       running_mutex_(),
       bootstrap_attempt_(0),
       bootstrap_endpoints_(),
+      bootstrap_contacts_(),
       bootstrap_connection_id_(),
       this_node_relay_connection_id_(),
       routing_table_(routing_table),
       client_routing_table_(client_routing_table),
       nat_type_(rudp::NatType::kUnknown),
       new_bootstrap_endpoint_(),
-      rudp_() {}
+      peer_endpoints_mutex_(),
+      peer_endpoints_(),
+      session_keys_(routing_table.kConnectionId()),
+      transport_created_(),
+      transport_(),
+      signature_verifier_(Parameters::signature_verification_threads) {}
 
 NetworkUtils::~NetworkUtils() {
   std::lock_guard<std::mutex> lock(running_mutex_);
@@ -65,7 +76,7 @@ NetworkUtils::~NetworkUtils() {
 }
 
 int NetworkUtils::Bootstrap(const std::vector<Endpoint>& bootstrap_endpoints,
-                            const rudp::MessageReceivedFunctor& message_received_functor,
+                            const MessageReceivedFromFunctor& message_received_functor,
                             const rudp::ConnectionLostFunctor& connection_lost_functor,
                             Endpoint local_endpoint) {
   {
@@ -79,11 +90,19 @@ int NetworkUtils::Bootstrap(const std::vector<Endpoint>& bootstrap_endpoints,
   auto private_key(std::make_shared<asymm::PrivateKey>(routing_table_.kPrivateKey()));
   auto public_key(std::make_shared<asymm::PublicKey>(routing_table_.kPublicKey()));
 
-  if (!bootstrap_endpoints.empty())
-    bootstrap_endpoints_ = bootstrap_endpoints;
+  // Given endpoints go ahead of those from earlier calls, which are kept for re-bootstrapping.
+  if (!bootstrap_endpoints.empty()) {
+    std::vector<Endpoint> merged_endpoints(bootstrap_endpoints);
+    for (const auto& endpoint : bootstrap_endpoints_) {
+      if (std::find(merged_endpoints.begin(), merged_endpoints.end(), endpoint) ==
+          merged_endpoints.end())
+        merged_endpoints.push_back(endpoint);
+    }
+    bootstrap_endpoints_.swap(merged_endpoints);
+  }
 
   if (Parameters::append_maidsafe_endpoints && bootstrap_attempt_ == 0) {
-    LOG(kInfo) << "Appending Maidsafe Endpoints";
+    ROUTING_LOG(kInfo) << "Appending Maidsafe Endpoints";
     std::vector<Endpoint> maidsafe_endpoints(MaidSafeEndpoints());
     bootstrap_endpoints_.insert(bootstrap_endpoints_.end(), maidsafe_endpoints.begin(),
                                 maidsafe_endpoints.end());
@@ -95,31 +114,51 @@ int NetworkUtils::Bootstrap(const std::vector<Endpoint>& bootstrap_endpoints,
 
   if (Parameters::append_local_live_port_endpoint && bootstrap_attempt_ == 0) {
     bootstrap_endpoints_.push_back(Endpoint(GetLocalIp(), kLivePort));
-    LOG(kInfo) << "Appending local live port endpoints: " << bootstrap_endpoints_.back();
+    ROUTING_LOG(kInfo) << "Appending local live port endpoints: " << bootstrap_endpoints_.back();
   }
 
   if (bootstrap_endpoints_.empty())
     return kInvalidBootstrapContacts;
 
-  int result(rudp_.Bootstrap(/* sorted_ */bootstrap_endpoints_,
-                             message_received_functor,
-                             connection_lost_functor,
-                             routing_table_.kConnectionId(),
-                             private_key,
-                             public_key,
-                             bootstrap_connection_id_,
-                             nat_type_,
-                             local_endpoint));
+  // rudp handles one bootstrap at a time, trying its endpoints in turn.  The best ranked endpoints
+  // are given to it singly so that each one's outcome and latency can be recorded.
+  std::vector<Endpoint> ranked_endpoints(bootstrap_contacts_.Rank(bootstrap_endpoints_));
+  size_t ranked_attempts(std::min(ranked_endpoints.size(),
+                                  static_cast<size_t>(Parameters::ranked_bootstrap_attempts)));
+  int result(kNoOnlineBootstrapContacts);
+  for (size_t i(0); i <= ranked_attempts && result != kSuccess; ++i) {
+    std::vector<Endpoint> endpoints;
+    if (i < ranked_attempts)
+      endpoints.push_back(ranked_endpoints.at(i));
+    else
+      endpoints.assign(ranked_endpoints.begin() + ranked_attempts, ranked_endpoints.end());
+    if (endpoints.empty())
+      break;
+    auto start_time(std::chrono::steady_clock::now());
+    result = transport().Bootstrap(endpoints,
+                                   message_received_functor,
+                                   connection_lost_functor,
+                                   routing_table_.kConnectionId(),
+                                   private_key,
+                                   public_key,
+                                   bootstrap_connection_id_,
+                                   nat_type_,
+                                   local_endpoint);
+    if (i < ranked_attempts) {
+      bootstrap_contacts_.AddResult(endpoints.front(), result == kSuccess,
+                                    std::chrono::steady_clock::now() - start_time);
+    }
+  }
   ++bootstrap_attempt_;
   // RUDP will return a kZeroId for zero state !!
   if (result != kSuccess || bootstrap_connection_id_.IsZero()) {
-    LOG(kError) << "No Online Bootstrap Node found.";
+    ROUTING_LOG(kError) << "No Online Bootstrap Node found.";
     return kNoOnlineBootstrapContacts;
   }
 
   this_node_relay_connection_id_ = routing_table_.kConnectionId();
-  LOG(kInfo) << "Bootstrap successful, bootstrap connection id - "
-             << DebugId(bootstrap_connection_id_);
+  ROUTING_LOG(kInfo) << "Bootstrap successful, bootstrap connection id - "
+                     << DebugId(bootstrap_connection_id_);
   return kSuccess;
 }
 
@@ -132,7 +171,8 @@ int NetworkUtils::GetAvailableEndpoint(const NodeId& peer_id,
     if (!running_)
       return kNetworkShuttingDown;
   }
-  return rudp_.GetAvailableEndpoint(peer_id, peer_endpoint_pair, this_endpoint_pair, this_nat_type);
+  return transport().GetAvailableEndpoint(peer_id, peer_endpoint_pair, this_endpoint_pair,
+                                          this_nat_type);
 }
 
 int NetworkUtils::Add(const NodeId& peer_id,
@@ -143,7 +183,12 @@ int NetworkUtils::Add(const NodeId& peer_id,
     if (!running_)
       return kNetworkShuttingDown;
   }
-  return rudp_.Add(peer_id, peer_endpoint_pair, validation_data);
+  int result(transport().Add(peer_id, peer_endpoint_pair, validation_data));
+  if (result == kSuccess) {
+    std::lock_guard<std::mutex> lock(peer_endpoints_mutex_);
+    peer_endpoints_[peer_id] = peer_endpoint_pair;
+  }
+  return result;
 }
 
 int NetworkUtils::MarkConnectionAsValid(const NodeId& peer_id) {
@@ -153,9 +198,9 @@ int NetworkUtils::MarkConnectionAsValid(const NodeId& peer_id) {
       return kNetworkShuttingDown;
   }
   Endpoint new_bootstrap_endpoint;
-  int ret_val(rudp_.MarkConnectionAsValid(peer_id, new_bootstrap_endpoint));
+  int ret_val(transport().MarkConnectionAsValid(peer_id, new_bootstrap_endpoint));
   if ((ret_val == kSuccess) && !new_bootstrap_endpoint.address().is_unspecified()) {
-    LOG(kVerbose) << "Found usable endpoint for bootstrapping : " << new_bootstrap_endpoint;
+    ROUTING_LOG(kVerbose) << "Found usable endpoint for bootstrapping : " << new_bootstrap_endpoint;
     // TODO(Prakash): Is separate thread needed here ?
     if (new_bootstrap_endpoint_)
       new_bootstrap_endpoint_(new_bootstrap_endpoint);
@@ -169,7 +214,22 @@ void NetworkUtils::Remove(const NodeId& peer_id) {
     if (!running_)
       return;
   }
-  rudp_.Remove(peer_id);
+  {
+    std::lock_guard<std::mutex> lock(peer_endpoints_mutex_);
+    peer_endpoints_.erase(peer_id);
+  }
+  session_keys_.Remove(peer_id);
+  transport().Remove(peer_id);
+}
+
+bool NetworkUtils::GetPeerEndpoints(const NodeId& peer_id,
+                                    rudp::EndpointPair& peer_endpoint_pair) const {
+  std::lock_guard<std::mutex> lock(peer_endpoints_mutex_);
+  auto itr(peer_endpoints_.find(peer_id));
+  if (itr == peer_endpoints_.end())
+    return false;
+  peer_endpoint_pair = itr->second;
+  return true;
 }
 
 void NetworkUtils::RudpSend(const NodeId& peer_id,
@@ -180,11 +240,20 @@ void NetworkUtils::RudpSend(const NodeId& peer_id,
     if (!running_)
       return;
   }
-  rudp_.Send(peer_id, message.SerializeAsString(), message_sent_functor);
-  LOG(kVerbose) << "  [" << DebugId(routing_table_.kNodeId())
-             << "] send : " << MessageTypeString(message)
-             << " to   " << DebugId(peer_id) << "   (id: " << message.id() << ")"
-             << " --To Rudp--";
+  std::string serialised_message;
+  if (message.trace()) {
+    protobuf::Message traced_message(message);
+    SetTraceNextHop(traced_message, routing_table_.kNodeId(), peer_id);
+    serialised_message = session_keys_.Serialise(traced_message, peer_id);
+  } else {
+    serialised_message = session_keys_.Serialise(message, peer_id);
+  }
+  routing_table_.metrics().MessageSent(message, serialised_message.size());
+  transport().Send(peer_id, serialised_message, message_sent_functor);
+  ROUTING_LOG(kVerbose) << "  [" << DebugId(routing_table_.kNodeId())
+                        << "] send : " << MessageTypeString(message)
+                        << " to   " << DebugId(peer_id) << "   (id: " << message.id() << ")"
+                        << " --To Rudp--";
 }
 
 void NetworkUtils::SendToDirect(const protobuf::Message& message,
@@ -215,29 +284,30 @@ void NetworkUtils::SendToClosestNode(const protobuf::Message& message) {
       if ((IsRequest(message) && message.source_id() != routing_table_.kNodeId().string()) &&
           (!message.client_node() ||
            (message.source_id() != message.destination_id()))) {
-        LOG(kWarning) << "This node [" << DebugId(routing_table_.kNodeId())
-                      << " Dropping message as non-client to client message not allowed."
-                      << PrintMessage(message);
+        ROUTING_LOG(kWarning) << "This node [" << DebugId(routing_table_.kNodeId())
+                              << " Dropping message as non-client to client message not allowed."
+                              << PrintMessage(message);
         return;
       }
-      LOG(kVerbose) << "This node [" << DebugId(routing_table_.kNodeId()) << "] has "
-                    << client_routing_nodes.size()
-                    << " destination node(s) in its non-routing table."
-                    << " id: " << message.id();
+      ROUTING_LOG(kVerbose) << "This node [" << DebugId(routing_table_.kNodeId()) << "] has "
+                            << client_routing_nodes.size()
+                            << " destination node(s) in its non-routing table."
+                            << " id: " << message.id();
 
       for (const auto& i : client_routing_nodes) {
-        LOG(kVerbose) << "Sending message to NRT node with ID " << message.id()
-                      << " node_id " << DebugId(i.node_id)
-                      << " connection id " << DebugId(i.connection_id);
+        ROUTING_LOG(kVerbose) << "Sending message to NRT node with ID " << message.id()
+                              << " node_id " << DebugId(i.node_id)
+                              << " connection id " << DebugId(i.connection_id);
         SendTo(message, i.node_id, i.connection_id);
       }
     } else if (routing_table_.size() > 0) {  // getting closer nodes from routing table
       RecursiveSendOn(message);
     } else {
-      LOG(kError) << " No endpoint to send to; aborting send.  Attempt to send a type "
-                  << MessageTypeString(message) << " message to " << HexSubstr(message.source_id())
-                  << " from " << DebugId(routing_table_.kNodeId())
-                  << " id: " << message.id();
+      ROUTING_LOG(kError) << " No endpoint to send to; aborting send.  Attempt to send a type "
+                          << MessageTypeString(message) << " message to "
+                          << HexSubstr(message.source_id())
+                          << " from " << DebugId(routing_table_.kNodeId())
+                          << " id: " << message.id();
     }
     return;
   }
@@ -249,11 +319,12 @@ void NetworkUtils::SendToClosestNode(const protobuf::Message& message) {
     SendTo(relay_message, NodeId(relay_message.relay_id()),
            NodeId(relay_message.relay_connection_id()));
   } else {
-    LOG(kError) << "Unable to work out destination; aborting send." << " id: " << message.id()
-                << " message.has_relay_id() ; " << std::boolalpha << message.has_relay_id()
-                << " Isresponse(message) : " << std::boolalpha << IsResponse(message)
-                << " message.has_relay_connection_id() : "
-                << std::boolalpha << message.has_relay_connection_id();
+    ROUTING_LOG(kError) << "Unable to work out destination; aborting send."
+                        << " id: " << message.id()
+                        << " message.has_relay_id() ; " << std::boolalpha << message.has_relay_id()
+                        << " Isresponse(message) : " << std::boolalpha << IsResponse(message)
+                        << " message.has_relay_connection_id() : "
+                        << std::boolalpha << message.has_relay_connection_id();
   }
 }
 
@@ -263,15 +334,18 @@ void NetworkUtils::SendTo(const protobuf::Message& message,
   const std::string kThisId(routing_table_.kNodeId().string());
   rudp::MessageSentFunctor message_sent_functor = [=](int message_sent) {
       if (rudp::kSuccess == message_sent) {
-        LOG(kVerbose) << "  [" << HexSubstr(kThisId) << "] sent : " << MessageTypeString(message)
-                      << " to   " << DebugId(peer_node_id) << "   (id: " << message.id() << ")";
+        ROUTING_LOG(kVerbose) << "  [" << HexSubstr(kThisId) << "] sent : "
+                              << MessageTypeString(message) << " to   " << DebugId(peer_node_id)
+                              << "   (id: " << message.id() << ")";
       } else {
-        LOG(kError) << "Sending type " << MessageTypeString(message) << " message from "
-                    << HexSubstr(kThisId) << " to " << DebugId(peer_node_id) << " failed with code "
-                    << message_sent << " id: " << message.id();
+        ROUTING_LOG(kError) << "Sending type " << MessageTypeString(message) << " message from "
+                            << HexSubstr(kThisId) << " to " << DebugId(peer_node_id)
+                            << " failed with code "
+                            << message_sent << " id: " << message.id();
       }
     };
-  LOG(kVerbose) << " >>>>>>>>> rudp send message to connection id " << DebugId(peer_connection_id);
+  ROUTING_LOG(kVerbose) << " >>>>>>>>> rudp send message to connection id "
+                        << DebugId(peer_connection_id);
   RudpSend(peer_connection_id, message, message_sent_functor);
 }
 
@@ -284,25 +358,28 @@ void NetworkUtils::RecursiveSendOn(protobuf::Message message,
       return;
   }
   if (attempt_count >= 3) {
-    LOG(kWarning) << " Retry attempts failed to send to ["
-                  << HexSubstr(last_node_attempted.node_id.string())
-                  << "] will drop this node now and try with another node."
-                  << " id: " << message.id();
+    ROUTING_LOG(kWarning) << " Retry attempts failed to send to ["
+                          << HexSubstr(last_node_attempted.node_id.string())
+                          << "] will drop this node now and try with another node."
+                          << " id: " << message.id();
     attempt_count = 0;
     {
       std::lock_guard<std::mutex> lock(running_mutex_);
       if (!running_)
         return;
-      rudp_.Remove(last_node_attempted.connection_id);
-      LOG(kWarning) << " Routing -> removing connection " << last_node_attempted.node_id.string();
+      transport().Remove(last_node_attempted.connection_id);
+      ROUTING_LOG(kWarning) << " Routing -> removing connection "
+                            << last_node_attempted.node_id.string();
       // FIXME Should we remove this node or let rudp handle that?
       routing_table_.DropNode(last_node_attempted.connection_id, false);
       client_routing_table_.DropConnection(last_node_attempted.connection_id);
     }
   }
 
-  if (attempt_count > 0)
+  if (attempt_count > 0) {
+    routing_table_.metrics().Increment(MetricsRegistry::Counter::kSendRetries);
     Sleep(std::chrono::milliseconds(50));
+  }
 
   const std::string kThisId(routing_table_.kNodeId().string());
   bool ignore_exact_match(!IsDirect(message));
@@ -330,7 +407,8 @@ void NetworkUtils::RecursiveSendOn(protobuf::Message message,
                                                      ignore_exact_match);
     }
     if (peer.node_id == NodeId()) {
-      LOG(kError) << "This node's routing table is empty now.  Need to re-bootstrap.";
+      ROUTING_LOG(kError) << "This node's routing table is empty now.  Need to re-bootstrap.";
+      routing_table_.metrics().MessageDropped(MetricsRegistry::DropReason::kNoRoute);
       return;
     }
     AdjustRouteHistory(message);
@@ -343,39 +421,39 @@ void NetworkUtils::RecursiveSendOn(protobuf::Message message,
           return;
       }
       if (rudp::kSuccess == message_sent) {
-        LOG(kVerbose) << "  [" << HexSubstr(kThisId) << "] sent : "
-                      << MessageTypeString(message) << " to   "
-                      << HexSubstr(peer.node_id.string())
-                      << "   (id: " << message.id() << ")"
-                      << " dst : " << HexSubstr(message.destination_id());
+        ROUTING_LOG(kVerbose) << "  [" << HexSubstr(kThisId) << "] sent : "
+                              << MessageTypeString(message) << " to   "
+                              << HexSubstr(peer.node_id.string())
+                              << "   (id: " << message.id() << ")"
+                              << " dst : " << HexSubstr(message.destination_id());
       } else if (rudp::kSendFailure == message_sent) {
-        LOG(kError) << "Sending type " << MessageTypeString(message)
-                    << " message from " << HexSubstr(routing_table_.kNodeId().string())
-                    << " to " << HexSubstr(peer.node_id.string())
-                    << " with destination ID " << HexSubstr(message.destination_id())
-                    << " failed with code " << message_sent
-                    << ".  Will retry to Send.  Attempt count = " << attempt_count + 1
-                    << " id: " << message.id();
+        ROUTING_LOG(kError) << "Sending type " << MessageTypeString(message)
+                            << " message from " << HexSubstr(routing_table_.kNodeId().string())
+                            << " to " << HexSubstr(peer.node_id.string())
+                            << " with destination ID " << HexSubstr(message.destination_id())
+                            << " failed with code " << message_sent
+                            << ".  Will retry to Send.  Attempt count = " << attempt_count + 1
+                            << " id: " << message.id();
         RecursiveSendOn(message, peer, attempt_count + 1);
       } else {
-        LOG(kError) << "Sending type " << MessageTypeString(message) << " message from "
-                    << HexSubstr(kThisId) << " to " << HexSubstr(peer.node_id.string())
-                    << " with destination ID " << HexSubstr(message.destination_id())
-                    << " failed with code " << message_sent << "  Will remove node."
-                    << " message id: " << message.id();
+        ROUTING_LOG(kError) << "Sending type " << MessageTypeString(message) << " message from "
+                            << HexSubstr(kThisId) << " to " << HexSubstr(peer.node_id.string())
+                            << " with destination ID " << HexSubstr(message.destination_id())
+                            << " failed with code " << message_sent << "  Will remove node."
+                            << " message id: " << message.id();
         {
           std::lock_guard<std::mutex> lock(running_mutex_);
           if (!running_)
             return;
-          rudp_.Remove(last_node_attempted.connection_id);
+          transport().Remove(last_node_attempted.connection_id);
         }
-        LOG(kWarning) << " Routing-> removing connection " << DebugId(peer.connection_id);
+        ROUTING_LOG(kWarning) << " Routing-> removing connection " << DebugId(peer.connection_id);
         routing_table_.DropNode(peer.node_id, false);
         client_routing_table_.DropConnection(peer.connection_id);
         RecursiveSendOn(message);
       }
   };
-  LOG(kVerbose) << "Rudp recursive send message to " << DebugId(peer.connection_id);
+  ROUTING_LOG(kVerbose) << "Rudp recursive send message to " << DebugId(peer.connection_id);
   RudpSend(peer.connection_id, message, message_sent_functor);
 }
 
@@ -421,6 +499,36 @@ rudp::NatType NetworkUtils::nat_type() const {
   return nat_type_;
 }
 
+SessionKeys& NetworkUtils::session_keys() {
+  return session_keys_;
+}
+
+BootstrapContacts& NetworkUtils::bootstrap_contacts() {
+  return bootstrap_contacts_;
+}
+
+SignatureVerifier& NetworkUtils::signature_verifier() {
+  return signature_verifier_;
+}
+
+void NetworkUtils::set_transport(std::unique_ptr<Transport> transport) {
+  assert(transport);
+  bool set(false);
+  std::call_once(transport_created_, [&] {
+                                       transport_ = std::move(transport);
+                                       if (transport_->ReportsConnections())
+                                         session_keys_.Enable();
+                                       set = true;
+                                     });
+  assert(set && "Set transport before it is first used");
+  static_cast<void>(set);
+}
+
+Transport& NetworkUtils::transport() {
+  std::call_once(transport_created_, [this] { transport_.reset(new RudpTransport); });
+  return *transport_;
+}
+
 }  // namespace routing
 
 }  // namespace maidsafe
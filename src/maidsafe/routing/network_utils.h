@@ -19,6 +19,8 @@
 #ifndef MAIDSAFE_ROUTING_NETWORK_UTILS_H_
 #define MAIDSAFE_ROUTING_NETWORK_UTILS_H_
 
+#include <map>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -29,8 +31,12 @@
 #include "maidsafe/rudp/managed_connections.h"
 
 #include "maidsafe/routing/api_config.h"
+#include "maidsafe/routing/bootstrap_contacts.h"
 #include "maidsafe/routing/node_info.h"
+#include "maidsafe/routing/session_keys.h"
+#include "maidsafe/routing/signature_verifier.h"
 #include "maidsafe/routing/timer.h"
+#include "maidsafe/routing/transport.h"
 
 
 namespace maidsafe {
@@ -52,7 +58,7 @@ class NetworkUtils {
   NetworkUtils(RoutingTable& routing_table, ClientRoutingTable& client_routing_table);
   virtual ~NetworkUtils();
   int Bootstrap(const std::vector<boost::asio::ip::udp::endpoint>& bootstrap_endpoints,
-                const rudp::MessageReceivedFunctor& message_received_functor,
+                const MessageReceivedFromFunctor& message_received_functor,
                 const rudp::ConnectionLostFunctor& connection_lost_functor,
                 boost::asio::ip::udp::endpoint local_endpoint = boost::asio::ip::udp::endpoint());
   virtual int GetAvailableEndpoint(const NodeId& peer_id,
@@ -64,6 +70,8 @@ class NetworkUtils {
                   const std::string& validation_data);
   virtual int MarkConnectionAsValid(const NodeId& peer_id);
   void Remove(const NodeId& peer_id);
+  // Endpoints of a connection added through Add, for as long as that connection is held.
+  bool GetPeerEndpoints(const NodeId& peer_id, rudp::EndpointPair& peer_endpoint_pair) const;
   // For sending relay requests, message with empty source ID may be provided, along with
   // direct endpoint.
   void SendToDirect(const protobuf::Message& message,
@@ -84,6 +92,12 @@ class NetworkUtils {
   NodeId bootstrap_connection_id() const;
   NodeId this_node_relay_connection_id() const;
   rudp::NatType nat_type() const;
+  SessionKeys& session_keys();
+  BootstrapContacts& bootstrap_contacts();
+  SignatureVerifier& signature_verifier();
+  // Replaces the default rudp transport, e.g. with a simulated one.  Must be called before the
+  // transport is first used, which creates the default one.
+  void set_transport(std::unique_ptr<Transport> transport);
 
   friend class test::GenericNode;
   friend class test::MockNetworkUtils;
@@ -103,18 +117,26 @@ class NetworkUtils {
                        NodeInfo last_node_attempted = NodeInfo(),
                        int attempt_count = 0);
   void AdjustRouteHistory(protobuf::Message& message);
+  Transport& transport();
 
   bool running_;
   std::mutex running_mutex_;
   uint16_t bootstrap_attempt_;
   std::vector<boost::asio::ip::udp::endpoint> bootstrap_endpoints_;
+  BootstrapContacts bootstrap_contacts_;
   NodeId bootstrap_connection_id_;
   NodeId this_node_relay_connection_id_;
   RoutingTable& routing_table_;
   ClientRoutingTable& client_routing_table_;
   rudp::NatType nat_type_;
   NewBootstrapEndpointFunctor new_bootstrap_endpoint_;
-  rudp::ManagedConnections rudp_;
+  mutable std::mutex peer_endpoints_mutex_;
+  std::map<NodeId, rudp::EndpointPair> peer_endpoints_;
+  SessionKeys session_keys_;
+  std::once_flag transport_created_;
+  std::unique_ptr<Transport> transport_;
+  // Last, so its workers are stopped before anything they may use is destroyed.
+  SignatureVerifier signature_verifier_;
 };
 
 }  // namespace routing
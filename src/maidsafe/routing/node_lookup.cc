@@ -0,0 +1,197 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/routing/node_lookup.h"
+
+#include <algorithm>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/log.h"
+
+#include "maidsafe/routing/parameters.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+NodeLookup::NodeLookup(const NodeId& target, Timer<std::string>& timer,
+                       SendFindNodesFunctor send_find_nodes_functor)
+    : kTarget_(target),
+      timer_(timer),
+      send_find_nodes_functor_(send_find_nodes_functor),
+      mutex_(),
+      query_count_(0),
+      shortlist_() {
+  assert(send_find_nodes_functor_);
+}
+
+void NodeLookup::AddResponse(const NodeId& responder, const std::vector<NodeId>& nodes) {
+  std::vector<NodeId> next_requests;
+  bool answered(false);
+  TaskId answered_task(0);
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto itr(std::find_if(shortlist_.begin(),
+                          shortlist_.end(),
+                          [&responder] (const Candidate& candidate) {
+                            return candidate.node_id == responder;
+                          }));
+    bool own_request(itr != shortlist_.end() && itr->state == State::kQueried);
+    // Late responses to this lookup's own requests may still improve it; anything else after the
+    // lookup is done is ignored.
+    if (!shortlist_.empty() && !own_request && Done(lock)) {
+      LOG(kVerbose) << "Lookup for " << DebugId(kTarget_) << " is done; ignoring response from "
+                    << DebugId(responder);
+      return;
+    }
+    if (own_request) {
+      itr->state = State::kResponded;
+      answered = true;
+      answered_task = itr->task_id;
+    }
+    AddCandidates(nodes, lock);
+    next_requests = NextRequests(lock);
+  }
+  // Completes the request's Timer task.  This is done outside the lock since the Timer may invoke
+  // the task's functor synchronously.
+  if (answered) {
+    try {
+      timer_.AddResponse(answered_task, std::string());
+    }
+    catch (const maidsafe_error&) {
+      // The task has already timed out.
+    }
+  }
+  SendRequests(next_requests);
+}
+
+void NodeLookup::Restart() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (Done(lock))
+    shortlist_.clear();
+}
+
+bool NodeLookup::Done() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return Done(lock);
+}
+
+void NodeLookup::AddCandidates(const std::vector<NodeId>& nodes,
+                               std::unique_lock<std::mutex>& lock) {
+  assert(lock.owns_lock());
+  static_cast<void>(lock);
+  for (const auto& node_id : nodes) {
+    if (node_id.IsZero() || node_id == kTarget_)
+      continue;
+    auto itr(std::lower_bound(shortlist_.begin(),
+                              shortlist_.end(),
+                              node_id,
+                              [this] (const Candidate& candidate, const NodeId& node_id) {
+                                return NodeId::CloserToTarget(candidate.node_id, node_id,
+                                                              kTarget_);
+                              }));
+    if (itr == shortlist_.end() || itr->node_id != node_id)
+      shortlist_.insert(itr, Candidate(node_id));
+  }
+}
+
+std::vector<NodeId> NodeLookup::NextRequests(std::unique_lock<std::mutex>& lock) {
+  assert(lock.owns_lock());
+  std::vector<NodeId> next_requests;
+  if (Done(lock))
+    return next_requests;
+  auto outstanding(static_cast<uint16_t>(std::count_if(shortlist_.begin(),
+                                 shortlist_.end(),
+                                 [] (const Candidate& candidate) {
+                                   return candidate.state == State::kQueried;
+                                 })));
+  for (auto& candidate : shortlist_) {
+    if (outstanding >= Parameters::lookup_parallelism)
+      break;
+    if (candidate.state == State::kUnqueried) {
+      candidate.state = State::kQueried;
+      candidate.queried_time = std::chrono::steady_clock::now();
+      candidate.query_number = ++query_count_;
+      NodeId node_id(candidate.node_id);
+      uint32_t query_number(candidate.query_number);
+      // The task's functor runs when the request is answered, when it times out and if the Timer
+      // is destroyed first; it only fails the request if it is still unanswered.
+      candidate.task_id = timer_.AddTask(Parameters::lookup_request_timeout,
+                                         [this, node_id, query_number](std::string) {
+                                           RequestTimedOut(node_id, query_number);
+                                         },
+                                         1);
+      next_requests.push_back(candidate.node_id);
+      ++outstanding;
+    }
+  }
+  return next_requests;
+}
+
+void NodeLookup::RequestTimedOut(const NodeId& candidate, uint32_t query_number) {
+  std::vector<NodeId> next_requests;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto itr(std::find_if(shortlist_.begin(),
+                          shortlist_.end(),
+                          [&candidate] (const Candidate& entry) {
+                            return entry.node_id == candidate;
+                          }));
+    if (itr == shortlist_.end() || itr->state != State::kQueried ||
+        itr->query_number != query_number) {
+      return;
+    }
+    itr->state = State::kFailed;
+    // Before the deadline, the task can only have been cancelled by the Timer being destroyed, so
+    // no further requests are sent.
+    if (std::chrono::steady_clock::now() - itr->queried_time < Parameters::lookup_request_timeout)
+      return;
+    LOG(kVerbose) << "Lookup request to " << DebugId(candidate) << " timed out.";
+    next_requests = NextRequests(lock);
+  }
+  SendRequests(next_requests);
+}
+
+void NodeLookup::SendRequests(const std::vector<NodeId>& next_requests) {
+  for (const auto& candidate : next_requests) {
+    LOG(kVerbose) << "Lookup for " << DebugId(kTarget_) << " querying " << DebugId(candidate);
+    send_find_nodes_functor_(candidate);
+  }
+}
+
+bool NodeLookup::Done(std::unique_lock<std::mutex>& lock) const {
+  assert(lock.owns_lock());
+  static_cast<void>(lock);
+  if (shortlist_.empty())
+    return true;
+  uint16_t responded(0);
+  for (const auto& candidate : shortlist_) {
+    if (candidate.state == State::kFailed)
+      continue;
+    if (candidate.state != State::kResponded)
+      return false;
+    if (++responded == Parameters::closest_nodes_size)
+      break;
+  }
+  return true;
+}
+
+}  // namespace routing
+
+}  // namespace maidsafe
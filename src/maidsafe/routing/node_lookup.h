@@ -0,0 +1,94 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_ROUTING_NODE_LOOKUP_H_
+#define MAIDSAFE_ROUTING_NODE_LOOKUP_H_
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "maidsafe/common/node_id.h"
+
+#include "maidsafe/routing/timer.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+// Iterative, Kademlia-style lookup of the nodes closest to a target.  Up to
+// Parameters::lookup_parallelism FindNodes requests are kept outstanding, each sent to the closest
+// candidate not yet queried.  The lookup is done once the Parameters::closest_nodes_size closest
+// candidates have all responded.  Each request is given a Timer task, and is treated as failed if
+// still unanswered after Parameters::lookup_request_timeout.
+class NodeLookup {
+ public:
+  typedef std::function<void(const NodeId& /*candidate*/)> SendFindNodesFunctor;
+
+  // Each request's Timer task refers to this object, so 'timer' must be destroyed first.
+  NodeLookup(const NodeId& target, Timer<std::string>& timer,
+             SendFindNodesFunctor send_find_nodes_functor);
+  // Feeds a FindNodes response into the lookup, starting a new lookup from 'nodes' if none has
+  // been started, and sends requests to any candidates now eligible.  Once the lookup is done,
+  // only late responses to its own requests are used; others are ignored until 'Restart'.
+  void AddResponse(const NodeId& responder, const std::vector<NodeId>& nodes);
+  // Clears a finished lookup, so that the next response starts a new one.  Has no effect while a
+  // lookup is in progress.
+  void Restart();
+  bool Done() const;
+
+ private:
+  enum class State { kUnqueried, kQueried, kResponded, kFailed };
+  struct Candidate {
+    explicit Candidate(const NodeId& node_id_in) : node_id(node_id_in), state(State::kUnqueried),
+                                          queried_time(), query_number(0), task_id(0) {}
+    NodeId node_id;
+    State state;
+    std::chrono::steady_clock::time_point queried_time;
+    // Identifies the request most recently sent to this candidate, so a timeout belonging to an
+    // earlier lookup can't fail a later request.
+    uint32_t query_number;
+    TaskId task_id;
+  };
+
+  NodeLookup(const NodeLookup&);
+  NodeLookup& operator=(const NodeLookup&);
+  void AddCandidates(const std::vector<NodeId>& nodes, std::unique_lock<std::mutex>& lock);
+  std::vector<NodeId> NextRequests(std::unique_lock<std::mutex>& lock);
+  void RequestTimedOut(const NodeId& candidate, uint32_t query_number);
+  void SendRequests(const std::vector<NodeId>& next_requests);
+  bool Done(std::unique_lock<std::mutex>& lock) const;
+
+  const NodeId kTarget_;
+  Timer<std::string>& timer_;
+  SendFindNodesFunctor send_find_nodes_functor_;
+  mutable std::mutex mutex_;
+  uint32_t query_count_;
+  // Sorted by distance from kTarget_.
+  std::vector<Candidate> shortlist_;
+};
+
+}  // namespace routing
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_ROUTING_NODE_LOOKUP_H_
@@ -18,6 +18,8 @@
 
 #include "maidsafe/routing/parameters.h"
 
+#include "maidsafe/common/log.h"
+
 #include "maidsafe/rudp/parameters.h"
 #include "maidsafe/rudp/managed_connections.h"
 
@@ -29,6 +31,8 @@ namespace routing {
 
 uint16_t Parameters::thread_count(8);
 uint16_t Parameters::num_chunks_to_cache(100);
+uint16_t Parameters::negative_cache_size(1000);
+std::chrono::steady_clock::duration Parameters::negative_cache_ttl(std::chrono::seconds(2));
 uint16_t Parameters::closest_nodes_size(8);
 uint16_t Parameters::node_group_size(4);
 uint16_t Parameters::proximity_factor(2);
@@ -41,9 +45,12 @@ std::chrono::steady_clock::duration Parameters::default_response_timeout(std::ch
 std::chrono::seconds Parameters::find_node_interval(10);
 std::chrono::seconds Parameters::recovery_time_lag(5);
 bptime::time_duration Parameters::re_bootstrap_time_lag(bptime::seconds(10));
+uint16_t Parameters::ranked_bootstrap_attempts(3);
 bptime::time_duration Parameters::find_close_node_interval(bptime::seconds(3));
 uint16_t Parameters::find_node_repeats_per_num_requested(3);
 uint16_t Parameters::maximum_find_close_node_failures(10);
+uint16_t Parameters::lookup_parallelism(3);
+std::chrono::steady_clock::duration Parameters::lookup_request_timeout(std::chrono::seconds(2));
 uint16_t Parameters::max_route_history(5);
 uint16_t Parameters::hops_to_live(50);
 uint16_t Parameters::accepted_distance_tolerance(1);
@@ -52,6 +59,20 @@ uint16_t Parameters::split_avoidance(4);
 uint16_t Parameters::routing_table_ready_to_response(Parameters::greedy_fraction * 9 / 10);
 bptime::time_duration Parameters::connect_rpc_prune_timeout(
     rudp::Parameters::rendezvous_connect_timeout * 2);
+uint16_t Parameters::max_connect_attempts_in_flight(8);
+uint16_t Parameters::signature_verification_threads(2);
+uint16_t Parameters::signature_verification_batch_size(16);
+uint16_t Parameters::verified_signature_cache_size(256);
+bool Parameters::accept_unsigned_connect_acks(false);
+uint16_t Parameters::validated_public_key_cache_size(256);
+uint16_t Parameters::route_cache_size(64);
+uint16_t Parameters::route_cache_prefix_length(8);
+std::chrono::steady_clock::duration Parameters::connect_attempt_timeout(std::chrono::seconds(10));
+std::chrono::steady_clock::duration Parameters::connect_attempt_check_interval(
+    std::chrono::seconds(1));
+std::chrono::steady_clock::duration Parameters::session_handshake_timeout(
+    std::chrono::seconds(60));
+bptime::time_duration Parameters::group_change_coalescing_window(bptime::milliseconds(250));
 // 10 KB of book keeping data for Routing
 uint32_t Parameters::max_data_size(rudp::ManagedConnections::kMaxMessageSize() - 10240);
 bool Parameters::append_maidsafe_endpoints(false);
@@ -67,6 +88,17 @@ bool Parameters::append_maidsafe_local_endpoints(false);
 bool Parameters::append_local_live_port_endpoint(false);
 // TODO(Prakash): BEFORE_RELEASE enable caching after persona tests are passing
 bool Parameters::caching(false);
+CachingPolicy Parameters::caching_policy(CachingPolicy::kAllHops);
+uint16_t Parameters::caching_hops(3);
+boost::filesystem::path Parameters::cache_directory;
+uint32_t Parameters::cache_segment_size(16 * 1024 * 1024);
+uint16_t Parameters::max_cache_segments(32);
+boost::filesystem::path Parameters::routing_table_snapshot_directory;
+bptime::time_duration Parameters::routing_table_snapshot_interval(bptime::minutes(1));
+std::atomic<int> Parameters::log_level(maidsafe::log::kVerbose);
+uint16_t Parameters::message_trace_interval(1);
+uint16_t Parameters::max_trace_hops(32);
+
 }  // namespace routing
 
 }  // namespace maidsafe
@@ -0,0 +1,348 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/routing/persistent_cache.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include "boost/crc.hpp"
+#include "boost/filesystem/operations.hpp"
+
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/utils.h"
+
+
+namespace fs = boost::filesystem;
+namespace bi = boost::interprocess;
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace {
+
+// Each record is a header holding the name and data sizes and a checksum of the name and data,
+// followed by the name and the data.  The header is written last, so a record torn by a crash
+// usually reads as the end of its segment, and otherwise fails its checksum.
+const uint32_t kHeaderSize(3 * sizeof(uint32_t));
+const char kSegmentPrefix[] = "segment_";
+const char kSegmentExtension[] = ".dat";
+
+uint32_t RecordSize(const std::string& name, const std::string& data) {
+  return kHeaderSize + static_cast<uint32_t>(name.size() + data.size());
+}
+
+uint32_t Checksum(const char* name_and_data, uint32_t size) {
+  boost::crc_32_type crc;
+  crc.process_bytes(name_and_data, size);
+  return crc.checksum();
+}
+
+}  // unnamed namespace
+
+PersistentCache::Segment::Segment(const fs::path& path_in, uint32_t size)
+    : path(path_in),
+      file(),
+      region(),
+      used_bytes(0),
+      live_bytes(0),
+      flushed_bytes(0) {
+  if (!fs::exists(path)) {
+    std::ofstream stream(path.string().c_str(), std::ios::binary | std::ios::out);
+    stream.close();
+    fs::resize_file(path, size);
+  }
+  file = bi::file_mapping(path.string().c_str(), bi::read_write);
+  region = bi::mapped_region(file, bi::read_write);
+}
+
+PersistentCache::PersistentCache(const fs::path& directory,
+                                 uint32_t segment_size,
+                                 uint16_t max_segments)
+    : kDirectory_(directory),
+      kSegmentSize_(segment_size),
+      kMaxSegments_(max_segments),
+      mutex_(),
+      condition_(),
+      running_(true),
+      segments_(),
+      index_(),
+      background_() {
+  assert(kSegmentSize_ > kHeaderSize);
+  assert(kMaxSegments_ > 1);
+  fs::create_directories(kDirectory_);
+  Recover();
+  background_ = std::thread([this] { Run(); });  // NOLINT
+}
+
+PersistentCache::~PersistentCache() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+  }
+  condition_.notify_one();
+  background_.join();
+  for (auto& segment : segments_)
+    segment.second->region.flush(0, segment.second->used_bytes, false);
+}
+
+void PersistentCache::Put(const std::string& name, const std::string& data) {
+  if (name.empty() || RecordSize(name, data) > kSegmentSize_) {
+    LOG(kWarning) << "Not caching " << HexSubstr(name) << " of size " << data.size();
+    return;
+  }
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    Append(name, data, lock);
+  }
+  condition_.notify_one();
+}
+
+bool PersistentCache::Get(const std::string& name, std::string& data) const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto itr(index_.find(name));
+  if (itr == index_.end())
+    return false;
+  data = ReadData(itr->second, lock);
+  return true;
+}
+
+size_t PersistentCache::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return index_.size();
+}
+
+void PersistentCache::Recover() {
+  std::vector<uint32_t> segment_indices;
+  for (fs::directory_iterator itr(kDirectory_); itr != fs::directory_iterator(); ++itr) {
+    std::string file_name(itr->path().filename().string());
+    if (file_name.compare(0, std::strlen(kSegmentPrefix), kSegmentPrefix) != 0 ||
+        itr->path().extension().string() != kSegmentExtension)
+      continue;
+    try {
+      segment_indices.push_back(static_cast<uint32_t>(std::stoul(
+          file_name.substr(std::strlen(kSegmentPrefix)))));
+    }
+    catch(const std::exception&) {
+      LOG(kWarning) << "Ignoring " << itr->path();
+    }
+  }
+  std::sort(segment_indices.begin(), segment_indices.end());
+  for (auto segment_index : segment_indices)
+    LoadSegment(segment_index);
+  LOG(kVerbose) << "Recovered " << index_.size() << " cache entries from " << segments_.size()
+                << " segments in " << kDirectory_;
+}
+
+void PersistentCache::LoadSegment(uint32_t segment_index) {
+  std::unique_ptr<Segment> segment(new Segment(SegmentPath(segment_index), kSegmentSize_));
+  const char* begin(static_cast<const char*>(segment->region.get_address()));
+  const uint32_t kMappedSize(static_cast<uint32_t>(segment->region.get_size()));
+  uint32_t offset(0);
+  while (offset + kHeaderSize <= kMappedSize) {
+    uint32_t name_size(0), data_size(0), checksum(0);
+    std::memcpy(&name_size, begin + offset, sizeof(name_size));
+    std::memcpy(&data_size, begin + offset + sizeof(name_size), sizeof(data_size));
+    std::memcpy(&checksum, begin + offset + 2 * sizeof(uint32_t), sizeof(checksum));
+    if (name_size == 0 ||
+        static_cast<uint64_t>(offset) + kHeaderSize + name_size + data_size > kMappedSize)
+      break;
+    uint32_t record_size(kHeaderSize + name_size + data_size);
+    if (Checksum(begin + offset + kHeaderSize, name_size + data_size) != checksum) {
+      LOG(kWarning) << "Dropping corrupt record at " << offset << " in " << segment->path;
+      offset += record_size;
+      continue;
+    }
+    std::string name(begin + offset + kHeaderSize, name_size);
+    auto itr(index_.find(name));
+    if (itr != index_.end()) {
+      auto superseded(itr->second.segment == segment_index ? segment.get() :
+                                                              segments_[itr->second.segment].get());
+      superseded->live_bytes -= itr->second.record_size;
+    }
+    index_[name] = Location(segment_index, offset, record_size);
+    segment->live_bytes += record_size;
+    offset += record_size;
+  }
+  segment->used_bytes = offset;
+  segment->flushed_bytes = offset;
+  segments_[segment_index] = std::move(segment);
+}
+
+void PersistentCache::Append(const std::string& name, const std::string& data,
+                             std::unique_lock<std::mutex>& lock) {
+  assert(lock.owns_lock());
+  const uint32_t kRecordSize(RecordSize(name, data));
+  if (segments_.empty() ||
+      segments_.rbegin()->second->used_bytes + kRecordSize >
+          segments_.rbegin()->second->region.get_size())
+    AddSegment(lock);
+
+  const uint32_t kSegmentIndex(segments_.rbegin()->first);
+  Segment& segment(*segments_.rbegin()->second);
+  char* record(static_cast<char*>(segment.region.get_address()) + segment.used_bytes);
+  std::memcpy(record + kHeaderSize, name.data(), name.size());
+  std::memcpy(record + kHeaderSize + name.size(), data.data(), data.size());
+  uint32_t name_size(static_cast<uint32_t>(name.size()));
+  uint32_t data_size(static_cast<uint32_t>(data.size()));
+  uint32_t checksum(Checksum(record + kHeaderSize, name_size + data_size));
+  std::memcpy(record + 2 * sizeof(uint32_t), &checksum, sizeof(checksum));
+  std::memcpy(record + sizeof(name_size), &data_size, sizeof(data_size));
+  std::memcpy(record, &name_size, sizeof(name_size));
+
+  auto itr(index_.find(name));
+  if (itr != index_.end())
+    segments_[itr->second.segment]->live_bytes -= itr->second.record_size;
+  index_[name] = Location(kSegmentIndex, segment.used_bytes, kRecordSize);
+  segment.used_bytes += kRecordSize;
+  segment.live_bytes += kRecordSize;
+}
+
+void PersistentCache::AddSegment(std::unique_lock<std::mutex>& lock) {
+  assert(lock.owns_lock());
+  static_cast<void>(lock);
+  uint32_t segment_index(segments_.empty() ? 0 : segments_.rbegin()->first + 1);
+  segments_[segment_index].reset(new Segment(SegmentPath(segment_index), kSegmentSize_));
+}
+
+void PersistentCache::RemoveSegment(uint32_t segment_index, std::unique_lock<std::mutex>& lock) {
+  assert(lock.owns_lock());
+  static_cast<void>(lock);
+  for (auto itr(index_.begin()); itr != index_.end();) {
+    if (itr->second.segment == segment_index)
+      itr = index_.erase(itr);
+    else
+      ++itr;
+  }
+  auto segment_itr(segments_.find(segment_index));
+  fs::path path(segment_itr->second->path);
+  segments_.erase(segment_itr);
+  boost::system::error_code error_code;
+  fs::remove(path, error_code);
+  if (error_code)
+    LOG(kWarning) << "Failed to remove " << path << ": " << error_code.message();
+}
+
+std::string PersistentCache::ReadData(const Location& location,
+                                      std::unique_lock<std::mutex>& lock) const {
+  assert(lock.owns_lock());
+  static_cast<void>(lock);
+  const char* record(static_cast<const char*>(
+      segments_.at(location.segment)->region.get_address()) + location.offset);
+  uint32_t name_size(0);
+  std::memcpy(&name_size, record, sizeof(name_size));
+  return std::string(record + kHeaderSize + name_size,
+                     location.record_size - kHeaderSize - name_size);
+}
+
+bool PersistentCache::IsSparse(const Segment& segment) const {
+  return segment.live_bytes < segment.used_bytes / 2;
+}
+
+bool PersistentCache::NeedsCompaction(std::unique_lock<std::mutex>& lock) const {
+  assert(lock.owns_lock());
+  static_cast<void>(lock);
+  if (segments_.size() > kMaxSegments_)
+    return true;
+  // The last segment is still being appended to.
+  for (auto itr(segments_.begin()); itr != segments_.end() && std::next(itr) != segments_.end();
+       ++itr) {
+    if (IsSparse(*itr->second))
+      return true;
+  }
+  return false;
+}
+
+bool PersistentCache::NeedsFlush(std::unique_lock<std::mutex>& lock) const {
+  assert(lock.owns_lock());
+  static_cast<void>(lock);
+  for (const auto& segment : segments_) {
+    if (segment.second->flushed_bytes != segment.second->used_bytes)
+      return true;
+  }
+  return false;
+}
+
+void PersistentCache::Flush(std::unique_lock<std::mutex>& lock) {
+  assert(lock.owns_lock());
+  std::vector<std::pair<Segment*, std::pair<uint32_t, uint32_t>>> ranges;
+  for (auto& segment : segments_) {
+    Segment& current(*segment.second);
+    if (current.flushed_bytes == current.used_bytes)
+      continue;
+    ranges.push_back(std::make_pair(&current, std::make_pair(
+        current.flushed_bytes, current.used_bytes - current.flushed_bytes)));
+    current.flushed_bytes = current.used_bytes;
+  }
+  lock.unlock();
+  for (const auto& range : ranges)
+    range.first->region.flush(range.second.first, range.second.second, false);
+  lock.lock();
+}
+
+void PersistentCache::CompactOnce(std::unique_lock<std::mutex>& lock) {
+  assert(lock.owns_lock());
+  if (segments_.size() > kMaxSegments_) {
+    LOG(kVerbose) << "Evicting cache segment " << segments_.begin()->first;
+    return RemoveSegment(segments_.begin()->first, lock);
+  }
+  for (auto itr(segments_.begin()); itr != segments_.end() && std::next(itr) != segments_.end();
+       ++itr) {
+    if (!IsSparse(*itr->second))
+      continue;
+    const uint32_t kSegmentIndex(itr->first);
+    std::vector<std::pair<std::string, std::string>> live_entries;
+    for (const auto& entry : index_) {
+      if (entry.second.segment == kSegmentIndex)
+        live_entries.push_back(std::make_pair(entry.first, ReadData(entry.second, lock)));
+    }
+    LOG(kVerbose) << "Compacting cache segment " << kSegmentIndex << " with "
+                  << live_entries.size() << " live entries";
+    for (const auto& entry : live_entries)
+      Append(entry.first, entry.second, lock);
+    return RemoveSegment(kSegmentIndex, lock);
+  }
+}
+
+void PersistentCache::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (running_) {
+    condition_.wait(lock, [&] {  // NOLINT
+      return !running_ || NeedsFlush(lock) || NeedsCompaction(lock);
+    });
+    if (!running_)
+      break;
+    Flush(lock);
+    if (running_ && NeedsCompaction(lock))
+      CompactOnce(lock);
+  }
+}
+
+fs::path PersistentCache::SegmentPath(uint32_t segment_index) const {
+  return kDirectory_ / (kSegmentPrefix + std::to_string(segment_index) + kSegmentExtension);
+}
+
+}  // namespace routing
+
+}  // namespace maidsafe
@@ -0,0 +1,116 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_ROUTING_PERSISTENT_CACHE_H_
+#define MAIDSAFE_ROUTING_PERSISTENT_CACHE_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "boost/filesystem/path.hpp"
+#include "boost/interprocess/file_mapping.hpp"
+#include "boost/interprocess/mapped_region.hpp"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace test {
+  class PersistentCacheTest_BEH_CompactSupersededEntries_Test;
+}
+
+// Disk-backed store of named data.  Entries are appended to fixed-size memory-mapped segment files
+// in |directory|, and found through an in-memory index which is rebuilt from those files on
+// construction, skipping any record whose checksum doesn't match.  A background thread flushes
+// appended records to disk, evicts the oldest segment once there are more than |max_segments|, and
+// rewrites any sealed segment which is mostly superseded entries.
+class PersistentCache {
+ public:
+  PersistentCache(const boost::filesystem::path& directory,
+                  uint32_t segment_size,
+                  uint16_t max_segments);
+  ~PersistentCache();
+  void Put(const std::string& name, const std::string& data);
+  bool Get(const std::string& name, std::string& data) const;
+  size_t size() const;
+
+  friend class test::PersistentCacheTest_BEH_CompactSupersededEntries_Test;
+
+ private:
+  struct Segment {
+    Segment(const boost::filesystem::path& path_in, uint32_t size);
+    boost::filesystem::path path;
+    boost::interprocess::file_mapping file;
+    boost::interprocess::mapped_region region;
+    uint32_t used_bytes;
+    uint32_t live_bytes;
+    // Bytes up to which appended records have been flushed to disk.
+    uint32_t flushed_bytes;
+  };
+
+  struct Location {
+    Location() : segment(0), offset(0), record_size(0) {}
+    Location(uint32_t segment_in, uint32_t offset_in, uint32_t record_size_in)
+        : segment(segment_in), offset(offset_in), record_size(record_size_in) {}
+    uint32_t segment;
+    uint32_t offset;
+    uint32_t record_size;
+  };
+
+  PersistentCache(const PersistentCache&);
+  PersistentCache& operator=(const PersistentCache&);
+  void Recover();
+  void LoadSegment(uint32_t segment_index);
+  void Append(const std::string& name, const std::string& data,
+              std::unique_lock<std::mutex>& lock);
+  void AddSegment(std::unique_lock<std::mutex>& lock);
+  void RemoveSegment(uint32_t segment_index, std::unique_lock<std::mutex>& lock);
+  std::string ReadData(const Location& location, std::unique_lock<std::mutex>& lock) const;
+  bool IsSparse(const Segment& segment) const;
+  bool NeedsCompaction(std::unique_lock<std::mutex>& lock) const;
+  bool NeedsFlush(std::unique_lock<std::mutex>& lock) const;
+  // Flushes appended records with the lock released.  Only the background thread removes
+  // segments, so those being flushed can't be removed meanwhile.
+  void Flush(std::unique_lock<std::mutex>& lock);
+  void CompactOnce(std::unique_lock<std::mutex>& lock);
+  void Run();
+  boost::filesystem::path SegmentPath(uint32_t segment_index) const;
+
+  const boost::filesystem::path kDirectory_;
+  const uint32_t kSegmentSize_;
+  const uint16_t kMaxSegments_;
+  mutable std::mutex mutex_;
+  std::condition_variable condition_;
+  bool running_;
+  // Keyed by segment number; the last is the one being appended to.
+  std::map<uint32_t, std::unique_ptr<Segment>> segments_;
+  std::map<std::string, Location> index_;
+  std::thread background_;
+};
+
+}  // namespace routing
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_ROUTING_PERSISTENT_CACHE_H_
@@ -31,10 +31,13 @@
 #include "maidsafe/routing/client_routing_table.h"
 #include "maidsafe/routing/group_change_handler.h"
 #include "maidsafe/routing/network_utils.h"
+#include "maidsafe/routing/parameters.h"
 #include "maidsafe/routing/return_codes.h"
 #include "maidsafe/routing/routing.pb.h"
 #include "maidsafe/routing/routing_table.h"
+#include "maidsafe/routing/routing_table_snapshot.h"
 #include "maidsafe/routing/rpcs.h"
+#include "maidsafe/routing/session_keys.h"
 #include "maidsafe/routing/utils.h"
 
 
@@ -53,13 +56,21 @@ typedef boost::asio::ip::udp::endpoint Endpoint;
 ResponseHandler::ResponseHandler(RoutingTable& routing_table,
                                  ClientRoutingTable& client_routing_table,
                                  NetworkUtils& network,
-                                 GroupChangeHandler &group_change_handler)
+                                 GroupChangeHandler &group_change_handler,
+                                 Timer<std::string>& timer)
     : mutex_(),
       routing_table_(routing_table),
       client_routing_table_(client_routing_table),
       network_(network),
       group_change_handler_(group_change_handler),
-      request_public_key_functor_() {
+      request_public_key_functor_(),
+      expected_public_key_digests_(),
+      node_lookup_(routing_table_.kNodeId(), timer,
+                   [this] (const NodeId& candidate) { SendFindNodesRequest(candidate); }),
+      connection_manager_(routing_table_, timer,
+                          [this] (const NodeId& candidate) {
+                            return SendConnectRequest(candidate);
+                          }) {
 }
 
 ResponseHandler::~ResponseHandler() {}
@@ -89,6 +100,7 @@ void ResponseHandler::Connect(protobuf::Message& message) {
 
   if (connect_response.answer() == protobuf::ConnectResponseType::kRejected) {
     LOG(kInfo) << "Peer rejected this node's connection request." << " id: " << message.id();
+    connection_manager_.Complete(NodeId(connect_request.peer_id()));
     return;
   }
 
@@ -96,6 +108,7 @@ void ResponseHandler::Connect(protobuf::Message& message) {
         protobuf::ConnectResponseType::kConnectAttemptAlreadyRunning) {
     LOG(kInfo) << "Already ongoing connection attempt with : "
                << HexSubstr(connect_response.contact().node_id());
+    connection_manager_.Complete(NodeId(connect_request.peer_id()));
     return;
   }
 
@@ -117,6 +130,7 @@ void ResponseHandler::Connect(protobuf::Message& message) {
     if (peer_endpoint_pair.external.address().is_unspecified() &&
         peer_endpoint_pair.local.address().is_unspecified()) {
       LOG(kError) << "Invalid peer endpoint details";
+      connection_manager_.Complete(node_to_add.node_id);
       return;
     }
 
@@ -128,6 +142,12 @@ void ResponseHandler::Connect(protobuf::Message& message) {
                   << DebugId(peer_node_id)
                   << " id: " << message.id();
 
+    if (connect_request.has_session_nonce() && connect_response.has_session_nonce()) {
+      network_.session_keys().AddHandshake(peer_connection_id,
+                                           connect_request.session_nonce(),
+                                           connect_response.session_nonce(),
+                                           true);
+    }
     int result = AddToRudp(network_, routing_table_.kNodeId(),
                            routing_table_.kConnectionId(),
                            peer_node_id,
@@ -147,11 +167,15 @@ void ResponseHandler::Connect(protobuf::Message& message) {
             true,  // this node is requestor
             close_ids,
             routing_table_.client_mode()));
-        network_.SendToDirect(connect_success_ack, peer_node_id, peer_connection_id);
+        SignAndSendDirect(network_, connect_success_ack, routing_table_.kPrivateKey(),
+                          peer_node_id, peer_connection_id);
       }
+    } else {
+      connection_manager_.Complete(peer_node_id);
     }
   } else {
     LOG(kVerbose) << "Already added node";
+    connection_manager_.Complete(node_to_add.node_id);
   }
 }
 
@@ -193,16 +217,49 @@ void ResponseHandler::FindNodes(const protobuf::Message& message) {
 
   LOG(kVerbose) << find_node_result;
 
+  std::vector<NodeId> found_nodes;
   for (int i = 0; i < find_nodes_response.nodes_size(); ++i) {
-    if (!find_nodes_response.nodes(i).empty())
-      CheckAndSendConnectRequest(NodeId(find_nodes_response.nodes(i)));
+    if (!find_nodes_response.nodes(i).empty() && CheckId(find_nodes_response.nodes(i)))
+      found_nodes.push_back(NodeId(find_nodes_response.nodes(i)));
   }
+  for (const auto& node_id : found_nodes)
+    CheckAndSendConnectRequest(node_id);
+
+  // Responses to requests for this node's own closest nodes drive the join lookup.
+  if (find_nodes_request.target_node() == routing_table_.kNodeId().string() &&
+      CheckId(message.source_id()) && message.source_id() != routing_table_.kNodeId().string()) {
+    // A finished lookup is only started afresh while this node is short of close peers.
+    if (routing_table_.size() < Parameters::closest_nodes_size)
+      node_lookup_.Restart();
+    node_lookup_.AddResponse(NodeId(message.source_id()), found_nodes);
+  }
+}
+
+void ResponseHandler::SendFindNodesRequest(const NodeId& candidate) {
+  // Until this node has a routing table, requests go through, and responses come back via, the
+  // bootstrap connection.
+  bool relay_message(routing_table_.size() == 0);
+  if (relay_message && network_.bootstrap_connection_id().IsZero())
+    return;
+  protobuf::Message find_nodes_rpc(
+      rpcs::FindNodes(routing_table_.kNodeId(), routing_table_.kNodeId(),
+                      Parameters::closest_nodes_size, relay_message,
+                      network_.this_node_relay_connection_id()));
+  // Unlike the join request, which is routed to the node closest to this one, each lookup request
+  // goes directly to a chosen candidate.
+  find_nodes_rpc.set_destination_id(candidate.string());
+  find_nodes_rpc.set_direct(true);
+  if (relay_message)
+    network_.SendToDirect(find_nodes_rpc, network_.bootstrap_connection_id(),
+                          network_.bootstrap_connection_id());
+  else
+    network_.SendToClosestNode(find_nodes_rpc);
 }
 
-void ResponseHandler::SendConnectRequest(const NodeId peer_node_id) {
+bool ResponseHandler::SendConnectRequest(const NodeId peer_node_id) {
   if (network_.bootstrap_connection_id().IsZero() && (routing_table_.size() == 0)) {
     LOG(kWarning) << "Need to re bootstrap !";
-    return;
+    return false;
   }
   bool send_to_bootstrap_connection((routing_table_.size() < Parameters::closest_nodes_size) &&
                                     !network_.bootstrap_connection_id().IsZero());
@@ -211,7 +268,7 @@ void ResponseHandler::SendConnectRequest(const NodeId peer_node_id) {
 
   if (peer.node_id == NodeId(routing_table_.kNodeId())) {
 //    LOG(kInfo) << "Can't send connect request to self !";
-    return;
+    return false;
   }
 
   if (routing_table_.CheckNode(peer)) {
@@ -237,7 +294,7 @@ void ResponseHandler::SendConnectRequest(const NodeId peer_node_id) {
       } else {
         LOG(kVerbose) << "Already ongoing attempt to : " << DebugId(peer.node_id);
       }
-      return;
+      return false;
     }
     assert((!this_endpoint_pair.external.address().is_unspecified() ||
             !this_endpoint_pair.local.address().is_unspecified()) &&
@@ -257,7 +314,9 @@ void ResponseHandler::SendConnectRequest(const NodeId peer_node_id) {
         routing_table_.client_mode(),
         this_nat_type,
         relay_message,
-        relay_connection_id));
+        relay_connection_id,
+        routing_table_.client_mode() || !network_.session_keys().enabled() ?
+            std::string() : SessionKeys::NewNonce()));
     LOG(kVerbose) << "Sending Connect RPC to " << DebugId(peer.node_id)
                   << " message id : " << connect_rpc.id();
     if (send_to_bootstrap_connection)
@@ -265,7 +324,9 @@ void ResponseHandler::SendConnectRequest(const NodeId peer_node_id) {
                             network_.bootstrap_connection_id());
     else
       network_.SendToClosestNode(connect_rpc);
+    return true;
   }
+  return false;
 }
 
 void ResponseHandler::ConnectSuccessAcknowledgement(protobuf::Message& message) {
@@ -290,6 +351,7 @@ void ResponseHandler::ConnectSuccessAcknowledgement(protobuf::Message& message)
     LOG(kWarning) << "Invalid peer connection_id provided";
     return;
   }
+  connection_manager_.Complete(peer.node_id);
 
   bool from_requestor(connect_success_ack.requestor());
   bool client_node(message.client_node());
@@ -302,7 +364,9 @@ void ResponseHandler::ConnectSuccessAcknowledgement(protobuf::Message& message)
   }
   if (!client_node) {
     LOG(kInfo) << "Validation -- Need non-client's public key";
-    ValidateAndCompleteConnectionToNonClient(peer, from_requestor, close_ids);
+    ValidateAndCompleteConnectionToNonClient(peer, from_requestor, close_ids, message.data(0),
+                                             message.signature(),
+                                             connect_success_ack.session_secret());
   } else {
     LOG(kInfo) << "Validation -- Not looking for client's public key";
     ValidateAndCompleteConnectionToClient(peer, from_requestor, close_ids);
@@ -331,28 +395,68 @@ void  ResponseHandler::ValidateAndCompleteConnectionToClient(const NodeInfo& pee
 void ResponseHandler::ValidateAndCompleteConnectionToNonClient(
     const NodeInfo& peer,
     bool from_requestor,
-    const std::vector<NodeId>& close_ids) {
+    const std::vector<NodeId>& close_ids,
+    const std::string& signed_data,
+    const std::string& signature,
+    const std::string& session_secret) {
   std::weak_ptr<ResponseHandler> response_handler_weak_ptr = shared_from_this();
   if (request_public_key_functor_) {
-    auto validate_node(
+    auto complete_connection(
         [=] (const asymm::PublicKey& key) {
-            LOG(kInfo) << "Validation callback called with public key for "
-                       << DebugId(peer.node_id);
             if (std::shared_ptr<ResponseHandler> response_handler =
                 response_handler_weak_ptr.lock()) {
+              if (!response_handler->MatchesExpectedPublicKey(peer.node_id, key)) {
+                LOG(kWarning) << "Public key of " << DebugId(peer.node_id)
+                              << " differs from the one in the routing table snapshot.";
+                return;
+              }
               if (ValidateAndAddToRoutingTable(response_handler->network_,
                                                response_handler->routing_table_,
                                                response_handler->client_routing_table_,
                                                peer.node_id, peer.connection_id,
                                                key, false)) {
                 if (from_requestor) {
-                  response_handler->HandleSuccessAcknowledgementAsReponder(peer, false);
+                  NodeInfo keyed_peer(peer);
+                  keyed_peer.public_key = key;
+                  response_handler->HandleSuccessAcknowledgementAsReponder(keyed_peer, false);
                 } else {
+                  // Only a signed ack vouches for the session secret it carries.
+                  if (!session_secret.empty() && !signature.empty()) {
+                    response_handler->network_.session_keys().Accept(
+                        peer.connection_id, session_secret,
+                        response_handler->routing_table_.kPrivateKey());
+                  }
                   response_handler->HandleSuccessAcknowledgementAsRequestor(close_ids);
                 }
               }
             }
       });
+    auto validate_node(
+        [=] (const asymm::PublicKey& key) {
+            LOG(kInfo) << "Validation callback called with public key for "
+                       << DebugId(peer.node_id);
+            if (signature.empty()) {
+              if (Parameters::accept_unsigned_connect_acks) {
+                complete_connection(key);
+              } else {
+                LOG(kWarning) << "Unsigned connect success ack from " << DebugId(peer.node_id);
+              }
+              return;
+            }
+            if (std::shared_ptr<ResponseHandler> response_handler =
+                response_handler_weak_ptr.lock()) {
+              response_handler->network_.signature_verifier().Verify(
+                  key, signed_data, signature,
+                  [=] (bool valid) {
+                    if (valid) {
+                      complete_connection(key);
+                    } else {
+                      LOG(kWarning) << "Invalid signature on connect success ack from "
+                                    << DebugId(peer.node_id);
+                    }
+                  });
+            }
+      });
     request_public_key_functor_(peer.node_id, validate_node);
   }
 }
@@ -370,14 +474,19 @@ void ResponseHandler::HandleSuccessAcknowledgementAsReponder(NodeInfo peer,
   if (itr != close_ids_for_peer.end())
     close_ids_for_peer.erase(itr);
 
+  std::string session_secret;
+  if (!client)
+    session_secret = network_.session_keys().Offer(peer.connection_id, peer.public_key);
   protobuf::Message connect_success_ack(
       rpcs::ConnectSuccessAcknowledgement(peer.node_id,
                                           routing_table_.kNodeId(),
                                           routing_table_.kConnectionId(),
                                           false,  // this node is responder
                                           close_ids_for_peer,
-                                          routing_table_.client_mode()));
-  network_.SendToDirect(connect_success_ack, peer.node_id, peer.connection_id);
+                                          routing_table_.client_mode(),
+                                          session_secret));
+  SignAndSendDirect(network_, connect_success_ack, routing_table_.kPrivateKey(), peer.node_id,
+                    peer.connection_id);
 }
 
 void ResponseHandler::HandleSuccessAcknowledgementAsRequestor(
@@ -397,7 +506,7 @@ void ResponseHandler::CheckAndSendConnectRequest(const NodeId& node_id) {
                              routing_table_.GetNthClosestNode(routing_table_.kNodeId(),
                                                               limit).node_id,
                              routing_table_.kNodeId()))
-    SendConnectRequest(node_id);
+    connection_manager_.Add(node_id);
 }
 
 void ResponseHandler::CloseNodeUpdateForClient(protobuf::Message& message) {
@@ -419,14 +528,16 @@ void ResponseHandler::CloseNodeUpdateForClient(protobuf::Message& message) {
     return;
   }
 
+  // Only nodes new to the sender's close group are carried by a delta update.
   std::vector<NodeId> closest_nodes;
-  for (const auto& basic_info : closest_node_update.nodes_info()) {
+  for (const auto& basic_info : closest_node_update.delta() ? closest_node_update.added_nodes() :
+                                                              closest_node_update.nodes_info()) {
     if (CheckId(basic_info.node_id())) {
       closest_nodes.push_back(NodeId(basic_info.node_id()));
     }
   }
-  assert(!closest_nodes.empty());
-  HandleSuccessAcknowledgementAsRequestor(closest_nodes);
+  if (!closest_nodes.empty())
+    HandleSuccessAcknowledgementAsRequestor(closest_nodes);
   message.Clear();
 }
 
@@ -441,6 +552,29 @@ void ResponseHandler::GetGroup(Timer<std::string>& timer, protobuf::Message& mes
   }
 }
 
+void ResponseHandler::ConnectToPeers(const std::vector<NodeId>& peers,
+                                     const std::map<NodeId, std::string>& public_key_digests) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& public_key_digest : public_key_digests)
+      expected_public_key_digests_[public_key_digest.first] = public_key_digest.second;
+  }
+  for (const auto& peer : peers)
+    CheckAndSendConnectRequest(peer);
+}
+
+bool ResponseHandler::MatchesExpectedPublicKey(const NodeId& peer_id,
+                                               const asymm::PublicKey& public_key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto itr(expected_public_key_digests_.find(peer_id));
+  if (itr == expected_public_key_digests_.end())
+    return true;
+  if (SnapshotPublicKeyDigest(public_key) != itr->second)
+    return false;
+  expected_public_key_digests_.erase(itr);
+  return true;
+}
+
 void ResponseHandler::set_request_public_key_functor(RequestPublicKeyFunctor request_public_key) {
   request_public_key_functor_ = request_public_key;
 }
@@ -19,6 +19,7 @@
 #ifndef MAIDSAFE_ROUTING_RESPONSE_HANDLER_H_
 #define MAIDSAFE_ROUTING_RESPONSE_HANDLER_H_
 
+#include <map>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -30,6 +31,8 @@
 #include "maidsafe/rudp/managed_connections.h"
 
 #include "maidsafe/routing/api_config.h"
+#include "maidsafe/routing/connection_manager.h"
+#include "maidsafe/routing/node_lookup.h"
 #include "maidsafe/routing/timer.h"
 
 
@@ -53,7 +56,8 @@ class ResponseHandler : public std::enable_shared_from_this<ResponseHandler> {
   ResponseHandler(RoutingTable& routing_table,
                   ClientRoutingTable& client_routing_table,
                   NetworkUtils& network,
-                  GroupChangeHandler& group_change_handler);
+                  GroupChangeHandler& group_change_handler,
+                  Timer<std::string>& timer);
   virtual ~ResponseHandler();
   virtual void Ping(protobuf::Message& message);
   virtual void Connect(protobuf::Message& message);
@@ -63,11 +67,18 @@ class ResponseHandler : public std::enable_shared_from_this<ResponseHandler> {
   RequestPublicKeyFunctor request_public_key_functor() const;
   void GetGroup(Timer<std::string>& timer, protobuf::Message& message);
   void CloseNodeUpdateForClient(protobuf::Message& message);
+  // Queues connect requests to any of 'peers' the routing table would accept.  Until it has been
+  // matched, a peer listed in 'public_key_digests' is only accepted with a public key having that
+  // digest.
+  void ConnectToPeers(const std::vector<NodeId>& peers,
+                      const std::map<NodeId, std::string>& public_key_digests);
 
   friend class test::ResponseHandlerTest_BEH_ConnectAttempts_Test;
 
  private:
-  void SendConnectRequest(const NodeId peer_node_id);
+  bool SendConnectRequest(const NodeId peer_node_id);
+  void SendFindNodesRequest(const NodeId& candidate);
+  bool MatchesExpectedPublicKey(const NodeId& peer_id, const asymm::PublicKey& public_key);
   void CheckAndSendConnectRequest(const NodeId& node_id);
   void HandleSuccessAcknowledgementAsRequestor(const std::vector<NodeId>& close_ids);
   void HandleSuccessAcknowledgementAsReponder(NodeInfo peer, const bool& client);
@@ -75,7 +86,10 @@ class ResponseHandler : public std::enable_shared_from_this<ResponseHandler> {
                                               const std::vector<NodeId>& close_ids);
   void ValidateAndCompleteConnectionToNonClient(const NodeInfo& peer,
                                                 bool from_requestor,
-                                                const std::vector<NodeId>& close_ids);
+                                                const std::vector<NodeId>& close_ids,
+                                                const std::string& signed_data,
+                                                const std::string& signature,
+                                                const std::string& session_secret);
 
   mutable std::mutex mutex_;
   RoutingTable& routing_table_;
@@ -83,6 +97,9 @@ class ResponseHandler : public std::enable_shared_from_this<ResponseHandler> {
   NetworkUtils& network_;
   GroupChangeHandler& group_change_handler_;
   RequestPublicKeyFunctor request_public_key_functor_;
+  std::map<NodeId, std::string> expected_public_key_digests_;
+  NodeLookup node_lookup_;
+  ConnectionManager connection_manager_;
 };
 
 }  // namespace routing
@@ -28,13 +28,19 @@ namespace { typedef boost::asio::ip::udp::endpoint Endpoint; }
 
 template<>
 Routing::Routing(const NodeId& node_id) : pimpl_() {
-  InitialisePimpl(true, node_id, asymm::GenerateKeyPair());
+  InitialisePimpl(true, node_id, asymm::GenerateKeyPair(), std::shared_ptr<Runtime>());
+}
+
+template<>
+Routing::Routing(const NodeId& node_id, std::shared_ptr<Runtime> runtime) : pimpl_() {
+  InitialisePimpl(true, node_id, asymm::GenerateKeyPair(), runtime);
 }
 
 void Routing::InitialisePimpl(bool client_mode,
                               const NodeId& node_id,
-                              const asymm::Keys& keys) {
-  pimpl_.reset(new Impl(client_mode, node_id, keys));
+                              const asymm::Keys& keys,
+                              std::shared_ptr<Runtime> runtime) {
+  pimpl_.reset(new Impl(client_mode, node_id, keys, runtime));
 }
 
 void Routing::Join(Functors functors, std::vector<Endpoint> peer_endpoints) {
@@ -117,6 +123,18 @@ int Routing::network_status() {
   return pimpl_->network_status();
 }
 
+RoutingMetrics Routing::GetMetrics() {
+  return pimpl_->GetMetrics();
+}
+
+Tuning Routing::GetTuning() const {
+  return pimpl_->GetTuning();
+}
+
+void Routing::SetTuning(const Tuning& tuning) {
+  pimpl_->SetTuning(tuning);
+}
+
 std::vector<NodeInfo> Routing::ClosestNodes() {
   return pimpl_->ClosestNodes();
 }
@@ -19,8 +19,11 @@
 #include "maidsafe/routing/routing_impl.h"
 
 #include <cstdint>
+#include <map>
 #include <type_traits>
 
+#include "boost/filesystem/operations.hpp"
+
 #include "maidsafe/common/log.h"
 
 #include "maidsafe/rudp/managed_connections.h"
@@ -31,10 +34,14 @@
 #include "maidsafe/routing/bootstrap_file_handler.h"
 #include "maidsafe/routing/message.h"
 #include "maidsafe/routing/message_handler.h"
+#include "maidsafe/routing/metrics_registry.h"
 #include "maidsafe/routing/node_info.h"
 #include "maidsafe/routing/return_codes.h"
 #include "maidsafe/routing/routing.pb.h"
+#include "maidsafe/routing/routing_log.h"
+#include "maidsafe/routing/routing_table_snapshot.h"
 #include "maidsafe/routing/rpcs.h"
+#include "maidsafe/routing/runtime.h"
 #include "maidsafe/routing/utils.h"
 #include "maidsafe/routing/network_statistics.h"
 
@@ -58,35 +65,44 @@ namespace detail {
 
 Routing::Impl::Impl(bool client_mode,
                     const NodeId& node_id,
-                    const asymm::Keys& keys)
+                    const asymm::Keys& keys,
+                    std::shared_ptr<Runtime> runtime)
     : network_status_mutex_(),
       network_status_(kNotJoined),
-      routing_table_(client_mode, node_id, keys, network_statistics_),
+      tuning_(),
+      routing_table_(client_mode, node_id, keys, network_statistics_, &tuning_),
       kNodeId_(routing_table_.kNodeId()),
       running_(true),
       running_mutex_(),
+      snapshot_mutex_(),
       functors_(),
+      trace_sample_count_(0),
       random_node_helper_(),
       // TODO(Prakash) : don't create client_routing_table for client nodes (wrap both)
       client_routing_table_(routing_table_.kNodeId()),
       remove_furthest_node_(routing_table_, network_),
       group_change_handler_(routing_table_, client_routing_table_, network_),
       network_statistics_(routing_table_.kNodeId()),
+      handler_tracker_(),
       message_handler_(),
-      asio_service_(2),
+      runtime_(runtime ? runtime : std::make_shared<Runtime>(2)),
+      asio_service_(runtime_->asio_service()),
       network_(routing_table_, client_routing_table_),
       timer_(asio_service_),
       re_bootstrap_timer_(asio_service_.service()),
       recovery_timer_(asio_service_.service()),
-      setup_timer_(asio_service_.service()) {
-  asio_service_.Start();
+      setup_timer_(asio_service_.service()),
+      group_change_timer_(asio_service_.service()),
+      snapshot_timer_(asio_service_.service()) {
   message_handler_.reset(new MessageHandler(routing_table_,
                                             client_routing_table_,
                                             network_,
                                             timer_,
                                             remove_furthest_node_,
                                             group_change_handler_,
-                                            network_statistics_));
+                                            network_statistics_,
+                                            tuning_));
+  ApplyLoggerLogLevel();
   LOG(kInfo) << (client_mode ? "client " : "non-client ") << "node. Id : " << DebugId(kNodeId_);
   assert((client_mode || !node_id.IsZero()) && "Server Nodes cannot be created without valid keys");
 }
@@ -94,18 +110,47 @@ Routing::Impl::Impl(bool client_mode,
 Routing::Impl::~Impl() {
   LOG(kVerbose) << "~Impl " << DebugId(kNodeId_) << ", connection id "
                 << DebugId(routing_table_.kConnectionId());
-  std::lock_guard<std::mutex> lock(running_mutex_);
-  running_ = false;
+  WriteSnapshot();
+  {
+    std::lock_guard<std::mutex> lock(running_mutex_);
+    running_ = false;
+    // A shared runtime keeps running after this, so nothing of ours may be left queued on it.
+    boost::system::error_code error_code;
+    re_bootstrap_timer_.cancel(error_code);
+    recovery_timer_.cancel(error_code);
+    setup_timer_.cancel(error_code);
+    group_change_timer_.cancel(error_code);
+    snapshot_timer_.cancel(error_code);
+  }
+  handler_tracker_.WaitForAll();
 }
 
 void Routing::Impl::Join(const Functors& functors, const std::vector<Endpoint>& peer_endpoints) {
   ConnectFunctors(functors);
+  // Peers from the last run are tried as bootstrap contacts ahead of the given ones, and are sent
+  // connect requests directly once bootstrapped rather than waiting to be found again.
+  std::vector<Endpoint> endpoints(peer_endpoints);
+  std::vector<NodeId> snapshot_node_ids;
+  std::map<NodeId, std::string> snapshot_public_key_digests;
+  protobuf::RoutingTableSnapshot snapshot;
+  if (!SnapshotPath().empty())
+    network_.bootstrap_contacts().Read(BootstrapContactsPath());
+  if (!SnapshotPath().empty() && ReadRoutingTableSnapshot(SnapshotPath(), snapshot)) {
+    std::vector<Endpoint> snapshot_endpoints(SnapshotBootstrapEndpoints(snapshot, kNodeId_));
+    endpoints.insert(endpoints.begin(), snapshot_endpoints.begin(), snapshot_endpoints.end());
+    snapshot_node_ids = SnapshotNodeIds(snapshot, kNodeId_);
+    snapshot_public_key_digests = SnapshotPublicKeyDigests(snapshot);
+    LOG(kInfo) << "Warm starting from snapshot of " << snapshot.peers_size() << " peers";
+  }
   if (!peer_endpoints.empty()) {
-    BootstrapFromTheseEndpoints(peer_endpoints);
+    BootstrapFromTheseEndpoints(endpoints);
   } else {
     LOG(kInfo) << "Doing a default join";
-    DoJoin(peer_endpoints);
+    DoJoin(endpoints);
   }
+  if (!snapshot_node_ids.empty() && !network_.bootstrap_connection_id().IsZero())
+    message_handler_->ConnectToPeers(snapshot_node_ids, snapshot_public_key_digests);
+  ScheduleSnapshot();
 }
 
 void Routing::Impl::ConnectFunctors(const Functors& functors) {
@@ -130,6 +175,10 @@ void Routing::Impl::ConnectFunctors(const Functors& functors) {
                                     },
                                     functors_.close_node_replaced,
                                     functors.matrix_changed);
+  if (!Parameters::group_change_coalescing_window.is_zero())
+    routing_table_.set_group_change_scheduling_functor([this] {
+                                                         ScheduleGroupChangeNotification();
+                                                       });
   // only one of MessageAndCachingFunctors or TypedMessageAndCachingFunctor should be provided
   assert(!functors.message_and_caching.message_received !=
          !functors.typed_message_and_caching.single_to_single.message_received);
@@ -146,9 +195,72 @@ void Routing::Impl::ConnectFunctors(const Functors& functors) {
     message_handler_->set_typed_message_and_caching_functor(functors.typed_message_and_caching);
 
   message_handler_->set_request_public_key_functor(functors.request_public_key);
+  message_handler_->set_message_trace_functor(functors.message_trace);
   network_.set_new_bootstrap_endpoint_functor(functors.new_bootstrap_endpoint);
 }
 
+void Routing::Impl::ScheduleGroupChangeNotification() {
+  std::lock_guard<std::mutex> lock(running_mutex_);
+  if (!running_)
+    return;
+  group_change_timer_.expires_from_now(Parameters::group_change_coalescing_window);
+  group_change_timer_.async_wait(handler_tracker_.Wrap(
+      [this](const boost::system::error_code& error_code) {
+        if (error_code != boost::asio::error::operation_aborted)
+          routing_table_.FlushGroupChanges();
+      }));
+}
+
+fs::path Routing::Impl::SnapshotPath() const {
+  if (Parameters::routing_table_snapshot_directory.empty() || routing_table_.client_mode())
+    return fs::path();
+  return Parameters::routing_table_snapshot_directory / kNodeId_.ToStringEncoded(NodeId::kHex);
+}
+
+fs::path Routing::Impl::BootstrapContactsPath() const {
+  fs::path snapshot_path(SnapshotPath());
+  if (snapshot_path.empty())
+    return fs::path();
+  snapshot_path += ".bootstrap_contacts";
+  return snapshot_path;
+}
+
+void Routing::Impl::ScheduleSnapshot() {
+  if (SnapshotPath().empty())
+    return;
+  std::lock_guard<std::mutex> lock(running_mutex_);
+  if (!running_)
+    return;
+  snapshot_timer_.expires_from_now(Parameters::routing_table_snapshot_interval);
+  snapshot_timer_.async_wait(handler_tracker_.Wrap(
+      [this](const boost::system::error_code& error_code) {
+        if (error_code != boost::asio::error::operation_aborted) {
+          WriteSnapshot();
+          ScheduleSnapshot();
+        }
+      }));
+}
+
+void Routing::Impl::WriteSnapshot() {
+  fs::path snapshot_path(SnapshotPath());
+  if (snapshot_path.empty())
+    return;
+  std::lock_guard<std::mutex> lock(snapshot_mutex_);
+  boost::system::error_code error_code;
+  fs::create_directories(snapshot_path.parent_path(), error_code);
+  if (error_code) {
+    LOG(kError) << "Failed to create " << snapshot_path.parent_path() << ": "
+                << error_code.message();
+    return;
+  }
+  // The bootstrap contact ranking is kept even while the routing table is empty, since it then
+  // records which contacts failed.
+  network_.bootstrap_contacts().Write(BootstrapContactsPath());
+  // An empty routing table would only replace the last useful snapshot.
+  if (routing_table_.size() != 0)
+    WriteRoutingTableSnapshot(MakeRoutingTableSnapshot(routing_table_, network_), snapshot_path);
+}
+
 void Routing::Impl::BootstrapFromTheseEndpoints(const std::vector<Endpoint>& endpoints) {
   LOG(kInfo) << "Doing a BootstrapFromTheseEndpoints Join.  Entered first bootstrap endpoint: "
              << endpoints[0] << ", this node's ID: " << DebugId(kNodeId_)
@@ -192,7 +304,9 @@ int Routing::Impl::DoBootstrap(const std::vector<Endpoint>& endpoints) {
 
   return network_.Bootstrap(
       endpoints,
-      [=](const std::string& message) { OnMessageReceived(message); },
+      [=](const std::string& message, const NodeId& peer_connection_id) {
+        OnMessageReceived(message, peer_connection_id);
+      },
       [=](const NodeId& lost_connection_id) { OnConnectionLost(lost_connection_id);});  // NOLINT
 }
 
@@ -218,15 +332,16 @@ void Routing::Impl::FindClosestNode(const boost::system::error_code& error_code,
       LOG(kVerbose) << "[" << DebugId(kNodeId_) << "] Added a node in routing table."
                     << " Terminating setup loop & Scheduling recovery loop.";
       recovery_timer_.expires_from_now(
-          boost::posix_time::seconds(static_cast<long>(Parameters::find_node_interval.count())));  // NOLINT
-      recovery_timer_.async_wait([=](const boost::system::error_code& error_code) {
-                                      if (error_code != boost::asio::error::operation_aborted)
-                                        ReSendFindNodeRequest(error_code, false);
-                                    });
+          boost::posix_time::seconds(static_cast<long>(tuning_.Get()->find_node_interval.count())));  // NOLINT
+      recovery_timer_.async_wait(handler_tracker_.Wrap(
+          [=](const boost::system::error_code& error_code) {
+            if (error_code != boost::asio::error::operation_aborted)
+              ReSendFindNodeRequest(error_code, false);
+          }));
       return;
     }
 
-    if (attempts >= Parameters::maximum_find_close_node_failures) {
+    if (attempts >= tuning_.Get()->maximum_find_close_node_failures) {
       LOG(kError) << "[" << DebugId(kNodeId_) << "] failed to get closest node. ReBootstrapping...";
       // TODO(Prakash) : Remove the bootstrap node from the list
       ReBootstrap();
@@ -261,11 +376,12 @@ void Routing::Impl::FindClosestNode(const boost::system::error_code& error_code,
   std::lock_guard<std::mutex> lock(running_mutex_);
   if (!running_)
     return;
-  setup_timer_.expires_from_now(Parameters::find_close_node_interval);
-  setup_timer_.async_wait([=](boost::system::error_code error_code_local) {
-                              if (error_code_local != boost::asio::error::operation_aborted)
-                                FindClosestNode(error_code_local, attempts);
-                            });
+  setup_timer_.expires_from_now(tuning_.Get()->find_close_node_interval);
+  setup_timer_.async_wait(handler_tracker_.Wrap(
+      [=](boost::system::error_code error_code_local) {
+        if (error_code_local != boost::asio::error::operation_aborted)
+          FindClosestNode(error_code_local, attempts);
+      }));
 }
 
 int Routing::Impl::ZeroStateJoin(const Functors& functors,
@@ -276,7 +392,9 @@ int Routing::Impl::ZeroStateJoin(const Functors& functors,
   ConnectFunctors(functors);
   int result(network_.Bootstrap(
       std::vector<Endpoint>(1, peer_endpoint),
-      [=](const std::string& message) { OnMessageReceived(message); },
+      [=](const std::string& message, const NodeId& peer_connection_id) {
+        OnMessageReceived(message, peer_connection_id);
+      },
       [=](const NodeId& lost_connection_id) { OnConnectionLost(lost_connection_id); },
       local_endpoint));
 
@@ -334,11 +452,12 @@ int Routing::Impl::ZeroStateJoin(const Functors& functors,
     if (!running_)
       return kNetworkShuttingDown;
     recovery_timer_.expires_from_now(
-        boost::posix_time::seconds(static_cast<long>(Parameters::find_node_interval.count())));  // NOLINT
-    recovery_timer_.async_wait([=](const boost::system::error_code& error_code) {
-                                   if (error_code != boost::asio::error::operation_aborted)
-                                     ReSendFindNodeRequest(error_code, false);
-                                 });
+        boost::posix_time::seconds(static_cast<long>(tuning_.Get()->find_node_interval.count())));  // NOLINT
+    recovery_timer_.async_wait(handler_tracker_.Wrap(
+        [=](const boost::system::error_code& error_code) {
+          if (error_code != boost::asio::error::operation_aborted)
+            ReSendFindNodeRequest(error_code, false);
+        }));
     return kSuccess;
   } else {
     LOG(kError) << "Failed to join zero state network, with bootstrap_endpoint "
@@ -377,7 +496,7 @@ void Routing::Impl::Send(const NodeId& destination_id,
   if (response_functor) {
     if (DestinationType::kGroup == destination_type)
       expected_response_count = 4;
-    proto_message.set_id(timer_.AddTask(Parameters::default_response_timeout, response_functor,
+    proto_message.set_id(timer_.AddTask(tuning_.Get()->response_timeout, response_functor,
                                         expected_response_count));
   } else {
     proto_message.set_id(0);
@@ -386,6 +505,7 @@ void Routing::Impl::Send(const NodeId& destination_id,
 }
 
 void Routing::Impl::SendMessage(const NodeId& destination_id, protobuf::Message& proto_message) {
+  SampleForTracing(proto_message);
   if (routing_table_.size() == 0) {  // Partial join state
     PartiallyJoinedSend(proto_message);
   } else {  // Normal node
@@ -397,11 +517,19 @@ void Routing::Impl::SendMessage(const NodeId& destination_id, protobuf::Message&
       network_.SendToClosestNode(proto_message);
     } else {
       LOG(kInfo) << "Sending request to self";
-      OnMessageReceived(proto_message.SerializeAsString());
+      OnMessageReceived(proto_message.SerializeAsString(), routing_table_.kConnectionId());
     }
   }
 }
 
+void Routing::Impl::SampleForTracing(protobuf::Message& proto_message) {
+  if (!functors_.message_trace || Parameters::message_trace_interval == 0 ||
+      !proto_message.request() || proto_message.id() == 0)
+    return;
+  if (trace_sample_count_++ % Parameters::message_trace_interval == 0)
+    proto_message.set_trace(true);
+}
+
 // Partial join state
 void Routing::Impl::PartiallyJoinedSend(protobuf::Message& proto_message) {
   proto_message.set_relay_id(kNodeId_.string());
@@ -413,7 +541,7 @@ void Routing::Impl::PartiallyJoinedSend(protobuf::Message& proto_message) {
         std::lock_guard<std::mutex> lock(running_mutex_);
         if (!running_)
           return;
-        asio_service_.service().post([=]() {
+        asio_service_.service().post(handler_tracker_.Wrap([=]() {
             if (rudp::kSuccess != result) {
               timer_.CancelTask(proto_message.id());
                 LOG(kError) << "Partial join Session Ended, Send not allowed anymore";
@@ -426,7 +554,7 @@ void Routing::Impl::PartiallyJoinedSend(protobuf::Message& proto_message) {
                             << " dst : " << HexSubstr(proto_message.destination_id())
                             << " --Partial-joined--";
             }
-          });
+          }));
         });
   network_.SendToDirect(proto_message, bootstrap_connection_id, message_sent);
 }
@@ -511,28 +639,43 @@ std::future<std::vector<NodeId>> Routing::Impl::GetGroup(const NodeId& group_id)
                      promise->set_value(nodes_id);
                    };
   protobuf::Message get_group_message(rpcs::GetGroup(group_id, kNodeId_));
-  get_group_message.set_id(timer_.AddTask(Parameters::default_response_timeout, callback, 1));
+  get_group_message.set_id(timer_.AddTask(tuning_.Get()->response_timeout, callback, 1));
   network_.SendToClosestNode(get_group_message);
   return std::move(future);
 }
 
-void Routing::Impl::OnMessageReceived(const std::string& message) {
+void Routing::Impl::OnMessageReceived(const std::string& message,
+                                      const NodeId& peer_connection_id) {
   std::lock_guard<std::mutex> lock(running_mutex_);
-  if (running_)
-    asio_service_.service().post([=]() { DoOnMessageReceived(message); });  // NOLINT (Fraser)
+  if (running_) {
+    auto received(std::chrono::steady_clock::now());
+    asio_service_.service().post(handler_tracker_.Wrap([=]() {
+                                   DoOnMessageReceived(message, peer_connection_id, received);
+                                 }));
+  }
 }
 
-void Routing::Impl::DoOnMessageReceived(const std::string& message) {
+void Routing::Impl::DoOnMessageReceived(const std::string& message,
+                                        const NodeId& peer_connection_id,
+                                        std::chrono::steady_clock::time_point received) {
   protobuf::Message pb_message;
   if (pb_message.ParseFromString(message)) {
+    if (!network_.session_keys().Authenticate(message, peer_connection_id, pb_message)) {
+      LOG(kWarning) << "Message received, failed to authenticate";
+      network_statistics_.metrics().MessageDropped(
+          MetricsRegistry::DropReason::kAuthenticationFailure);
+      return;
+    }
+    network_statistics_.metrics().MessageReceived(pb_message);
+    AddTraceHop(pb_message, kNodeId_, received);
     bool relay_message(!pb_message.has_source_id());
-    LOG(kVerbose) << "   [" << DebugId(kNodeId_) << "] rcvd : "
-                  << MessageTypeString(pb_message) << " from "
-                  << (relay_message ? HexSubstr(pb_message.relay_id()) :
-                                      HexSubstr(pb_message.source_id()))
-                  << " to " << HexSubstr(pb_message.destination_id())
-                  << "   (id: " << pb_message.id() << ")"
-                  << (relay_message ? " --Relay--" : "");
+    ROUTING_LOG(kVerbose) << "   [" << DebugId(kNodeId_) << "] rcvd : "
+                          << MessageTypeString(pb_message) << " from "
+                          << (relay_message ? HexSubstr(pb_message.relay_id()) :
+                                              HexSubstr(pb_message.source_id()))
+                          << " to " << HexSubstr(pb_message.destination_id())
+                          << "   (id: " << pb_message.id() << ")"
+                          << (relay_message ? " --Relay--" : "");
     if ((!pb_message.client_node() && pb_message.has_source_id()) ||
         (!pb_message.direct() && !pb_message.request())) {
       NodeId source_id(pb_message.source_id());
@@ -547,13 +690,15 @@ void Routing::Impl::DoOnMessageReceived(const std::string& message) {
     message_handler_->HandleMessage(pb_message);
   } else {
     LOG(kWarning) << "Message received, failed to parse";
+    network_statistics_.metrics().MessageDropped(MetricsRegistry::DropReason::kParseFailure);
   }
 }
 
 void Routing::Impl::OnConnectionLost(const NodeId& lost_connection_id) {
   std::lock_guard<std::mutex> lock(running_mutex_);
   if (running_)
-    asio_service_.service().post([=]() { DoOnConnectionLost(lost_connection_id); });  // NOLINT (Fraser)
+    asio_service_.service().post(
+        handler_tracker_.Wrap([=]() { DoOnConnectionLost(lost_connection_id); }));  // NOLINT
 }
 
 void Routing::Impl::DoOnConnectionLost(const NodeId& lost_connection_id) {
@@ -564,6 +709,7 @@ void Routing::Impl::DoOnConnectionLost(const NodeId& lost_connection_id) {
     if (!running_)
       return;
   }
+  network_.session_keys().Remove(lost_connection_id);
 
   NodeInfo dropped_node;
   bool resend(routing_table_.GetNodeInfo(lost_connection_id, dropped_node) &&
@@ -575,6 +721,7 @@ void Routing::Impl::DoOnConnectionLost(const NodeId& lost_connection_id) {
     LOG(kWarning) << "[" << DebugId(kNodeId_) << "]"
                   << "Lost connection with routing node " << DebugId(dropped_node.node_id);
     random_node_helper_.Remove(dropped_node.node_id);
+    group_change_handler_.PeerRemoved(dropped_node.node_id);
   }
 
   // Checking non-routing table
@@ -613,11 +760,12 @@ void Routing::Impl::DoOnConnectionLost(const NodeId& lost_connection_id) {
     // Close node lost, get more nodes
     LOG(kWarning) << "Lost close node, getting more.";
     recovery_timer_.expires_from_now(
-        boost::posix_time::seconds(static_cast<long>(Parameters::recovery_time_lag.count())));  // NOLINT
-    recovery_timer_.async_wait([=](const boost::system::error_code& error_code) {
-                                   if (error_code != boost::asio::error::operation_aborted)
-                                     ReSendFindNodeRequest(error_code, true);
-                                 });
+        boost::posix_time::seconds(static_cast<long>(tuning_.Get()->recovery_time_lag.count())));  // NOLINT
+    recovery_timer_.async_wait(handler_tracker_.Wrap(
+        [=](const boost::system::error_code& error_code) {
+          if (error_code != boost::asio::error::operation_aborted)
+            ReSendFindNodeRequest(error_code, true);
+        }));
   }
 }
 
@@ -625,6 +773,7 @@ void Routing::Impl::RemoveNode(const NodeInfo& node, bool internal_rudp_only) {
   if (node.connection_id.IsZero() || node.node_id.IsZero())
     return;
 
+  group_change_handler_.PeerRemoved(node.node_id);
   network_.Remove(node.connection_id);
   if (internal_rudp_only) {  // No recovery
     LOG(kInfo) << "Routing: removed node : " << DebugId(node.node_id)
@@ -646,11 +795,12 @@ void Routing::Impl::RemoveNode(const NodeInfo& node, bool internal_rudp_only) {
     LOG(kWarning) << "[" << DebugId(kNodeId_)
                   << "] Removed close node, sending find node to get more nodes.";
     recovery_timer_.expires_from_now(
-        boost::posix_time::seconds(static_cast<long>(Parameters::recovery_time_lag.count())));  // NOLINT
-    recovery_timer_.async_wait([=](const boost::system::error_code& error_code) {
-                                   if (error_code != boost::asio::error::operation_aborted)
-                                     ReSendFindNodeRequest(error_code, true);
-                                 });
+        boost::posix_time::seconds(static_cast<long>(tuning_.Get()->recovery_time_lag.count())));  // NOLINT
+    recovery_timer_.async_wait(handler_tracker_.Wrap(
+        [=](const boost::system::error_code& error_code) {
+          if (error_code != boost::asio::error::operation_aborted)
+            ReSendFindNodeRequest(error_code, true);
+        }));
   }
 }
 
@@ -693,11 +843,12 @@ void Routing::Impl::ReSendFindNodeRequest(const boost::system::error_code& error
     if (!running_)
       return;
     recovery_timer_.expires_from_now(
-        boost::posix_time::seconds(static_cast<long>(Parameters::find_node_interval.count())));  // NOLINT
-    recovery_timer_.async_wait([=](boost::system::error_code error_code_local) {
-                                    if (error_code != boost::asio::error::operation_aborted)
-                                      ReSendFindNodeRequest(error_code_local, false);
-                                  });
+        boost::posix_time::seconds(static_cast<long>(tuning_.Get()->find_node_interval.count())));  // NOLINT
+    recovery_timer_.async_wait(handler_tracker_.Wrap(
+        [=](boost::system::error_code error_code_local) {
+          if (error_code != boost::asio::error::operation_aborted)
+            ReSendFindNodeRequest(error_code_local, false);
+        }));
   }
 }
 
@@ -705,11 +856,12 @@ void Routing::Impl::ReBootstrap() {
   std::lock_guard<std::mutex> lock(running_mutex_);
   if (!running_)
     return;
-  re_bootstrap_timer_.expires_from_now(Parameters::re_bootstrap_time_lag);
-  re_bootstrap_timer_.async_wait([=](boost::system::error_code error_code_local) {
-      if (error_code_local != boost::asio::error::operation_aborted)
-        DoReBootstrap(error_code_local);
-    });
+  re_bootstrap_timer_.expires_from_now(tuning_.Get()->re_bootstrap_time_lag);
+  re_bootstrap_timer_.async_wait(handler_tracker_.Wrap(
+      [=](boost::system::error_code error_code_local) {
+        if (error_code_local != boost::asio::error::operation_aborted)
+          DoReBootstrap(error_code_local);
+      }));
 }
 
 void Routing::Impl::DoReBootstrap(const boost::system::error_code& error_code) {
@@ -739,6 +891,22 @@ int Routing::Impl::network_status() {
   return network_status_;
 }
 
+RoutingMetrics Routing::Impl::GetMetrics() {
+  RoutingMetrics metrics(network_statistics_.metrics().Snapshot());
+  metrics.timer_timeouts = timer_.timed_out_count();
+  metrics.response_latency_us = timer_.response_latency().Snapshot();
+  return metrics;
+}
+
+Tuning Routing::Impl::GetTuning() const {
+  return *tuning_.Get();
+}
+
+void Routing::Impl::SetTuning(const Tuning& tuning) {
+  tuning_.Set(tuning);
+  LOG(kInfo) << "[" << DebugId(kNodeId_) << "] tuning updated";
+}
+
 std::vector<NodeInfo> Routing::Impl::ClosestNodes() {
   return routing_table_.GetMatrixNodes();
 }
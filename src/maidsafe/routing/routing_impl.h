@@ -19,6 +19,8 @@
 #ifndef MAIDSAFE_ROUTING_ROUTING_IMPL_H_
 #define MAIDSAFE_ROUTING_ROUTING_IMPL_H_
 
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -27,6 +29,7 @@
 #include "boost/asio/deadline_timer.hpp"
 #include "boost/asio/ip/udp.hpp"
 #include "boost/date_time/posix_time/posix_time_config.hpp"
+#include "boost/filesystem/path.hpp"
 #include "boost/system/error_code.hpp"
 
 #include "maidsafe/common/asio_service.h"
@@ -37,6 +40,8 @@
 #include "maidsafe/routing/api_config.h"
 #include "maidsafe/routing/client_routing_table.h"
 #include "maidsafe/routing/group_change_handler.h"
+#include "maidsafe/routing/handler_tracker.h"
+#include "maidsafe/routing/live_tuning.h"
 #include "maidsafe/routing/message_handler.h"
 #include "maidsafe/routing/network_utils.h"
 #include "maidsafe/routing/random_node_helper.h"
@@ -44,6 +49,7 @@
 #include "maidsafe/routing/routing_api.h"
 #include "maidsafe/routing/routing.pb.h"
 #include "maidsafe/routing/routing_table.h"
+#include "maidsafe/routing/runtime.h"
 #include "maidsafe/routing/timer.h"
 
 
@@ -95,7 +101,9 @@ namespace test { class GenericNode; }
 
 class Routing::Impl {
  public:
-  Impl(bool client_mode, const NodeId& node_id, const asymm::Keys& keys);
+  // If 'runtime' is null, the node runs on a private runtime of two threads.
+  Impl(bool client_mode, const NodeId& node_id, const asymm::Keys& keys,
+       std::shared_ptr<Runtime> runtime);
   ~Impl();
 
   void Join(const Functors& functors,
@@ -137,6 +145,9 @@ class Routing::Impl {
   NodeId kNodeId() const;
 
   int network_status();
+  RoutingMetrics GetMetrics();
+  Tuning GetTuning() const;
+  void SetTuning(const Tuning& tuning);
 
   std::vector<NodeInfo> ClosestNodes();
 
@@ -151,6 +162,12 @@ class Routing::Impl {
   Impl& operator=(const Impl&);
 
   void ConnectFunctors(const Functors& functors);
+  void ScheduleGroupChangeNotification();
+  boost::filesystem::path SnapshotPath() const;
+  // Next to the snapshot, where the bootstrap contact ranking is kept between runs.
+  boost::filesystem::path BootstrapContactsPath() const;
+  void ScheduleSnapshot();
+  void WriteSnapshot();
   void BootstrapFromTheseEndpoints(const std::vector<boost::asio::ip::udp::endpoint>& endpoints);
   void DoJoin(const std::vector<boost::asio::ip::udp::endpoint>& endpoints);
   int DoBootstrap(const std::vector<boost::asio::ip::udp::endpoint>& endpoints);
@@ -158,8 +175,10 @@ class Routing::Impl {
   void DoReBootstrap(const boost::system::error_code &error_code);
   void FindClosestNode(const boost::system::error_code& error_code, int attempts);
   void ReSendFindNodeRequest(const boost::system::error_code& error_code, bool ignore_size);
-  void OnMessageReceived(const std::string& message);
-  void DoOnMessageReceived(const std::string& message);
+  void OnMessageReceived(const std::string& message, const NodeId& peer_connection_id);
+  void DoOnMessageReceived(const std::string& message,
+                           const NodeId& peer_connection_id,
+                           std::chrono::steady_clock::time_point received);
   void OnConnectionLost(const NodeId& lost_connection_id);
   void DoOnConnectionLost(const NodeId& lost_connection_id);
   void RemoveNode(const NodeInfo& node, bool internal_rudp_only);
@@ -170,6 +189,7 @@ class Routing::Impl {
             ResponseFunctor response_functor);
   void SendMessage(const NodeId& destination_id, protobuf::Message& proto_message);
   void PartiallyJoinedSend(protobuf::Message& proto_message);
+  void SampleForTracing(protobuf::Message& proto_message);
   protobuf::Message CreateNodeLevelPartialMessage(
       const NodeId& destination_id,
       const DestinationType& destination_type,
@@ -191,24 +211,33 @@ class Routing::Impl {
 
   std::mutex network_status_mutex_;
   int network_status_;
+  // Ahead of routing_table_, which reads it.
+  LiveTuning tuning_;
   RoutingTable routing_table_;
   const NodeId kNodeId_;
   bool running_;
   std::mutex running_mutex_;
+  std::mutex snapshot_mutex_;
   Functors functors_;
+  std::atomic<uint32_t> trace_sample_count_;
   RandomNodeHelper random_node_helper_;
   ClientRoutingTable client_routing_table_;
   RemoveFurthestNode remove_furthest_node_;
   GroupChangeHandler group_change_handler_;
   NetworkStatistics network_statistics_;
+  // Every handler this object posts or arms on asio_service_ is wrapped by this, so that the
+  // destructor can wait for them when the runtime is shared.
+  HandlerTracker handler_tracker_;
   // The following variables' declarations should remain the last ones in this class and should stay
-  // in the order: message_handler_, asio_service_, network_, all timers.  This is important for the
-  // proper destruction of the routing library, i.e. to avoid segmentation faults.
+  // in the order: message_handler_, runtime_, asio_service_, network_, all timers.  This is
+  // important for the proper destruction of the routing library, i.e. to avoid segmentation faults.
   std::unique_ptr<MessageHandler> message_handler_;
-  AsioService asio_service_;
+  std::shared_ptr<Runtime> runtime_;
+  AsioService& asio_service_;
   NetworkUtils network_;
   Timer<std::string> timer_;
-  boost::asio::deadline_timer re_bootstrap_timer_, recovery_timer_, setup_timer_;
+  boost::asio::deadline_timer re_bootstrap_timer_, recovery_timer_, setup_timer_,
+                              group_change_timer_, snapshot_timer_;
 };
 
 // Implementations
@@ -0,0 +1,70 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_ROUTING_ROUTING_LOG_H_
+#define MAIDSAFE_ROUTING_ROUTING_LOG_H_
+
+#include <limits>
+#include <string>
+
+#include "maidsafe/common/log.h"
+
+#include "maidsafe/routing/parameters.h"
+
+
+// Use ROUTING_LOG(level) in place of LOG(level) where the streamed arguments are costly to build,
+// e.g. DebugId and HexSubstr on the message forwarding path.  Nothing after the macro is evaluated
+// unless 'level' reaches both MAIDSAFE_ROUTING_MIN_LOG_LEVEL, fixed at compile time, and
+// Parameters::log_level, which may be changed at run time and follows the logger's filter.
+
+#ifdef MAIDSAFE_ROUTING_NO_VERBOSE_LOGS
+#  define MAIDSAFE_ROUTING_MIN_LOG_LEVEL maidsafe::log::kInfo
+#else
+#  define MAIDSAFE_ROUTING_MIN_LOG_LEVEL maidsafe::log::kVerbose
+#endif
+
+#define ROUTING_LOG_ENABLED(level)                                                                \
+    (maidsafe::log::level >= MAIDSAFE_ROUTING_MIN_LOG_LEVEL &&                                    \
+     maidsafe::log::level >=                                                                      \
+         maidsafe::routing::Parameters::log_level.load(std::memory_order_relaxed))
+
+#define ROUTING_LOG(level) if (!ROUTING_LOG_ENABLED(level)) {} else LOG(level)  // NOLINT
+
+namespace maidsafe {
+
+namespace routing {
+
+// Raises Parameters::log_level to the lowest level the logger shows for routing, so statements it
+// would drop aren't built.  To be called once logging has been initialised.
+inline void ApplyLoggerLogLevel() {
+  log::FilterMap filter(log::Logging::Instance().Filter());
+  auto itr(filter.find("routing"));
+  if (itr == filter.end())
+    itr = filter.find("*");
+  // With no entry for routing, the logger shows nothing from it.
+  int logger_level(itr == filter.end() ? std::numeric_limits<int>::max() : itr->second);
+  int current(Parameters::log_level.load());
+  while (current < logger_level &&
+         !Parameters::log_level.compare_exchange_weak(current, logger_level)) {}
+}
+
+}  // namespace routing
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_ROUTING_ROUTING_LOG_H_
@@ -23,6 +23,7 @@
 #include <limits>
 #include <map>
 
+#include "maidsafe/common/crypto.h"
 #include "maidsafe/common/log.h"
 #include "maidsafe/common/utils.h"
 #include "maidsafe/common/tools/network_viewer.h"
@@ -37,10 +38,31 @@ namespace maidsafe {
 
 namespace routing {
 
+namespace {
+
+std::string PublicKeyDigest(const asymm::PublicKey& public_key) {
+  try {
+    return crypto::Hash<crypto::SHA512>(asymm::EncodeKey(public_key).string()).string();
+  }
+  catch(const std::exception&) {
+    return std::string();
+  }
+}
+
+std::string RouteCacheKey(const NodeId& target_id,
+                          bool ignore_exact_match,
+                          const Tuning& tuning) {
+  return target_id.string().substr(0, tuning.route_cache_prefix_length) +
+         (ignore_exact_match ? '\1' : '\0');
+}
+
+}  // unnamed namespace
+
 RoutingTable::RoutingTable(bool client_mode,
                            const NodeId& node_id,
                            const asymm::Keys& keys,
-                           NetworkStatistics& network_statistics)
+                           NetworkStatistics& network_statistics,
+                           const LiveTuning* tuning)
     : kClientMode_(client_mode),
       kNodeId_(node_id),
       kConnectionId_(kClientMode_ ? NodeId(NodeId::kRandomId) : kNodeId_),
@@ -56,7 +78,24 @@ RoutingTable::RoutingTable(bool client_mode,
       remove_furthest_node_(),
       connected_group_change_functor_(),
       close_node_replaced_functor_(),
+      matrix_change_functor_(),
+      schedule_group_change_functor_(),
+      group_change_mutex_(),
+      group_change_scheduled_(false),
+      connected_group_changed_(false),
+      pending_connected_close_nodes_(),
+      pending_matrix_change_(),
       nodes_(),
+      close_radii_(),
+      version_(0),
+      default_tuning_(),
+      tuning_(tuning ? *tuning : default_tuning_),
+      route_cache_(),
+      route_cache_index_(),
+      public_key_digests_(),
+      validated_keys_mutex_(),
+      validated_keys_(),
+      validated_keys_index_(),
       group_matrix_(kNodeId_, client_mode),
       ipc_message_queue_(),
       network_statistics_(network_statistics) {
@@ -109,6 +148,32 @@ void RoutingTable::InitialiseFunctors(NetworkStatusFunctor network_status_functo
 //  }
 }
 
+void RoutingTable::set_group_change_scheduling_functor(
+    std::function<void()> schedule_group_change_functor) {
+  std::lock_guard<std::mutex> lock(group_change_mutex_);
+  schedule_group_change_functor_ = schedule_group_change_functor;
+}
+
+void RoutingTable::FlushGroupChanges() {
+  bool connected_group_changed(false);
+  std::vector<NodeInfo> new_connected_close_nodes;
+  std::shared_ptr<MatrixChange> matrix_change;
+  {
+    std::lock_guard<std::mutex> lock(group_change_mutex_);
+    group_change_scheduled_ = false;
+    std::swap(connected_group_changed, connected_group_changed_);
+    new_connected_close_nodes.swap(pending_connected_close_nodes_);
+    matrix_change.swap(pending_matrix_change_);
+  }
+  if (connected_group_changed && connected_group_change_functor_)
+    connected_group_change_functor_(new_connected_close_nodes);
+  // Changes in the window may have cancelled each other out.
+  if (matrix_change && !matrix_change->OldEqualsToNew() && matrix_change_functor_) {
+    metrics().Increment(MetricsRegistry::Counter::kMatrixChangesNotified);
+    matrix_change_functor_(matrix_change);
+  }
+}
+
 bool RoutingTable::AddNode(const NodeInfo& peer) {
   return AddOrCheckNode(peer, true);
 }
@@ -122,9 +187,13 @@ bool RoutingTable::AddOrCheckNode(NodeInfo peer, bool remove) {
     LOG(kError) << "Attempt to add an invalid node " << DebugId(peer.node_id);
     return false;
   }
-  if (remove && !asymm::ValidateKey(peer.public_key)) {
-    LOG(kInfo) << "Invalid public key for node " << DebugId(peer.node_id);
-    return false;
+  std::string public_key_digest;
+  if (remove) {
+    public_key_digest = PublicKeyDigest(peer.public_key);
+    if (!ValidatePublicKey(peer, public_key_digest)) {
+      LOG(kInfo) << "Invalid public key for node " << DebugId(peer.node_id);
+      return false;
+    }
   }
 
   bool return_value(false), remove_furthest_node(false);
@@ -144,10 +213,18 @@ bool RoutingTable::AddOrCheckNode(NodeInfo peer, bool remove) {
       return false;
     }
 
-    if (MakeSpaceForNodeToBeAdded(peer, remove, removed_node, lock)) {
+    if (MakeSpaceForNodeToBeAdded(peer, public_key_digest, remove, removed_node, lock)) {
       if (remove) {
         assert(peer.bucket != NodeInfo::kInvalidBucket);
+        if (!removed_node.node_id.IsZero()) {
+          public_key_digests_.erase(PublicKeyDigest(removed_node.public_key));
+          metrics().Increment(MetricsRegistry::Counter::kNodesDropped);
+        }
         nodes_.push_back(peer);
+        UpdateCloseRadii(lock);
+        ++version_;
+        public_key_digests_.insert(public_key_digest);
+        metrics().Increment(MetricsRegistry::Counter::kNodesAdded);
         old_connected_close_nodes = group_matrix_.GetConnectedPeers();
         matrix_change = UpdateCloseNodeChange(lock, peer, new_connected_close_nodes);
         if (nodes_.size() > Parameters::greedy_fraction)
@@ -180,17 +257,14 @@ bool RoutingTable::AddOrCheckNode(NodeInfo peer, bool remove) {
                      [](const NodeInfo& lhs, const NodeInfo& rhs) {
                        return lhs.node_id == rhs.node_id;
                      }))) {
-      if (connected_group_change_functor_) {
-        connected_group_change_functor_(new_connected_close_nodes);
-      }
+      NotifyConnectedGroupChange(new_connected_close_nodes);
     }
 
     if ((matrix_change != nullptr) && !matrix_change->OldEqualsToNew()) {
       network_statistics_.UpdateLocalAverageDistance(unique_nodes);
       if (close_node_replaced_functor_)
         close_node_replaced_functor_(new_closest_nodes);
-      if (matrix_change_functor_)
-        matrix_change_functor_(matrix_change);
+      NotifyMatrixChange(matrix_change);
       IpcSendGroupMatrix();
     }
 
@@ -220,6 +294,10 @@ NodeInfo RoutingTable::DropNode(const NodeId& node_to_drop, bool routing_only) {
     if (found.first) {
       dropped_node = *found.second;
       nodes_.erase(found.second);
+      UpdateCloseRadii(lock);
+      ++version_;
+      metrics().Increment(MetricsRegistry::Counter::kNodesDropped);
+      public_key_digests_.erase(PublicKeyDigest(dropped_node.public_key));
       old_connected_close_nodes = group_matrix_.GetConnectedPeers();
       matrix_change = group_matrix_.RemoveConnectedPeer(dropped_node);
       new_connected_close_nodes = group_matrix_.GetConnectedPeers();
@@ -238,15 +316,14 @@ NodeInfo RoutingTable::DropNode(const NodeId& node_to_drop, bool routing_only) {
     unique_nodes = group_matrix_.GetUniqueNodeIds();
   }
 
-  if (close_nodes_changed && connected_group_change_functor_)
-    connected_group_change_functor_(new_connected_close_nodes);
+  if (close_nodes_changed)
+    NotifyConnectedGroupChange(new_connected_close_nodes);
 
   if ((matrix_change != nullptr) && !matrix_change->OldEqualsToNew()) {
     network_statistics_.UpdateLocalAverageDistance(unique_nodes);
     if (close_node_replaced_functor_)
       close_node_replaced_functor_(new_closest_nodes);
-    if (matrix_change_functor_)
-      matrix_change_functor_(matrix_change);
+    NotifyMatrixChange(matrix_change);
     IpcSendGroupMatrix();
   }
 
@@ -390,6 +467,8 @@ bool RoutingTable::IsThisNodeInRange(const NodeId& target_id, const uint16_t ran
   std::unique_lock<std::mutex> lock(mutex_);
   if (nodes_.size() < range)
     return true;
+  if (range != 0 && range <= close_radii_.size())
+    return (target_id ^ kNodeId_) < close_radii_[range - 1];
   NthElementSortFromTarget(kNodeId_, range, lock);
   return NodeId::CloserToTarget(target_id, nodes_[range - 1].node_id, kNodeId_);
 }
@@ -399,6 +478,12 @@ bool RoutingTable::IsThisNodeClosestTo(const NodeId& target_id, bool ignore_exac
     LOG(kError) << "Invalid target_id passed.";
     return false;
   }
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    bool closest(false);
+    if (IsThisNodeClosestByCloseRadii(target_id ^ kNodeId_, ignore_exact_match, closest, lock))
+      return closest;
+  }
   NodeInfo closest_node(GetClosestNode(target_id, ignore_exact_match));
   return (closest_node.bucket == NodeInfo::kInvalidBucket) ||
          NodeId::CloserToTarget(kNodeId_, closest_node.node_id, target_id);
@@ -451,9 +536,29 @@ void RoutingTable::GroupUpdateFromConnectedPeer(const NodeId& peer,
       group_matrix_.AddConnectedPeer(*found.second);
     }
     matrix_change = group_matrix_.UpdateFromConnectedPeer(peer, nodes, old_unique_ids);
+    ++version_;
   }
-  if (!matrix_change->OldEqualsToNew() && matrix_change_functor_)
-    matrix_change_functor_(matrix_change);
+  metrics().MatrixUpdated(nodes.size());
+  if (!matrix_change->OldEqualsToNew())
+    NotifyMatrixChange(matrix_change);
+}
+
+bool RoutingTable::GroupPatchFromConnectedPeer(const NodeId& peer,
+                                               const std::vector<NodeInfo>& added,
+                                               const std::vector<NodeId>& removed) {
+  std::shared_ptr<MatrixChange> matrix_change;
+  std::vector<NodeId> old_unique_ids(group_matrix_.GetUniqueNodeIds());
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    matrix_change = group_matrix_.PatchFromConnectedPeer(peer, added, removed, old_unique_ids);
+    ++version_;
+  }
+  metrics().MatrixUpdated(added.size() + removed.size());
+  if (!matrix_change)
+    return false;
+  if (!matrix_change->OldEqualsToNew())
+    NotifyMatrixChange(matrix_change);
+  return true;
 }
 
 std::shared_ptr<MatrixChange> RoutingTable::UpdateCloseNodeChange(
@@ -496,16 +601,39 @@ void RoutingTable::SetBucketIndex(NodeInfo &node_info) const {
   node_info.bucket = 0;
 }
 
-bool RoutingTable::CheckPublicKeyIsUnique(const NodeInfo& node,
+bool RoutingTable::ValidatePublicKey(const NodeInfo& peer, const std::string& public_key_digest) {
+  if (public_key_digest.empty())
+    return false;
+  {
+    std::lock_guard<std::mutex> lock(validated_keys_mutex_);
+    auto itr(validated_keys_index_.find(peer.node_id));
+    if (itr != validated_keys_index_.end() && itr->second->second == public_key_digest) {
+      validated_keys_.splice(validated_keys_.begin(), validated_keys_, itr->second);
+      return true;
+    }
+  }
+  if (!asymm::ValidateKey(peer.public_key))
+    return false;
+
+  std::lock_guard<std::mutex> lock(validated_keys_mutex_);
+  auto itr(validated_keys_index_.find(peer.node_id));
+  if (itr != validated_keys_index_.end())
+    validated_keys_.erase(itr->second);
+  validated_keys_.push_front(std::make_pair(peer.node_id, public_key_digest));
+  validated_keys_index_[peer.node_id] = validated_keys_.begin();
+  while (validated_keys_.size() > Parameters::validated_public_key_cache_size) {
+    validated_keys_index_.erase(validated_keys_.back().first);
+    validated_keys_.pop_back();
+  }
+  return true;
+}
+
+bool RoutingTable::CheckPublicKeyIsUnique(const std::string& public_key_digest,
                                           std::unique_lock<std::mutex>& lock) const {
   assert(lock.owns_lock());
   static_cast<void>(lock);
   // If we already have a duplicate public key return false
-  if (std::find_if(nodes_.begin(),
-                   nodes_.end(),
-                   [node](const NodeInfo& node_info) {
-                     return asymm::MatchingKeys(node_info.public_key, node.public_key);
-                   }) != nodes_.end()) {
+  if (public_key_digests_.count(public_key_digest) != 0) {
     LOG(kInfo) << "Already have node with this public key";
     return false;
   }
@@ -527,12 +655,13 @@ bool RoutingTable::CheckPublicKeyIsUnique(const NodeInfo& node,
 }
 
 bool RoutingTable::MakeSpaceForNodeToBeAdded(const NodeInfo& node,
+                                             const std::string& public_key_digest,
                                              bool remove,
                                              NodeInfo& removed_node,
                                              std::unique_lock<std::mutex>& lock) {
   assert(lock.owns_lock());
 
-  if (remove && !CheckPublicKeyIsUnique(node, lock))
+  if (remove && !CheckPublicKeyIsUnique(public_key_digest, lock))
     return false;
 
   if (nodes_.size() < kMaxSize_)
@@ -589,6 +718,46 @@ uint16_t RoutingTable::PartialSortFromTarget(const NodeId& target,
   return count;
 }
 
+void RoutingTable::UpdateCloseRadii(std::unique_lock<std::mutex>& lock) {
+  uint16_t count(PartialSortFromTarget(kNodeId_, Parameters::closest_nodes_size, lock));
+  close_radii_.clear();
+  for (uint16_t i(0); i != count; ++i)
+    close_radii_.push_back(nodes_[i].node_id ^ kNodeId_);
+}
+
+bool RoutingTable::IsThisNodeClosestByCloseRadii(const NodeId& distance,
+                                                 bool ignore_exact_match,
+                                                 bool& closest,
+                                                 std::unique_lock<std::mutex>& lock) const {
+  assert(lock.owns_lock());
+  static_cast<void>(lock);
+  if (nodes_.empty()) {
+    closest = true;
+    return true;
+  }
+  if (close_radii_.empty())
+    return false;
+  // A node at 'radius' from this one is at (radius ^ distance) from the target, which is less than
+  // 'distance' only if radius's highest set bit is set in 'distance'.
+  for (const auto& radius : close_radii_) {
+    if (ignore_exact_match && radius == distance)
+      continue;
+    if ((radius ^ distance) < distance) {
+      closest = false;
+      return true;
+    }
+  }
+  // Any node not in close_radii_ is further out than its last entry, so if that entry's highest
+  // set bit is above distance's, so is theirs and none of them is closer to the target.
+  if (close_radii_.size() != nodes_.size()) {
+    const NodeId& outer_radius(close_radii_.back());
+    if (!(distance < outer_radius && (distance ^ outer_radius) > distance))
+      return false;
+  }
+  closest = true;
+  return true;
+}
+
 void RoutingTable::NthElementSortFromTarget(const NodeId& target,
                                             uint16_t nth_element,
                                             std::unique_lock<std::mutex>& lock) {
@@ -649,6 +818,20 @@ NodeInfo RoutingTable::GetNodeForSendingMessage(const NodeId& target_id,
 NodeInfo RoutingTable::GetNodeForSendingMessage(const NodeId& target_id,
                                                 const std::vector<std::string>& exclude,
                                                 bool ignore_exact_match) {
+  std::shared_ptr<const Tuning> tuning(tuning_.Get());
+  uint64_t version(0);
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    NodeInfo cached_peer;
+    if (GetCachedRoute(target_id, exclude, ignore_exact_match, *tuning, cached_peer, lock)) {
+      metrics().Increment(MetricsRegistry::Counter::kRouteCacheHits);
+      return cached_peer;
+    }
+    version = version_;
+  }
+  if (tuning->route_cache_size != 0)
+    metrics().Increment(MetricsRegistry::Counter::kRouteCacheMisses);
+
   NodeInfo current_peer(GetClosestNode(target_id, exclude, ignore_exact_match));
   std::unique_lock<std::mutex> lock(mutex_);
   if (current_peer.node_id != target_id) {
@@ -657,6 +840,9 @@ NodeInfo RoutingTable::GetNodeForSendingMessage(const NodeId& target_id,
                                                  ignore_exact_match,
                                                  current_peer);
   }
+  // Not cached if the table changed while the lock was released, as it may already be stale.
+  if (version == version_)
+    CacheRoute(target_id, ignore_exact_match, current_peer, *tuning, lock);
   std::string excluded_ids;
   for (const auto& excluded_id : exclude) {
     excluded_ids.append("\t");
@@ -667,6 +853,60 @@ NodeInfo RoutingTable::GetNodeForSendingMessage(const NodeId& target_id,
   return current_peer;
 }
 
+bool RoutingTable::GetCachedRoute(const NodeId& target_id,
+                                  const std::vector<std::string>& exclude,
+                                  bool ignore_exact_match,
+                                  const Tuning& tuning,
+                                  NodeInfo& next_hop,
+                                  std::unique_lock<std::mutex>& lock) {
+  assert(lock.owns_lock());
+  if (tuning.route_cache_size == 0 || route_cache_.empty())
+    return false;
+  auto itr(route_cache_index_.find(RouteCacheKey(target_id, ignore_exact_match, tuning)));
+  if (itr == route_cache_index_.end())
+    return false;
+  const CachedRoute& route(*itr->second);
+  if (route.version != version_) {
+    route_cache_.erase(itr->second);
+    route_cache_index_.erase(itr);
+    return false;
+  }
+  // The hop may have been chosen for another destination sharing the prefix, or with a different
+  // route history, so is only used where it still makes progress towards this destination.  A
+  // destination which is itself connected is always sent to directly.
+  const NodeId& hop_id(route.next_hop.node_id);
+  if ((ignore_exact_match && hop_id == target_id) ||
+      std::find(exclude.begin(), exclude.end(), hop_id.string()) != exclude.end() ||
+      !NodeId::CloserToTarget(hop_id, kNodeId_, target_id) ||
+      (!ignore_exact_match && hop_id != target_id && Find(target_id, lock).first)) {
+    return false;
+  }
+  route_cache_.splice(route_cache_.begin(), route_cache_, itr->second);
+  next_hop = route.next_hop;
+  return true;
+}
+
+void RoutingTable::CacheRoute(const NodeId& target_id,
+                              bool ignore_exact_match,
+                              const NodeInfo& next_hop,
+                              const Tuning& tuning,
+                              std::unique_lock<std::mutex>& lock) {
+  assert(lock.owns_lock());
+  static_cast<void>(lock);
+  if (tuning.route_cache_size == 0 || next_hop.node_id.IsZero())
+    return;
+  std::string key(RouteCacheKey(target_id, ignore_exact_match, tuning));
+  auto itr(route_cache_index_.find(key));
+  if (itr != route_cache_index_.end())
+    route_cache_.erase(itr->second);
+  route_cache_.push_front(CachedRoute(key, next_hop, version_));
+  route_cache_index_[key] = route_cache_.begin();
+  while (route_cache_.size() > tuning.route_cache_size) {
+    route_cache_index_.erase(route_cache_.back().key);
+    route_cache_.pop_back();
+  }
+}
+
 NodeInfo RoutingTable::GetRemovableNode(std::vector<std::string> attempted) {
   std::map<uint32_t, uint16_t> bucket_rank_map;
   std::unique_lock<std::mutex> lock(mutex_);
@@ -839,11 +1079,78 @@ void RoutingTable::UpdateNetworkStatus(uint16_t size) const {
   LOG(kVerbose) << DebugId(kNodeId_) << " Updating network status !!! " << (size * 100) / kMaxSize_;
 }
 
+uint16_t RoutingTable::BucketOccupancy(const NodeId& node_id) const {
+  NodeInfo node_info;
+  node_info.node_id = node_id;
+  SetBucketIndex(node_info);
+  std::lock_guard<std::mutex> lock(mutex_);
+  return static_cast<uint16_t>(std::count_if(nodes_.begin(),
+                                             nodes_.end(),
+                                             [&node_info] (const NodeInfo& node) {
+                                               return node.bucket == node_info.bucket;
+                                             }));
+}
+
 size_t RoutingTable::size() const {
   std::lock_guard<std::mutex> lock(mutex_);
   return nodes_.size();
 }
 
+uint64_t RoutingTable::version() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return version_;
+}
+
+void RoutingTable::NotifyConnectedGroupChange(
+    const std::vector<NodeInfo>& new_connected_close_nodes) {
+  std::function<void()> schedule_group_change_functor;
+  bool coalesce(false);
+  {
+    std::lock_guard<std::mutex> lock(group_change_mutex_);
+    coalesce = static_cast<bool>(schedule_group_change_functor_);
+    if (coalesce) {
+      // Only the latest connected group is of interest.
+      connected_group_changed_ = true;
+      pending_connected_close_nodes_ = new_connected_close_nodes;
+      if (!group_change_scheduled_)
+        schedule_group_change_functor = schedule_group_change_functor_;
+      group_change_scheduled_ = true;
+    }
+  }
+  if (schedule_group_change_functor)
+    schedule_group_change_functor();
+  else if (!coalesce && connected_group_change_functor_)
+    connected_group_change_functor_(new_connected_close_nodes);
+}
+
+void RoutingTable::NotifyMatrixChange(std::shared_ptr<MatrixChange> matrix_change) {
+  std::function<void()> schedule_group_change_functor;
+  bool coalesce(false);
+  {
+    std::lock_guard<std::mutex> lock(group_change_mutex_);
+    coalesce = static_cast<bool>(schedule_group_change_functor_);
+    if (coalesce) {
+      // The merged change spans from the oldest pending matrix to the newest.
+      if (pending_matrix_change_) {
+        pending_matrix_change_ = std::make_shared<MatrixChange>(
+            MatrixChange(kNodeId_, pending_matrix_change_->kOldMatrix_,
+                         matrix_change->kNewMatrix_));
+      } else {
+        pending_matrix_change_ = matrix_change;
+      }
+      if (!group_change_scheduled_)
+        schedule_group_change_functor = schedule_group_change_functor_;
+      group_change_scheduled_ = true;
+    }
+  }
+  if (schedule_group_change_functor) {
+    schedule_group_change_functor();
+  } else if (!coalesce && matrix_change_functor_) {
+    metrics().Increment(MetricsRegistry::Counter::kMatrixChangesNotified);
+    matrix_change_functor_(matrix_change);
+  }
+}
+
 void RoutingTable::IpcSendGroupMatrix() const {
   if (ipc_message_queue_) {
     network_viewer::MatrixRecord matrix_record(kNodeId_);
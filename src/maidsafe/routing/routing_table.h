@@ -20,8 +20,11 @@
 #define MAIDSAFE_ROUTING_ROUTING_TABLE_H_
 
 #include <cstdint>
+#include <list>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
@@ -37,6 +40,7 @@
 
 #include "maidsafe/routing/api_config.h"
 #include "maidsafe/routing/group_matrix.h"
+#include "maidsafe/routing/live_tuning.h"
 #include "maidsafe/routing/network_statistics.h"
 #include "maidsafe/routing/parameters.h"
 
@@ -68,8 +72,9 @@ typedef std::function<void(std::vector<NodeInfo> /*new_group*/)>
 
 class RoutingTable {
  public:
+  // The route cache follows 'tuning', or the Parameters defaults if that is null.
   RoutingTable(bool client_mode, const NodeId& node_id, const asymm::Keys& keys,
-               NetworkStatistics& network_statistics);
+               NetworkStatistics& network_statistics, const LiveTuning* tuning = nullptr);
   virtual ~RoutingTable();
   void InitialiseFunctors(NetworkStatusFunctor network_status_functor,
                           std::function<void(const NodeInfo&, bool)> remove_node_functor,
@@ -77,6 +82,10 @@ class RoutingTable {
                           ConnectedGroupChangeFunctor connected_group_change_functor,
                           CloseNodeReplacedFunctor close_node_replaced_functor,
                           MatrixChangedFunctor matrix_change_functor);
+  // If set, connected group and matrix changes are held back and merged until FlushGroupChanges is
+  // called.  The functor is called when the first change is held back.
+  void set_group_change_scheduling_functor(std::function<void()> schedule_group_change_functor);
+  void FlushGroupChanges();
   bool AddNode(const NodeInfo& peer);
   bool CheckNode(const NodeInfo& peer);
   NodeInfo DropNode(const NodeId &node_to_drop, bool routing_only);
@@ -96,6 +105,10 @@ class RoutingTable {
   bool Contains(const NodeId& node_id) const;
   bool ConfirmGroupMembers(const NodeId& node1, const NodeId& node2);
   void GroupUpdateFromConnectedPeer(const NodeId& peer, const std::vector<NodeInfo>& nodes);
+  // Returns false if peer's matrix row is unknown and a full update is needed instead.
+  bool GroupPatchFromConnectedPeer(const NodeId& peer,
+                                   const std::vector<NodeInfo>& added,
+                                   const std::vector<NodeId>& removed);
   NodeId RandomConnectedNode();
   std::vector<NodeInfo> GetMatrixNodes();
   bool IsConnected(const NodeId& node_id);
@@ -115,13 +128,18 @@ class RoutingTable {
   std::vector<NodeId> GetGroup(const NodeId& target_id);
   NodeInfo GetRemovableNode(std::vector<std::string> attempted = std::vector<std::string>());
   void GetNodesNeedingGroupUpdates(std::vector<NodeInfo>& nodes_needing_update);
+  // Returns the number of nodes held in the bucket node_id would be placed in.
+  uint16_t BucketOccupancy(const NodeId& node_id) const;
   size_t size() const;
+  // Changes whenever the set of nodes or the group matrix changes.
+  uint64_t version() const;
   uint16_t kThresholdSize() const { return kThresholdSize_; }
   NodeId kNodeId() const { return kNodeId_; }
   asymm::PrivateKey kPrivateKey() const { return kKeys_.private_key; }
   asymm::PublicKey kPublicKey() const { return kKeys_.public_key; }
   NodeId kConnectionId() const { return kConnectionId_; }
   bool client_mode() const { return kClientMode_; }
+  MetricsRegistry& metrics() { return network_statistics_.metrics(); }
 
   friend class test::GenericNode;
   friend class GroupChangeHandler;
@@ -136,9 +154,20 @@ class RoutingTable {
  private:
   RoutingTable(const RoutingTable&);
   RoutingTable& operator=(const RoutingTable&);
+  struct CachedRoute {
+    CachedRoute(const std::string& key_in, const NodeInfo& next_hop_in, uint64_t version_in)
+        : key(key_in), next_hop(next_hop_in), version(version_in) {}
+    std::string key;
+    NodeInfo next_hop;
+    uint64_t version;
+  };
+
   bool AddOrCheckNode(NodeInfo node, bool remove);
   void SetBucketIndex(NodeInfo& node_info) const;
-  bool CheckPublicKeyIsUnique(const NodeInfo& node, std::unique_lock<std::mutex>& lock) const;
+  // Validates peer's key unless the same key was validated for it recently.
+  bool ValidatePublicKey(const NodeInfo& peer, const std::string& public_key_digest);
+  bool CheckPublicKeyIsUnique(const std::string& public_key_digest,
+                              std::unique_lock<std::mutex>& lock) const;
   NodeInfo ResolveConnectionDuplication(const NodeInfo& new_duplicate_node,
                                         bool local_endpoint,
                                         NodeInfo& existing_node);
@@ -146,6 +175,7 @@ class RoutingTable {
                                                       const NodeInfo& peer,
                                                       std::vector<NodeInfo>& new_connected_nodes);
   bool MakeSpaceForNodeToBeAdded(const NodeInfo& node,
+                                 const std::string& public_key_digest,
                                  bool remove,
                                  NodeInfo& removed_node,
                                  std::unique_lock<std::mutex>& lock);
@@ -155,6 +185,27 @@ class RoutingTable {
   void NthElementSortFromTarget(const NodeId& target,
                                 uint16_t nth_element,
                                 std::unique_lock<std::mutex>& lock);
+  // Must be called whenever a node is added to or removed from nodes_.
+  void UpdateCloseRadii(std::unique_lock<std::mutex>& lock);
+  // Sets 'closest' to whether this node is closer than any other to the target at 'distance' from
+  // it, if that can be decided from close_radii_ alone.  Returns false otherwise.
+  bool IsThisNodeClosestByCloseRadii(const NodeId& distance,
+                                     bool ignore_exact_match,
+                                     bool& closest,
+                                     std::unique_lock<std::mutex>& lock) const;
+  // Sets 'next_hop' to the hop remembered for target_id, if it is still current, is not excluded
+  // and is closer to target_id than this node.  Returns false otherwise.
+  bool GetCachedRoute(const NodeId& target_id,
+                      const std::vector<std::string>& exclude,
+                      bool ignore_exact_match,
+                      const Tuning& tuning,
+                      NodeInfo& next_hop,
+                      std::unique_lock<std::mutex>& lock);
+  void CacheRoute(const NodeId& target_id,
+                  bool ignore_exact_match,
+                  const NodeInfo& next_hop,
+                  const Tuning& tuning,
+                  std::unique_lock<std::mutex>& lock);
   NodeId FurthestCloseNode();
   std::vector<NodeInfo> GetClosestNodeInfo(const NodeId& target_id,
                                            uint16_t number_to_get,
@@ -165,6 +216,8 @@ class RoutingTable {
       const NodeId& node_id,
       std::unique_lock<std::mutex>& lock) const;
   void UpdateNetworkStatus(uint16_t size) const;
+  void NotifyConnectedGroupChange(const std::vector<NodeInfo>& new_connected_close_nodes);
+  void NotifyMatrixChange(std::shared_ptr<MatrixChange> matrix_change);
 
   void IpcSendGroupMatrix() const;
   std::string PrintRoutingTable();
@@ -184,7 +237,30 @@ class RoutingTable {
   ConnectedGroupChangeFunctor connected_group_change_functor_;
   CloseNodeReplacedFunctor close_node_replaced_functor_;
   MatrixChangedFunctor matrix_change_functor_;
+  std::function<void()> schedule_group_change_functor_;
+  std::mutex group_change_mutex_;
+  bool group_change_scheduled_, connected_group_changed_;
+  std::vector<NodeInfo> pending_connected_close_nodes_;
+  std::shared_ptr<MatrixChange> pending_matrix_change_;
   std::vector<NodeInfo> nodes_;
+  // Distances from this node of the up to Parameters::closest_nodes_size nodes closest to it,
+  // nearest first, i.e. the radius of each size of close group.  Range checks compare against
+  // these rather than sorting nodes_.
+  std::vector<NodeId> close_radii_;
+  // Incremented whenever nodes_ or group_matrix_ changes, which invalidates any cached route.
+  uint64_t version_;
+  // Used where no node's tuning is given.
+  LiveTuning default_tuning_;
+  const LiveTuning& tuning_;
+  // Most recently used first, keyed by destination ID prefix, with an index by key.
+  std::list<CachedRoute> route_cache_;
+  std::map<std::string, std::list<CachedRoute>::iterator> route_cache_index_;
+  // Digests of the public keys of nodes_.
+  std::set<std::string> public_key_digests_;
+  std::mutex validated_keys_mutex_;
+  // Most recently validated first, as (node ID, public key digest), with an index by node ID.
+  std::list<std::pair<NodeId, std::string>> validated_keys_;
+  std::map<NodeId, std::list<std::pair<NodeId, std::string>>::iterator> validated_keys_index_;
   GroupMatrix group_matrix_;
   std::unique_ptr<boost::interprocess::message_queue> ipc_message_queue_;
   NetworkStatistics& network_statistics_;
@@ -0,0 +1,185 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/routing/routing_table_snapshot.h"
+
+#include <algorithm>
+#include <string>
+
+#include "boost/filesystem/operations.hpp"
+
+#include "maidsafe/common/crypto.h"
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/rsa.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/routing/network_utils.h"
+#include "maidsafe/routing/parameters.h"
+#include "maidsafe/routing/routing.pb.h"
+#include "maidsafe/routing/routing_table.h"
+#include "maidsafe/routing/utils.h"
+
+
+namespace fs = boost::filesystem;
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace {
+
+typedef boost::asio::ip::udp::endpoint Endpoint;
+
+std::vector<const protobuf::SnapshotPeer*> SortedPeers(
+    const protobuf::RoutingTableSnapshot& snapshot,
+    const NodeId& node_id) {
+  std::vector<const protobuf::SnapshotPeer*> peers;
+  for (const auto& peer : snapshot.peers())
+    peers.push_back(&peer);
+  std::sort(peers.begin(), peers.end(),
+            [&node_id] (const protobuf::SnapshotPeer* lhs, const protobuf::SnapshotPeer* rhs) {
+              return NodeId::CloserToTarget(NodeId(lhs->node_id()), NodeId(rhs->node_id()),
+                                            node_id);
+            });
+  return peers;
+}
+
+}  // unnamed namespace
+
+protobuf::RoutingTableSnapshot MakeRoutingTableSnapshot(RoutingTable& routing_table,
+                                                        const NetworkUtils& network) {
+  protobuf::RoutingTableSnapshot snapshot;
+  std::vector<NodeId> peer_ids(routing_table.GetClosestNodes(routing_table.kNodeId(),
+                                                             Parameters::max_routing_table_size));
+  for (const auto& peer_id : peer_ids) {
+    NodeInfo node_info;
+    if (!routing_table.GetNodeInfo(peer_id, node_info))
+      continue;
+    protobuf::SnapshotPeer* peer(snapshot.add_peers());
+    peer->set_node_id(node_info.node_id.string());
+    peer->set_connection_id(node_info.connection_id.string());
+    rudp::EndpointPair endpoint_pair;
+    if (network.GetPeerEndpoints(node_info.connection_id, endpoint_pair)) {
+      SetProtobufEndpoint(endpoint_pair.external, peer->mutable_public_endpoint());
+      SetProtobufEndpoint(endpoint_pair.local, peer->mutable_private_endpoint());
+    }
+    peer->set_nat_type(NatTypeProtobuf(node_info.nat_type));
+    std::string public_key_digest(SnapshotPublicKeyDigest(node_info.public_key));
+    if (!public_key_digest.empty())
+      peer->set_public_key_digest(public_key_digest);
+  }
+  for (const auto& node_info : routing_table.GetMatrixNodes()) {
+    if (std::find(peer_ids.begin(), peer_ids.end(), node_info.node_id) == peer_ids.end() &&
+        node_info.node_id != routing_table.kNodeId())
+      snapshot.add_matrix_node_ids(node_info.node_id.string());
+  }
+  return snapshot;
+}
+
+bool WriteRoutingTableSnapshot(const protobuf::RoutingTableSnapshot& snapshot,
+                               const fs::path& snapshot_path) {
+  std::string serialised_snapshot;
+  if (!snapshot.SerializeToString(&serialised_snapshot)) {
+    LOG(kError) << "Could not serialise routing table snapshot.";
+    return false;
+  }
+  fs::path temp_path(snapshot_path);
+  temp_path += ".tmp";
+  if (!WriteFile(temp_path, serialised_snapshot)) {
+    LOG(kError) << "Could not write routing table snapshot to " << temp_path;
+    return false;
+  }
+  boost::system::error_code error_code;
+  fs::rename(temp_path, snapshot_path, error_code);
+  if (error_code) {
+    LOG(kError) << "Could not replace routing table snapshot " << snapshot_path << ": "
+                << error_code.message();
+    fs::remove(temp_path, error_code);
+    return false;
+  }
+  return true;
+}
+
+bool ReadRoutingTableSnapshot(const fs::path& snapshot_path,
+                              protobuf::RoutingTableSnapshot& snapshot) {
+  boost::system::error_code error_code;
+  if (!fs::exists(snapshot_path, error_code))
+    return false;
+  std::string serialised_snapshot;
+  if (!ReadFile(snapshot_path, &serialised_snapshot) ||
+      !snapshot.ParseFromString(serialised_snapshot)) {
+    LOG(kWarning) << "Could not read routing table snapshot " << snapshot_path;
+    snapshot.Clear();
+    return false;
+  }
+  return true;
+}
+
+std::vector<Endpoint> SnapshotBootstrapEndpoints(const protobuf::RoutingTableSnapshot& snapshot,
+                                                 const NodeId& node_id) {
+  std::vector<Endpoint> endpoints;
+  auto add_endpoint([&endpoints] (const protobuf::Endpoint& pb_endpoint) {
+    Endpoint endpoint(GetEndpointFromProtobuf(pb_endpoint));
+    if (!endpoint.address().is_unspecified() &&
+        std::find(endpoints.begin(), endpoints.end(), endpoint) == endpoints.end())
+      endpoints.push_back(endpoint);
+  });
+  for (const auto& peer : SortedPeers(snapshot, node_id)) {
+    if (peer->has_public_endpoint())
+      add_endpoint(peer->public_endpoint());
+    if (peer->has_private_endpoint())
+      add_endpoint(peer->private_endpoint());
+  }
+  return endpoints;
+}
+
+std::vector<NodeId> SnapshotNodeIds(const protobuf::RoutingTableSnapshot& snapshot,
+                                    const NodeId& node_id) {
+  std::vector<NodeId> node_ids;
+  for (const auto& peer : snapshot.peers())
+    node_ids.push_back(NodeId(peer.node_id()));
+  for (const auto& matrix_node_id : snapshot.matrix_node_ids())
+    node_ids.push_back(NodeId(matrix_node_id));
+  std::sort(node_ids.begin(), node_ids.end(),
+            [&node_id] (const NodeId& lhs, const NodeId& rhs) {
+              return NodeId::CloserToTarget(lhs, rhs, node_id);
+            });
+  node_ids.erase(std::unique(node_ids.begin(), node_ids.end()), node_ids.end());
+  node_ids.erase(std::remove(node_ids.begin(), node_ids.end(), node_id), node_ids.end());
+  return node_ids;
+}
+
+std::map<NodeId, std::string> SnapshotPublicKeyDigests(
+    const protobuf::RoutingTableSnapshot& snapshot) {
+  std::map<NodeId, std::string> public_key_digests;
+  for (const auto& peer : snapshot.peers()) {
+    if (!peer.public_key_digest().empty())
+      public_key_digests[NodeId(peer.node_id())] = peer.public_key_digest();
+  }
+  return public_key_digests;
+}
+
+std::string SnapshotPublicKeyDigest(const asymm::PublicKey& public_key) {
+  if (!asymm::ValidateKey(public_key))
+    return std::string();
+  return crypto::Hash<crypto::SHA512>(asymm::EncodeKey(public_key).string()).string();
+}
+
+}  // namespace routing
+
+}  // namespace maidsafe
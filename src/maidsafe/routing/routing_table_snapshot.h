@@ -0,0 +1,75 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_ROUTING_ROUTING_TABLE_SNAPSHOT_H_
+#define MAIDSAFE_ROUTING_ROUTING_TABLE_SNAPSHOT_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "boost/asio/ip/udp.hpp"
+#include "boost/filesystem/path.hpp"
+
+#include "maidsafe/common/node_id.h"
+#include "maidsafe/common/rsa.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace protobuf { class RoutingTableSnapshot; }
+
+class NetworkUtils;
+class RoutingTable;
+
+// Records the routing table's peers with the endpoints they are connected on, plus the IDs of the
+// other nodes known through the group matrix.
+protobuf::RoutingTableSnapshot MakeRoutingTableSnapshot(RoutingTable& routing_table,
+                                                        const NetworkUtils& network);
+
+// Writes to a temporary file which is then renamed over 'snapshot_path', so an interrupted write
+// leaves the previous snapshot intact.
+bool WriteRoutingTableSnapshot(const protobuf::RoutingTableSnapshot& snapshot,
+                               const boost::filesystem::path& snapshot_path);
+
+bool ReadRoutingTableSnapshot(const boost::filesystem::path& snapshot_path,
+                              protobuf::RoutingTableSnapshot& snapshot);
+
+// Endpoints of the snapshot's peers, closest to 'node_id' first, for use as bootstrap contacts.
+std::vector<boost::asio::ip::udp::endpoint> SnapshotBootstrapEndpoints(
+    const protobuf::RoutingTableSnapshot& snapshot,
+    const NodeId& node_id);
+
+// IDs of the snapshot's peers and matrix nodes, closest to 'node_id' first.
+std::vector<NodeId> SnapshotNodeIds(const protobuf::RoutingTableSnapshot& snapshot,
+                                    const NodeId& node_id);
+
+// Digest of each snapshot peer's public key, where one was recorded.
+std::map<NodeId, std::string> SnapshotPublicKeyDigests(
+    const protobuf::RoutingTableSnapshot& snapshot);
+
+// The digest recorded for 'public_key' in a snapshot, or an empty string if the key is invalid.
+std::string SnapshotPublicKeyDigest(const asymm::PublicKey& public_key);
+
+}  // namespace routing
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_ROUTING_ROUTING_TABLE_SNAPSHOT_H_
@@ -34,6 +34,31 @@ namespace routing {
 
 namespace rpcs {
 
+namespace {
+
+protobuf::Message ClosestNodesUpdateMessage(
+    const NodeId& node_id,
+    const NodeId& my_node_id,
+    protobuf::ClosestNodesUpdate closest_nodes_update) {
+  closest_nodes_update.set_accepts_delta(true);
+  protobuf::Message message;
+  message.set_destination_id(node_id.string());
+  message.set_source_id(my_node_id.string());
+  message.set_routing_message(true);
+  message.add_data(closest_nodes_update.SerializeAsString());
+  message.set_direct(true);
+  message.set_replication(1);
+  message.set_type(static_cast<int32_t>(MessageType::kClosestNodesUpdate));
+  message.set_request(true);
+  message.set_client_node(false);
+  message.set_hops_to_live(Parameters::hops_to_live);
+  message.set_id(RandomUint32() % 10000);
+  assert(message.IsInitialized() && "Unintialised message");
+  return message;
+}
+
+}  // unnamed namespace
+
 // This is maybe not required and might be removed
 protobuf::Message Ping(const NodeId& node_id, const std::string& identity) {
   assert(!node_id.IsZero() && "Invalid node_id");
@@ -63,7 +88,8 @@ protobuf::Message Connect(const NodeId& node_id,
                           bool client_node,
                           rudp::NatType nat_type,
                           bool relay_message,
-                          NodeId relay_connection_id) {
+                          NodeId relay_connection_id,
+                          const std::string& session_nonce) {
   assert(!node_id.IsZero() && "Invalid node_id");
   assert(!this_node_id.IsZero() && "Invalid my node_id");
   assert(!this_connection_id.IsZero() && "Invalid this_connection_id");
@@ -79,6 +105,8 @@ protobuf::Message Connect(const NodeId& node_id,
   contact->set_connection_id(this_connection_id.string());
   contact->set_nat_type(NatTypeProtobuf(nat_type));
   protobuf_connect_request.set_timestamp(GetTimeStamp());
+  if (!session_nonce.empty())
+    protobuf_connect_request.set_session_nonce(session_nonce);
   message.set_id(RandomUint32() % 10000);
   message.set_destination_id(node_id.string());
   message.set_routing_message(true);
@@ -203,7 +231,8 @@ protobuf::Message ConnectSuccessAcknowledgement(const NodeId& node_id,
                                                 const NodeId& this_connection_id,
                                                 const bool& requestor,
                                                 const std::vector<NodeId>& close_ids,
-                                                const bool& client_node) {
+                                                const bool& client_node,
+                                                const std::string& session_secret) {
   assert(!node_id.IsZero() && "Invalid node_id");
   assert(!this_node_id.IsZero() && "Invalid my node_id");
   assert(!this_connection_id.IsZero() && "Invalid this_connection_id");
@@ -215,6 +244,8 @@ protobuf::Message ConnectSuccessAcknowledgement(const NodeId& node_id,
   for (const auto& i : close_ids) {
     protobuf_connect_success_ack.add_close_ids(i.string());
   }
+  if (!session_secret.empty())
+    protobuf_connect_success_ack.set_session_secret(session_secret);
   message.set_destination_id(node_id.string());
   message.set_routing_message(true);
   message.add_data(protobuf_connect_success_ack.SerializeAsString());
@@ -235,11 +266,11 @@ protobuf::Message ConnectSuccessAcknowledgement(const NodeId& node_id,
 protobuf::Message ClosestNodesUpdate(
     const NodeId& node_id,
     const NodeId& my_node_id,
-    const std::vector<NodeInfo>& closest_nodes) {
+    const std::vector<NodeInfo>& closest_nodes,
+    const uint32_t& sequence) {
   assert(!node_id.IsZero() && "Invalid node_id");
   assert(!my_node_id.IsZero() && "Invalid my node_id");
   // assert(!close_nodes.empty() && "Empty close nodes");
-  protobuf::Message message;
   protobuf::ClosestNodesUpdate closest_nodes_update;
   closest_nodes_update.set_node(my_node_id.string());
   for (const auto& i : closest_nodes) {
@@ -248,19 +279,42 @@ protobuf::Message ClosestNodesUpdate(
     basic_node_info->set_node_id(i.node_id.string());
     basic_node_info->set_rank(i.rank);
   }
-  message.set_destination_id(node_id.string());
-  message.set_source_id(my_node_id.string());
-  message.set_routing_message(true);
-  message.add_data(closest_nodes_update.SerializeAsString());
-  message.set_direct(true);
-  message.set_replication(1);
-  message.set_type(static_cast<int32_t>(MessageType::kClosestNodesUpdate));
-  message.set_request(true);
-  message.set_client_node(false);
-  message.set_hops_to_live(Parameters::hops_to_live);
-  message.set_id(RandomUint32() % 10000);
-  assert(message.IsInitialized() && "Unintialised message");
-  return message;
+  if (sequence != 0)
+    closest_nodes_update.set_sequence(sequence);
+  return ClosestNodesUpdateMessage(node_id, my_node_id, closest_nodes_update);
+}
+
+protobuf::Message ClosestNodesUpdateDelta(
+    const NodeId& node_id,
+    const NodeId& my_node_id,
+    const std::vector<NodeInfo>& added_nodes,
+    const std::vector<NodeId>& removed_nodes,
+    const uint32_t& sequence) {
+  assert(!node_id.IsZero() && "Invalid node_id");
+  assert(!my_node_id.IsZero() && "Invalid my node_id");
+  assert(sequence != 0 && "Invalid sequence");
+  protobuf::ClosestNodesUpdate closest_nodes_update;
+  closest_nodes_update.set_node(my_node_id.string());
+  closest_nodes_update.set_delta(true);
+  closest_nodes_update.set_sequence(sequence);
+  for (const auto& i : added_nodes) {
+    protobuf::BasicNodeInfo* basic_node_info;
+    basic_node_info = closest_nodes_update.add_added_nodes();
+    basic_node_info->set_node_id(i.node_id.string());
+    basic_node_info->set_rank(i.rank);
+  }
+  for (const auto& i : removed_nodes)
+    closest_nodes_update.add_removed_nodes(i.string());
+  return ClosestNodesUpdateMessage(node_id, my_node_id, closest_nodes_update);
+}
+
+protobuf::Message ClosestNodesUpdateResync(const NodeId& node_id, const NodeId& my_node_id) {
+  assert(!node_id.IsZero() && "Invalid node_id");
+  assert(!my_node_id.IsZero() && "Invalid my node_id");
+  protobuf::ClosestNodesUpdate closest_nodes_update;
+  closest_nodes_update.set_node(my_node_id.string());
+  closest_nodes_update.set_resync(true);
+  return ClosestNodesUpdateMessage(node_id, my_node_id, closest_nodes_update);
 }
 
 protobuf::Message GetGroup(const NodeId& node_id,
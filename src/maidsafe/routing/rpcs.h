@@ -48,7 +48,8 @@ protobuf::Message Connect(const NodeId& node_id,
     bool client_node = false,
     rudp::NatType nat_type = rudp::NatType::kUnknown,
     bool relay_message = false,
-    NodeId relay_connection_id = NodeId());
+    NodeId relay_connection_id = NodeId(),
+    const std::string& session_nonce = std::string());
 
 protobuf::Message Remove(const NodeId& node_id,
                          const NodeId& this_node_id,
@@ -82,11 +83,21 @@ protobuf::Message ConnectSuccessAcknowledgement(
     const NodeId& this_connection_id,
     const bool& requestor,
     const std::vector<NodeId>& close_ids,
-    const bool& client_node);
+    const bool& client_node,
+    const std::string& session_secret = std::string());
 
 protobuf::Message ClosestNodesUpdate(const NodeId& node_id,
     const NodeId& my_node_id,
-    const std::vector<NodeInfo>& closest_nodes);
+    const std::vector<NodeInfo>& closest_nodes,
+    const uint32_t& sequence = 0);
+
+protobuf::Message ClosestNodesUpdateDelta(const NodeId& node_id,
+    const NodeId& my_node_id,
+    const std::vector<NodeInfo>& added_nodes,
+    const std::vector<NodeId>& removed_nodes,
+    const uint32_t& sequence);
+
+protobuf::Message ClosestNodesUpdateResync(const NodeId& node_id, const NodeId& my_node_id);
 
 protobuf::Message ClosestNodesUpdateSubscribe(
     const NodeId& node_id,
@@ -0,0 +1,39 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/routing/runtime.h"
+
+#include "maidsafe/common/log.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+Runtime::Runtime(uint16_t thread_count)
+    : kThreadCount_(thread_count == 0 ? 1 : thread_count),
+      asio_service_(kThreadCount_) {
+  asio_service_.Start();
+  LOG(kVerbose) << "Started routing runtime with " << kThreadCount_ << " threads";
+}
+
+Runtime::~Runtime() {}
+
+}  // namespace routing
+
+}  // namespace maidsafe
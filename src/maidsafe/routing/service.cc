@@ -37,6 +37,7 @@
 #include "maidsafe/routing/routing.pb.h"
 #include "maidsafe/routing/routing_table.h"
 #include "maidsafe/routing/rpcs.h"
+#include "maidsafe/routing/session_keys.h"
 #include "maidsafe/routing/utils.h"
 
 
@@ -215,6 +216,15 @@ void Service::Connect(protobuf::Message& message) {
                           connect_response.mutable_contact()->mutable_private_endpoint());
       SetProtobufEndpoint(this_endpoint_pair.external,
                           connect_response.mutable_contact()->mutable_public_endpoint());
+
+      if (connect_request.has_session_nonce() && !message.client_node() &&
+          !routing_table_.client_mode() && network_.session_keys().enabled()) {
+        connect_response.set_session_nonce(SessionKeys::NewNonce());
+        network_.session_keys().AddHandshake(peer_node.connection_id,
+                                             connect_request.session_nonce(),
+                                             connect_response.session_nonce(),
+                                             false);
+      }
     }
   } else {
     LOG(kVerbose) << "CheckNode(node) for " << (message.client_node() ? "client" : "server")
@@ -331,7 +341,8 @@ void Service::ConnectSuccessFromResponder(NodeInfo& peer, const bool& client) {
                                           true,  // this node is requestor
                                           close_ids_for_peer,
                                           routing_table_.client_mode()));
-  network_.SendToDirect(connect_success_ack, peer.node_id, peer.connection_id);
+  SignAndSendDirect(network_, connect_success_ack, routing_table_.kPrivateKey(), peer.node_id,
+                    peer.connection_id);
 }
 
 void Service::GetGroup(protobuf::Message& message) {
@@ -0,0 +1,279 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/routing/session_keys.h"
+
+#include <cstdint>
+
+#include "cryptopp/hmac.h"
+#include "cryptopp/sha.h"
+
+#include "maidsafe/common/crypto.h"
+#include "maidsafe/common/log.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/routing/parameters.h"
+#include "maidsafe/routing/routing.pb.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace {
+
+const size_t kNonceSize(32);
+const size_t kSecretSize(32);
+
+typedef CryptoPP::HMAC<CryptoPP::SHA512> Hmac;
+
+std::string Mac(const std::string& key, const std::string& data) {
+  Hmac hmac(reinterpret_cast<const unsigned char*>(key.data()), key.size());
+  std::string mac(hmac.DigestSize(), 0);
+  hmac.CalculateDigest(reinterpret_cast<unsigned char*>(&mac[0]),
+                       reinterpret_cast<const unsigned char*>(data.data()), data.size());
+  return mac;
+}
+
+// Compares in time independent of where the MACs differ.
+bool MacMatches(const std::string& key, const std::string& data, const std::string& mac) {
+  Hmac hmac(reinterpret_cast<const unsigned char*>(key.data()), key.size());
+  return mac.size() == hmac.DigestSize() &&
+         hmac.VerifyDigest(reinterpret_cast<const unsigned char*>(mac.data()),
+                           reinterpret_cast<const unsigned char*>(data.data()), data.size());
+}
+
+}  // unnamed namespace
+
+SessionKeys::SessionKeys(const NodeId& this_connection_id)
+    : kThisConnectionId_(this_connection_id),
+      mutex_(),
+      enabled_(false),
+      handshakes_(),
+      keys_(),
+      pending_keys_() {}
+
+std::string SessionKeys::NewNonce() {
+  return RandomString(kNonceSize);
+}
+
+void SessionKeys::Enable() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  enabled_ = true;
+}
+
+bool SessionKeys::enabled() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return enabled_;
+}
+
+void SessionKeys::AddHandshake(const NodeId& peer_connection_id,
+                               const std::string& requester_nonce,
+                               const std::string& responder_nonce,
+                               bool this_node_requester) {
+  if (requester_nonce.size() != kNonceSize || responder_nonce.size() != kNonceSize)
+    return;
+  Handshake handshake;
+  handshake.requester_nonce = requester_nonce;
+  handshake.responder_nonce = responder_nonce;
+  handshake.this_node_requester = this_node_requester;
+  handshake.started = std::chrono::steady_clock::now();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!enabled_)
+    return;
+  for (auto itr(handshakes_.begin()); itr != handshakes_.end();) {
+    if (handshake.started - itr->second.started > Parameters::session_handshake_timeout)
+      itr = handshakes_.erase(itr);
+    else
+      ++itr;
+  }
+  handshakes_[peer_connection_id] = handshake;
+}
+
+std::string SessionKeys::Offer(const NodeId& peer_connection_id,
+                               const asymm::PublicKey& peer_public_key) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto itr(handshakes_.find(peer_connection_id));
+    if (itr == handshakes_.end() || itr->second.this_node_requester)
+      return std::string();
+  }
+  std::string secret(RandomString(kSecretSize)), encrypted_secret;
+  try {
+    encrypted_secret = asymm::Encrypt(asymm::PlainText(secret), peer_public_key).string();
+  }
+  catch(const std::exception& e) {
+    LOG(kWarning) << "Failed to encrypt session secret for " << DebugId(peer_connection_id)
+                  << ": " << e.what();
+    return std::string();
+  }
+  // The requester only uses the keys once it has checked the signed ack carrying the secret.
+  return Establish(peer_connection_id, secret, true) ? encrypted_secret : std::string();
+}
+
+bool SessionKeys::Accept(const NodeId& peer_connection_id,
+                         const std::string& encrypted_secret,
+                         const asymm::PrivateKey& private_key) {
+  std::string secret;
+  try {
+    secret = asymm::Decrypt(asymm::CipherText(encrypted_secret), private_key).string();
+  }
+  catch(const std::exception& e) {
+    LOG(kWarning) << "Failed to decrypt session secret from " << DebugId(peer_connection_id)
+                  << ": " << e.what();
+    return false;
+  }
+  if (secret.size() != kSecretSize)
+    return false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto itr(handshakes_.find(peer_connection_id));
+    if (itr == handshakes_.end() || !itr->second.this_node_requester)
+      return false;
+  }
+  return Establish(peer_connection_id, secret, false);
+}
+
+bool SessionKeys::Establish(const NodeId& peer_connection_id,
+                            const std::string& secret,
+                            bool pending) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto itr(handshakes_.find(peer_connection_id));
+  if (itr == handshakes_.end())
+    return false;
+  Keys keys;
+  keys.send = DirectionKey(secret, itr->second, kThisConnectionId_, peer_connection_id);
+  keys.receive = DirectionKey(secret, itr->second, peer_connection_id, kThisConnectionId_);
+  handshakes_.erase(itr);
+  if (pending) {
+    pending_keys_[peer_connection_id] = keys;
+  } else {
+    pending_keys_.erase(peer_connection_id);
+    keys_[peer_connection_id] = keys;
+  }
+  LOG(kVerbose) << "Session keys set up with " << DebugId(peer_connection_id)
+                << (pending ? ", pending" : "");
+  return true;
+}
+
+std::string SessionKeys::DirectionKey(const std::string& secret,
+                                      const Handshake& handshake,
+                                      const NodeId& from,
+                                      const NodeId& to) const {
+  return crypto::Hash<crypto::SHA512>(secret + handshake.requester_nonce +
+                                      handshake.responder_nonce + from.string() +
+                                      to.string()).string();
+}
+
+void SessionKeys::Remove(const NodeId& peer_connection_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  handshakes_.erase(peer_connection_id);
+  keys_.erase(peer_connection_id);
+  pending_keys_.erase(peer_connection_id);
+}
+
+bool SessionKeys::HasKeys(const NodeId& peer_connection_id) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return keys_.find(peer_connection_id) != keys_.end();
+}
+
+std::string SessionKeys::Serialise(const protobuf::Message& message,
+                                   const NodeId& peer_connection_id) const {
+  std::string serialised_message(message.SerializeAsString());
+  std::string send_key;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto itr(keys_.find(peer_connection_id));
+    if (itr == keys_.end())
+      return serialised_message;
+    send_key = itr->second.send;
+  }
+  // Fields of a serialised message may be appended, so the tag goes after the bytes it covers.
+  protobuf::Message tag;
+  tag.set_hop_id(kThisConnectionId_.string());
+  tag.set_hop_mac(Mac(send_key, serialised_message));
+  return serialised_message + tag.SerializePartialAsString();
+}
+
+bool SessionKeys::Authenticate(const std::string& serialised_message,
+                               const NodeId& peer_connection_id,
+                               protobuf::Message& message) {
+  bool tagged(message.has_hop_mac());
+  protobuf::Message tag;
+  if (tagged) {
+    tag.set_hop_id(message.hop_id());
+    tag.set_hop_mac(message.hop_mac());
+  }
+  message.clear_hop_id();
+  message.clear_hop_mac();
+
+  const NodeId& connection_id(peer_connection_id);
+  if (connection_id == kThisConnectionId_)
+    return !tagged;  // Sent by this node to itself, so never through a transport.
+
+  std::string receive_key;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (connection_id.IsZero()) {
+      // The message can't be attributed to a peer, so is only trusted where no keys are used.
+      if (enabled_ || tagged)
+        LOG(kWarning) << "Message received on an unknown connection";
+      return !enabled_ && !tagged;
+    }
+    auto itr(keys_.find(connection_id));
+    if (itr != keys_.end()) {
+      if (!tagged) {
+        if (itr->second.peer_tagging)
+          LOG(kWarning) << "Untagged message from " << DebugId(connection_id);
+        return !itr->second.peer_tagging;
+      }
+      receive_key = itr->second.receive;
+    } else {
+      auto pending_itr(pending_keys_.find(connection_id));
+      if (pending_itr == pending_keys_.end() || !tagged)
+        return !tagged;
+      receive_key = pending_itr->second.receive;
+    }
+  }
+  if (tag.hop_id() != connection_id.string())
+    return false;
+  size_t tag_size(static_cast<size_t>(tag.ByteSize()));
+  if (tag_size > serialised_message.size() ||
+      !MacMatches(receive_key, serialised_message.substr(0, serialised_message.size() - tag_size),
+                  tag.hop_mac())) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto pending_itr(pending_keys_.find(connection_id));
+  if (pending_itr != pending_keys_.end()) {
+    // The peer has taken up the keys this node offered, so this node starts using them too.
+    keys_[connection_id] = pending_itr->second;
+    pending_keys_.erase(pending_itr);
+    LOG(kVerbose) << "Session keys in use with " << DebugId(connection_id);
+  }
+  auto itr(keys_.find(connection_id));
+  if (itr != keys_.end())
+    itr->second.peer_tagging = true;
+  return true;
+}
+
+}  // namespace routing
+
+}  // namespace maidsafe
@@ -0,0 +1,118 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_ROUTING_SESSION_KEYS_H_
+#define MAIDSAFE_ROUTING_SESSION_KEYS_H_
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "maidsafe/common/node_id.h"
+#include "maidsafe/common/rsa.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace protobuf { class Message; }
+
+// Symmetric keys shared with directly connected peers, keyed by the peer's connection ID, used to
+// authenticate each hop of a message with an HMAC instead of an RSA signature.
+//
+// Each side of a Connect exchange contributes a nonce (the requester in its ConnectRequest, the
+// responder in its ConnectResponse).  Once the responder has the requester's validated public key,
+// it picks a secret and sends it, RSA encrypted, in its signed ConnectSuccessAcknowledgement.  Both
+// sides then derive one key per direction from the secret, the nonces and the connection IDs.  The
+// requester uses its keys once it has checked the ack's signature.  The responder holds its keys
+// back until the first message from the peer carrying a valid tag shows that the requester did so.
+//
+// A peer's messages are checked against the keys for the connection they arrived on.  Once a peer
+// has sent a valid tag, all its messages must carry one naming that connection.  Keys are only set
+// up once enabled, which needs a transport reporting the connection each message arrived on.
+class SessionKeys {
+ public:
+  explicit SessionKeys(const NodeId& this_connection_id);
+  static std::string NewNonce();
+  void Enable();
+  bool enabled() const;
+  // Records the nonces of a Connect exchange with the peer, if enabled, until its keys are set up
+  // or Parameters::session_handshake_timeout passes.
+  void AddHandshake(const NodeId& peer_connection_id,
+                    const std::string& requester_nonce,
+                    const std::string& responder_nonce,
+                    bool this_node_requester);
+  // For the responder.  Sets up pending keys for the peer and returns their secret encrypted for
+  // it, or an empty string if there is no handshake with the peer.
+  std::string Offer(const NodeId& peer_connection_id, const asymm::PublicKey& peer_public_key);
+  // For the requester.  Sets up keys for the peer from the secret it offered.
+  bool Accept(const NodeId& peer_connection_id,
+              const std::string& encrypted_secret,
+              const asymm::PrivateKey& private_key);
+  void Remove(const NodeId& peer_connection_id);
+  // Whether keys are in use with the peer, so that messages to and from it are tagged.
+  bool HasKeys(const NodeId& peer_connection_id) const;
+  // Serialises 'message' for sending to the peer, with a tag authenticating it if keys are in use.
+  std::string Serialise(const protobuf::Message& message, const NodeId& peer_connection_id) const;
+  // Checks the tag of 'message', parsed from 'serialised_message', and strips it.  The message
+  // arrived on 'peer_connection_id', which is this node's own for a message sent to itself, or zero
+  // if the transport can't tell.  Fails if the tag names another connection, or one without keys,
+  // or doesn't match, or if there is no tag but the peer has already sent one.  A message on an
+  // unknown connection fails if enabled or tagged.
+  bool Authenticate(const std::string& serialised_message,
+                    const NodeId& peer_connection_id,
+                    protobuf::Message& message);
+
+ private:
+  struct Handshake {
+    std::string requester_nonce, responder_nonce;
+    bool this_node_requester;
+    std::chrono::steady_clock::time_point started;
+  };
+  // HMAC-SHA512 keys, one per direction.
+  struct Keys {
+    Keys() : send(), receive(), peer_tagging(false) {}
+    std::string send, receive;
+    // Set once the peer has sent a valid tag, after which its untagged messages are rejected.
+    bool peer_tagging;
+  };
+
+  SessionKeys(const SessionKeys&);
+  SessionKeys& operator=(const SessionKeys&);
+  bool Establish(const NodeId& peer_connection_id, const std::string& secret, bool pending);
+  std::string DirectionKey(const std::string& secret,
+                           const Handshake& handshake,
+                           const NodeId& from,
+                           const NodeId& to) const;
+
+  const NodeId kThisConnectionId_;
+  mutable std::mutex mutex_;
+  bool enabled_;
+  std::map<NodeId, Handshake> handshakes_;
+  std::map<NodeId, Keys> keys_;
+  // Keys offered by this node as responder, not yet used by the peer.
+  std::map<NodeId, Keys> pending_keys_;
+};
+
+}  // namespace routing
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_ROUTING_SESSION_KEYS_H_
@@ -0,0 +1,197 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/routing/signature_verifier.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+#include "maidsafe/common/crypto.h"
+#include "maidsafe/common/log.h"
+
+#include "maidsafe/routing/parameters.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace {
+
+std::string Digest(const asymm::PublicKey& public_key,
+                   const std::string& data,
+                   const std::string& signature) {
+  return crypto::Hash<crypto::SHA512>(asymm::EncodeKey(public_key).string() + data +
+                                      signature).string();
+}
+
+std::string MakeSignature(const asymm::PrivateKey& private_key, const std::string& data) {
+  try {
+    return asymm::Sign(asymm::PlainText(data), private_key).string();
+  }
+  catch(const std::exception& e) {
+    LOG(kError) << "Failed to sign: " << e.what();
+    return std::string();
+  }
+}
+
+}  // unnamed namespace
+
+SignatureVerifier::SignatureVerifier(uint16_t thread_count)
+    : state_(std::make_shared<State>()),
+      workers_() {
+  for (uint16_t i(0); i != thread_count; ++i) {
+    std::shared_ptr<State> state(state_);
+    workers_.push_back(std::thread([state] { Run(state); }));
+  }
+}
+
+SignatureVerifier::~SignatureVerifier() {
+  std::deque<Job> abandoned;
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->running = false;
+    abandoned.swap(state_->queue);
+  }
+  state_->condition.notify_all();
+  for (auto& worker : workers_) {
+    // The owner may be released from a functor, so on one of the workers.  That worker keeps its
+    // own reference to state_, and abandons the rest of its batch.
+    if (worker.get_id() == std::this_thread::get_id())
+      worker.detach();
+    else
+      worker.join();
+  }
+  for (auto& job : abandoned)
+    job(false);
+}
+
+void SignatureVerifier::Verify(const asymm::PublicKey& public_key,
+                               const std::string& data,
+                               const std::string& signature,
+                               VerifiedFunctor verified_functor) {
+  assert(verified_functor);
+  if (!asymm::ValidateKey(public_key) || data.empty() || signature.empty()) {
+    verified_functor(false);
+    return;
+  }
+  Check check(public_key, data, signature, Digest(public_key, data, signature), verified_functor);
+  {
+    std::unique_lock<std::mutex> lock(state_->mutex);
+    if (IsCached(*state_, check.digest, lock)) {
+      lock.unlock();
+      verified_functor(true);
+      return;
+    }
+  }
+  // Jobs only run while a worker, or this object, holds the state.
+  State* state(state_.get());
+  Enqueue([state, check](bool run) { check.verified_functor(run && Process(*state, check)); });
+}
+
+void SignatureVerifier::Sign(const asymm::PrivateKey& private_key,
+                             const std::string& data,
+                             SignedFunctor signed_functor) {
+  assert(signed_functor);
+  Enqueue([private_key, data, signed_functor](bool run) {
+    signed_functor(run ? MakeSignature(private_key, data) : std::string());
+  });
+}
+
+void SignatureVerifier::Enqueue(Job job) {
+  if (workers_.empty()) {
+    job(true);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->queue.push_back(std::move(job));
+  }
+  state_->condition.notify_one();
+}
+
+void SignatureVerifier::Run(std::shared_ptr<State> state) {
+  std::unique_lock<std::mutex> lock(state->mutex);
+  for (;;) {
+    state->condition.wait(lock, [&state] { return !state->running || !state->queue.empty(); });
+    if (!state->running)
+      return;
+    size_t batch_size(std::min(state->queue.size(),
+                               static_cast<size_t>(Parameters::signature_verification_batch_size)));
+    std::vector<Job> batch(std::make_move_iterator(state->queue.begin()),
+                           std::make_move_iterator(state->queue.begin() + batch_size));
+    state->queue.erase(state->queue.begin(), state->queue.begin() + batch_size);
+    for (auto& job : batch) {
+      bool run(state->running);
+      lock.unlock();
+      job(run);
+      lock.lock();
+    }
+  }
+}
+
+bool SignatureVerifier::Process(State& state, const Check& check) {
+  {
+    // Repeats of a check may have been queued together, so the cache is consulted again here.
+    std::unique_lock<std::mutex> lock(state.mutex);
+    if (IsCached(state, check.digest, lock))
+      return true;
+  }
+  bool valid(false);
+  try {
+    valid = asymm::CheckSignature(asymm::PlainText(check.data), asymm::Signature(check.signature),
+                                  check.public_key);
+  }
+  catch(const std::exception& e) {
+    LOG(kWarning) << "Failed to check signature: " << e.what();
+  }
+  if (valid) {
+    std::unique_lock<std::mutex> lock(state.mutex);
+    AddToCache(state, check.digest, lock);
+  }
+  return valid;
+}
+
+bool SignatureVerifier::IsCached(State& state, const std::string& digest,
+                                 std::unique_lock<std::mutex>& lock) {
+  assert(lock.owns_lock());
+  static_cast<void>(lock);
+  auto itr(state.verified_index.find(digest));
+  if (itr == state.verified_index.end())
+    return false;
+  state.verified_digests.splice(state.verified_digests.begin(), state.verified_digests,
+                                itr->second);
+  return true;
+}
+
+void SignatureVerifier::AddToCache(State& state, const std::string& digest,
+                                   std::unique_lock<std::mutex>& lock) {
+  if (Parameters::verified_signature_cache_size == 0 || IsCached(state, digest, lock))
+    return;
+  state.verified_digests.push_front(digest);
+  state.verified_index[digest] = state.verified_digests.begin();
+  while (state.verified_digests.size() > Parameters::verified_signature_cache_size) {
+    state.verified_index.erase(state.verified_digests.back());
+    state.verified_digests.pop_back();
+  }
+}
+
+}  // namespace routing
+
+}  // namespace maidsafe
@@ -0,0 +1,116 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_ROUTING_SIGNATURE_VERIFIER_H_
+#define MAIDSAFE_ROUTING_SIGNATURE_VERIFIER_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "maidsafe/common/rsa.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+// Checks and makes RSA signatures on a pool of worker threads, so that routing's asio threads
+// aren't held up by them.  Each worker takes up to Parameters::signature_verification_batch_size
+// queued jobs at a time.  The last Parameters::verified_signature_cache_size signatures found
+// valid are remembered, so repeats are answered without an RSA operation.  With no worker threads,
+// jobs are done on the calling thread.  Jobs still pending at destruction are abandoned, their
+// functors being called with false or an empty signature.
+class SignatureVerifier {
+ public:
+  typedef std::function<void(bool /*valid*/)> VerifiedFunctor;
+  typedef std::function<void(const std::string& /*signature*/)> SignedFunctor;
+
+  explicit SignatureVerifier(uint16_t thread_count);
+  ~SignatureVerifier();
+  // 'verified_functor' is called exactly once, on a worker thread unless the check is answered
+  // from the cache or done inline.
+  void Verify(const asymm::PublicKey& public_key,
+              const std::string& data,
+              const std::string& signature,
+              VerifiedFunctor verified_functor);
+  // 'signed_functor' is called exactly once, on a worker thread unless done inline, with an empty
+  // signature if 'data' couldn't be signed.
+  void Sign(const asymm::PrivateKey& private_key,
+            const std::string& data,
+            SignedFunctor signed_functor);
+
+ private:
+  struct Check {
+    Check(const asymm::PublicKey& public_key_in,
+          const std::string& data_in,
+          const std::string& signature_in,
+          const std::string& digest_in,
+          VerifiedFunctor verified_functor_in)
+        : public_key(public_key_in),
+          data(data_in),
+          signature(signature_in),
+          digest(digest_in),
+          verified_functor(verified_functor_in) {}
+    asymm::PublicKey public_key;
+    std::string data, signature, digest;
+    VerifiedFunctor verified_functor;
+  };
+  // Runs a queued check or signing, or abandons it if passed false.
+  typedef std::function<void(bool /*run*/)> Job;
+  // Shared with the workers, so that one left running after destruction (when the owner is
+  // released from a functor called on that worker) never uses freed state.
+  struct State {
+    State() : mutex(), condition(), running(true), queue(), verified_digests(),
+              verified_index() {}
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool running;
+    std::deque<Job> queue;
+    // Most recently verified first.
+    std::list<std::string> verified_digests;
+    std::map<std::string, std::list<std::string>::iterator> verified_index;
+  };
+
+  SignatureVerifier(const SignatureVerifier&);
+  SignatureVerifier& operator=(const SignatureVerifier&);
+  void Enqueue(Job job);
+  static void Run(std::shared_ptr<State> state);
+  static bool Process(State& state, const Check& check);
+  static bool IsCached(State& state, const std::string& digest,
+                       std::unique_lock<std::mutex>& lock);
+  static void AddToCache(State& state, const std::string& digest,
+                         std::unique_lock<std::mutex>& lock);
+
+  std::shared_ptr<State> state_;
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace routing
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_ROUTING_SIGNATURE_VERIFIER_H_
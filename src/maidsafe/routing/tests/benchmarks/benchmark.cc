@@ -0,0 +1,151 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/routing/tests/benchmarks/benchmark.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <map>
+
+#include "maidsafe/routing/tests/test_utils.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace benchmark {
+
+namespace {
+
+const uint64_t kMaxIterations(1000000000);
+
+struct Registration {
+  Registration() : function(), args() {}
+  BenchmarkFunction function;
+  std::vector<std::vector<int>> args;
+};
+
+// Ordered by name, so output is stable regardless of static initialisation order.
+std::map<std::string, Registration>& Registry() {
+  static std::map<std::string, Registration> registry;
+  return registry;
+}
+
+std::string FullName(const std::string& name, const std::vector<int>& args) {
+  std::string full_name(name);
+  for (int arg : args)
+    full_name += "/" + std::to_string(arg);
+  return full_name;
+}
+
+}  // unnamed namespace
+
+State::State(const std::vector<int>& args, uint64_t iterations)
+    : args_(args),
+      kIterations_(iterations),
+      completed_(0),
+      timing_(false),
+      start_(),
+      elapsed_(0) {}
+
+bool State::KeepRunning() {
+  if (completed_ == 0 && !timing_)
+    ResumeTiming();
+  if (completed_++ < kIterations_)
+    return true;
+  PauseTiming();
+  return false;
+}
+
+void State::PauseTiming() {
+  if (!timing_)
+    return;
+  elapsed_ += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::steady_clock::now() - start_);
+  timing_ = false;
+}
+
+void State::ResumeTiming() {
+  if (timing_)
+    return;
+  timing_ = true;
+  start_ = std::chrono::steady_clock::now();
+}
+
+bool Register(const std::string& name, BenchmarkFunction function,
+              const std::vector<std::vector<int>>& args) {
+  Registration& registration(Registry()[name]);
+  registration.function = function;
+  registration.args = args.empty() ? std::vector<std::vector<int>>(1) : args;
+  return true;
+}
+
+int RunAll(const std::string& filter, std::chrono::milliseconds min_time, bool csv) {
+  int run_count(0);
+  if (csv)
+    std::cout << "name,iterations,ns_per_iteration\n";
+  else
+    std::cout << std::left << std::setw(56) << "Benchmark" << std::right << std::setw(12)
+              << "Iterations" << std::setw(16) << "ns/iteration" << '\n';
+  for (const auto& entry : Registry()) {
+    for (const auto& args : entry.second.args) {
+      std::string name(FullName(entry.first, args));
+      if (name.find(filter) == std::string::npos)
+        continue;
+      uint64_t iterations(1);
+      std::chrono::nanoseconds elapsed(0);
+      for (;;) {
+        State state(args, iterations);
+        entry.second.function(state);
+        elapsed = state.elapsed();
+        if (elapsed >= min_time || iterations >= kMaxIterations)
+          break;
+        iterations *= 10;
+      }
+      double per_iteration(static_cast<double>(elapsed.count()) / iterations);
+      if (csv) {
+        std::cout << name << ',' << iterations << ',' << per_iteration << '\n';
+      } else {
+        std::cout << std::left << std::setw(56) << name << std::right << std::setw(12)
+                  << iterations << std::setw(16) << std::fixed << std::setprecision(1)
+                  << per_iteration << '\n';
+      }
+      std::cout.flush();
+      ++run_count;
+    }
+  }
+  return run_count;
+}
+
+// Defined out of line, so that the compiler can't see the value is never read.
+void DoNotOptimise(const void* /*value*/) {}
+
+const std::vector<NodeInfo>& NodePool(size_t count) {
+  static std::vector<NodeInfo> pool;
+  while (pool.size() < count)
+    pool.push_back(test::MakeNode());
+  return pool;
+}
+
+}  // namespace benchmark
+
+}  // namespace routing
+
+}  // namespace maidsafe
@@ -0,0 +1,93 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_ROUTING_TESTS_BENCHMARKS_BENCHMARK_H_
+#define MAIDSAFE_ROUTING_TESTS_BENCHMARKS_BENCHMARK_H_
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "maidsafe/routing/node_info.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace benchmark {
+
+// Passed to each benchmark function.  The function does its setup, then loops on KeepRunning()
+// around the code being measured.  Only time spent inside the loop and not paused is counted.
+class State {
+ public:
+  State(const std::vector<int>& args, uint64_t iterations);
+  bool KeepRunning();
+  void PauseTiming();
+  void ResumeTiming();
+  int range(size_t index) const { return args_.at(index); }
+  uint64_t iterations() const { return kIterations_; }
+  std::chrono::nanoseconds elapsed() const { return elapsed_; }
+
+ private:
+  State(const State&);
+  State& operator=(const State&);
+
+  const std::vector<int> args_;
+  const uint64_t kIterations_;
+  uint64_t completed_;
+  bool timing_;
+  std::chrono::steady_clock::time_point start_;
+  std::chrono::nanoseconds elapsed_;
+};
+
+typedef std::function<void(State&)> BenchmarkFunction;
+
+// Registers 'function' to be run once for each set of arguments in 'args'.  Always returns true,
+// so that it can be used to initialise a namespace-scope variable.
+bool Register(const std::string& name, BenchmarkFunction function,
+              const std::vector<std::vector<int>>& args);
+
+// Runs each registered benchmark whose name contains 'filter', repeating it with ten times as
+// many iterations until it has run for at least 'min_time'.  Returns the number of benchmarks run.
+int RunAll(const std::string& filter, std::chrono::milliseconds min_time, bool csv);
+
+// Stops the compiler from discarding 'value' as unused.
+void DoNotOptimise(const void* value);
+template <typename T>
+void DoNotOptimise(const T& value) {
+  DoNotOptimise(static_cast<const void*>(&value));
+}
+
+// Returns 'count' nodes with distinct IDs and keys.  Key generation is slow, so nodes are created
+// once and shared by all benchmarks.
+const std::vector<NodeInfo>& NodePool(size_t count);
+
+}  // namespace benchmark
+
+}  // namespace routing
+
+}  // namespace maidsafe
+
+#define ROUTING_BENCHMARK(function, ...)                                                         \
+    const bool function##_registered(                                                            \
+        ::maidsafe::routing::benchmark::Register(#function, function, __VA_ARGS__))
+
+#endif  // MAIDSAFE_ROUTING_TESTS_BENCHMARKS_BENCHMARK_H_
@@ -0,0 +1,88 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "boost/program_options.hpp"
+
+#include "maidsafe/common/log.h"
+
+#include "maidsafe/routing/tests/benchmarks/benchmark.h"
+#include "maidsafe/routing/tests/benchmarks/churn_benchmark.h"
+
+namespace po = boost::program_options;
+
+int main(int argc, char **argv) {
+  maidsafe::log::Logging::Instance().Initialise(argc, argv);
+  try {
+    po::options_description options_description("Options");
+    options_description.add_options()
+        ("help,h", "Print options.")
+        ("filter,f", po::value<std::string>()->default_value(""),
+            "Only run benchmarks whose name contains this")
+        ("min_time,t", po::value<int>()->default_value(500),
+            "Minimum time in milliseconds to run each benchmark for")
+        ("csv", po::bool_switch(), "Print results as comma-separated values")
+        ("churn", po::bool_switch(), "Run the churn scenario instead of the micro-benchmarks")
+        ("vaults", po::value<size_t>()->default_value(16), "Churn: initial number of vaults")
+        ("churn_events", po::value<size_t>()->default_value(10), "Churn: number of events")
+        ("churn_interval", po::value<int>()->default_value(10000),
+            "Churn: milliseconds between events")
+        ("join_probability", po::value<double>()->default_value(0.5),
+            "Churn: chance of each event being a join rather than a leave")
+        ("simulated", po::bool_switch(),
+            "Churn: connect nodes over the in-memory simulated network rather than rudp")
+        ("seed", po::value<uint32_t>()->default_value(0),
+            "Churn: seed for choosing events and for the simulated network");
+    po::variables_map variables_map;
+    po::store(po::command_line_parser(argc, argv).options(options_description).allow_unregistered().
+                                                  run(), variables_map);
+    po::notify(variables_map);
+    if (variables_map.count("help")) {
+      std::cout << options_description << std::endl;
+      return 0;
+    }
+    if (variables_map["churn"].as<bool>()) {
+      maidsafe::routing::benchmark::ChurnConfig config;
+      config.vaults = variables_map["vaults"].as<size_t>();
+      config.events = variables_map["churn_events"].as<size_t>();
+      config.interval = std::chrono::milliseconds(variables_map["churn_interval"].as<int>());
+      config.join_probability = variables_map["join_probability"].as<double>();
+      config.simulated = variables_map["simulated"].as<bool>();
+      config.seed = variables_map["seed"].as<uint32_t>();
+      return maidsafe::routing::benchmark::RunChurnScenario(config,
+                                                            variables_map["csv"].as<bool>()) ?
+             0 : 1;
+    }
+    int run_count(maidsafe::routing::benchmark::RunAll(
+        variables_map["filter"].as<std::string>(),
+        std::chrono::milliseconds(variables_map["min_time"].as<int>()),
+        variables_map["csv"].as<bool>()));
+    if (run_count == 0) {
+      std::cout << "No benchmarks matched." << std::endl;
+      return 1;
+    }
+  }
+  catch(const std::exception& exception) {
+    std::cout << "Error: " << exception.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,359 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/routing/tests/benchmarks/churn_benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "maidsafe/common/node_id.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/routing/message_handler.h"
+#include "maidsafe/routing/metrics.h"
+#include "maidsafe/routing/parameters.h"
+#include "maidsafe/routing/tests/routing_network.h"
+#include "maidsafe/routing/tests/simulated_network.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace benchmark {
+
+namespace {
+
+typedef test::GenericNetwork::NodePtr NodePtr;
+
+const std::chrono::milliseconds kPollInterval(20);
+const std::chrono::seconds kSetUpTimeout(60);
+
+// Control traffic summed over nodes.
+struct Traffic {
+  Traffic() : messages(), bytes(), matrix_changes(0) {}
+  std::map<int32_t, uint64_t> messages, bytes;  // keyed by message type
+  uint64_t matrix_changes;
+};
+
+struct EventResult {
+  EventResult() : join(false), vaults(0), converged(false), convergence(0), traffic() {}
+  bool join;
+  size_t vaults;
+  bool converged;
+  std::chrono::milliseconds convergence;
+  Traffic traffic;
+};
+
+const MessageType kReportedTypes[] = {
+  MessageType::kClosestNodesUpdate,
+  MessageType::kFindNodes,
+  MessageType::kConnect
+};
+
+Traffic TotalTraffic(const std::vector<NodePtr>& nodes, const NodeId& excluded) {
+  Traffic traffic;
+  for (const auto& node : nodes) {
+    if (node->node_id() == excluded)
+      continue;
+    RoutingMetrics metrics(node->routing()->GetMetrics());
+    for (const auto& sent : metrics.messages_sent)
+      traffic.messages[sent.first] += sent.second;
+    for (const auto& sent : metrics.bytes_sent)
+      traffic.bytes[sent.first] += sent.second;
+    traffic.matrix_changes += metrics.matrix_changes_notified;
+  }
+  return traffic;
+}
+
+Traffic Difference(const Traffic& after, const Traffic& before) {
+  Traffic difference(after);
+  for (const auto& sent : before.messages)
+    difference.messages[sent.first] -= std::min(sent.second, difference.messages[sent.first]);
+  for (const auto& sent : before.bytes)
+    difference.bytes[sent.first] -= std::min(sent.second, difference.bytes[sent.first]);
+  difference.matrix_changes -= std::min(before.matrix_changes, difference.matrix_changes);
+  return difference;
+}
+
+uint64_t Total(const std::map<int32_t, uint64_t>& by_type) {
+  uint64_t total(0);
+  for (const auto& entry : by_type)
+    total += entry.second;
+  return total;
+}
+
+uint64_t Lookup(const std::map<int32_t, uint64_t>& by_type, MessageType type) {
+  auto itr(by_type.find(static_cast<int32_t>(type)));
+  return itr == by_type.end() ? 0 : itr->second;
+}
+
+std::vector<NodeId> ClosestTo(const NodeId& target, std::vector<NodeId> node_ids, size_t count) {
+  count = std::min(count, node_ids.size());
+  std::partial_sort(node_ids.begin(), node_ids.begin() + count, node_ids.end(),
+                    [&target](const NodeId& lhs, const NodeId& rhs) {
+                      return NodeId::CloserToTarget(lhs, rhs, target);
+                    });
+  node_ids.resize(count);
+  return node_ids;
+}
+
+// True once every vault has joined and has the vaults closest to it at the head of both its
+// routing table and its group matrix.
+bool Converged(const std::vector<NodePtr>& nodes) {
+  std::vector<NodeId> vault_ids;
+  for (const auto& node : nodes) {
+    if (node->IsClient())
+      continue;
+    if (!node->joined())
+      return false;
+    vault_ids.push_back(node->node_id());
+  }
+  for (const auto& node : nodes) {
+    if (node->IsClient())
+      continue;
+    std::vector<NodeId> others(vault_ids);
+    others.erase(std::remove(others.begin(), others.end(), node->node_id()), others.end());
+    std::vector<NodeId> expected(ClosestTo(node->node_id(), others,
+                                           Parameters::closest_nodes_size));
+    if (ClosestTo(node->node_id(), node->ReturnRoutingTable(), expected.size()) != expected)
+      return false;
+    std::vector<NodeId> matrix_ids;
+    for (const auto& node_info : node->ClosestNodes()) {
+      if (node_info.node_id != node->node_id())
+        matrix_ids.push_back(node_info.node_id);
+    }
+    if (ClosestTo(node->node_id(), matrix_ids, expected.size()) != expected)
+      return false;
+  }
+  return true;
+}
+
+bool Contains(const std::vector<NodePtr>& nodes, const NodeId& node_id) {
+  return std::any_of(nodes.begin(), nodes.end(),
+                     [&node_id](const NodePtr& node) { return node->node_id() == node_id; });
+}
+
+void PrintHeader(bool csv) {
+  const char* const kColumns[] = { "event", "type", "vaults", "converge_ms", "cnu_msgs",
+                                   "cnu_bytes", "find_msgs", "find_bytes", "connect_msgs",
+                                   "connect_bytes", "all_msgs", "all_bytes", "matrix_changes" };
+  for (size_t i(0); i != sizeof(kColumns) / sizeof(kColumns[0]); ++i) {
+    if (csv)
+      std::cout << (i == 0 ? "" : ",") << kColumns[i];
+    else
+      std::cout << std::setw(i < 2 ? 8 : 15) << kColumns[i];
+  }
+  std::cout << '\n';
+}
+
+// Traffic figures are given as doubles so that the same row can print per-event means.
+void PrintRow(bool csv, const std::string& event, const std::string& type,
+              const std::string& vaults, const std::string& convergence,
+              const std::vector<double>& figures) {
+  std::vector<std::string> cells;
+  cells.push_back(event);
+  cells.push_back(type);
+  cells.push_back(vaults);
+  cells.push_back(convergence);
+  for (double figure : figures) {
+    std::ostringstream cell;
+    cell << std::fixed << std::setprecision(std::floor(figure) == figure ? 0 : 1) << figure;
+    cells.push_back(cell.str());
+  }
+  for (size_t i(0); i != cells.size(); ++i) {
+    if (csv)
+      std::cout << (i == 0 ? "" : ",") << cells[i];
+    else
+      std::cout << std::setw(i < 2 ? 8 : 15) << cells[i];
+  }
+  std::cout << '\n';
+}
+
+std::vector<double> Figures(const Traffic& traffic) {
+  std::vector<double> figures;
+  for (auto type : kReportedTypes) {
+    figures.push_back(static_cast<double>(Lookup(traffic.messages, type)));
+    figures.push_back(static_cast<double>(Lookup(traffic.bytes, type)));
+  }
+  figures.push_back(static_cast<double>(Total(traffic.messages)));
+  figures.push_back(static_cast<double>(Total(traffic.bytes)));
+  figures.push_back(static_cast<double>(traffic.matrix_changes));
+  return figures;
+}
+
+void PrintMeans(bool csv, const std::vector<EventResult>& results, bool join) {
+  size_t count(0), converged(0);
+  std::chrono::milliseconds total_convergence(0);
+  std::vector<double> means;
+  for (const auto& result : results) {
+    if (result.join != join)
+      continue;
+    std::vector<double> figures(Figures(result.traffic));
+    means.resize(figures.size());
+    for (size_t i(0); i != figures.size(); ++i)
+      means[i] += figures[i];
+    ++count;
+    if (result.converged) {
+      ++converged;
+      total_convergence += result.convergence;
+    }
+  }
+  if (count == 0)
+    return;
+  for (auto& mean : means)
+    mean /= static_cast<double>(count);
+  std::string convergence(converged == 0 ? "-" :
+                          std::to_string(total_convergence.count() / converged));
+  PrintRow(csv, "mean", join ? "join" : "leave", "-", convergence, means);
+  if (!csv) {
+    std::cout << "  " << converged << " of " << count << (join ? " joins" : " leaves")
+              << " converged before the next event\n";
+  }
+}
+
+bool WaitToConverge(const test::GenericNetwork& network,
+                    std::chrono::steady_clock::duration timeout) {
+  auto deadline(std::chrono::steady_clock::now() + timeout);
+  while (!Converged(network.Nodes())) {
+    if (std::chrono::steady_clock::now() > deadline)
+      return false;
+    Sleep(kPollInterval);
+  }
+  return true;
+}
+
+}  // unnamed namespace
+
+ChurnConfig::ChurnConfig()
+    : vaults(16),
+      events(10),
+      interval(std::chrono::seconds(10)),
+      join_probability(0.5),
+      simulated(false),
+      seed(0) {}
+
+bool RunChurnScenario(const ChurnConfig& config, bool csv) {
+  std::mt19937 generator(config.seed);
+  std::shared_ptr<test::SimulatedNetwork> simulated_network;
+  test::GenericNetwork network;
+  if (config.simulated) {
+    // The simulator's latency, loss and NAT choices follow the scenario's seed too.
+    test::SimulatedNetwork::Config simulated_config;
+    simulated_config.seed = config.seed;
+    simulated_network.reset(new test::SimulatedNetwork(simulated_config));
+    simulated_network->Start();
+    network.set_simulated_network(simulated_network);
+  }
+  network.SetUp();
+  network.SetUpNetwork(config.vaults);
+  if (!WaitToConverge(network, kSetUpTimeout)) {
+    std::cout << "Network of " << config.vaults << " vaults failed to converge." << std::endl;
+    return false;
+  }
+
+  std::vector<EventResult> results;
+  for (size_t i(0); i != config.events; ++i) {
+    EventResult result;
+    std::vector<NodePtr> nodes(network.Nodes());
+    // The first two vaults are the bootstrap nodes, and are kept so that others can still join.
+    std::vector<NodeId> removable;
+    for (size_t j(2); j < nodes.size(); ++j) {
+      if (!nodes[j]->IsClient())
+        removable.push_back(nodes[j]->node_id());
+    }
+    std::bernoulli_distribution join(config.join_probability);
+    result.join = removable.empty() || join(generator);
+
+    Traffic before;
+    std::future<void> joining;
+    auto event_start(std::chrono::steady_clock::now());
+    if (result.join) {
+      NodeId new_id(NodeId::kRandomId);
+      before = TotalTraffic(nodes, NodeId());
+      nodes.clear();
+      joining = std::async(std::launch::async, [&network, new_id] {
+                                                 network.AddNode(false, new_id);
+                                               });
+      // The node's keys are generated before it is added, so timing starts once it is joining.
+      while (!Contains(network.Nodes(), new_id) &&
+             joining.wait_for(std::chrono::milliseconds(1)) != std::future_status::ready) {}
+      event_start = std::chrono::steady_clock::now();
+    } else {
+      NodeId leaving_id(removable.at(generator() % removable.size()));
+      before = TotalTraffic(nodes, leaving_id);
+      nodes.clear();
+      network.RemoveNode(leaving_id);
+    }
+
+    auto next_event(event_start + config.interval);
+    while (std::chrono::steady_clock::now() < next_event) {
+      if (!result.converged && Converged(network.Nodes())) {
+        result.converged = true;
+        result.convergence = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - event_start);
+      }
+      Sleep(kPollInterval);
+    }
+    if (joining.valid())
+      joining.get();
+
+    nodes = network.Nodes();
+    result.traffic = Difference(TotalTraffic(nodes, NodeId()), before);
+    result.vaults = static_cast<size_t>(std::count_if(nodes.begin(), nodes.end(),
+                                                      [](const NodePtr& node) {
+                                                        return !node->IsClient();
+                                                      }));
+    nodes.clear();
+    results.push_back(result);
+  }
+
+  if (!csv) {
+    std::cout << "Churn of " << config.events << " events, one every " << config.interval.count()
+              << " ms, from " << config.vaults << " vaults over "
+              << (config.simulated ? "the simulated network" : "rudp") << " (seed "
+              << config.seed << ")\n";
+  }
+  PrintHeader(csv);
+  for (size_t i(0); i != results.size(); ++i) {
+    const EventResult& result(results[i]);
+    PrintRow(csv, std::to_string(i + 1), result.join ? "join" : "leave",
+             std::to_string(result.vaults),
+             result.converged ? std::to_string(result.convergence.count()) : "-",
+             Figures(result.traffic));
+  }
+  PrintMeans(csv, results, true);
+  PrintMeans(csv, results, false);
+  std::cout << std::flush;
+  return true;
+}
+
+}  // namespace benchmark
+
+}  // namespace routing
+
+}  // namespace maidsafe
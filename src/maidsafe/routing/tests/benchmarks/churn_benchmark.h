@@ -0,0 +1,58 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_ROUTING_TESTS_BENCHMARKS_CHURN_BENCHMARK_H_
+#define MAIDSAFE_ROUTING_TESTS_BENCHMARKS_CHURN_BENCHMARK_H_
+
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace benchmark {
+
+struct ChurnConfig {
+  ChurnConfig();
+  size_t vaults;  // initial network size
+  size_t events;
+  // Time between the starts of successive churn events, so the churn rate is one per interval.
+  std::chrono::milliseconds interval;
+  // Chance that an event is a vault joining rather than leaving.
+  double join_probability;
+  // Connect the nodes over an in-memory SimulatedNetwork rather than rudp on loopback.
+  bool simulated;
+  uint32_t seed;
+};
+
+// Sets up a network of vaults, then has vaults join or leave at a fixed rate.  For each event it
+// prints the time until every routing table and group matrix again agrees with the network, and
+// the control traffic sent by all nodes until the next event.  Returns false if the initial
+// network fails to converge.
+bool RunChurnScenario(const ChurnConfig& config, bool csv);
+
+}  // namespace benchmark
+
+}  // namespace routing
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_ROUTING_TESTS_BENCHMARKS_CHURN_BENCHMARK_H_
@@ -0,0 +1,130 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "maidsafe/common/node_id.h"
+
+#include "maidsafe/routing/group_matrix.h"
+#include "maidsafe/routing/parameters.h"
+#include "maidsafe/routing/tests/benchmarks/benchmark.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace benchmark {
+
+namespace {
+
+const size_t kTargetCount(1024);
+
+std::vector<NodeInfo> RandomNodes(int count) {
+  std::vector<NodeInfo> nodes(count);
+  for (auto& node : nodes)
+    node.node_id = NodeId(NodeId::kRandomId);
+  return nodes;
+}
+
+// A group matrix of 'peer_count' connected peers, each with a row of 'row_size' nodes.  A second
+// set of rows is kept, so that updates can alternate between the two and always change the matrix.
+class GroupMatrixFixture {
+ public:
+  GroupMatrixFixture(int peer_count, int row_size)
+      : kNodeId_(NodeId::kRandomId),
+        matrix_(kNodeId_, false),
+        peers_(RandomNodes(peer_count)),
+        rows_(),
+        alternate_rows_(),
+        targets_() {
+    for (const auto& peer : peers_) {
+      matrix_.AddConnectedPeer(peer);
+      rows_.push_back(RandomNodes(row_size));
+      alternate_rows_.push_back(RandomNodes(row_size));
+      matrix_.UpdateFromConnectedPeer(peer.node_id, rows_.back(), matrix_.GetUniqueNodeIds());
+    }
+    for (size_t i(0); i != kTargetCount; ++i)
+      targets_.push_back(NodeId(NodeId::kRandomId));
+  }
+
+  // Replaces a peer's row with its other row, cycling through the peers.
+  std::shared_ptr<MatrixChange> Update(uint64_t index) {
+    size_t peer_index(static_cast<size_t>(index % peers_.size()));
+    const auto& row((index / peers_.size()) % 2 == 0 ? alternate_rows_.at(peer_index) :
+                                                       rows_.at(peer_index));
+    return matrix_.UpdateFromConnectedPeer(peers_.at(peer_index).node_id, row,
+                                           matrix_.GetUniqueNodeIds());
+  }
+
+  GroupMatrix& matrix() { return matrix_; }
+  const NodeInfo& peer(size_t index) const { return peers_.at(index); }
+  const NodeId& target(uint64_t index) const { return targets_.at(index % kTargetCount); }
+
+ private:
+  const NodeId kNodeId_;
+  GroupMatrix matrix_;
+  std::vector<NodeInfo> peers_;
+  std::vector<std::vector<NodeInfo>> rows_, alternate_rows_;
+  std::vector<NodeId> targets_;
+};
+
+// {connected peers, row size}.  Peer counts stay within Parameters::closest_nodes_size, so that
+// no peer is pruned from the matrix.
+const std::vector<std::vector<int>> kMatrixArgs = { {2, 8}, {4, 16}, {8, 16}, {8, 48} };
+
+void GroupMatrixUpdateFromConnectedPeer(State& state) {
+  GroupMatrixFixture fixture(state.range(0), state.range(1));
+  uint64_t index(0);
+  while (state.KeepRunning())
+    DoNotOptimise(fixture.Update(index++));
+}
+
+void GroupMatrixGetBetterNodeForSendingMessage(State& state) {
+  GroupMatrixFixture fixture(state.range(0), state.range(1));
+  const std::vector<std::string> exclude;
+  uint64_t index(0);
+  while (state.KeepRunning()) {
+    NodeInfo closest_peer(fixture.peer(0));
+    fixture.matrix().GetBetterNodeForSendingMessage(fixture.target(index++), exclude, false,
+                                                    closest_peer);
+    DoNotOptimise(closest_peer);
+  }
+}
+
+void MatrixChangeCheckHolders(State& state) {
+  GroupMatrixFixture fixture(state.range(0), state.range(1));
+  std::shared_ptr<MatrixChange> matrix_change(fixture.Update(0));
+  uint64_t index(0);
+  while (state.KeepRunning())
+    DoNotOptimise(matrix_change->CheckHolders(fixture.target(index++)));
+}
+
+}  // unnamed namespace
+
+ROUTING_BENCHMARK(GroupMatrixUpdateFromConnectedPeer, kMatrixArgs);
+ROUTING_BENCHMARK(GroupMatrixGetBetterNodeForSendingMessage, kMatrixArgs);
+ROUTING_BENCHMARK(MatrixChangeCheckHolders, kMatrixArgs);
+
+}  // namespace benchmark
+
+}  // namespace routing
+
+}  // namespace maidsafe
@@ -0,0 +1,107 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include <string>
+#include <vector>
+
+#include "maidsafe/common/node_id.h"
+#include "maidsafe/common/rsa.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/routing/message_handler.h"
+#include "maidsafe/routing/parameters.h"
+#include "maidsafe/routing/routing.pb.h"
+#include "maidsafe/routing/session_keys.h"
+#include "maidsafe/routing/tests/benchmarks/benchmark.h"
+#include "maidsafe/routing/utils.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace benchmark {
+
+namespace {
+
+// A node-level group request as built by Routing::Impl, carrying 'payload_size' bytes of data and
+// a full route history.
+protobuf::Message MakeMessage(int payload_size) {
+  protobuf::Message message;
+  message.set_source_id(NodeId(NodeId::kRandomId).string());
+  message.set_destination_id(NodeId(NodeId::kRandomId).string());
+  message.set_routing_message(false);
+  message.add_data(RandomString(payload_size));
+  message.set_type(static_cast<int32_t>(MessageType::kNodeLevel));
+  message.set_direct(false);
+  message.set_client_node(false);
+  message.set_request(true);
+  message.set_hops_to_live(Parameters::hops_to_live);
+  message.set_visited(false);
+  message.set_replication(Parameters::node_group_size);
+  message.set_id(RandomUint32());
+  for (uint16_t i(0); i != Parameters::max_route_history; ++i)
+    message.add_route_history(NodeId(NodeId::kRandomId).string());
+  return message;
+}
+
+// {payload size}
+const std::vector<std::vector<int>> kPayloadArgs = { {64}, {1024}, {65536} };
+
+void MessageValidate(State& state) {
+  protobuf::Message message(MakeMessage(state.range(0)));
+  while (state.KeepRunning())
+    DoNotOptimise(ValidateMessage(message));
+}
+
+// The work done by Routing::Impl::DoOnMessageReceived before handing a message on: parsing it,
+// checking its hop tag and validating it.  The second argument selects whether the sender has
+// exchanged session keys with this node, and so tags its messages.
+void MessageReceive(State& state) {
+  NodeId sender_id(NodeId::kRandomId), receiver_id(NodeId::kRandomId);
+  SessionKeys sender(sender_id), receiver(receiver_id);
+  sender.Enable();
+  receiver.Enable();
+  if (state.range(1) != 0) {
+    // The sender is the requester, as the responder only tags once the requester has.
+    asymm::Keys sender_keys(asymm::GenerateKeyPair());
+    std::string sender_nonce(SessionKeys::NewNonce()), receiver_nonce(SessionKeys::NewNonce());
+    sender.AddHandshake(receiver_id, sender_nonce, receiver_nonce, true);
+    receiver.AddHandshake(sender_id, sender_nonce, receiver_nonce, false);
+    sender.Accept(receiver_id, receiver.Offer(sender_id, sender_keys.public_key),
+                  sender_keys.private_key);
+  }
+  std::string serialised(sender.Serialise(MakeMessage(state.range(0)), receiver_id));
+  while (state.KeepRunning()) {
+    protobuf::Message message;
+    bool valid(message.ParseFromString(serialised) &&
+               receiver.Authenticate(serialised, sender_id, message) && ValidateMessage(message));
+    DoNotOptimise(valid);
+  }
+}
+
+}  // unnamed namespace
+
+ROUTING_BENCHMARK(MessageValidate, kPayloadArgs);
+ROUTING_BENCHMARK(MessageReceive, { {64, 0}, {64, 1}, {1024, 0}, {1024, 1}, {65536, 1} });
+
+}  // namespace benchmark
+
+}  // namespace routing
+
+}  // namespace maidsafe
@@ -0,0 +1,80 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include <vector>
+
+#include "maidsafe/common/node_id.h"
+
+#include "maidsafe/routing/network_statistics.h"
+#include "maidsafe/routing/tests/benchmarks/benchmark.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace benchmark {
+
+namespace {
+
+const size_t kTargetCount(1024);
+
+// {unique nodes in the matrix}
+const std::vector<std::vector<int>> kUniqueNodeArgs = { {8}, {64}, {256} };
+
+std::vector<NodeId> RandomIds(size_t count) {
+  std::vector<NodeId> ids;
+  for (size_t i(0); i != count; ++i)
+    ids.push_back(NodeId(NodeId::kRandomId));
+  return ids;
+}
+
+void NetworkStatisticsUpdateLocalAverageDistance(State& state) {
+  NetworkStatistics network_statistics((NodeId(NodeId::kRandomId)));
+  const std::vector<NodeId> unique_nodes(RandomIds(state.range(0)));
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    std::vector<NodeId> nodes(unique_nodes);
+    state.ResumeTiming();
+    network_statistics.UpdateLocalAverageDistance(nodes);
+  }
+}
+
+void NetworkStatisticsEstimateInGroup(State& state) {
+  NetworkStatistics network_statistics((NodeId(NodeId::kRandomId)));
+  std::vector<NodeId> unique_nodes(RandomIds(state.range(0)));
+  network_statistics.UpdateLocalAverageDistance(unique_nodes);
+  const std::vector<NodeId> senders(RandomIds(kTargetCount)), targets(RandomIds(kTargetCount));
+  uint64_t index(0);
+  while (state.KeepRunning()) {
+    DoNotOptimise(network_statistics.EstimateInGroup(senders.at(index % kTargetCount),
+                                                     targets.at((index / 7) % kTargetCount)));
+    ++index;
+  }
+}
+
+}  // unnamed namespace
+
+ROUTING_BENCHMARK(NetworkStatisticsUpdateLocalAverageDistance, kUniqueNodeArgs);
+ROUTING_BENCHMARK(NetworkStatisticsEstimateInGroup, kUniqueNodeArgs);
+
+}  // namespace benchmark
+
+}  // namespace routing
+
+}  // namespace maidsafe
@@ -0,0 +1,139 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include <memory>
+#include <vector>
+
+#include "maidsafe/common/node_id.h"
+#include "maidsafe/common/rsa.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/routing/network_statistics.h"
+#include "maidsafe/routing/parameters.h"
+#include "maidsafe/routing/routing_table.h"
+#include "maidsafe/routing/tests/benchmarks/benchmark.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace benchmark {
+
+namespace {
+
+const size_t kTargetCount(1024);
+
+// A vault's routing table holding 'table_size' nodes from the node pool, whose closest peers have
+// each reported a matrix row of 'row_size' further nodes.
+class RoutingTableFixture {
+ public:
+  RoutingTableFixture(int table_size, int row_size)
+      : kNodeId_(NodeId::kRandomId),
+        network_statistics_(kNodeId_),
+        routing_table_(false, kNodeId_, asymm::GenerateKeyPair(), network_statistics_),
+        nodes_(NodePool(table_size + 1)),
+        targets_() {
+    routing_table_.InitialiseFunctors([](int) {},
+                                      [](const NodeInfo&, bool) {},
+                                      []() {},
+                                      [](const std::vector<NodeInfo>&) {},
+                                      [](const std::vector<NodeInfo>&) {},
+                                      [](std::shared_ptr<MatrixChange>) {});
+    for (int i(0); i != table_size; ++i)
+      routing_table_.AddNode(nodes_.at(i));
+    for (const auto& peer : routing_table_.GetClosestNodes(kNodeId_,
+                                                           Parameters::closest_nodes_size)) {
+      std::vector<NodeInfo> row(row_size);
+      for (auto& node : row)
+        node.node_id = NodeId(NodeId::kRandomId);
+      routing_table_.GroupUpdateFromConnectedPeer(peer, row);
+    }
+    for (size_t i(0); i != kTargetCount; ++i)
+      targets_.push_back(NodeId(NodeId::kRandomId));
+  }
+
+  RoutingTable& routing_table() { return routing_table_; }
+  // A pool node which is not in the table.
+  const NodeInfo& spare_node() const { return nodes_.back(); }
+  const NodeId& target(uint64_t index) const { return targets_.at(index % kTargetCount); }
+
+ private:
+  const NodeId kNodeId_;
+  NetworkStatistics network_statistics_;
+  RoutingTable routing_table_;
+  std::vector<NodeInfo> nodes_;
+  std::vector<NodeId> targets_;
+};
+
+// {table size, matrix row size}.  Table sizes stay below the maximum, so adding the spare node
+// never evicts another.
+const std::vector<std::vector<int>> kTableArgs = { {8, 0}, {16, 8}, {32, 16}, {48, 32} };
+
+void RoutingTableAddNode(State& state) {
+  RoutingTableFixture fixture(state.range(0), state.range(1));
+  while (state.KeepRunning()) {
+    DoNotOptimise(fixture.routing_table().AddNode(fixture.spare_node()));
+    state.PauseTiming();
+    fixture.routing_table().DropNode(fixture.spare_node().node_id, true);
+    state.ResumeTiming();
+  }
+}
+
+void RoutingTableDropNode(State& state) {
+  RoutingTableFixture fixture(state.range(0), state.range(1));
+  fixture.routing_table().AddNode(fixture.spare_node());
+  while (state.KeepRunning()) {
+    DoNotOptimise(fixture.routing_table().DropNode(fixture.spare_node().node_id, true));
+    state.PauseTiming();
+    fixture.routing_table().AddNode(fixture.spare_node());
+    state.ResumeTiming();
+  }
+}
+
+void RoutingTableGetNodeForSendingMessage(State& state) {
+  RoutingTableFixture fixture(state.range(0), state.range(1));
+  const std::vector<std::string> exclude;
+  uint64_t index(0);
+  while (state.KeepRunning()) {
+    DoNotOptimise(fixture.routing_table().GetNodeForSendingMessage(fixture.target(index++),
+                                                                   exclude));
+  }
+}
+
+void RoutingTableIsThisNodeInRange(State& state) {
+  RoutingTableFixture fixture(state.range(0), state.range(1));
+  uint64_t index(0);
+  while (state.KeepRunning()) {
+    DoNotOptimise(fixture.routing_table().IsThisNodeInRange(fixture.target(index++),
+                                                            Parameters::closest_nodes_size));
+  }
+}
+
+}  // unnamed namespace
+
+ROUTING_BENCHMARK(RoutingTableAddNode, kTableArgs);
+ROUTING_BENCHMARK(RoutingTableDropNode, kTableArgs);
+ROUTING_BENCHMARK(RoutingTableGetNodeForSendingMessage, kTableArgs);
+ROUTING_BENCHMARK(RoutingTableIsThisNodeInRange, kTableArgs);
+
+}  // namespace benchmark
+
+}  // namespace routing
+
+}  // namespace maidsafe
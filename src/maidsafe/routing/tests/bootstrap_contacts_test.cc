@@ -0,0 +1,100 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include <chrono>
+#include <vector>
+
+#include "boost/filesystem/path.hpp"
+
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/routing/bootstrap_contacts.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace test {
+
+namespace {
+
+typedef boost::asio::ip::udp::endpoint Endpoint;
+
+}  // unnamed namespace
+
+TEST(BootstrapContactsTest, BEH_Rank) {
+  std::vector<Endpoint> endpoints;
+  for (uint16_t i(0); i != 5; ++i)
+    endpoints.push_back(Endpoint(GetLocalIp(), static_cast<uint16_t>(5483 + i)));
+  BootstrapContacts bootstrap_contacts;
+  EXPECT_EQ(endpoints, bootstrap_contacts.Rank(endpoints));
+
+  // endpoints[4] answers slowly, endpoints[3] quickly, endpoints[0] not at all, endpoints[1] and
+  // endpoints[2] are untried.
+  bootstrap_contacts.AddResult(endpoints[4], true, std::chrono::milliseconds(900));
+  bootstrap_contacts.AddResult(endpoints[3], true, std::chrono::milliseconds(100));
+  bootstrap_contacts.AddResult(endpoints[0], false, std::chrono::seconds(5));
+  std::vector<Endpoint> expected;
+  expected.push_back(endpoints[3]);
+  expected.push_back(endpoints[4]);
+  expected.push_back(endpoints[1]);
+  expected.push_back(endpoints[2]);
+  expected.push_back(endpoints[0]);
+  EXPECT_EQ(expected, bootstrap_contacts.Rank(endpoints));
+
+  // Repeated failures outweigh an earlier fast success.
+  bootstrap_contacts.AddResult(endpoints[3], false, std::chrono::seconds(5));
+  bootstrap_contacts.AddResult(endpoints[3], false, std::chrono::seconds(5));
+  std::vector<Endpoint> ranked(bootstrap_contacts.Rank(endpoints));
+  EXPECT_EQ(endpoints[4], ranked.front());
+  EXPECT_EQ(endpoints[3], ranked.at(3));
+  EXPECT_EQ(endpoints[0], ranked.back());
+}
+
+TEST(BootstrapContactsTest, BEH_WriteAndRead) {
+  maidsafe::test::TestPath test_path(
+      maidsafe::test::CreateTestPath("MaidSafe_TestBootstrapContacts"));
+  boost::filesystem::path path(*test_path / "bootstrap_contacts");
+  std::vector<Endpoint> endpoints;
+  for (uint16_t i(0); i != 3; ++i)
+    endpoints.push_back(Endpoint(GetLocalIp(), static_cast<uint16_t>(5483 + i)));
+  BootstrapContacts bootstrap_contacts;
+  bootstrap_contacts.AddResult(endpoints[2], true, std::chrono::milliseconds(100));
+  bootstrap_contacts.AddResult(endpoints[0], false, std::chrono::seconds(5));
+  std::vector<Endpoint> ranked(bootstrap_contacts.Rank(endpoints));
+  ASSERT_TRUE(bootstrap_contacts.Write(path));
+
+  // A fresh instance ranks the same way once it has read the records back.
+  BootstrapContacts read_contacts;
+  EXPECT_EQ(endpoints, read_contacts.Rank(endpoints));
+  ASSERT_TRUE(read_contacts.Read(path));
+  EXPECT_EQ(ranked, read_contacts.Rank(endpoints));
+
+  // A missing or corrupt file is rejected.
+  EXPECT_FALSE(read_contacts.Read(*test_path / "missing"));
+  ASSERT_TRUE(WriteFile(path, "not a record"));
+  EXPECT_FALSE(read_contacts.Read(path));
+}
+
+}  // namespace test
+
+}  // namespace routing
+
+}  // namespace maidsafe
@@ -0,0 +1,282 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include <chrono>
+#include <string>
+
+#include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/node_id.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/routing/cache_manager.h"
+#include "maidsafe/routing/client_routing_table.h"
+#include "maidsafe/routing/live_tuning.h"
+#include "maidsafe/routing/network_statistics.h"
+#include "maidsafe/routing/network_utils.h"
+#include "maidsafe/routing/parameters.h"
+#include "maidsafe/routing/routing.pb.h"
+#include "maidsafe/routing/routing_table.h"
+#include "maidsafe/routing/timer.h"
+#include "maidsafe/routing/tests/test_utils.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace test {
+
+namespace {
+
+// Returns an ID sharing exactly |common_bits| leading bits with |id|.
+NodeId IdWithCommonLeadingBits(const NodeId& id, uint16_t common_bits) {
+  assert(common_bits < 8 * NodeId::kSize);
+  std::string raw_id(id.string());
+  raw_id[common_bits / 8] = static_cast<char>(raw_id[common_bits / 8] ^
+                                              (0x80 >> (common_bits % 8)));
+  return NodeId(raw_id);
+}
+
+}  // unnamed namespace
+
+class CacheManagerTest : public testing::Test {
+ protected:
+  CacheManagerTest()
+      : node_id_(NodeId::kRandomId),
+        network_statistics_(node_id_),
+        routing_table_(false, node_id_, asymm::GenerateKeyPair(), network_statistics_),
+        client_routing_table_(node_id_),
+        network_(routing_table_, client_routing_table_),
+        tuning_(),
+        cache_manager_(node_id_, network_, timer_, tuning_),
+        asio_service_(2),
+        timer_(asio_service_),
+        kCachingPolicy_(Parameters::caching_policy),
+        kCachingHops_(Parameters::caching_hops) {
+    asio_service_.Start();
+  }
+
+  ~CacheManagerTest() {
+    Parameters::caching_policy = kCachingPolicy_;
+    Parameters::caching_hops = kCachingHops_;
+  }
+
+  protobuf::Message CacheableGet(const NodeId& name) {
+    protobuf::Message message;
+    message.set_destination_id(name.string());
+    message.set_source_id(NodeId(NodeId::kRandomId).string());
+    message.set_routing_message(false);
+    message.set_request(true);
+    message.set_direct(true);
+    message.set_cacheable(static_cast<int32_t>(Cacheable::kGet));
+    message.set_hops_to_live(Parameters::hops_to_live);
+    message.set_id(RandomUint32());
+    message.add_data(RandomString(10));
+    return message;
+  }
+
+  protobuf::Message CacheablePut(const NodeId& source_id, uint16_t hops) {
+    protobuf::Message message;
+    message.set_destination_id(NodeId(NodeId::kRandomId).string());
+    message.set_source_id(source_id.string());
+    message.set_routing_message(false);
+    message.set_request(false);
+    message.set_direct(true);
+    message.set_cacheable(static_cast<int32_t>(Cacheable::kPut));
+    message.add_data(RandomString(100));
+    message.add_route_history(source_id.string());
+    for (uint16_t hop(1); hop < hops; ++hop)
+      message.add_route_history(NodeId(NodeId::kRandomId).string());
+    return message;
+  }
+
+  NodeId node_id_;
+  NetworkStatistics network_statistics_;
+  RoutingTable routing_table_;
+  ClientRoutingTable client_routing_table_;
+  NetworkUtils network_;
+  LiveTuning tuning_;
+  CacheManager cache_manager_;
+  // Destroyed first, so that pending gets finish while cache_manager_ still exists.
+  AsioService asio_service_;
+  Timer<std::string> timer_;
+
+ private:
+  const CachingPolicy kCachingPolicy_;
+  const uint16_t kCachingHops_;
+};
+
+TEST_F(CacheManagerTest, BEH_CachingPolicyAllHops) {
+  Parameters::caching_policy = CachingPolicy::kAllHops;
+  for (uint16_t hops(1); hops <= Parameters::max_route_history; ++hops)
+    EXPECT_TRUE(cache_manager_.ShouldCache(CacheablePut(NodeId(NodeId::kRandomId), hops)));
+}
+
+TEST_F(CacheManagerTest, BEH_CachingPolicyNearestHops) {
+  Parameters::caching_policy = CachingPolicy::kNearestHops;
+  Parameters::caching_hops = 2;
+  EXPECT_TRUE(cache_manager_.ShouldCache(CacheablePut(NodeId(NodeId::kRandomId), 1)));
+  EXPECT_TRUE(cache_manager_.ShouldCache(CacheablePut(NodeId(NodeId::kRandomId), 2)));
+  EXPECT_FALSE(cache_manager_.ShouldCache(CacheablePut(NodeId(NodeId::kRandomId), 3)));
+
+  // Once the route history is full, the hop count is unknown so the copy is not kept.
+  Parameters::caching_hops = Parameters::max_route_history;
+  EXPECT_FALSE(cache_manager_.ShouldCache(
+      CacheablePut(NodeId(NodeId::kRandomId), Parameters::max_route_history)));
+}
+
+TEST_F(CacheManagerTest, BEH_CachingPolicyDistanceWeighted) {
+  Parameters::caching_policy = CachingPolicy::kDistanceWeighted;
+  // First hop after the responder always caches.
+  NodeId content_id(IdWithCommonLeadingBits(node_id_, 100));
+  EXPECT_TRUE(cache_manager_.ShouldCache(CacheablePut(content_id, 1)));
+
+  // A closer node already on the route history makes this node very unlikely to cache.
+  protobuf::Message message(CacheablePut(content_id, 1));
+  message.add_route_history(IdWithCommonLeadingBits(content_id, 200).string());
+  EXPECT_FALSE(cache_manager_.ShouldCache(message));
+
+  // This node being closer than every previous hop always caches.
+  message = CacheablePut(content_id, 1);
+  message.add_route_history(IdWithCommonLeadingBits(content_id, 50).string());
+  EXPECT_TRUE(cache_manager_.ShouldCache(message));
+}
+
+TEST_F(CacheManagerTest, BEH_NegativeCache) {
+  Tuning tuning(*tuning_.Get());
+  tuning.negative_cache_ttl = std::chrono::milliseconds(500);
+  tuning_.Set(tuning);
+  int lookups(0);
+  cache_manager_.InitialiseFunctors(
+      [&lookups](const std::string&, const bool&, ReplyFunctor reply_functor) {
+        ++lookups;
+        reply_functor("");
+      },
+      [](const std::string&) {});
+
+  NodeId name(NodeId::kRandomId);
+  protobuf::Message message(CacheableGet(name));
+  cache_manager_.HandleGetFromCache(message);
+  EXPECT_EQ(1, lookups);
+  // A repeated lookup within the TTL is not passed to the upper layer.
+  message = CacheableGet(name);
+  cache_manager_.HandleGetFromCache(message);
+  EXPECT_EQ(1, lookups);
+  message = CacheableGet(NodeId(NodeId::kRandomId));
+  cache_manager_.HandleGetFromCache(message);
+  EXPECT_EQ(2, lookups);
+
+  // Once data is stored under the name, the next lookup is passed on within the TTL.
+  protobuf::Message response(CacheablePut(node_id_, 1));
+  response.set_cache_name(name.string());
+  cache_manager_.AddToCache(response);
+  message = CacheableGet(name);
+  cache_manager_.HandleGetFromCache(message);
+  EXPECT_EQ(3, lookups);
+
+  Sleep(std::chrono::milliseconds(600));
+  message = CacheableGet(name);
+  cache_manager_.HandleGetFromCache(message);
+  EXPECT_EQ(4, lookups);
+}
+
+TEST_F(CacheManagerTest, BEH_CoalesceCacheableGets) {
+  int lookups(0);
+  cache_manager_.InitialiseFunctors(
+      [&lookups](const std::string&, const bool&, ReplyFunctor reply_functor) {
+        ++lookups;
+        reply_functor("");
+      },
+      [](const std::string&) {});
+
+  NodeId name(NodeId::kRandomId);
+  const size_t kRequestCount(5);
+  for (size_t index(0); index != kRequestCount; ++index) {
+    protobuf::Message message(CacheableGet(name));
+    message.set_relay_id(NodeId(NodeId::kRandomId).string());
+    message.set_relay_connection_id(NodeId(NodeId::kRandomId).string());
+    cache_manager_.HandleGetFromCache(message);
+  }
+  EXPECT_EQ(1, lookups);
+  ASSERT_EQ(1U, cache_manager_.pending_gets_.size());
+  auto pending(cache_manager_.pending_gets_.begin());
+  EXPECT_EQ(CacheManager::PendingGetKey(CacheableGet(name)), pending->first);
+  EXPECT_EQ(kRequestCount, pending->second.requests.size());
+
+  // A get for another type of data at the same destination is not held behind the first.
+  protobuf::Message other_type(CacheableGet(name));
+  other_type.set_type(1);
+  cache_manager_.HandleGetFromCache(other_type);
+  EXPECT_EQ(2U, cache_manager_.pending_gets_.size());
+  pending = cache_manager_.pending_gets_.find(CacheManager::PendingGetKey(CacheableGet(name)));
+  ASSERT_NE(cache_manager_.pending_gets_.end(), pending);
+
+  protobuf::Message response;
+  response.set_destination_id(node_id_.string());
+  response.set_source_id(NodeId(NodeId::kRandomId).string());
+  response.set_routing_message(false);
+  response.set_request(false);
+  response.set_direct(true);
+  response.set_cacheable(static_cast<int32_t>(Cacheable::kPut));
+  response.add_data(RandomString(100));
+  response.set_id(pending->second.id ^ 1);
+  EXPECT_FALSE(cache_manager_.HandleCoalescedResponse(response));
+  response.set_id(pending->second.id);
+  EXPECT_TRUE(cache_manager_.HandleCoalescedResponse(response));
+  Sleep(std::chrono::milliseconds(100));
+  EXPECT_EQ(1U, cache_manager_.pending_gets_.size());
+  EXPECT_FALSE(cache_manager_.HandleCoalescedResponse(response));
+}
+
+TEST_F(CacheManagerTest, BEH_ExpireCoalescedGets) {
+  Tuning tuning(*tuning_.Get());
+  tuning.response_timeout = std::chrono::milliseconds(200);
+  tuning_.Set(tuning);
+  cache_manager_.InitialiseFunctors(
+      [](const std::string&, const bool&, ReplyFunctor reply_functor) { reply_functor(""); },
+      [](const std::string&) {});
+
+  NodeId name(NodeId::kRandomId);
+  for (int index(0); index != 3; ++index) {
+    protobuf::Message message(CacheableGet(name));
+    cache_manager_.HandleGetFromCache(message);
+  }
+  ASSERT_EQ(1U, cache_manager_.pending_gets_.size());
+  TaskId id(cache_manager_.pending_gets_.begin()->second.id);
+
+  // Once the forwarded get times out, the held requests are passed on rather than dropped, and a
+  // late response is no longer treated as coalesced.
+  Sleep(std::chrono::milliseconds(400));
+  EXPECT_TRUE(cache_manager_.pending_gets_.empty());
+  protobuf::Message response;
+  response.set_destination_id(node_id_.string());
+  response.set_routing_message(false);
+  response.set_request(false);
+  response.set_direct(true);
+  response.set_cacheable(static_cast<int32_t>(Cacheable::kPut));
+  response.add_data(RandomString(100));
+  response.set_id(id);
+  EXPECT_FALSE(cache_manager_.HandleCoalescedResponse(response));
+}
+
+}  // namespace test
+
+}  // namespace routing
+
+}  // namespace maidsafe
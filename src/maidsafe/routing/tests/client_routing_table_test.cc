@@ -16,6 +16,7 @@
     See the Licences for the specific language governing permissions and limitations relating to
     use of the MaidSafe Software.                                                                 */
 
+#include <algorithm>
 #include <bitset>
 #include <memory>
 #include <vector>
@@ -292,6 +293,45 @@ TEST_F(ClientRoutingTableTest, FUNC_GetNodesInfo) {
   }
 }
 
+TEST_F(ClientRoutingTableTest, FUNC_LookupsAfterDrops) {
+  ClientRoutingTable client_routing_table(node_id_);
+
+  PopulateNodesSetFurthestCloseNode(Parameters::max_client_routing_table_size,
+                                    client_routing_table.kNodeId());
+  ScrambleNodesOrder();
+
+  std::vector<NodeInfo> expected_nodes;
+  NodeId sought_id(BiasNodeIds(expected_nodes));
+
+  PopulateClientRoutingTable(client_routing_table);
+
+  // Drop every other connection, then all connections of the biased node ID.
+  std::vector<NodeInfo> remaining_nodes;
+  for (size_t i(0); i != nodes_.size(); ++i) {
+    if (i % 2 == 0)
+      EXPECT_EQ(nodes_.at(i).connection_id,
+                client_routing_table.DropConnection(nodes_.at(i).connection_id).connection_id);
+    else if (nodes_.at(i).node_id != sought_id)
+      remaining_nodes.push_back(nodes_.at(i));
+  }
+  client_routing_table.DropNodes(sought_id);
+  EXPECT_FALSE(client_routing_table.Contains(sought_id));
+  EXPECT_TRUE(client_routing_table.GetNodesInfo(sought_id).empty());
+  EXPECT_EQ(remaining_nodes.size(), client_routing_table.size());
+
+  for (const auto& node : remaining_nodes) {
+    EXPECT_TRUE(client_routing_table.Contains(node.node_id));
+    std::vector<NodeInfo> got_nodes(client_routing_table.GetNodesInfo(node.node_id));
+    EXPECT_NE(got_nodes.end(), std::find_if(got_nodes.begin(), got_nodes.end(),
+                                            [&node](const NodeInfo& got_node) {
+                                              return got_node.connection_id == node.connection_id;
+                                            }));
+    EXPECT_EQ(node.connection_id,
+              client_routing_table.DropConnection(node.connection_id).connection_id);
+  }
+  EXPECT_EQ(0, client_routing_table.size());
+}
+
 TEST_F(ClientRoutingTableTest, FUNC_IsConnected) {
   ClientRoutingTable client_routing_table(node_id_);
 
@@ -0,0 +1,198 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/node_id.h"
+#include "maidsafe/common/rsa.h"
+#include "maidsafe/common/test.h"
+
+#include "maidsafe/routing/connection_manager.h"
+#include "maidsafe/routing/network_statistics.h"
+#include "maidsafe/routing/parameters.h"
+#include "maidsafe/routing/routing_table.h"
+#include "maidsafe/routing/timer.h"
+#include "maidsafe/routing/tests/test_utils.h"
+
+namespace maidsafe {
+namespace routing {
+namespace test {
+
+class ConnectionManagerTest : public testing::Test {
+ protected:
+  ConnectionManagerTest()
+      : kConnectAttemptTimeout_(Parameters::connect_attempt_timeout),
+        kConnectAttemptCheckInterval_(Parameters::connect_attempt_check_interval),
+        node_id_(NodeId::kRandomId),
+        network_statistics_(node_id_),
+        routing_table_(false, node_id_, asymm::GenerateKeyPair(), network_statistics_),
+        mutex_(),
+        attempted_(),
+        accept_(true),
+        asio_service_(2),
+        connection_manager_(routing_table_, timer_, [this](const NodeId& candidate) {
+                                                      std::lock_guard<std::mutex> lock(mutex_);
+                                                      attempted_.push_back(candidate);
+                                                      return accept_;
+                                                    }),
+        timer_(asio_service_) {
+    // Only BEH_ChecksPeriodically relies on the periodic check; elsewhere it would just race the
+    // test's own calls.
+    Parameters::connect_attempt_check_interval = std::chrono::hours(1);
+    asio_service_.Start();
+  }
+
+  ~ConnectionManagerTest() {
+    Parameters::connect_attempt_timeout = kConnectAttemptTimeout_;
+    Parameters::connect_attempt_check_interval = kConnectAttemptCheckInterval_;
+  }
+
+  std::vector<NodeId> Attempted() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return attempted_;
+  }
+
+  const std::chrono::steady_clock::duration kConnectAttemptTimeout_;
+  const std::chrono::steady_clock::duration kConnectAttemptCheckInterval_;
+  NodeId node_id_;
+  NetworkStatistics network_statistics_;
+  RoutingTable routing_table_;
+  std::mutex mutex_;
+  std::vector<NodeId> attempted_;
+  bool accept_;
+  AsioService asio_service_;
+  ConnectionManager connection_manager_;
+  // Declared last so that the Timer's tasks are finished before the ConnectionManager is destroyed.
+  Timer<std::string> timer_;
+};
+
+TEST_F(ConnectionManagerTest, BEH_BoundsAttemptsInFlight) {
+  const size_t kMaxInFlight(Parameters::max_connect_attempts_in_flight);
+  std::vector<NodeId> candidates;
+  for (size_t i(0); i != kMaxInFlight + 3; ++i) {
+    candidates.push_back(NodeId(NodeId::kRandomId));
+    connection_manager_.Add(candidates.back());
+  }
+  EXPECT_EQ(kMaxInFlight, Attempted().size());
+  EXPECT_EQ(kMaxInFlight, connection_manager_.in_flight());
+  EXPECT_EQ(3U, connection_manager_.queued());
+
+  // Duplicates of queued or running attempts are ignored.
+  connection_manager_.Add(candidates.front());
+  connection_manager_.Add(candidates.back());
+  EXPECT_EQ(kMaxInFlight, Attempted().size());
+  EXPECT_EQ(3U, connection_manager_.queued());
+
+  // With an empty routing table all candidates are close, so the closest queued one goes next.
+  std::vector<NodeId> queued(candidates.begin() + kMaxInFlight, candidates.end());
+  SortIdsFromTarget(node_id_, queued);
+  connection_manager_.Complete(candidates.front());
+  ASSERT_EQ(kMaxInFlight + 1, Attempted().size());
+  EXPECT_EQ(queued.front(), Attempted().back());
+  EXPECT_EQ(2U, connection_manager_.queued());
+
+  // Completing an unknown peer frees nothing.
+  connection_manager_.Complete(NodeId(NodeId::kRandomId));
+  EXPECT_EQ(kMaxInFlight + 1, Attempted().size());
+
+  // A candidate the functor fails to contact gives its slot to the next one.
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    accept_ = false;
+  }
+  connection_manager_.Complete(candidates.at(1));
+  EXPECT_EQ(kMaxInFlight + 3, Attempted().size());
+  EXPECT_EQ(kMaxInFlight - 1, connection_manager_.in_flight());
+  EXPECT_EQ(0U, connection_manager_.queued());
+}
+
+TEST_F(ConnectionManagerTest, BEH_DropsRedundantAttempts) {
+  std::vector<NodeInfo> nodes;
+  for (uint16_t i(0); i != Parameters::max_connect_attempts_in_flight + 1; ++i) {
+    nodes.push_back(MakeNode());
+    connection_manager_.Add(nodes.back().node_id);
+  }
+  EXPECT_EQ(Parameters::max_connect_attempts_in_flight, connection_manager_.in_flight());
+  EXPECT_EQ(1U, connection_manager_.queued());
+
+  // Once in the routing table, neither the running nor the queued attempt is needed any more.
+  EXPECT_TRUE(routing_table_.AddNode(nodes.front()));
+  EXPECT_TRUE(routing_table_.AddNode(nodes.back()));
+  connection_manager_.Add(NodeId(NodeId::kRandomId));
+  EXPECT_EQ(Parameters::max_connect_attempts_in_flight, connection_manager_.in_flight());
+  EXPECT_EQ(0U, connection_manager_.queued());
+  std::vector<NodeId> attempted(Attempted());
+  EXPECT_EQ(static_cast<size_t>(Parameters::max_connect_attempts_in_flight + 1), attempted.size());
+  EXPECT_TRUE(std::find(attempted.begin(), attempted.end(), nodes.back().node_id) ==
+              attempted.end());
+
+  // A candidate already in the routing table isn't queued at all.
+  connection_manager_.Add(nodes.front().node_id);
+  EXPECT_EQ(0U, connection_manager_.queued());
+}
+
+TEST_F(ConnectionManagerTest, BEH_ChecksPeriodically) {
+  Parameters::connect_attempt_timeout = std::chrono::seconds(1);
+  Parameters::connect_attempt_check_interval = std::chrono::milliseconds(20);
+  const size_t kMaxInFlight(Parameters::max_connect_attempts_in_flight);
+  std::vector<NodeInfo> nodes;
+  for (size_t i(0); i != kMaxInFlight + 2; ++i)
+    nodes.push_back(MakeNode());
+  for (const auto& node : nodes)
+    connection_manager_.Add(node.node_id);
+  EXPECT_EQ(kMaxInFlight, connection_manager_.in_flight());
+  EXPECT_EQ(2U, connection_manager_.queued());
+
+  // A change to the routing table is picked up without any further calls.
+  std::vector<NodeId> attempted(Attempted()), queued;
+  for (const auto& node : nodes) {
+    if (std::find(attempted.begin(), attempted.end(), node.node_id) == attempted.end())
+      queued.push_back(node.node_id);
+  }
+  ASSERT_EQ(2U, queued.size());
+  NodeInfo queued_node(*std::find_if(nodes.begin(), nodes.end(), [&](const NodeInfo& node) {
+                                       return node.node_id == queued.front();
+                                     }));
+  EXPECT_TRUE(routing_table_.AddNode(queued_node));
+  auto deadline(std::chrono::steady_clock::now() + std::chrono::seconds(10));
+  while (connection_manager_.queued() != 1U && std::chrono::steady_clock::now() < deadline)
+    Sleep(std::chrono::milliseconds(10));
+  EXPECT_EQ(1U, connection_manager_.queued());
+
+  // Timed out attempts release their slots to the remaining candidate, and then that attempt
+  // times out too, all without any response arriving.
+  while ((connection_manager_.in_flight() != 0U || connection_manager_.queued() != 0U) &&
+         std::chrono::steady_clock::now() < deadline) {
+    Sleep(std::chrono::milliseconds(10));
+  }
+  EXPECT_EQ(0U, connection_manager_.in_flight());
+  EXPECT_EQ(0U, connection_manager_.queued());
+  attempted = Attempted();
+  EXPECT_EQ(kMaxInFlight + 1, attempted.size());
+  EXPECT_TRUE(std::find(attempted.begin(), attempted.end(), queued.back()) != attempted.end());
+  EXPECT_TRUE(std::find(attempted.begin(), attempted.end(), queued.front()) == attempted.end());
+}
+
+}  // namespace test
+}  // namespace routing
+}  // namespace maidsafe
@@ -0,0 +1,210 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "maidsafe/common/node_id.h"
+#include "maidsafe/common/test.h"
+
+#include "maidsafe/routing/client_routing_table.h"
+#include "maidsafe/routing/group_change_handler.h"
+#include "maidsafe/routing/network_statistics.h"
+#include "maidsafe/routing/parameters.h"
+#include "maidsafe/routing/routing.pb.h"
+#include "maidsafe/routing/routing_table.h"
+#include "maidsafe/routing/rpcs.h"
+#include "maidsafe/routing/tests/mock_network_utils.h"
+#include "maidsafe/routing/tests/test_utils.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace test {
+
+class GroupChangeHandlerTest : public testing::Test {
+ protected:
+  GroupChangeHandlerTest()
+      : node_id_(NodeId::kRandomId),
+        network_statistics_(node_id_),
+        routing_table_(false, node_id_, asymm::GenerateKeyPair(), network_statistics_),
+        client_routing_table_(node_id_),
+        network_(routing_table_, client_routing_table_),
+        group_change_handler_(routing_table_, client_routing_table_, network_),
+        peer_(MakeNode()),
+        sent_() {
+    EXPECT_TRUE(routing_table_.AddNode(peer_));
+    ON_CALL(network_, SendToDirect(testing::_, testing::_, testing::_))
+        .WillByDefault(testing::Invoke([this](const protobuf::Message& message, const NodeId&,
+                                              const NodeId&) {
+          protobuf::ClosestNodesUpdate update;
+          ASSERT_TRUE(update.ParseFromString(message.data(0)));
+          sent_.push_back(update);
+        }));
+    EXPECT_CALL(network_, SendToDirect(testing::_, testing::_, testing::_))
+        .Times(testing::AnyNumber());
+  }
+
+  void Receive(protobuf::Message message) {
+    group_change_handler_.ClosestNodesUpdate(message);
+    // Cleared, so that it isn't passed on, even when ignored.
+    EXPECT_FALSE(message.IsInitialized());
+  }
+
+  void ReceiveFull(const std::vector<NodeInfo>& nodes, uint32_t sequence) {
+    Receive(rpcs::ClosestNodesUpdate(node_id_, peer_.node_id, nodes, sequence));
+  }
+
+  void ReceiveDelta(const std::vector<NodeInfo>& added,
+                    const std::vector<NodeId>& removed,
+                    uint32_t sequence) {
+    Receive(rpcs::ClosestNodesUpdateDelta(node_id_, peer_.node_id, added, removed, sequence));
+  }
+
+  size_t ResyncsSent() const {
+    size_t count(0);
+    for (const auto& update : sent_) {
+      if (update.resync())
+        ++count;
+    }
+    return count;
+  }
+
+  bool InMatrix(const NodeId& node_id) {
+    for (const auto& node_info : routing_table_.GetMatrixNodes()) {
+      if (node_info.node_id == node_id)
+        return true;
+    }
+    return false;
+  }
+
+  bool HasSequenceFor(const NodeId& node_id) {
+    std::lock_guard<std::mutex> lock(group_change_handler_.mutex_);
+    return group_change_handler_.peer_update_sequences_.count(node_id) != 0;
+  }
+
+  std::vector<NodeInfo> RandomNodes(size_t count) {
+    std::vector<NodeInfo> nodes;
+    for (size_t i(0); i != count; ++i)
+      nodes.push_back(MakeNode());
+    return nodes;
+  }
+
+  NodeId node_id_;
+  NetworkStatistics network_statistics_;
+  RoutingTable routing_table_;
+  ClientRoutingTable client_routing_table_;
+  testing::NiceMock<MockNetworkUtils> network_;
+  GroupChangeHandler group_change_handler_;
+  NodeInfo peer_;
+  std::vector<protobuf::ClosestNodesUpdate> sent_;
+};
+
+TEST_F(GroupChangeHandlerTest, BEH_InOrderDelta) {
+  std::vector<NodeInfo> row(RandomNodes(4));
+  ReceiveFull(row, 1);
+  NodeInfo added(MakeNode());
+  ReceiveDelta(std::vector<NodeInfo>(1, added), std::vector<NodeId>(1, row.front().node_id), 2);
+  EXPECT_TRUE(sent_.empty());
+  EXPECT_TRUE(InMatrix(added.node_id));
+  EXPECT_FALSE(InMatrix(row.front().node_id));
+  EXPECT_TRUE(InMatrix(row.back().node_id));
+}
+
+TEST_F(GroupChangeHandlerTest, BEH_GapRequestsResync) {
+  std::vector<NodeInfo> row(RandomNodes(4));
+  ReceiveFull(row, 1);
+  NodeInfo added(MakeNode());
+  ReceiveDelta(std::vector<NodeInfo>(1, added), std::vector<NodeId>(), 3);
+  EXPECT_EQ(1U, ResyncsSent());
+  EXPECT_FALSE(InMatrix(added.node_id));
+
+  // The full list sent in reply is applied, and deltas following it are accepted again.
+  row.push_back(added);
+  ReceiveFull(row, 3);
+  EXPECT_TRUE(InMatrix(added.node_id));
+  ReceiveDelta(std::vector<NodeInfo>(), std::vector<NodeId>(1, added.node_id), 4);
+  EXPECT_EQ(1U, ResyncsSent());
+  EXPECT_FALSE(InMatrix(added.node_id));
+}
+
+TEST_F(GroupChangeHandlerTest, BEH_RepeatedUpdatesIgnored) {
+  std::vector<NodeInfo> row(RandomNodes(4));
+  ReceiveFull(row, 1);
+  NodeInfo added(MakeNode());
+  ReceiveDelta(std::vector<NodeInfo>(1, added), std::vector<NodeId>(), 2);
+  ReceiveDelta(std::vector<NodeInfo>(), std::vector<NodeId>(1, added.node_id), 3);
+  EXPECT_FALSE(InMatrix(added.node_id));
+
+  // Neither a duplicate nor an older update is applied, and neither asks for a resync.
+  ReceiveDelta(std::vector<NodeInfo>(1, added), std::vector<NodeId>(), 2);
+  ReceiveDelta(std::vector<NodeInfo>(1, added), std::vector<NodeId>(), 3);
+  row.push_back(added);
+  ReceiveFull(row, 1);
+  EXPECT_FALSE(InMatrix(added.node_id));
+  EXPECT_TRUE(sent_.empty());
+}
+
+TEST_F(GroupChangeHandlerTest, BEH_DeltaWithoutFullUpdate) {
+  NodeInfo added(MakeNode());
+  ReceiveDelta(std::vector<NodeInfo>(1, added), std::vector<NodeId>(), 5);
+  EXPECT_EQ(1U, ResyncsSent());
+  EXPECT_FALSE(InMatrix(added.node_id));
+
+  // Nor is a delta applied once the peer has left and rejoined.
+  ReceiveFull(RandomNodes(4), 1);
+  EXPECT_TRUE(HasSequenceFor(peer_.node_id));
+  group_change_handler_.PeerRemoved(peer_.node_id);
+  EXPECT_FALSE(HasSequenceFor(peer_.node_id));
+  ReceiveDelta(std::vector<NodeInfo>(1, added), std::vector<NodeId>(), 2);
+  EXPECT_EQ(2U, ResyncsSent());
+}
+
+TEST_F(GroupChangeHandlerTest, BEH_DeltasOnlyToCapablePeers) {
+  std::vector<NodeInfo> close_nodes(1, peer_);
+  while (close_nodes.size() != Parameters::closest_nodes_size) {
+    close_nodes.push_back(MakeNode());
+    EXPECT_TRUE(routing_table_.AddNode(close_nodes.back()));
+  }
+  group_change_handler_.SendClosestNodesUpdateRpcs(close_nodes);
+  ASSERT_EQ(close_nodes.size(), sent_.size());
+  for (const auto& update : sent_)
+    EXPECT_FALSE(update.delta());
+
+  // Only peer_ has said it understands deltas.
+  ReceiveFull(RandomNodes(4), 1);
+  sent_.clear();
+  close_nodes.back() = MakeNode();
+  group_change_handler_.SendClosestNodesUpdateRpcs(close_nodes);
+  ASSERT_EQ(close_nodes.size(), sent_.size());
+  size_t deltas(0);
+  for (const auto& update : sent_) {
+    if (update.delta())
+      ++deltas;
+  }
+  EXPECT_EQ(1U, deltas);
+}
+
+}  // namespace test
+
+}  // namespace routing
+
+}  // namespace maidsafe
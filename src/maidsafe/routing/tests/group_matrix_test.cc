@@ -837,6 +837,44 @@ TEST_P(GroupMatrixTest, BEH_UpdateFromConnectedPeer) {
     EXPECT_EQ(row_1.node_id, matrix_.GetConnectedPeerFor(new_node_id.node_id).node_id);
 }
 
+TEST_P(GroupMatrixTest, BEH_PatchFromConnectedPeer) {
+  NodeInfo row_1;
+  row_1.node_id = NodeId(NodeId::kRandomId);
+  std::vector<NodeInfo> row_entries;
+  NodeInfo node_info;
+  for (uint16_t i(0); i < Parameters::closest_nodes_size; ++i) {
+    node_info.node_id = NodeId(NodeId::kRandomId);
+    row_entries.push_back(node_info);
+  }
+
+  // Patching an unknown row fails
+  EXPECT_TRUE(matrix_.PatchFromConnectedPeer(row_1.node_id, row_entries, std::vector<NodeId>(),
+                                             std::vector<NodeId>()) == nullptr);
+
+  matrix_.AddConnectedPeer(row_1);
+  matrix_.UpdateFromConnectedPeer(row_1.node_id, row_entries, std::vector<NodeId>());
+
+  // Remove two entries, add one new entry and re-add an existing one
+  std::vector<NodeId> removed;
+  removed.push_back(row_entries.at(0).node_id);
+  removed.push_back(row_entries.at(1).node_id);
+  std::vector<NodeInfo> added;
+  node_info.node_id = NodeId(NodeId::kRandomId);
+  added.push_back(node_info);
+  added.push_back(row_entries.at(2));
+  EXPECT_TRUE(matrix_.PatchFromConnectedPeer(row_1.node_id, added, removed,
+                                             matrix_.GetUniqueNodeIds()) != nullptr);
+
+  std::vector<NodeInfo> expected_entries(row_entries.begin() + 2, row_entries.end());
+  expected_entries.push_back(node_info);
+  std::vector<NodeInfo> row_result;
+  EXPECT_TRUE(matrix_.GetRow(row_1.node_id, row_result));
+  EXPECT_TRUE(CompareListOfNodeInfos(row_result, expected_entries));
+  for (const auto& removed_id : removed)
+    EXPECT_EQ(NodeId(), matrix_.GetConnectedPeerFor(removed_id).node_id);
+  EXPECT_EQ(row_1.node_id, matrix_.GetConnectedPeerFor(node_info.node_id).node_id);
+}
+
 TEST_P(GroupMatrixTest, BEH_CheckUniqueNodeList) {
   // Add rows to matrix and check GetUniqueNodes
   std::vector<NodeInfo> row_ids;
@@ -0,0 +1,80 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include <chrono>
+#include <memory>
+
+#include "maidsafe/common/error.h"
+#include "maidsafe/common/node_id.h"
+#include "maidsafe/common/test.h"
+
+#include "maidsafe/routing/live_tuning.h"
+#include "maidsafe/routing/parameters.h"
+#include "maidsafe/routing/routing_api.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace test {
+
+TEST(LiveTuningTest, BEH_SetAndSnapshot) {
+  LiveTuning live_tuning;
+  std::shared_ptr<const Tuning> before(live_tuning.Get());
+  EXPECT_EQ(Parameters::default_response_timeout, before->response_timeout);
+  EXPECT_EQ(Parameters::negative_cache_size, before->negative_cache_size);
+  EXPECT_EQ(Parameters::route_cache_size, before->route_cache_size);
+  EXPECT_EQ(Parameters::route_cache_prefix_length, before->route_cache_prefix_length);
+
+  Tuning tuning(*before);
+  tuning.response_timeout = std::chrono::milliseconds(250);
+  tuning.negative_cache_size = 5;
+  live_tuning.Set(tuning);
+  EXPECT_EQ(std::chrono::steady_clock::duration(std::chrono::milliseconds(250)),
+            live_tuning.Get()->response_timeout);
+  EXPECT_EQ(5, live_tuning.Get()->negative_cache_size);
+  // A snapshot already taken keeps the values it was taken with.
+  EXPECT_EQ(Parameters::default_response_timeout, before->response_timeout);
+
+  Tuning invalid(tuning);
+  invalid.find_close_node_interval = boost::posix_time::time_duration();
+  EXPECT_THROW(live_tuning.Set(invalid), maidsafe_error);
+  EXPECT_EQ(std::chrono::steady_clock::duration(std::chrono::milliseconds(250)),
+            live_tuning.Get()->response_timeout);
+}
+
+TEST(LiveTuningTest, BEH_PerRoutingObject) {
+  Routing routing1(NodeId(NodeId::kRandomId)), routing2(NodeId(NodeId::kRandomId));
+  Tuning tuning(routing1.GetTuning());
+  tuning.response_timeout = std::chrono::seconds(1);
+  tuning.maximum_find_close_node_failures = 3;
+  routing1.SetTuning(tuning);
+  EXPECT_EQ(std::chrono::steady_clock::duration(std::chrono::seconds(1)),
+            routing1.GetTuning().response_timeout);
+  EXPECT_EQ(3, routing1.GetTuning().maximum_find_close_node_failures);
+  EXPECT_EQ(Parameters::default_response_timeout, routing2.GetTuning().response_timeout);
+  EXPECT_EQ(Parameters::maximum_find_close_node_failures,
+            routing2.GetTuning().maximum_find_close_node_failures);
+}
+
+}  // namespace test
+
+}  // namespace routing
+
+}  // namespace maidsafe
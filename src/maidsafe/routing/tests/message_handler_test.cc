@@ -33,6 +33,7 @@
 #include "maidsafe/routing/tests/test_utils.h"
 #include "maidsafe/routing/client_routing_table.h"
 #include "maidsafe/routing/group_change_handler.h"
+#include "maidsafe/routing/live_tuning.h"
 #include "maidsafe/routing/parameters.h"
 #include "maidsafe/routing/routing.pb.h"
 #include "maidsafe/routing/routing_table.h"
@@ -63,7 +64,8 @@ class MessageHandlerTest : public testing::Test {
         service_(),
         response_handler_(),
         network_statistics_(),
-        close_info_() {
+        close_info_(),
+        tuning_() {
     message_and_caching_functor_.message_received = [this] (const std::string& message,
         const bool& /*cache_lookup*/,
         ReplyFunctor reply_functor) {
@@ -80,7 +82,7 @@ class MessageHandlerTest : public testing::Test {
     group_change_handler_.reset(new GroupChangeHandler(*table_, *ntable_, *utils_));
     service_.reset(new MockService(*table_, *ntable_, *utils_));
     response_handler_.reset(new MockResponseHandler(*table_, *ntable_, *utils_,
-                                                    *group_change_handler_));
+                                                    *group_change_handler_, timer_));
     close_info_ = MakeNodeInfoAndKeys().node_info;
     close_info_.node_id = GenerateUniqueRandomId(table_->kNodeId(), 20);
     table_->AddNode(close_info_);
@@ -113,11 +115,12 @@ void ClearMessage(protobuf::Message& message) {
   std::shared_ptr<MockResponseHandler> response_handler_;
   std::shared_ptr<NetworkStatistics> network_statistics_;
   NodeInfo close_info_;
+  LiveTuning tuning_;
 };
 
 TEST_F(MessageHandlerTest, BEH_HandleInvalidMessage) {
   MessageHandler message_handler(*table_, *ntable_, *utils_, timer_, *remove_furthest_node_,
-                                 *group_change_handler_, *network_statistics_);
+                                 *group_change_handler_, *network_statistics_, tuning_);
   // Reset the service and response handler inside the message handler to be mocks
   message_handler.service_ = service_;
   message_handler.response_handler_ = response_handler_;
@@ -146,7 +149,7 @@ TEST_F(MessageHandlerTest, BEH_HandleInvalidMessage) {
 
 TEST_F(MessageHandlerTest, BEH_HandleRelay) {
   MessageHandler message_handler(*table_, *ntable_, *utils_, timer_, *remove_furthest_node_,
-                                 *group_change_handler_, *network_statistics_);
+                                 *group_change_handler_, *network_statistics_, tuning_);
   message_handler.service_ = service_;
   message_handler.response_handler_ = response_handler_;
 
@@ -231,7 +234,7 @@ TEST_F(MessageHandlerTest, BEH_HandleRelay) {
 
 TEST_F(MessageHandlerTest, BEH_HandleGroupMessage) {
   MessageHandler message_handler(*table_, *ntable_, *utils_, timer_, *remove_furthest_node_,
-                                 *group_change_handler_, *network_statistics_);
+                                 *group_change_handler_, *network_statistics_, tuning_);
   bool result(true);
   message_handler.service_ = service_;
   message_handler.response_handler_ = response_handler_;
@@ -589,7 +592,7 @@ TEST_F(MessageHandlerTest, BEH_HandleGroupMessage) {
 
 TEST_F(MessageHandlerTest, BEH_HandleNodeLevelMessage) {
   MessageHandler message_handler(*table_, *ntable_, *utils_, timer_, *remove_furthest_node_,
-                                 *group_change_handler_, *network_statistics_);
+                                 *group_change_handler_, *network_statistics_, tuning_);
   message_handler.service_ = service_;
   message_handler.response_handler_ = response_handler_;
   protobuf::Message message;
@@ -648,7 +651,7 @@ TEST_F(MessageHandlerTest, BEH_ClientRoutingTable) {
                                     *network_statistics_));
   table_->AddNode(close_info_);
   MessageHandler message_handler(*table_, *ntable_, *utils_, timer_, *remove_furthest_node_,
-                                 *group_change_handler_, *network_statistics_);
+                                 *group_change_handler_, *network_statistics_, tuning_);
   message_handler.service_ = service_;
   message_handler.response_handler_ = response_handler_;
   protobuf::Message message;
@@ -0,0 +1,83 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "maidsafe/common/node_id.h"
+#include "maidsafe/common/test.h"
+
+#include "maidsafe/routing/parameters.h"
+#include "maidsafe/routing/routing.pb.h"
+#include "maidsafe/routing/rpcs.h"
+#include "maidsafe/routing/utils.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace test {
+
+TEST(MessageTraceTest, BEH_RecordHops) {
+  NodeId source_id(NodeId::kRandomId), relay_id(NodeId::kRandomId),
+         destination_id(NodeId::kRandomId);
+  protobuf::Message message(rpcs::Ping(destination_id, "identity"));
+
+  // Untraced messages are left alone.
+  AddTraceHop(message, relay_id, std::chrono::steady_clock::now());
+  SetTraceNextHop(message, source_id, relay_id);
+  EXPECT_EQ(0, message.trace_hops_size());
+
+  message.set_trace(true);
+  SetTraceNextHop(message, source_id, relay_id);
+  ASSERT_EQ(1, message.trace_hops_size());
+  EXPECT_EQ(source_id.string().substr(0, 4), message.trace_hops(0).node_id_prefix());
+  EXPECT_EQ(relay_id.string().substr(0, 4), message.trace_hops(0).next_hop_prefix());
+
+  AddTraceHop(message, relay_id, std::chrono::steady_clock::now() - std::chrono::milliseconds(5));
+  ASSERT_EQ(2, message.trace_hops_size());
+  EXPECT_GE(message.trace_hops(1).queue_wait(), 5000);
+  EXPECT_FALSE(message.trace_hops(1).has_next_hop_prefix());
+  SetTraceNextHop(message, relay_id, destination_id);
+  ASSERT_EQ(2, message.trace_hops_size());
+  EXPECT_EQ(destination_id.string().substr(0, 4), message.trace_hops(1).next_hop_prefix());
+  EXPECT_GE(message.trace_hops(1).processing(), 0);
+
+  AddTraceHop(message, destination_id, std::chrono::steady_clock::now());
+  std::vector<TraceHop> hops(GetTraceHops(message));
+  ASSERT_EQ(3U, hops.size());
+  EXPECT_EQ(relay_id.string().substr(0, 4), hops.at(1).node_id_prefix);
+  EXPECT_LE(hops.at(0).received, hops.at(2).received);
+  EXPECT_TRUE(hops.at(2).next_hop_prefix.empty());
+}
+
+TEST(MessageTraceTest, BEH_LimitHops) {
+  protobuf::Message message(rpcs::Ping(NodeId(NodeId::kRandomId), "identity"));
+  message.set_trace(true);
+  for (uint16_t i(0); i != Parameters::max_trace_hops + 2; ++i)
+    AddTraceHop(message, NodeId(NodeId::kRandomId), std::chrono::steady_clock::now());
+  EXPECT_EQ(static_cast<int>(Parameters::max_trace_hops), message.trace_hops_size());
+}
+
+}  // namespace test
+
+}  // namespace routing
+
+}  // namespace maidsafe
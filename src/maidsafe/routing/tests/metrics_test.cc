@@ -0,0 +1,111 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/routing/message_handler.h"
+#include "maidsafe/routing/metrics.h"
+#include "maidsafe/routing/metrics_registry.h"
+#include "maidsafe/routing/parameters.h"
+#include "maidsafe/routing/routing.pb.h"
+#include "maidsafe/routing/rpcs.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace test {
+
+TEST(MetricsTest, BEH_HistogramBuckets) {
+  Histogram histogram;
+  EXPECT_EQ(0U, histogram.Snapshot().Percentile(0.5));
+  for (uint64_t value(0); value != 1000; ++value)
+    histogram.Record(value);
+  histogram.Record(uint64_t(1) << 63);
+
+  HistogramSnapshot snapshot(histogram.Snapshot());
+  EXPECT_EQ(1001U, snapshot.count);
+  EXPECT_EQ(uint64_t(1) << 63, snapshot.max);
+  uint64_t previous_bound(0), total(0);
+  for (size_t i(0); i != snapshot.buckets.size(); ++i) {
+    if (i != 0)
+      EXPECT_LT(previous_bound, snapshot.buckets[i].first);
+    previous_bound = snapshot.buckets[i].first;
+    total += snapshot.buckets[i].second;
+  }
+  EXPECT_EQ(snapshot.count, total);
+  // Values below 8 get a bucket each; above that, buckets are within 1/8th of their bound.
+  EXPECT_EQ(0U, snapshot.Percentile(0.0));
+  EXPECT_EQ(5U, snapshot.Percentile(0.005));
+  uint64_t median(snapshot.Percentile(0.5));
+  EXPECT_LE(median, 500U);
+  EXPECT_GE(median, 500U - 500U / 8);
+  EXPECT_EQ(uint64_t(1) << 63, snapshot.Percentile(1.0));
+}
+
+TEST(MetricsTest, BEH_RegistryCounts) {
+  MetricsRegistry registry;
+  protobuf::Message ping(rpcs::Ping(NodeId(NodeId::kRandomId), "identity"));
+  protobuf::Message node_level(ping);
+  node_level.set_type(static_cast<int32_t>(MessageType::kNodeLevel));
+
+  const int kThreadCount(4), kIncrements(1000);
+  std::vector<std::thread> threads;
+  for (int i(0); i != kThreadCount; ++i) {
+    threads.push_back(std::thread([&] {
+      for (int j(0); j != kIncrements; ++j) {
+        registry.MessageReceived(ping);
+        registry.Increment(MetricsRegistry::Counter::kForwarded);
+      }
+    }));
+  }
+  for (auto& thread : threads)
+    thread.join();
+
+  registry.MessageSent(node_level, 100);
+  registry.MessageDropped(MetricsRegistry::DropReason::kNoRoute);
+  node_level.set_hops_to_live(Parameters::hops_to_live - 3);
+  registry.MessageDelivered(node_level);
+  registry.MatrixUpdated(12);
+
+  RoutingMetrics metrics(registry.Snapshot());
+  EXPECT_EQ(1U, metrics.messages_received.size());
+  EXPECT_EQ(static_cast<uint64_t>(kThreadCount * kIncrements),
+            metrics.messages_received[static_cast<int32_t>(MessageType::kPing)]);
+  EXPECT_EQ(static_cast<uint64_t>(kThreadCount * kIncrements), metrics.messages_forwarded);
+  EXPECT_EQ(1U, metrics.messages_sent[static_cast<int32_t>(MessageType::kNodeLevel)]);
+  EXPECT_EQ(100U, metrics.bytes_sent[static_cast<int32_t>(MessageType::kNodeLevel)]);
+  EXPECT_EQ(1U, metrics.messages_dropped.size());
+  EXPECT_EQ(1U, metrics.messages_dropped["no_route"]);
+  EXPECT_EQ(1U, metrics.messages_delivered);
+  EXPECT_EQ(3U, metrics.hop_counts.max);
+  EXPECT_EQ(12U, metrics.matrix_update_sizes.sum);
+  EXPECT_EQ(0U, metrics.nodes_added);
+}
+
+}  // namespace test
+
+}  // namespace routing
+
+}  // namespace maidsafe
@@ -27,8 +27,9 @@ namespace test {
 MockResponseHandler::MockResponseHandler(RoutingTable& routing_table,
                          ClientRoutingTable& client_routing_table,
                          NetworkUtils& utils,
-                         GroupChangeHandler &group_change_handler)
-    : ResponseHandler(routing_table, client_routing_table, utils, group_change_handler) {}
+                         GroupChangeHandler &group_change_handler,
+                         Timer<std::string>& timer)
+    : ResponseHandler(routing_table, client_routing_table, utils, group_change_handler, timer) {}
 
 MockResponseHandler::~MockResponseHandler() {}
 
@@ -33,7 +33,8 @@ namespace test {
 class MockResponseHandler : public ResponseHandler {
  public:
   MockResponseHandler(RoutingTable& routing_table, ClientRoutingTable& client_routing_table,
-                   NetworkUtils& network_utils, GroupChangeHandler &group_change_handler);
+                   NetworkUtils& network_utils, GroupChangeHandler &group_change_handler,
+                   Timer<std::string>& timer);
   virtual ~MockResponseHandler();
 
   MOCK_METHOD1(Ping, void(protobuf::Message& message));
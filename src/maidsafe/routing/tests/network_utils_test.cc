@@ -224,7 +224,9 @@ TEST(NetworkUtilsTest, FUNC_ProcessSendDirectEndpoint) {
 
   std::vector<Endpoint> bootstrap_endpoint(1, endpoint2);
   EXPECT_EQ(kSuccess, network.Bootstrap(bootstrap_endpoint,
-                                        message_received_functor3,
+                                        [&](const std::string& message, const NodeId&) {
+                                          message_received_functor3(message);
+                                        },
                                         connection_lost_functor));
   rudp::NatType this_nat_type;
   EXPECT_EQ(rudp::kBootstrapConnectionAlreadyExists,
@@ -384,7 +386,9 @@ TEST(NetworkUtilsTest, FUNC_ProcessSendRecursiveSendOn) {
 
   std::vector<Endpoint> bootstrap_endpoint(1, endpoint2);
   EXPECT_EQ(kSuccess, network.Bootstrap(bootstrap_endpoint,
-                                        message_received_functor3,
+                                        [&](const std::string& message, const NodeId&) {
+                                          message_received_functor3(message);
+                                        },
                                         connection_lost_functor3));
   rudp::EndpointPair endpoint_pair2, endpoint_pair3;
   rudp::NatType this_nat_type;
@@ -0,0 +1,176 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "maidsafe/common/asio_service.h"
+#include "maidsafe/common/node_id.h"
+#include "maidsafe/common/test.h"
+
+#include "maidsafe/routing/node_lookup.h"
+#include "maidsafe/routing/parameters.h"
+#include "maidsafe/routing/timer.h"
+#include "maidsafe/routing/tests/test_utils.h"
+
+namespace maidsafe {
+namespace routing {
+namespace test {
+
+class NodeLookupTest : public testing::Test {
+ protected:
+  NodeLookupTest()
+      : kLookupRequestTimeout_(Parameters::lookup_request_timeout),
+        target_(NodeId::kRandomId),
+        mutex_(),
+        cond_var_(),
+        queried_(),
+        asio_service_(2),
+        node_lookup_(target_, timer_, [this](const NodeId& candidate) {
+                                        std::lock_guard<std::mutex> lock(mutex_);
+                                        queried_.push_back(candidate);
+                                        cond_var_.notify_all();
+                                      }),
+        timer_(asio_service_) {
+    asio_service_.Start();
+  }
+
+  ~NodeLookupTest() {
+    Parameters::lookup_request_timeout = kLookupRequestTimeout_;
+  }
+
+  std::vector<NodeId> Queried() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queried_;
+  }
+
+  bool WaitForQueries(size_t count) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cond_var_.wait_for(lock, std::chrono::seconds(10),
+                              [&] { return queried_.size() >= count; });
+  }
+
+  const std::chrono::steady_clock::duration kLookupRequestTimeout_;
+  NodeId target_;
+  std::mutex mutex_;
+  std::condition_variable cond_var_;
+  std::vector<NodeId> queried_;
+  AsioService asio_service_;
+  NodeLookup node_lookup_;
+  // Declared last so that the Timer's tasks are finished before the NodeLookup is destroyed.
+  Timer<std::string> timer_;
+};
+
+TEST_F(NodeLookupTest, BEH_FindsClosestNodes) {
+  std::vector<NodeId> network;
+  for (int i(0); i != 100; ++i)
+    network.push_back(NodeId(NodeId::kRandomId));
+  SortIdsFromTarget(target_, network);
+
+  // Each node only knows the few nodes ranked just closer to the target than itself, so the lookup
+  // has to iterate to reach the closest ones.
+  auto respond([&](const NodeId& responder, size_t rank) {
+    std::vector<NodeId> known_nodes(
+        network.begin() + (rank > Parameters::closest_nodes_size ?
+                           rank - Parameters::closest_nodes_size : 0),
+        network.begin() + rank);
+    known_nodes.push_back(responder);
+    node_lookup_.AddResponse(responder, known_nodes);
+  });
+  auto rank_of([&](const NodeId& node_id) {
+    return static_cast<size_t>(std::find(network.begin(), network.end(), node_id) -
+                               network.begin());
+  });
+
+  EXPECT_TRUE(node_lookup_.Done());
+  respond(NodeId(NodeId::kRandomId), network.size());
+  EXPECT_FALSE(node_lookup_.Done());
+  EXPECT_EQ(Parameters::lookup_parallelism, Queried().size());
+
+  size_t answered(0);
+  while (answered != Queried().size()) {
+    EXPECT_GE(Parameters::lookup_parallelism, Queried().size() - answered);
+    NodeId responder(Queried().at(answered++));
+    respond(responder, rank_of(responder));
+  }
+  EXPECT_TRUE(node_lookup_.Done());
+
+  // The lookup must have reached the closest nodes in the network, querying each only once.
+  std::vector<NodeId> queried(Queried());
+  std::set<NodeId> unique_queried(queried.begin(), queried.end());
+  EXPECT_EQ(queried.size(), unique_queried.size());
+  for (uint16_t i(0); i != Parameters::closest_nodes_size; ++i)
+    EXPECT_EQ(1U, unique_queried.count(network.at(i))) << "Missed " << i << "th closest node";
+}
+
+TEST_F(NodeLookupTest, BEH_IgnoresTarget) {
+  node_lookup_.AddResponse(NodeId(NodeId::kRandomId), std::vector<NodeId>(1, target_));
+  EXPECT_TRUE(Queried().empty());
+  EXPECT_TRUE(node_lookup_.Done());
+}
+
+TEST_F(NodeLookupTest, BEH_TimesOutUnansweredRequests) {
+  Parameters::lookup_request_timeout = std::chrono::milliseconds(100);
+  std::vector<NodeId> candidates;
+  for (int i(0); i != 10; ++i)
+    candidates.push_back(NodeId(NodeId::kRandomId));
+  node_lookup_.AddResponse(NodeId(NodeId::kRandomId), candidates);
+  EXPECT_EQ(Parameters::lookup_parallelism, Queried().size());
+
+  // With no responses at all, each timeout frees a slot for the next candidate until every
+  // candidate has been tried.
+  ASSERT_TRUE(WaitForQueries(candidates.size()));
+  std::vector<NodeId> queried(Queried());
+  EXPECT_EQ(candidates.size(), queried.size());
+  EXPECT_EQ(candidates.size(), std::set<NodeId>(queried.begin(), queried.end()).size());
+  auto deadline(std::chrono::steady_clock::now() + std::chrono::seconds(10));
+  while (!node_lookup_.Done() && std::chrono::steady_clock::now() < deadline)
+    Sleep(std::chrono::milliseconds(10));
+  EXPECT_TRUE(node_lookup_.Done());
+}
+
+TEST_F(NodeLookupTest, BEH_IgnoresResponsesOnceDone) {
+  std::vector<NodeId> candidates;
+  for (int i(0); i != 2; ++i)
+    candidates.push_back(NodeId(NodeId::kRandomId));
+  node_lookup_.AddResponse(NodeId(NodeId::kRandomId), candidates);
+  ASSERT_EQ(candidates.size(), Queried().size());
+  for (const auto& candidate : candidates)
+    node_lookup_.AddResponse(candidate, std::vector<NodeId>());
+  ASSERT_TRUE(node_lookup_.Done());
+
+  // A response which isn't to one of the lookup's own requests must not restart it.
+  std::vector<NodeId> others(1, NodeId(NodeId::kRandomId));
+  node_lookup_.AddResponse(NodeId(NodeId::kRandomId), others);
+  EXPECT_EQ(candidates.size(), Queried().size());
+  EXPECT_TRUE(node_lookup_.Done());
+
+  node_lookup_.Restart();
+  node_lookup_.AddResponse(NodeId(NodeId::kRandomId), others);
+  EXPECT_EQ(candidates.size() + 1, Queried().size());
+  EXPECT_FALSE(node_lookup_.Done());
+}
+
+}  // namespace test
+}  // namespace routing
+}  // namespace maidsafe
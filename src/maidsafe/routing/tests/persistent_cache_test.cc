@@ -0,0 +1,162 @@
+/*  Copyright 2013 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "boost/filesystem/operations.hpp"
+
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/routing/persistent_cache.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace test {
+
+namespace {
+
+const uint32_t kSegmentSize(4096);
+const uint16_t kMaxSegments(4);
+
+size_t SegmentFileCount(const boost::filesystem::path& directory) {
+  size_t count(0);
+  for (boost::filesystem::directory_iterator itr(directory);
+       itr != boost::filesystem::directory_iterator(); ++itr)
+    ++count;
+  return count;
+}
+
+}  // unnamed namespace
+
+class PersistentCacheTest : public testing::Test {
+ protected:
+  PersistentCacheTest()
+      : test_path_(maidsafe::test::CreateTestPath("MaidSafe_TestPersistentCache")),
+        directory_(*test_path_ / "cache") {}
+
+  maidsafe::test::TestPath test_path_;
+  boost::filesystem::path directory_;
+};
+
+TEST_F(PersistentCacheTest, BEH_PutGet) {
+  PersistentCache cache(directory_, kSegmentSize, kMaxSegments);
+  std::string data;
+  EXPECT_FALSE(cache.Get("name", data));
+  cache.Put("name", "data");
+  ASSERT_TRUE(cache.Get("name", data));
+  EXPECT_EQ("data", data);
+  cache.Put("name", "new data");
+  ASSERT_TRUE(cache.Get("name", data));
+  EXPECT_EQ("new data", data);
+  EXPECT_EQ(1U, cache.size());
+
+  // Empty names and entries larger than a segment are not stored.
+  cache.Put("", "data");
+  cache.Put("large", std::string(kSegmentSize, 'a'));
+  EXPECT_FALSE(cache.Get("large", data));
+  EXPECT_EQ(1U, cache.size());
+}
+
+TEST_F(PersistentCacheTest, BEH_Recover) {
+  std::vector<std::pair<std::string, std::string>> entries;
+  {
+    PersistentCache cache(directory_, kSegmentSize, kMaxSegments);
+    for (int i(0); i != 20; ++i) {
+      entries.push_back(std::make_pair(RandomString(64), RandomString(100)));
+      cache.Put(entries.back().first, entries.back().second);
+    }
+  }
+  PersistentCache cache(directory_, kSegmentSize, kMaxSegments);
+  EXPECT_EQ(entries.size(), cache.size());
+  for (const auto& entry : entries) {
+    std::string data;
+    ASSERT_TRUE(cache.Get(entry.first, data));
+    EXPECT_EQ(entry.second, data);
+  }
+}
+
+TEST_F(PersistentCacheTest, BEH_DropCorruptRecords) {
+  const std::string kCorruptName(RandomString(64)), kKeptName(RandomString(64));
+  const std::string kKeptData(RandomString(100));
+  {
+    PersistentCache cache(directory_, kSegmentSize, kMaxSegments);
+    cache.Put(kCorruptName, RandomString(100));
+    cache.Put(kKeptName, kKeptData);
+  }
+  // Changes a byte of the first record's data, as a torn write might.
+  boost::filesystem::path segment_path(directory_ / "segment_0.dat");
+  {
+    std::fstream stream(segment_path.string().c_str(),
+                        std::ios::binary | std::ios::in | std::ios::out);
+    stream.seekg(3 * sizeof(uint32_t) + kCorruptName.size() + 10);
+    char byte(0);
+    stream.get(byte);
+    stream.seekp(3 * sizeof(uint32_t) + kCorruptName.size() + 10);
+    stream.put(static_cast<char>(byte ^ 1));
+  }
+  PersistentCache cache(directory_, kSegmentSize, kMaxSegments);
+  std::string data;
+  EXPECT_FALSE(cache.Get(kCorruptName, data));
+  ASSERT_TRUE(cache.Get(kKeptName, data));
+  EXPECT_EQ(kKeptData, data);
+  EXPECT_EQ(1U, cache.size());
+}
+
+TEST_F(PersistentCacheTest, BEH_EvictOldestSegment) {
+  PersistentCache cache(directory_, kSegmentSize, kMaxSegments);
+  const std::string kFirstName(RandomString(64));
+  cache.Put(kFirstName, RandomString(1000));
+  for (uint32_t i(0); i != 5 * kMaxSegments * kSegmentSize / 1000; ++i)
+    cache.Put(RandomString(64), RandomString(1000));
+  Sleep(std::chrono::milliseconds(200));
+  std::string data;
+  EXPECT_FALSE(cache.Get(kFirstName, data));
+  EXPECT_GE(kMaxSegments, SegmentFileCount(directory_));
+}
+
+TEST_F(PersistentCacheTest, BEH_CompactSupersededEntries) {
+  PersistentCache cache(directory_, kSegmentSize, kMaxSegments);
+  const std::string kKeptName(RandomString(64)), kKeptData(RandomString(100));
+  cache.Put(kKeptName, kKeptData);
+  // Overwrite a single name until the first segments are mostly superseded entries.
+  for (uint32_t i(0); i != 2 * kSegmentSize / 1000; ++i)
+    cache.Put("overwritten", RandomString(1000));
+  Sleep(std::chrono::milliseconds(200));
+  {
+    std::unique_lock<std::mutex> lock(cache.mutex_);
+    EXPECT_FALSE(cache.NeedsCompaction(lock));
+    EXPECT_EQ(0U, cache.segments_.count(0));
+  }
+  std::string data;
+  ASSERT_TRUE(cache.Get(kKeptName, data));
+  EXPECT_EQ(kKeptData, data);
+  EXPECT_EQ(2U, cache.size());
+}
+
+}  // namespace test
+
+}  // namespace routing
+
+}  // namespace maidsafe
@@ -20,6 +20,7 @@
 #include <memory>
 #include <vector>
 
+#include "maidsafe/common/asio_service.h"
 #include "maidsafe/common/log.h"
 #include "maidsafe/common/test.h"
 #include "maidsafe/common/utils.h"
@@ -37,6 +38,7 @@
 #include "maidsafe/routing/routing_table.h"
 #include "maidsafe/routing/rpcs.h"
 #include "maidsafe/routing/service.h"
+#include "maidsafe/routing/timer.h"
 #include "maidsafe/routing/utils.h"
 #include "maidsafe/routing/tests/mock_network_utils.h"
 #include "maidsafe/routing/tests/test_utils.h"
@@ -58,7 +60,13 @@ class ResponseHandlerTest : public testing::Test {
        client_routing_table_(routing_table_.kNodeId()),
        network_(routing_table_, client_routing_table_),
        group_change_handler_(routing_table_, client_routing_table_, network_),
-       response_handler_(routing_table_, client_routing_table_, network_, group_change_handler_) {}
+       response_handler_(routing_table_, client_routing_table_, network_, group_change_handler_,
+                         timer_),
+       shared_response_handler_(),
+       asio_service_(2),
+       timer_(asio_service_) {
+    asio_service_.Start();
+  }
 
   int GetAvailableEndpoint(rudp::EndpointPair& this_endpoint_pair,
                            rudp::NatType& this_nat_type,
@@ -78,9 +86,22 @@ class ResponseHandlerTest : public testing::Test {
   }
 
  protected:
+  // Acks are signed and checked inline, so that their sends are made before the calls return.
+  static void SetUpTestCase() {
+    signature_verification_threads_ = Parameters::signature_verification_threads;
+    accept_unsigned_connect_acks_ = Parameters::accept_unsigned_connect_acks;
+    Parameters::signature_verification_threads = 0;
+  }
+
+  static void TearDownTestCase() {
+    Parameters::signature_verification_threads = signature_verification_threads_;
+  }
+
   void SetUp() {}
 
-  void TearDown() {}
+  void TearDown() {
+    Parameters::accept_unsigned_connect_acks = accept_unsigned_connect_acks_;
+  }
 
   void SetProtobufContact(protobuf::Contact* contact,
                           const NodeId &respondent_contact_node_id,
@@ -210,8 +231,20 @@ class ResponseHandlerTest : public testing::Test {
   MockNetworkUtils network_;
   GroupChangeHandler group_change_handler_;
   ResponseHandler response_handler_;
+  // For tests needing a ResponseHandler held by shared_ptr.
+  std::shared_ptr<ResponseHandler> shared_response_handler_;
+  // Declared last so that the Timer's tasks are finished before the ResponseHandlers are destroyed.
+  AsioService asio_service_;
+  Timer<std::string> timer_;
+
+ private:
+  static uint16_t signature_verification_threads_;
+  static bool accept_unsigned_connect_acks_;
 };
 
+uint16_t ResponseHandlerTest::signature_verification_threads_(0);
+bool ResponseHandlerTest::accept_unsigned_connect_acks_(false);
+
 TEST_F(ResponseHandlerTest, BEH_FindNodes) {
   protobuf::Message message;
   // Incorrect FindNodeResponse msg
@@ -361,9 +394,10 @@ TEST_F(ResponseHandlerTest, BEH_ConnectSuccessAcknowledgement) {
 
   // shared_from_this function inside requires the response_handler holder to be shared_ptr
   // if holding as a normal object, shared_from_this will throw an exception
-  std::shared_ptr<ResponseHandler> response_handler(
+  shared_response_handler_ =
       std::make_shared<ResponseHandler>(routing_table_, client_routing_table_, network_,
-                                        group_change_handler_));
+                                        group_change_handler_, timer_);
+  std::shared_ptr<ResponseHandler> response_handler(shared_response_handler_);
 
   // request_public_key_functor_ doesn't setup
   message = ComposeMsg(ComposeConnectSuccessAcknowledgement(node_id,
@@ -376,6 +410,14 @@ TEST_F(ResponseHandlerTest, BEH_ConnectSuccessAcknowledgement) {
       boost::bind(&ResponseHandlerTest::RequestPublicKey, this, _1, _2));
   EXPECT_NE(nullptr, response_handler->request_public_key_functor());
 
+  // Unsigned acks are rejected unless older nodes are accepted
+  Parameters::accept_unsigned_connect_acks = false;
+  EXPECT_CALL(network_, MarkConnectionAsValid(testing::_)).Times(0);
+  EXPECT_CALL(network_, SendToDirect(testing::_, testing::_, testing::_)).Times(0);
+  response_handler->ConnectSuccessAcknowledgement(message);
+  testing::Mock::VerifyAndClearExpectations(&network_);
+  Parameters::accept_unsigned_connect_acks = true;
+
   // Rudp failed to validate connection
   EXPECT_CALL(network_, MarkConnectionAsValid(testing::_))
       .WillOnce(testing::Return(-350020));
@@ -30,6 +30,7 @@
 #include "maidsafe/routing/routing_impl.h"
 #include "maidsafe/routing/return_codes.h"
 #include "maidsafe/routing/routing_api.h"
+#include "maidsafe/routing/tests/simulated_network.h"
 #include "maidsafe/routing/tests/test_utils.h"
 #include "maidsafe/routing/routing.pb.h"
 #include "maidsafe/routing/utils.h"
@@ -464,9 +465,19 @@ void GenericNode::SetHealth(const int &health) {
 }
 
 void GenericNode::PostTaskToAsioService(std::function<void()> functor) {
-  std::lock_guard<std::mutex> lock(routing_->pimpl_->running_mutex_);
-  if (routing_->pimpl_->running_)
-    routing_->pimpl_->asio_service_.service().post(functor);
+  Routing::Impl& impl(*routing_->pimpl_);
+  std::lock_guard<std::mutex> lock(impl.running_mutex_);
+  if (impl.running_)
+    impl.asio_service_.service().post(impl.handler_tracker_.Wrap(functor));
+}
+
+void GenericNode::UseSimulatedNetwork(SimulatedNetwork& network) {
+  NodeId connection_id(routing_->pimpl_->routing_table_.kConnectionId());
+  routing_->pimpl_->network_.set_transport(
+      network.CreateTransport(connection_id, has_symmetric_nat_ ?
+                                                 SimulatedNetwork::NatModel::kSymmetric :
+                                                 SimulatedNetwork::NatModel::kNone));
+  endpoint_ = network.GetEndpoint(connection_id);
 }
 
 rudp::NatType GenericNode::nat_type() {
@@ -481,6 +492,7 @@ GenericNetwork::GenericNetwork()
       public_keys_(),
       client_index_(0),
       nat_info_available_(true),
+      simulated_network_(),
       nodes_() { LOG(kVerbose) << "RoutingNetwork Constructor"; }
 
 GenericNetwork::~GenericNetwork() {
@@ -494,8 +506,16 @@ GenericNetwork::~GenericNetwork() {
     RemoveNode(nodes_.at(0)->node_id());
 }
 
+void GenericNetwork::set_simulated_network(std::shared_ptr<SimulatedNetwork> simulated_network) {
+  simulated_network_ = simulated_network;
+}
+
 void GenericNetwork::SetUp() {
   NodePtr node1(new GenericNode(false, false)), node2(new GenericNode(false, false));
+  if (simulated_network_) {
+    node1->UseSimulatedNetwork(*simulated_network_);
+    node2->UseSimulatedNetwork(*simulated_network_);
+  }
   nodes_.push_back(node1);
   nodes_.push_back(node2);
   client_index_ = 2;
@@ -647,6 +667,11 @@ bool GenericNetwork::RemoveNode(const NodeId& node_id) {
   return true;
 }
 
+std::vector<GenericNetwork::NodePtr> GenericNetwork::Nodes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return nodes_;
+}
+
 bool GenericNetwork::WaitForNodesToJoin() {
   // TODO(Alison) - tailor max. duration to match number of nodes joining?
   bool all_joined = true;
@@ -1474,6 +1499,8 @@ uint16_t GenericNetwork::NonClientNonSymmetricNatNodesSize() const {
 }
 
 void GenericNetwork::AddNodeDetails(NodePtr node) {
+  if (simulated_network_)
+    node->UseSimulatedNetwork(*simulated_network_);
   std::string descriptor;
   if (node->has_symmetric_nat_)
     descriptor.append("Symmetric ");
@@ -0,0 +1,151 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "boost/filesystem/operations.hpp"
+
+#include "maidsafe/common/node_id.h"
+#include "maidsafe/common/rsa.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/routing/routing.pb.h"
+#include "maidsafe/routing/routing_table_snapshot.h"
+#include "maidsafe/routing/tests/test_utils.h"
+#include "maidsafe/routing/utils.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace test {
+
+namespace {
+
+typedef boost::asio::ip::udp::endpoint Endpoint;
+
+void AddPeer(const NodeId& node_id,
+             const Endpoint& public_endpoint,
+             const Endpoint& private_endpoint,
+             protobuf::RoutingTableSnapshot& snapshot) {
+  protobuf::SnapshotPeer* peer(snapshot.add_peers());
+  peer->set_node_id(node_id.string());
+  peer->set_connection_id(node_id.string());
+  SetProtobufEndpoint(public_endpoint, peer->mutable_public_endpoint());
+  SetProtobufEndpoint(private_endpoint, peer->mutable_private_endpoint());
+}
+
+}  // unnamed namespace
+
+TEST(RoutingTableSnapshotTest, BEH_WriteAndRead) {
+  maidsafe::test::TestPath test_path(
+      maidsafe::test::CreateTestPath("MaidSafe_TestRoutingTableSnapshot"));
+  boost::filesystem::path snapshot_path(*test_path / "snapshot");
+  protobuf::RoutingTableSnapshot snapshot;
+  EXPECT_FALSE(ReadRoutingTableSnapshot(snapshot_path, snapshot));
+
+  AddPeer(NodeId(NodeId::kRandomId), Endpoint(GetLocalIp(), 5483), Endpoint(), snapshot);
+  snapshot.add_matrix_node_ids(NodeId(NodeId::kRandomId).string());
+  ASSERT_TRUE(WriteRoutingTableSnapshot(snapshot, snapshot_path));
+  protobuf::RoutingTableSnapshot read_snapshot;
+  ASSERT_TRUE(ReadRoutingTableSnapshot(snapshot_path, read_snapshot));
+  EXPECT_EQ(snapshot.SerializeAsString(), read_snapshot.SerializeAsString());
+
+  // Rewriting replaces the old snapshot and leaves no temporary file behind.
+  AddPeer(NodeId(NodeId::kRandomId), Endpoint(GetLocalIp(), 5484), Endpoint(), snapshot);
+  ASSERT_TRUE(WriteRoutingTableSnapshot(snapshot, snapshot_path));
+  ASSERT_TRUE(ReadRoutingTableSnapshot(snapshot_path, read_snapshot));
+  EXPECT_EQ(2, read_snapshot.peers_size());
+  size_t file_count(0);
+  for (boost::filesystem::directory_iterator itr(*test_path);
+       itr != boost::filesystem::directory_iterator(); ++itr)
+    ++file_count;
+  EXPECT_EQ(1U, file_count);
+
+  // A corrupt snapshot is rejected.
+  ASSERT_TRUE(WriteFile(snapshot_path, "not a snapshot"));
+  EXPECT_FALSE(ReadRoutingTableSnapshot(snapshot_path, read_snapshot));
+}
+
+TEST(RoutingTableSnapshotTest, BEH_ClosestPeersFirst) {
+  NodeId node_id(NodeId::kRandomId);
+  std::vector<NodeId> peer_ids, matrix_ids;
+  for (int i(0); i != 4; ++i) {
+    peer_ids.push_back(NodeId(NodeId::kRandomId));
+    matrix_ids.push_back(NodeId(NodeId::kRandomId));
+  }
+
+  protobuf::RoutingTableSnapshot snapshot;
+  for (size_t i(0); i != peer_ids.size(); ++i) {
+    AddPeer(peer_ids[i],
+            Endpoint(GetLocalIp(), static_cast<uint16_t>(6000 + i)),
+            Endpoint(GetLocalIp(), static_cast<uint16_t>(7000 + i)),
+            snapshot);
+  }
+  // Peers missing endpoints or duplicated by the matrix are still listed once.
+  protobuf::SnapshotPeer* peer(snapshot.add_peers());
+  peer->set_node_id(matrix_ids.front().string());
+  peer->set_connection_id(matrix_ids.front().string());
+  for (const auto& matrix_id : matrix_ids)
+    snapshot.add_matrix_node_ids(matrix_id.string());
+  snapshot.add_matrix_node_ids(node_id.string());
+
+  std::vector<Endpoint> endpoints(SnapshotBootstrapEndpoints(snapshot, node_id));
+  std::vector<NodeId> sorted_peer_ids(peer_ids);
+  SortIdsFromTarget(node_id, sorted_peer_ids);
+  ASSERT_EQ(2 * peer_ids.size(), endpoints.size());
+  for (size_t i(0); i != sorted_peer_ids.size(); ++i) {
+    size_t index(std::find(peer_ids.begin(), peer_ids.end(), sorted_peer_ids[i]) -
+                 peer_ids.begin());
+    EXPECT_EQ(6000 + index, endpoints[2 * i].port());
+    EXPECT_EQ(7000 + index, endpoints[2 * i + 1].port());
+  }
+
+  std::vector<NodeId> all_ids(peer_ids);
+  all_ids.insert(all_ids.end(), matrix_ids.begin(), matrix_ids.end());
+  SortIdsFromTarget(node_id, all_ids);
+  EXPECT_EQ(all_ids, SnapshotNodeIds(snapshot, node_id));
+}
+
+TEST(RoutingTableSnapshotTest, BEH_PublicKeyDigests) {
+  asymm::Keys keys(asymm::GenerateKeyPair()), other_keys(asymm::GenerateKeyPair());
+  EXPECT_TRUE(SnapshotPublicKeyDigest(asymm::PublicKey()).empty());
+  std::string digest(SnapshotPublicKeyDigest(keys.public_key));
+  EXPECT_FALSE(digest.empty());
+  EXPECT_NE(digest, SnapshotPublicKeyDigest(other_keys.public_key));
+
+  protobuf::RoutingTableSnapshot snapshot;
+  NodeId keyed_id(NodeId::kRandomId), unkeyed_id(NodeId::kRandomId);
+  AddPeer(keyed_id, Endpoint(GetLocalIp(), 6000), Endpoint(), snapshot);
+  snapshot.mutable_peers(0)->set_public_key_digest(digest);
+  AddPeer(unkeyed_id, Endpoint(GetLocalIp(), 6001), Endpoint(), snapshot);
+  std::map<NodeId, std::string> digests(SnapshotPublicKeyDigests(snapshot));
+  ASSERT_EQ(1U, digests.size());
+  EXPECT_EQ(digest, digests[keyed_id]);
+}
+
+}  // namespace test
+
+}  // namespace routing
+
+}  // namespace maidsafe
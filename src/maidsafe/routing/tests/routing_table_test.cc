@@ -16,6 +16,7 @@
     See the Licences for the specific language governing permissions and limitations relating to
     use of the MaidSafe Software.                                                                 */
 
+#include <algorithm>
 #include <bitset>
 #include <memory>
 #include <vector>
@@ -65,6 +66,27 @@ TEST(RoutingTableTest, BEH_AddCloseNodes) {
   EXPECT_EQ(Parameters::closest_nodes_size, routing_table.size());
 }
 
+TEST(RoutingTableTest, BEH_RejectDuplicatePublicKey) {
+  NodeId node_id(NodeId::kRandomId);
+  NetworkStatistics network_statistics(node_id);
+  RoutingTable routing_table(false, node_id, asymm::GenerateKeyPair(), network_statistics);
+  NodeInfo node(MakeNode());
+  EXPECT_TRUE(routing_table.AddNode(node));
+  // a different node presenting the same key is refused
+  NodeInfo impostor(MakeNode());
+  impostor.public_key = node.public_key;
+  EXPECT_FALSE(routing_table.AddNode(impostor));
+  EXPECT_EQ(1, routing_table.size());
+  // once dropped, the node (and its key) can be re-added
+  EXPECT_EQ(node.node_id, routing_table.DropNode(node.node_id, true).node_id);
+  EXPECT_EQ(0, routing_table.size());
+  EXPECT_TRUE(routing_table.AddNode(node));
+  EXPECT_FALSE(routing_table.AddNode(impostor));
+  EXPECT_TRUE(routing_table.DropNode(node.node_id, true).node_id == node.node_id);
+  EXPECT_TRUE(routing_table.AddNode(impostor));
+  EXPECT_EQ(1, routing_table.size());
+}
+
 TEST(RoutingTableTest, FUNC_AddTooManyNodes) {
   NodeId node_id(NodeId::kRandomId);
   NetworkStatistics network_statistics(node_id);
@@ -182,6 +204,53 @@ TEST(RoutingTableTest, FUNC_OrderedGroupChange) {
     EXPECT_EQ(expected_close_nodes.at(i), close_nodes.at(i).node_id);
 }
 
+TEST(RoutingTableTest, BEH_CoalescedGroupChange) {
+  NodeId node_id(NodeId::kRandomId);
+  NetworkStatistics network_statistics(node_id);
+  RoutingTable routing_table(false, node_id, asymm::GenerateKeyPair(), network_statistics);
+  std::vector<NodeInfo> nodes;
+
+  for (uint16_t i = 0; i < Parameters::closest_nodes_size; ++i)
+    nodes.push_back(MakeNode());
+
+  int group_change_count(0), matrix_change_count(0), schedule_count(0);
+  std::vector<NodeInfo> notified_close_nodes;
+  routing_table.InitialiseFunctors(
+      [](const int& status) { LOG(kVerbose) << "Status : " << status; },
+      [](const NodeInfo&, bool) {},
+      []() {},
+      [&](const std::vector<NodeInfo> close_nodes) {
+        ++group_change_count;
+        notified_close_nodes = close_nodes;
+      },
+      [](const std::vector<NodeInfo>&) {},
+      [&](std::shared_ptr<MatrixChange>) { ++matrix_change_count; });
+  routing_table.set_group_change_scheduling_functor([&schedule_count] { ++schedule_count; });
+
+  for (uint16_t i = 0; i < Parameters::closest_nodes_size; ++i)
+    ASSERT_TRUE(routing_table.AddNode(nodes.at(i)));
+
+  // Nothing is notified until the held back changes are flushed, and then only once.
+  EXPECT_EQ(1, schedule_count);
+  EXPECT_EQ(0, group_change_count);
+  EXPECT_EQ(0, matrix_change_count);
+  routing_table.FlushGroupChanges();
+  EXPECT_EQ(1, group_change_count);
+  EXPECT_EQ(1, matrix_change_count);
+  EXPECT_EQ(Parameters::closest_nodes_size, notified_close_nodes.size());
+
+  routing_table.FlushGroupChanges();
+  EXPECT_EQ(1, group_change_count);
+  EXPECT_EQ(1, matrix_change_count);
+
+  // A fresh change schedules a new notification.
+  routing_table.DropNode(nodes.at(0).node_id, true);
+  EXPECT_EQ(2, schedule_count);
+  routing_table.FlushGroupChanges();
+  EXPECT_EQ(2, group_change_count);
+  EXPECT_EQ(2, matrix_change_count);
+}
+
 TEST(RoutingTableTest, FUNC_ReverseOrderedGroupChange) {
   NodeId node_id(NodeId::kRandomId);
   NetworkStatistics network_statistics(node_id);
@@ -1425,6 +1494,136 @@ TEST(RoutingTableTest, FUNC_GetRandomExistingNode) {
   }
 }
 
+TEST(RoutingTableTest, BEH_RangeChecksAgreeWithSortedTable) {
+  NodeId own_node_id(NodeId::kRandomId);
+  NetworkStatistics network_statistics(own_node_id);
+  RoutingTable routing_table(false, own_node_id, asymm::GenerateKeyPair(), network_statistics);
+  std::vector<NodeInfo> known_nodes;
+  for (uint16_t i(0); i < Parameters::max_routing_table_size / 2; ++i) {
+    NodeInfo node_info(MakeNode());
+    known_nodes.push_back(node_info);
+    EXPECT_TRUE(routing_table.AddNode(node_info));
+  }
+
+  // Checks the cached answers against a full sort, for targets near this node (which the cache
+  // answers), far from it (which mostly fall back to a search), and equal to known nodes.
+  auto check_targets([&] {
+    std::vector<NodeId> targets;
+    for (uint16_t pos(496); pos <= 512; pos += 2)
+      targets.push_back(GenerateUniqueRandomId(own_node_id, pos));
+    for (const auto& node_info : known_nodes)
+      targets.push_back(node_info.node_id);
+    for (const auto& target : targets) {
+      std::vector<NodeInfo> by_own_distance(known_nodes);
+      SortFromTarget(own_node_id, by_own_distance);
+      for (uint16_t range : { Parameters::node_group_size, Parameters::closest_nodes_size }) {
+        EXPECT_EQ(NodeId::CloserToTarget(target, by_own_distance.at(range - 1).node_id,
+                                         own_node_id),
+                  routing_table.IsThisNodeInRange(target, range));
+      }
+      std::vector<NodeInfo> by_target_distance(known_nodes);
+      SortFromTarget(target, by_target_distance);
+      EXPECT_EQ(NodeId::CloserToTarget(own_node_id, by_target_distance.at(0).node_id, target),
+                routing_table.IsThisNodeClosestTo(target));
+      const NodeId& closest_other(by_target_distance.at(0).node_id == target ?
+                                  by_target_distance.at(1).node_id :
+                                  by_target_distance.at(0).node_id);
+      EXPECT_EQ(NodeId::CloserToTarget(own_node_id, closest_other, target),
+                routing_table.IsThisNodeClosestTo(target, true));
+    }
+  });
+  check_targets();
+
+  // The cached close group must follow drops, including of its own members.
+  SortFromTarget(own_node_id, known_nodes);
+  for (int i(0); i != 3; ++i) {
+    routing_table.DropNode(known_nodes.front().node_id, true);
+    known_nodes.erase(known_nodes.begin());
+    routing_table.DropNode(known_nodes.back().node_id, true);
+    known_nodes.pop_back();
+  }
+  check_targets();
+}
+
+TEST(RoutingTableTest, BEH_RouteCache) {
+  NodeId own_node_id(NodeId::kRandomId);
+  NetworkStatistics network_statistics(own_node_id);
+  LiveTuning live_tuning;
+  RoutingTable routing_table(false, own_node_id, asymm::GenerateKeyPair(), network_statistics,
+                             &live_tuning);
+  std::vector<NodeInfo> known_nodes;
+  for (uint16_t i(0); i < Parameters::max_routing_table_size / 2; ++i) {
+    NodeInfo node_info(MakeNode());
+    known_nodes.push_back(node_info);
+    EXPECT_TRUE(routing_table.AddNode(node_info));
+  }
+  auto closest_known([&](const NodeId& target) {
+    std::vector<NodeInfo> nodes(known_nodes);
+    SortFromTarget(target, nodes);
+    return nodes.front().node_id;
+  });
+
+  // Every known node is closer than this node to the furthest possible target.
+  NodeId target(own_node_id ^ NodeId(NodeId::kMaxId));
+  std::vector<std::string> exclude;
+  NodeId next_hop(routing_table.GetNodeForSendingMessage(target, exclude).node_id);
+  EXPECT_EQ(closest_known(target), next_hop);
+  EXPECT_EQ(0U, routing_table.metrics().Snapshot().route_cache_hits);
+  EXPECT_EQ(next_hop, routing_table.GetNodeForSendingMessage(target, exclude).node_id);
+  EXPECT_EQ(1U, routing_table.metrics().Snapshot().route_cache_hits);
+
+  // A destination sharing the prefix reuses the hop, as it is still closer than this node.
+  std::string nearby_id(target.string());
+  nearby_id[nearby_id.size() - 1] ^= 1;
+  EXPECT_EQ(next_hop,
+            routing_table.GetNodeForSendingMessage(NodeId(nearby_id), exclude).node_id);
+  EXPECT_EQ(2U, routing_table.metrics().Snapshot().route_cache_hits);
+
+  // A hop in the route history is never reused.
+  exclude.push_back(next_hop.string());
+  NodeId other_hop(routing_table.GetNodeForSendingMessage(target, exclude).node_id);
+  EXPECT_NE(next_hop, other_hop);
+  EXPECT_EQ(2U, routing_table.metrics().Snapshot().route_cache_hits);
+  exclude.clear();
+
+  // Dropping a node invalidates the cache.
+  EXPECT_EQ(other_hop, routing_table.GetNodeForSendingMessage(target, exclude).node_id);
+  EXPECT_EQ(3U, routing_table.metrics().Snapshot().route_cache_hits);
+  routing_table.DropNode(other_hop, true);
+  known_nodes.erase(std::find_if(known_nodes.begin(), known_nodes.end(),
+                                 [&](const NodeInfo& node_info) {
+                                   return node_info.node_id == other_hop;
+                                 }));
+  EXPECT_EQ(closest_known(target),
+            routing_table.GetNodeForSendingMessage(target, exclude).node_id);
+  EXPECT_EQ(3U, routing_table.metrics().Snapshot().route_cache_hits);
+
+  // A cached hop no closer than this node to the destination is not used, even where the whole
+  // ID space shares one cache entry.
+  {
+    Tuning whole_space(*live_tuning.Get());
+    whole_space.route_cache_prefix_length = 0;
+    ScopedTuning scoped_tuning(live_tuning, whole_space);
+    EXPECT_EQ(next_hop, routing_table.GetNodeForSendingMessage(target, exclude).node_id);
+    NodeId own_target(GenerateUniqueRandomId(own_node_id, 508));
+    EXPECT_EQ(closest_known(own_target),
+              routing_table.GetNodeForSendingMessage(own_target, exclude).node_id);
+    EXPECT_EQ(3U, routing_table.metrics().Snapshot().route_cache_hits);
+  }
+  EXPECT_EQ(Parameters::route_cache_prefix_length,
+            live_tuning.Get()->route_cache_prefix_length);
+
+  // With a zero size set while running, nothing more is cached or counted.
+  Tuning disabled(*live_tuning.Get());
+  disabled.route_cache_size = 0;
+  ScopedTuning scoped_tuning(live_tuning, disabled);
+  uint64_t misses(routing_table.metrics().Snapshot().route_cache_misses);
+  NodeId uncached_target(NodeId::kRandomId);
+  routing_table.GetNodeForSendingMessage(uncached_target, exclude);
+  routing_table.GetNodeForSendingMessage(uncached_target, exclude);
+  EXPECT_EQ(misses, routing_table.metrics().Snapshot().route_cache_misses);
+}
+
 }  // namespace test
 }  // namespace routing
 }  // namespace maidsafe
@@ -0,0 +1,98 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <vector>
+
+#include "maidsafe/common/node_id.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/routing/handler_tracker.h"
+#include "maidsafe/routing/routing_api.h"
+#include "maidsafe/routing/runtime.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace test {
+
+TEST(RuntimeTest, BEH_HandlerTracker) {
+  Runtime runtime(2);
+  HandlerTracker handler_tracker;
+  std::atomic<int> run_count(0);
+  for (int i(0); i != 10; ++i) {
+    runtime.asio_service().service().post(handler_tracker.Wrap([&run_count] {
+                                            Sleep(std::chrono::milliseconds(10));
+                                            ++run_count;
+                                          }));
+  }
+  handler_tracker.WaitForAll();
+  EXPECT_EQ(10, run_count.load());
+  EXPECT_EQ(0U, handler_tracker.pending());
+
+  // A handler is released when its last copy goes, whether or not it was ever run.
+  {
+    auto unrun(handler_tracker.Wrap([&run_count] { ++run_count; }));
+    auto copy(unrun);
+    EXPECT_EQ(1U, handler_tracker.pending());
+  }
+  EXPECT_EQ(0U, handler_tracker.pending());
+  handler_tracker.WaitForAll();
+  EXPECT_EQ(10, run_count.load());
+}
+
+TEST(RuntimeTest, BEH_HandlerTrackerWaitFromOwnHandler) {
+  HandlerTracker handler_tracker;
+  {
+    // Asserts in debug builds.  Otherwise returns, rather than waiting on the handler running it.
+    auto wait_inside(handler_tracker.Wrap([&handler_tracker] { handler_tracker.WaitForAll(); }));
+    EXPECT_DEBUG_DEATH(wait_inside(), "own handlers");
+    EXPECT_EQ(1U, handler_tracker.pending());
+  }
+  EXPECT_EQ(0U, handler_tracker.pending());
+}
+
+TEST(RuntimeTest, BEH_SharedByRoutingObjects) {
+  const size_t kNodeCount(10);
+  std::shared_ptr<Runtime> runtime(std::make_shared<Runtime>(2));
+  EXPECT_EQ(2, runtime->thread_count());
+  std::vector<std::unique_ptr<Routing>> nodes;
+  for (size_t i(0); i != kNodeCount; ++i)
+    nodes.emplace_back(new Routing(NodeId(NodeId::kRandomId), runtime));
+  EXPECT_EQ(static_cast<long>(kNodeCount) + 1, runtime.use_count());  // NOLINT
+
+  // Destroying the nodes leaves the runtime running for whoever else shares it.
+  nodes.clear();
+  EXPECT_EQ(1, runtime.use_count());
+  std::promise<void> ran;
+  runtime->asio_service().service().post([&ran] { ran.set_value(); });
+  EXPECT_EQ(std::future_status::ready,
+            ran.get_future().wait_for(std::chrono::seconds(10)));
+}
+
+}  // namespace test
+
+}  // namespace routing
+
+}  // namespace maidsafe
@@ -0,0 +1,191 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include <string>
+
+#include "maidsafe/common/rsa.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/routing/routing.pb.h"
+#include "maidsafe/routing/rpcs.h"
+#include "maidsafe/routing/session_keys.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace test {
+
+TEST(SessionKeysTest, BEH_AuthenticateHops) {
+  NodeId requester_id(NodeId::kRandomId), responder_id(NodeId::kRandomId);
+  asymm::Keys requester_keys(asymm::GenerateKeyPair());
+  SessionKeys requester(requester_id), responder(responder_id);
+  std::string requester_nonce(SessionKeys::NewNonce()), responder_nonce(SessionKeys::NewNonce());
+  requester.Enable();
+  responder.Enable();
+
+  // Without a handshake there is nothing to offer, and messages go untagged.
+  EXPECT_TRUE(responder.Offer(requester_id, requester_keys.public_key).empty());
+  protobuf::Message message(rpcs::Ping(requester_id, "identity"));
+  std::string serialised(responder.Serialise(message, requester_id));
+  EXPECT_EQ(message.SerializeAsString(), serialised);
+
+  // The responder's keys are pending until the requester uses its own.
+  requester.AddHandshake(responder_id, requester_nonce, responder_nonce, true);
+  responder.AddHandshake(requester_id, requester_nonce, responder_nonce, false);
+  std::string encrypted_secret(responder.Offer(requester_id, requester_keys.public_key));
+  ASSERT_FALSE(encrypted_secret.empty());
+  EXPECT_FALSE(responder.HasKeys(requester_id));
+  EXPECT_EQ(message.SerializeAsString(), responder.Serialise(message, requester_id));
+  EXPECT_FALSE(requester.Accept(responder_id, RandomString(encrypted_secret.size()),
+                                requester_keys.private_key));
+  ASSERT_TRUE(requester.Accept(responder_id, encrypted_secret, requester_keys.private_key));
+  EXPECT_TRUE(requester.HasKeys(responder_id));
+
+  // The responder's untagged messages are accepted until it has sent a tag.
+  protobuf::Message received;
+  serialised = responder.Serialise(message, requester_id);
+  ASSERT_TRUE(received.ParseFromString(serialised));
+  EXPECT_TRUE(requester.Authenticate(serialised, responder_id, received));
+
+  // The requester's first tagged message brings the responder's keys into use.
+  serialised = requester.Serialise(message, responder_id);
+  ASSERT_TRUE(received.ParseFromString(serialised));
+  EXPECT_TRUE(received.has_hop_mac());
+  EXPECT_TRUE(responder.Authenticate(serialised, requester_id, received));
+  EXPECT_FALSE(received.has_hop_mac());
+  EXPECT_EQ(message.SerializeAsString(), received.SerializeAsString());
+  EXPECT_TRUE(responder.HasKeys(requester_id));
+  std::string requester_tagged(serialised);
+
+  serialised = responder.Serialise(message, requester_id);
+  ASSERT_TRUE(received.ParseFromString(serialised));
+  EXPECT_TRUE(received.has_hop_mac());
+  EXPECT_TRUE(requester.Authenticate(serialised, responder_id, received));
+
+  // Once both sides tag, untagged messages are rejected.
+  std::string untagged(message.SerializeAsString());
+  ASSERT_TRUE(received.ParseFromString(untagged));
+  EXPECT_FALSE(requester.Authenticate(untagged, responder_id, received));
+  ASSERT_TRUE(received.ParseFromString(untagged));
+  EXPECT_FALSE(responder.Authenticate(untagged, requester_id, received));
+
+  // A message reflected back to its sender, or altered on the way, is rejected.
+  ASSERT_TRUE(received.ParseFromString(requester_tagged));
+  protobuf::Message tag;
+  tag.set_hop_id(responder_id.string());
+  tag.set_hop_mac(received.hop_mac());
+  std::string reflected(message.SerializeAsString() + tag.SerializePartialAsString());
+  ASSERT_TRUE(received.ParseFromString(reflected));
+  EXPECT_FALSE(requester.Authenticate(reflected, responder_id, received));
+  protobuf::Message altered(message);
+  altered.set_id(message.id() + 1);
+  std::string tampered(altered.SerializeAsString() +
+                       requester_tagged.substr(message.SerializeAsString().size()));
+  ASSERT_TRUE(received.ParseFromString(tampered));
+  EXPECT_FALSE(responder.Authenticate(tampered, requester_id, received));
+
+  // Once the peer is removed, its tags are rejected and its untagged messages accepted.
+  responder.Remove(requester_id);
+  EXPECT_FALSE(responder.HasKeys(requester_id));
+  ASSERT_TRUE(received.ParseFromString(requester_tagged));
+  EXPECT_FALSE(responder.Authenticate(requester_tagged, requester_id, received));
+  ASSERT_TRUE(received.ParseFromString(untagged));
+  EXPECT_TRUE(responder.Authenticate(untagged, requester_id, received));
+}
+
+TEST(SessionKeysTest, BEH_AuthenticateByConnection) {
+  NodeId requester_id(NodeId::kRandomId), responder_id(NodeId::kRandomId);
+  NodeId other_id(NodeId::kRandomId);
+  asymm::Keys requester_keys(asymm::GenerateKeyPair());
+  SessionKeys requester(requester_id), responder(responder_id);
+  std::string requester_nonce(SessionKeys::NewNonce()), responder_nonce(SessionKeys::NewNonce());
+  requester.Enable();
+  responder.Enable();
+  requester.AddHandshake(responder_id, requester_nonce, responder_nonce, true);
+  responder.AddHandshake(requester_id, requester_nonce, responder_nonce, false);
+  ASSERT_TRUE(requester.Accept(responder_id,
+                               responder.Offer(requester_id, requester_keys.public_key),
+                               requester_keys.private_key));
+  protobuf::Message message(rpcs::Ping(requester_id, "identity")), received;
+  std::string tagged(requester.Serialise(message, responder_id));
+
+  // A valid tag arriving on another connection is rejected, as is a tag naming an unknown
+  // connection.
+  ASSERT_TRUE(received.ParseFromString(tagged));
+  EXPECT_FALSE(responder.Authenticate(tagged, other_id, received));
+  EXPECT_FALSE(responder.HasKeys(requester_id));
+  protobuf::Message tag;
+  tag.set_hop_id(other_id.string());
+  tag.set_hop_mac(RandomString(64));
+  std::string unknown(message.SerializeAsString() + tag.SerializePartialAsString());
+  ASSERT_TRUE(received.ParseFromString(unknown));
+  EXPECT_FALSE(responder.Authenticate(unknown, NodeId(), received));
+  ASSERT_TRUE(received.ParseFromString(unknown));
+  EXPECT_FALSE(responder.Authenticate(unknown, other_id, received));
+
+  // Where the connection isn't known, a message is rejected, even with a valid tag.
+  ASSERT_TRUE(received.ParseFromString(tagged));
+  EXPECT_FALSE(responder.Authenticate(tagged, NodeId(), received));
+  EXPECT_FALSE(responder.HasKeys(requester_id));
+  std::string untagged(message.SerializeAsString());
+  ASSERT_TRUE(received.ParseFromString(untagged));
+  EXPECT_FALSE(responder.Authenticate(untagged, NodeId(), received));
+
+  // A message this node sent to itself is accepted untagged.
+  ASSERT_TRUE(received.ParseFromString(untagged));
+  EXPECT_TRUE(responder.Authenticate(untagged, responder_id, received));
+  ASSERT_TRUE(received.ParseFromString(tagged));
+  EXPECT_FALSE(responder.Authenticate(tagged, responder_id, received));
+
+  ASSERT_TRUE(received.ParseFromString(tagged));
+  EXPECT_TRUE(responder.Authenticate(tagged, requester_id, received));
+  EXPECT_TRUE(responder.HasKeys(requester_id));
+  ASSERT_TRUE(received.ParseFromString(untagged));
+  EXPECT_FALSE(responder.Authenticate(untagged, requester_id, received));
+}
+
+TEST(SessionKeysTest, BEH_Disabled) {
+  NodeId requester_id(NodeId::kRandomId), responder_id(NodeId::kRandomId);
+  asymm::Keys requester_keys(asymm::GenerateKeyPair());
+  SessionKeys responder(responder_id);
+  EXPECT_FALSE(responder.enabled());
+
+  // No keys are set up, so messages go untagged and can't be attributed to a connection.
+  responder.AddHandshake(requester_id, SessionKeys::NewNonce(), SessionKeys::NewNonce(), false);
+  EXPECT_TRUE(responder.Offer(requester_id, requester_keys.public_key).empty());
+  protobuf::Message message(rpcs::Ping(requester_id, "identity")), received;
+  std::string untagged(message.SerializeAsString());
+  EXPECT_EQ(untagged, responder.Serialise(message, requester_id));
+  ASSERT_TRUE(received.ParseFromString(untagged));
+  EXPECT_TRUE(responder.Authenticate(untagged, NodeId(), received));
+  protobuf::Message tag;
+  tag.set_hop_id(requester_id.string());
+  tag.set_hop_mac(RandomString(64));
+  std::string tagged(untagged + tag.SerializePartialAsString());
+  ASSERT_TRUE(received.ParseFromString(tagged));
+  EXPECT_FALSE(responder.Authenticate(tagged, NodeId(), received));
+}
+
+}  // namespace test
+
+}  // namespace routing
+
+}  // namespace maidsafe
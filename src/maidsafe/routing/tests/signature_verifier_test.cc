@@ -0,0 +1,191 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "maidsafe/common/rsa.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/routing/signature_verifier.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace test {
+
+TEST(SignatureVerifierTest, BEH_VerifyInline) {
+  SignatureVerifier signature_verifier(0);
+  asymm::Keys keys(asymm::GenerateKeyPair()), other_keys(asymm::GenerateKeyPair());
+  std::string data(RandomString(100));
+  std::string signature(asymm::Sign(asymm::PlainText(data), keys.private_key).string());
+  int valid_count(0), invalid_count(0);
+  auto count([&](bool valid) { valid ? ++valid_count : ++invalid_count; });  // NOLINT
+
+  signature_verifier.Verify(keys.public_key, data, signature, count);
+  // Answered from the cache the second time.
+  signature_verifier.Verify(keys.public_key, data, signature, count);
+  EXPECT_EQ(2, valid_count);
+
+  signature_verifier.Verify(other_keys.public_key, data, signature, count);
+  signature_verifier.Verify(keys.public_key, data + "a", signature, count);
+  signature_verifier.Verify(keys.public_key, data, "", count);
+  signature_verifier.Verify(asymm::PublicKey(), data, signature, count);
+  EXPECT_EQ(2, valid_count);
+  EXPECT_EQ(4, invalid_count);
+}
+
+TEST(SignatureVerifierTest, BEH_VerifyOnWorkers) {
+  const size_t kCheckCount(20);
+  asymm::Keys keys(asymm::GenerateKeyPair());
+  std::vector<std::string> data, signatures;
+  for (size_t i(0); i != kCheckCount; ++i) {
+    data.push_back(RandomString(100));
+    signatures.push_back(asymm::Sign(asymm::PlainText(data.back()), keys.private_key).string());
+  }
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  size_t valid_count(0), invalid_count(0);
+  {
+    SignatureVerifier signature_verifier(2);
+    for (size_t i(0); i != kCheckCount; ++i) {
+      // Odd checks use the wrong signature.
+      signature_verifier.Verify(keys.public_key, data[i], signatures[i - i % 2],
+                                [&](bool valid) {
+                                  std::lock_guard<std::mutex> lock(mutex);
+                                  valid ? ++valid_count : ++invalid_count;  // NOLINT
+                                  condition.notify_one();
+                                });
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    EXPECT_TRUE(condition.wait_for(lock, std::chrono::seconds(10), [&] {
+                                     return valid_count + invalid_count == kCheckCount;
+                                   }));
+  }
+  EXPECT_EQ(kCheckCount / 2, valid_count);
+  EXPECT_EQ(kCheckCount / 2, invalid_count);
+}
+
+TEST(SignatureVerifierTest, BEH_Sign) {
+  asymm::Keys keys(asymm::GenerateKeyPair());
+  std::string data(RandomString(100));
+  std::string signature;
+  SignatureVerifier inline_verifier(0);
+  inline_verifier.Sign(keys.private_key, data,
+                       [&](const std::string& result) { signature = result; });
+  EXPECT_TRUE(asymm::CheckSignature(asymm::PlainText(data), asymm::Signature(signature),
+                                    keys.public_key));
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::string worker_signature;
+  SignatureVerifier signature_verifier(2);
+  signature_verifier.Sign(keys.private_key, data, [&](const std::string& result) {
+                                                    std::lock_guard<std::mutex> lock(mutex);
+                                                    worker_signature = result;
+                                                    condition.notify_one();
+                                                  });
+  std::unique_lock<std::mutex> lock(mutex);
+  ASSERT_TRUE(condition.wait_for(lock, std::chrono::seconds(10),
+                                 [&] { return !worker_signature.empty(); }));
+  EXPECT_TRUE(asymm::CheckSignature(asymm::PlainText(data), asymm::Signature(worker_signature),
+                                    keys.public_key));
+}
+
+TEST(SignatureVerifierTest, BEH_AbandonPendingJobs) {
+  const size_t kJobCount(50);
+  asymm::Keys keys(asymm::GenerateKeyPair());
+  std::string data(RandomString(100));
+  std::string signature(asymm::Sign(asymm::PlainText(data), keys.private_key).string());
+  std::mutex mutex;
+  std::vector<int> verified_calls(kJobCount, 0), signed_calls(kJobCount, 0);
+  {
+    SignatureVerifier signature_verifier(1);
+    for (size_t i(0); i != kJobCount; ++i) {
+      // Distinct data, so that no check is answered from the cache.
+      std::string job_data(data + std::to_string(i));
+      signature_verifier.Verify(keys.public_key, job_data, signature, [&, i](bool valid) {
+                                  EXPECT_FALSE(valid);
+                                  std::lock_guard<std::mutex> lock(mutex);
+                                  ++verified_calls[i];
+                                });
+      signature_verifier.Sign(keys.private_key, job_data, [&, i](const std::string&) {
+                                std::lock_guard<std::mutex> lock(mutex);
+                                ++signed_calls[i];
+                              });
+    }
+  }
+  // Every functor has been called exactly once, whether its job ran or was abandoned.
+  std::lock_guard<std::mutex> lock(mutex);
+  for (size_t i(0); i != kJobCount; ++i) {
+    EXPECT_EQ(1, verified_calls[i]);
+    EXPECT_EQ(1, signed_calls[i]);
+  }
+}
+
+TEST(SignatureVerifierTest, BEH_ReleaseFromWorker) {
+  asymm::Keys keys(asymm::GenerateKeyPair());
+  std::string data(RandomString(100));
+  std::mutex mutex;
+  std::condition_variable condition;
+  int abandoned_count(0);
+  bool released(false);
+  std::shared_ptr<SignatureVerifier> signature_verifier(std::make_shared<SignatureVerifier>(1));
+  std::weak_ptr<SignatureVerifier> weak_verifier(signature_verifier);
+  std::shared_ptr<SignatureVerifier>* owner(&signature_verifier);
+  {
+    // The first job drops the only reference while the second is still pending.
+    std::lock_guard<std::mutex> queue_lock(mutex);
+    signature_verifier->Sign(keys.private_key, data, [&, owner](const std::string&) {
+                               std::shared_ptr<SignatureVerifier> last;
+                               {
+                                 std::lock_guard<std::mutex> owner_lock(mutex);
+                                 last.swap(*owner);
+                               }
+                               last.reset();
+                               std::lock_guard<std::mutex> released_lock(mutex);
+                               released = true;
+                               condition.notify_one();
+                             });
+    signature_verifier->Sign(keys.private_key, data, [&](const std::string& result) {
+                               std::lock_guard<std::mutex> abandoned_lock(mutex);
+                               if (result.empty())
+                                 ++abandoned_count;
+                               condition.notify_one();
+                             });
+  }
+  std::unique_lock<std::mutex> lock(mutex);
+  // The pending job is abandoned, either by the destructor or by the detached worker.
+  ASSERT_TRUE(condition.wait_for(lock, std::chrono::seconds(10),
+                                 [&] { return released && abandoned_count == 1; }));
+  EXPECT_TRUE(weak_verifier.expired());
+}
+
+}  // namespace test
+
+}  // namespace routing
+
+}  // namespace maidsafe
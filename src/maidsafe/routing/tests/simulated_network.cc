@@ -0,0 +1,484 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/routing/tests/simulated_network.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "maidsafe/rudp/return_codes.h"
+
+#include "maidsafe/routing/return_codes.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace test {
+
+namespace {
+
+const uint16_t kSimulatedPort(5483);
+
+rudp::NatType RudpNatType(SimulatedNetwork::NatModel nat_model) {
+  return nat_model == SimulatedNetwork::NatModel::kSymmetric ? rudp::NatType::kSymmetric :
+                                                               rudp::NatType::kOther;
+}
+
+boost::asio::ip::address_v4 SimulatedAddress(uint32_t prefix, uint32_t index) {
+  return boost::asio::ip::address_v4((prefix << 24) | (index & 0xFFFFFF));
+}
+
+}  // unnamed namespace
+
+SimulatedNetwork::Config::Config()
+    : min_latency(std::chrono::milliseconds(10)),
+      max_latency(std::chrono::milliseconds(50)),
+      loss_rate(0.0),
+      retransmit_timeout(std::chrono::milliseconds(200)),
+      max_send_attempts(5),
+      bandwidth(0),
+      seed(0) {}
+
+SimulatedNetwork::SimulatedNetwork(const Config& config)
+    : kConfig_(config),
+      callback_mutex_(),
+      mutex_(),
+      condition_(),
+      now_(0),
+      next_sequence_(0),
+      events_(),
+      nodes_(),
+      endpoints_(),
+      next_address_(1),
+      random_(config.seed),
+      statistics_(),
+      running_(false),
+      pump_() {
+  assert(kConfig_.min_latency <= kConfig_.max_latency);
+  assert(kConfig_.max_send_attempts != 0);
+}
+
+SimulatedNetwork::~SimulatedNetwork() {
+  Stop();
+}
+
+std::unique_ptr<Transport> SimulatedNetwork::CreateTransport(const NodeId& connection_id,
+                                                             NatModel nat_model,
+                                                             Endpoint endpoint) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    assert(nodes_.find(connection_id) == nodes_.end() && "Duplicate connection ID");
+    uint32_t index(next_address_++);
+    Node& node(nodes_[connection_id]);
+    node.nat_model = nat_model;
+    if (endpoint.address().is_unspecified()) {
+      // Nodes behind NAT get a private local address; all have a distinct external address.
+      node.external = Endpoint(SimulatedAddress(198, index), kSimulatedPort);
+      node.local = (nat_model == NatModel::kNone) ? node.external :
+                                                    Endpoint(SimulatedAddress(10, index),
+                                                             kSimulatedPort);
+    } else {
+      node.local = node.external = endpoint;
+    }
+    endpoints_[node.external] = connection_id;
+  }
+  return std::unique_ptr<Transport>(new SimulatedTransport(*this, connection_id));
+}
+
+SimulatedNetwork::Endpoint SimulatedNetwork::GetEndpoint(const NodeId& connection_id) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto itr(nodes_.find(connection_id));
+  return itr == nodes_.end() ? Endpoint() : itr->second.external;
+}
+
+SimulatedNetwork::Duration SimulatedNetwork::Now() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return now_;
+}
+
+bool SimulatedNetwork::RunNext() {
+  std::lock_guard<std::recursive_mutex> callback_lock(callback_mutex_);
+  Event event(Duration(0), 0, NodeId(), nullptr);
+  if (!PopEvent(Duration::max(), event))
+    return false;
+  RunEvent(event);
+  return true;
+}
+
+void SimulatedNetwork::RunFor(Duration duration) {
+  Duration end_time(Now() + duration);
+  std::lock_guard<std::recursive_mutex> callback_lock(callback_mutex_);
+  Event event(Duration(0), 0, NodeId(), nullptr);
+  while (PopEvent(end_time, event))
+    RunEvent(event);
+  std::lock_guard<std::mutex> lock(mutex_);
+  now_ = std::max(now_, end_time);
+}
+
+size_t SimulatedNetwork::RunUntilIdle() {
+  size_t count(0);
+  while (RunNext())
+    ++count;
+  return count;
+}
+
+void SimulatedNetwork::Start() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (running_)
+    return;
+  running_ = true;
+  pump_ = std::thread([this] { Pump(); });
+}
+
+void SimulatedNetwork::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_)
+      return;
+    running_ = false;
+  }
+  condition_.notify_one();
+  if (pump_.joinable())
+    pump_.join();
+}
+
+SimulatedNetwork::Statistics SimulatedNetwork::statistics() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return statistics_;
+}
+
+void SimulatedNetwork::Pump() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto real_start(std::chrono::steady_clock::now());
+  Duration virtual_start(now_);
+  while (running_) {
+    if (events_.empty()) {
+      condition_.wait(lock);
+      continue;
+    }
+    auto due(real_start + (events_.top().time - virtual_start));
+    if (std::chrono::steady_clock::now() < due) {
+      condition_.wait_until(lock, due);
+      continue;
+    }
+    lock.unlock();
+    {
+      std::lock_guard<std::recursive_mutex> callback_lock(callback_mutex_);
+      Event event(Duration(0), 0, NodeId(), nullptr);
+      Duration virtual_now(virtual_start + std::chrono::duration_cast<Duration>(
+                                               std::chrono::steady_clock::now() - real_start));
+      if (PopEvent(virtual_now, event))
+        RunEvent(event);
+    }
+    lock.lock();
+  }
+}
+
+bool SimulatedNetwork::PopEvent(Duration end_time, Event& event) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (events_.empty() || events_.top().time > end_time)
+    return false;
+  event = events_.top();
+  events_.pop();
+  now_ = std::max(now_, event.time);
+  return true;
+}
+
+void SimulatedNetwork::RunEvent(const Event& event) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (nodes_.find(event.owner) == nodes_.end())
+      return;
+  }
+  event.action();
+}
+
+int SimulatedNetwork::Bootstrap(const NodeId& this_id,
+                                const std::vector<Endpoint>& bootstrap_endpoints,
+                                const MessageReceivedFromFunctor& message_received_functor,
+                                const rudp::ConnectionLostFunctor& connection_lost_functor,
+                                NodeId& chosen_bootstrap_peer,
+                                rudp::NatType& nat_type) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Node& node(nodes_.at(this_id));
+  node.message_received = message_received_functor;
+  node.connection_lost = connection_lost_functor;
+  for (const auto& message : node.inbox)
+    Schedule(Duration(0), this_id, [message_received_functor, message] {
+                                     message_received_functor(message.second, message.first);
+                                   });
+  node.inbox.clear();
+  nat_type = RudpNatType(node.nat_model);
+
+  for (const auto& endpoint : bootstrap_endpoints) {
+    auto found(endpoints_.find(endpoint));
+    if (found == endpoints_.end() || found->second == this_id)
+      continue;
+    Node& peer(nodes_.at(found->second));
+    if (peer.nat_model != NatModel::kNone)
+      continue;
+    auto connection(node.connections.find(found->second));
+    if (connection == node.connections.end()) {
+      node.connections[found->second].state = Connection::State::kBootstrap;
+      peer.connections[this_id].state = Connection::State::kBootstrap;
+    }
+    chosen_bootstrap_peer = found->second;
+    return kSuccess;
+  }
+  return kNoOnlineBootstrapContacts;
+}
+
+int SimulatedNetwork::GetAvailableEndpoint(const NodeId& this_id,
+                                           const NodeId& peer_id,
+                                           rudp::EndpointPair& this_endpoint_pair,
+                                           rudp::NatType& this_nat_type) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Node& node(nodes_.at(this_id));
+  this_endpoint_pair.local = node.local;
+  this_endpoint_pair.external = ExternalEndpoint(node);
+  this_nat_type = RudpNatType(node.nat_model);
+  auto connection(node.connections.find(peer_id));
+  if (connection == node.connections.end())
+    return kSuccess;
+  if (connection->second.state == Connection::State::kBootstrap)
+    return rudp::kBootstrapConnectionAlreadyExists;
+  if (connection->second.added || connection->second.state == Connection::State::kValid)
+    return rudp::kUnvalidatedConnectionAlreadyExists;
+  return kSuccess;
+}
+
+int SimulatedNetwork::Add(const NodeId& this_id,
+                          const NodeId& peer_id,
+                          const std::string& validation_data) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Node& node(nodes_.at(this_id));
+  auto peer(nodes_.find(peer_id));
+  if (peer == nodes_.end() || !Reachable(node, peer->second))
+    return kGeneralError;
+  Connection& connection(node.connections[peer_id]);
+  if (connection.added || connection.state == Connection::State::kValid)
+    return rudp::kUnvalidatedConnectionAlreadyExists;
+  connection.added = true;
+  connection.state = Connection::State::kUnvalidated;
+  Connection& peer_connection(peer->second.connections[this_id]);
+  if (peer_connection.state == Connection::State::kBootstrap)
+    peer_connection.state = Connection::State::kUnvalidated;
+  Transmit(this_id, peer_id, validation_data, nullptr);
+  return kSuccess;
+}
+
+int SimulatedNetwork::MarkConnectionAsValid(const NodeId& this_id,
+                                            const NodeId& peer_id,
+                                            Endpoint& new_bootstrap_endpoint) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Node& node(nodes_.at(this_id));
+  auto connection(node.connections.find(peer_id));
+  if (connection == node.connections.end())
+    return kGeneralError;
+  connection->second.state = Connection::State::kValid;
+  const Node& peer(nodes_.at(peer_id));
+  if (peer.nat_model == NatModel::kNone)
+    new_bootstrap_endpoint = peer.external;
+  return kSuccess;
+}
+
+void SimulatedNetwork::Remove(const NodeId& this_id, const NodeId& peer_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (nodes_.at(this_id).connections.erase(peer_id) != 0)
+    NotifyConnectionLost(this_id, peer_id);
+}
+
+void SimulatedNetwork::Send(const NodeId& this_id,
+                            const NodeId& peer_id,
+                            const std::string& message,
+                            const rudp::MessageSentFunctor& message_sent_functor) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const Node& node(nodes_.at(this_id));
+  if (node.connections.find(peer_id) != node.connections.end()) {
+    Transmit(this_id, peer_id, message, message_sent_functor);
+  } else if (message_sent_functor) {
+    ++statistics_.messages_failed;
+    Schedule(Duration(0), this_id, [message_sent_functor] { message_sent_functor(kGeneralError); });
+  }
+}
+
+void SimulatedNetwork::RemoveNode(const NodeId& this_id) {
+  std::lock_guard<std::recursive_mutex> callback_lock(callback_mutex_);
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto node(nodes_.find(this_id));
+  assert(node != nodes_.end());
+  for (const auto& connection : node->second.connections)
+    NotifyConnectionLost(this_id, connection.first);
+  endpoints_.erase(node->second.external);
+  nodes_.erase(node);
+}
+
+void SimulatedNetwork::Schedule(Duration delay, const NodeId& owner,
+                                std::function<void()> action) {
+  events_.push(Event(now_ + delay, next_sequence_++, owner, action));
+  condition_.notify_one();
+}
+
+void SimulatedNetwork::Transmit(const NodeId& sender_id,
+                                const NodeId& peer_id,
+                                const std::string& message,
+                                const rudp::MessageSentFunctor& message_sent_functor) {
+  ++statistics_.messages_sent;
+  statistics_.bytes_sent += message.size();
+  Node& sender(nodes_.at(sender_id));
+  // The message queues behind earlier ones on the sender's uplink.
+  Duration departure(std::max(now_, sender.uplink_free_at));
+  if (kConfig_.bandwidth != 0) {
+    departure += Duration(static_cast<Duration::rep>(message.size() * 1000000 /
+                                                     kConfig_.bandwidth));
+  }
+  sender.uplink_free_at = departure;
+
+  Duration delay(departure - now_);
+  std::bernoulli_distribution lost(kConfig_.loss_rate);
+  for (uint16_t attempt(1); lost(random_); ++attempt) {
+    if (attempt == kConfig_.max_send_attempts) {
+      ++statistics_.messages_failed;
+      if (message_sent_functor) {
+        Schedule(delay + kConfig_.retransmit_timeout, sender_id,
+                 [message_sent_functor] { message_sent_functor(rudp::kSendFailure); });
+      }
+      return;
+    }
+    delay += kConfig_.retransmit_timeout;
+  }
+  Schedule(delay + Latency(), sender_id,
+           [=] { Deliver(sender_id, peer_id, message, message_sent_functor); });
+}
+
+void SimulatedNetwork::NotifyConnectionLost(const NodeId& lost_id, const NodeId& peer_id) {
+  auto peer(nodes_.find(peer_id));
+  if (peer == nodes_.end() || peer->second.connections.erase(lost_id) == 0 ||
+      !peer->second.connection_lost)
+    return;
+  rudp::ConnectionLostFunctor connection_lost(peer->second.connection_lost);
+  Schedule(Latency(), peer_id, [connection_lost, lost_id] { connection_lost(lost_id); });
+}
+
+SimulatedNetwork::Duration SimulatedNetwork::Latency() {
+  std::uniform_int_distribution<Duration::rep> latency(kConfig_.min_latency.count(),
+                                                       kConfig_.max_latency.count());
+  return Duration(latency(random_));
+}
+
+bool SimulatedNetwork::Reachable(const Node& from, const Node& to) const {
+  return from.nat_model != NatModel::kSymmetric || to.nat_model != NatModel::kSymmetric;
+}
+
+SimulatedNetwork::Endpoint SimulatedNetwork::ExternalEndpoint(const Node& node) {
+  if (node.nat_model != NatModel::kSymmetric)
+    return node.external;
+  std::uniform_int_distribution<uint16_t> port(1025, 65535);
+  return Endpoint(node.external.address(), port(random_));
+}
+
+void SimulatedNetwork::Deliver(const NodeId& sender_id,
+                               const NodeId& peer_id,
+                               const std::string& message,
+                               const rudp::MessageSentFunctor& message_sent_functor) {
+  MessageReceivedFromFunctor message_received;
+  bool delivered(false);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto peer(nodes_.find(peer_id));
+    if (peer != nodes_.end() &&
+        peer->second.connections.find(sender_id) != peer->second.connections.end()) {
+      delivered = true;
+      if (peer->second.message_received)
+        message_received = peer->second.message_received;
+      else
+        peer->second.inbox.push_back(std::make_pair(sender_id, message));
+    }
+    ++(delivered ? statistics_.messages_delivered : statistics_.messages_failed);
+  }
+  if (message_received)
+    message_received(message, sender_id);
+  if (message_sent_functor)
+    message_sent_functor(delivered ? kSuccess : rudp::kSendFailure);
+}
+
+SimulatedTransport::SimulatedTransport(SimulatedNetwork& network, const NodeId& connection_id)
+    : network_(network),
+      kConnectionId_(connection_id) {}
+
+SimulatedTransport::~SimulatedTransport() {
+  network_.RemoveNode(kConnectionId_);
+}
+
+bool SimulatedTransport::ReportsConnections() const {
+  return true;
+}
+
+int SimulatedTransport::Bootstrap(
+    const std::vector<boost::asio::ip::udp::endpoint>& bootstrap_endpoints,
+    const MessageReceivedFromFunctor& message_received_functor,
+    const rudp::ConnectionLostFunctor& connection_lost_functor,
+    const NodeId& this_node_id,
+    std::shared_ptr<asymm::PrivateKey> /*private_key*/,
+    std::shared_ptr<asymm::PublicKey> /*public_key*/,
+    NodeId& chosen_bootstrap_peer,
+    rudp::NatType& nat_type,
+    boost::asio::ip::udp::endpoint /*local_endpoint*/) {
+  assert(this_node_id == kConnectionId_);
+  static_cast<void>(this_node_id);
+  return network_.Bootstrap(kConnectionId_, bootstrap_endpoints, message_received_functor,
+                            connection_lost_functor, chosen_bootstrap_peer, nat_type);
+}
+
+int SimulatedTransport::GetAvailableEndpoint(const NodeId& peer_id,
+                                             const rudp::EndpointPair& /*peer_endpoint_pair*/,
+                                             rudp::EndpointPair& this_endpoint_pair,
+                                             rudp::NatType& this_nat_type) {
+  return network_.GetAvailableEndpoint(kConnectionId_, peer_id, this_endpoint_pair,
+                                       this_nat_type);
+}
+
+int SimulatedTransport::Add(const NodeId& peer_id,
+                            const rudp::EndpointPair& /*peer_endpoint_pair*/,
+                            const std::string& validation_data) {
+  return network_.Add(kConnectionId_, peer_id, validation_data);
+}
+
+int SimulatedTransport::MarkConnectionAsValid(
+    const NodeId& peer_id,
+    boost::asio::ip::udp::endpoint& new_bootstrap_endpoint) {
+  return network_.MarkConnectionAsValid(kConnectionId_, peer_id, new_bootstrap_endpoint);
+}
+
+void SimulatedTransport::Remove(const NodeId& peer_id) {
+  network_.Remove(kConnectionId_, peer_id);
+}
+
+void SimulatedTransport::Send(const NodeId& peer_id,
+                              const std::string& message,
+                              const rudp::MessageSentFunctor& message_sent_functor) {
+  network_.Send(kConnectionId_, peer_id, message, message_sent_functor);
+}
+
+}  // namespace test
+
+}  // namespace routing
+
+}  // namespace maidsafe
@@ -0,0 +1,255 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_ROUTING_TESTS_SIMULATED_NETWORK_H_
+#define MAIDSAFE_ROUTING_TESTS_SIMULATED_NETWORK_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "boost/asio/ip/udp.hpp"
+
+#include "maidsafe/common/node_id.h"
+
+#include "maidsafe/routing/transport.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace test {
+
+class SimulatedTransport;
+
+// An in-memory network connecting SimulatedTransports, with modelled latency, loss, bandwidth and
+// NAT, run against a virtual clock.  Messages and connection changes are queued as events and
+// are only delivered as the clock is advanced, either by the caller (RunNext, RunFor,
+// RunUntilIdle) or in step with real time by a background thread (Start).  All random choices are
+// drawn from one generator seeded from the config, so a given sequence of calls always gives the
+// same deliveries at the same virtual times.  The network must outlive its transports.
+class SimulatedNetwork {
+ public:
+  typedef std::chrono::microseconds Duration;
+  typedef boost::asio::ip::udp::endpoint Endpoint;
+
+  struct Config {
+    Config();
+    // One-way latency of each message is drawn uniformly from this range.
+    Duration min_latency, max_latency;
+    // Each transmission attempt is lost with this probability.  A lost attempt delays the message
+    // by retransmit_timeout, and after max_send_attempts the send fails with rudp::kSendFailure.
+    double loss_rate;
+    Duration retransmit_timeout;
+    uint16_t max_send_attempts;
+    // Bytes per second of each node's uplink, or 0 for unlimited.
+    uint64_t bandwidth;
+    uint32_t seed;
+  };
+
+  // kNone nodes are reachable by all and may be bootstrapped from.  kFullCone nodes are reachable
+  // by all once they have a peer's endpoint.  kSymmetric nodes use a new external port for each
+  // connection and can't connect to one another.
+  enum class NatModel { kNone, kFullCone, kSymmetric };
+
+  struct Statistics {
+    Statistics() : messages_sent(0), messages_delivered(0), messages_failed(0), bytes_sent(0) {}
+    uint64_t messages_sent, messages_delivered, messages_failed, bytes_sent;
+  };
+
+  explicit SimulatedNetwork(const Config& config = Config());
+  ~SimulatedNetwork();
+
+  // Creates the transport for the node with 'connection_id'.  If 'endpoint' is unspecified, one is
+  // allocated.
+  std::unique_ptr<Transport> CreateTransport(const NodeId& connection_id, NatModel nat_model,
+                                             Endpoint endpoint = Endpoint());
+  // The endpoint other nodes may bootstrap from, unspecified if the node is unknown.
+  Endpoint GetEndpoint(const NodeId& connection_id) const;
+
+  Duration Now() const;
+  // Runs the next event, advancing the clock to it.  Returns false if there are no events.
+  bool RunNext();
+  // Runs all events due within 'duration' and leaves the clock 'duration' later.
+  void RunFor(Duration duration);
+  // Runs events until none remain, and returns the number run.
+  size_t RunUntilIdle();
+  // Runs events on a background thread, with the virtual clock following real time.
+  void Start();
+  void Stop();
+  Statistics statistics() const;
+
+  friend class SimulatedTransport;
+
+ private:
+  SimulatedNetwork(const SimulatedNetwork&);
+  SimulatedNetwork& operator=(const SimulatedNetwork&);
+
+  struct Connection {
+    enum class State { kBootstrap, kUnvalidated, kValid };
+    Connection() : state(State::kUnvalidated), added(false) {}
+    State state;
+    bool added;
+  };
+
+  struct Node {
+    Node() : nat_model(NatModel::kNone), local(), external(), message_received(),
+             connection_lost(), connections(), uplink_free_at(0), inbox() {}
+    NatModel nat_model;
+    Endpoint local, external;
+    MessageReceivedFromFunctor message_received;
+    rudp::ConnectionLostFunctor connection_lost;
+    std::map<NodeId, Connection> connections;
+    Duration uplink_free_at;
+    // Messages which arrived before the node bootstrapped, with their senders, and so had no
+    // functor to receive them.
+    std::vector<std::pair<NodeId, std::string>> inbox;
+  };
+
+  // An event calls back into 'owner', so is discarded if that node has been removed.
+  struct Event {
+    Event(Duration time_in, uint64_t sequence_in, const NodeId& owner_in,
+          std::function<void()> action_in)
+        : time(time_in), sequence(sequence_in), owner(owner_in), action(action_in) {}
+    Duration time;
+    uint64_t sequence;
+    NodeId owner;
+    std::function<void()> action;
+  };
+
+  struct EventLater {
+    bool operator()(const Event& lhs, const Event& rhs) const {
+      return lhs.time != rhs.time ? lhs.time > rhs.time : lhs.sequence > rhs.sequence;
+    }
+  };
+
+  // Called by SimulatedTransport.
+  int Bootstrap(const NodeId& this_id,
+                const std::vector<Endpoint>& bootstrap_endpoints,
+                const MessageReceivedFromFunctor& message_received_functor,
+                const rudp::ConnectionLostFunctor& connection_lost_functor,
+                NodeId& chosen_bootstrap_peer,
+                rudp::NatType& nat_type);
+  int GetAvailableEndpoint(const NodeId& this_id,
+                           const NodeId& peer_id,
+                           rudp::EndpointPair& this_endpoint_pair,
+                           rudp::NatType& this_nat_type);
+  int Add(const NodeId& this_id, const NodeId& peer_id, const std::string& validation_data);
+  int MarkConnectionAsValid(const NodeId& this_id,
+                            const NodeId& peer_id,
+                            Endpoint& new_bootstrap_endpoint);
+  void Remove(const NodeId& this_id, const NodeId& peer_id);
+  void Send(const NodeId& this_id,
+            const NodeId& peer_id,
+            const std::string& message,
+            const rudp::MessageSentFunctor& message_sent_functor);
+  void RemoveNode(const NodeId& this_id);
+
+  // The following must be called with mutex_ held.
+  void Schedule(Duration delay, const NodeId& owner, std::function<void()> action);
+  void Transmit(const NodeId& sender_id,
+                const NodeId& peer_id,
+                const std::string& message,
+                const rudp::MessageSentFunctor& message_sent_functor);
+  void NotifyConnectionLost(const NodeId& lost_id, const NodeId& peer_id);
+  Duration Latency();
+  bool Reachable(const Node& from, const Node& to) const;
+  Endpoint ExternalEndpoint(const Node& node);
+
+  // Pops the next event, if due by 'end_time'.  Must be called with callback_mutex_ held.
+  bool PopEvent(Duration end_time, Event& event);
+  // The following run on the event thread, with callback_mutex_ but not mutex_ held.
+  void RunEvent(const Event& event);
+  void Deliver(const NodeId& sender_id,
+               const NodeId& peer_id,
+               const std::string& message,
+               const rudp::MessageSentFunctor& message_sent_functor);
+  void Pump();
+
+  const Config kConfig_;
+  // Held while an event runs, so that removing a node waits for any callback into it to finish.
+  // Recursive, as a callback may itself remove a node.
+  std::recursive_mutex callback_mutex_;
+  mutable std::mutex mutex_;
+  std::condition_variable condition_;
+  Duration now_;
+  uint64_t next_sequence_;
+  std::priority_queue<Event, std::vector<Event>, EventLater> events_;
+  std::map<NodeId, Node> nodes_;
+  std::map<Endpoint, NodeId> endpoints_;
+  uint32_t next_address_;
+  std::mt19937 random_;
+  Statistics statistics_;
+  bool running_;
+  std::thread pump_;
+};
+
+class SimulatedTransport : public Transport {
+ public:
+  SimulatedTransport(SimulatedNetwork& network, const NodeId& connection_id);
+  virtual ~SimulatedTransport();
+  virtual bool ReportsConnections() const;
+  virtual int Bootstrap(const std::vector<boost::asio::ip::udp::endpoint>& bootstrap_endpoints,
+                        const MessageReceivedFromFunctor& message_received_functor,
+                        const rudp::ConnectionLostFunctor& connection_lost_functor,
+                        const NodeId& this_node_id,
+                        std::shared_ptr<asymm::PrivateKey> private_key,
+                        std::shared_ptr<asymm::PublicKey> public_key,
+                        NodeId& chosen_bootstrap_peer,
+                        rudp::NatType& nat_type,
+                        boost::asio::ip::udp::endpoint local_endpoint);
+  virtual int GetAvailableEndpoint(const NodeId& peer_id,
+                                   const rudp::EndpointPair& peer_endpoint_pair,
+                                   rudp::EndpointPair& this_endpoint_pair,
+                                   rudp::NatType& this_nat_type);
+  virtual int Add(const NodeId& peer_id,
+                  const rudp::EndpointPair& peer_endpoint_pair,
+                  const std::string& validation_data);
+  virtual int MarkConnectionAsValid(const NodeId& peer_id,
+                                    boost::asio::ip::udp::endpoint& new_bootstrap_endpoint);
+  virtual void Remove(const NodeId& peer_id);
+  virtual void Send(const NodeId& peer_id,
+                    const std::string& message,
+                    const rudp::MessageSentFunctor& message_sent_functor);
+
+ private:
+  SimulatedTransport(const SimulatedTransport&);
+  SimulatedTransport& operator=(const SimulatedTransport&);
+
+  SimulatedNetwork& network_;
+  const NodeId kConnectionId_;
+};
+
+}  // namespace test
+
+}  // namespace routing
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_ROUTING_TESTS_SIMULATED_NETWORK_H_
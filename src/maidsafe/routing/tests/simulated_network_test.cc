@@ -0,0 +1,214 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "maidsafe/common/node_id.h"
+#include "maidsafe/common/test.h"
+#include "maidsafe/rudp/return_codes.h"
+
+#include "maidsafe/routing/return_codes.h"
+#include "maidsafe/routing/tests/simulated_network.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace test {
+
+namespace {
+
+typedef SimulatedNetwork::Duration Duration;
+
+struct SimulatedPeer {
+  SimulatedPeer(SimulatedNetwork& network, SimulatedNetwork::NatModel nat_model)
+      : id(NodeId::kRandomId),
+        transport(network.CreateTransport(id, nat_model)),
+        received(),
+        receive_times(),
+        lost() {}
+
+  int Bootstrap(SimulatedNetwork& network, const std::vector<NodeId>& peers) {
+    std::vector<boost::asio::ip::udp::endpoint> endpoints;
+    for (const auto& peer : peers)
+      endpoints.push_back(network.GetEndpoint(peer));
+    NodeId chosen_peer;
+    rudp::NatType nat_type;
+    return transport->Bootstrap(endpoints,
+                                [this, &network](const std::string& message, const NodeId&) {
+                                  received.push_back(message);
+                                  receive_times.push_back(network.Now());
+                                },
+                                [this](const NodeId& peer) { lost.push_back(peer); },
+                                id, nullptr, nullptr, chosen_peer, nat_type,
+                                boost::asio::ip::udp::endpoint());
+  }
+
+  NodeId id;
+  std::unique_ptr<Transport> transport;
+  std::vector<std::string> received;
+  std::vector<Duration> receive_times;
+  std::vector<NodeId> lost;
+};
+
+}  // unnamed namespace
+
+TEST(SimulatedNetworkTest, BEH_DeliverWithLatency) {
+  SimulatedNetwork::Config config;
+  config.min_latency = std::chrono::milliseconds(20);
+  config.max_latency = std::chrono::milliseconds(30);
+  SimulatedNetwork network(config);
+  SimulatedPeer peer1(network, SimulatedNetwork::NatModel::kNone),
+                peer2(network, SimulatedNetwork::NatModel::kNone);
+  ASSERT_EQ(kSuccess, peer1.Bootstrap(network, std::vector<NodeId>(1, peer2.id)));
+  ASSERT_EQ(kSuccess, peer2.Bootstrap(network, std::vector<NodeId>(1, peer1.id)));
+
+  int sent_result(kGeneralError);
+  peer1.transport->Send(peer2.id, "message", [&sent_result](int result) {
+                                                 sent_result = result;
+                                               });
+  EXPECT_TRUE(peer2.received.empty());
+  network.RunFor(std::chrono::milliseconds(19));
+  EXPECT_TRUE(peer2.received.empty());
+  EXPECT_EQ(1U, network.RunUntilIdle());
+  ASSERT_EQ(1U, peer2.received.size());
+  EXPECT_EQ("message", peer2.received.front());
+  EXPECT_EQ(kSuccess, sent_result);
+  EXPECT_GE(peer2.receive_times.front(), Duration(std::chrono::milliseconds(20)));
+  EXPECT_LE(peer2.receive_times.front(), Duration(std::chrono::milliseconds(30)));
+
+  // Removing the connection notifies the peer, and later sends fail.
+  peer1.transport->Remove(peer2.id);
+  network.RunUntilIdle();
+  ASSERT_EQ(1U, peer2.lost.size());
+  EXPECT_EQ(peer1.id, peer2.lost.front());
+  peer1.transport->Send(peer2.id, "message", [&sent_result](int result) {
+                                                 sent_result = result;
+                                               });
+  network.RunUntilIdle();
+  EXPECT_NE(kSuccess, sent_result);
+  EXPECT_EQ(1U, peer2.received.size());
+}
+
+TEST(SimulatedNetworkTest, BEH_Deterministic) {
+  SimulatedNetwork::Config config;
+  config.loss_rate = 0.3;
+  config.seed = 7;
+  std::vector<Duration> receive_times[2];
+  for (auto& times : receive_times) {
+    SimulatedNetwork network(config);
+    SimulatedPeer peer1(network, SimulatedNetwork::NatModel::kNone),
+                  peer2(network, SimulatedNetwork::NatModel::kNone);
+    ASSERT_EQ(kSuccess, peer2.Bootstrap(network, std::vector<NodeId>(1, peer1.id)));
+    ASSERT_EQ(kSuccess, peer1.Bootstrap(network, std::vector<NodeId>(1, peer2.id)));
+    for (int i(0); i != 100; ++i)
+      peer2.transport->Send(peer1.id, std::to_string(i), nullptr);
+    network.RunUntilIdle();
+    EXPECT_GT(peer1.received.size(), 50U);
+    times = peer1.receive_times;
+  }
+  EXPECT_EQ(receive_times[0], receive_times[1]);
+}
+
+TEST(SimulatedNetworkTest, BEH_LossAndBandwidth) {
+  SimulatedNetwork::Config config;
+  config.min_latency = config.max_latency = Duration(0);
+  config.bandwidth = 1000;
+  SimulatedNetwork network(config);
+  SimulatedPeer peer1(network, SimulatedNetwork::NatModel::kNone),
+                peer2(network, SimulatedNetwork::NatModel::kNone);
+  ASSERT_EQ(kSuccess, peer1.Bootstrap(network, std::vector<NodeId>(1, peer2.id)));
+  ASSERT_EQ(kSuccess, peer2.Bootstrap(network, std::vector<NodeId>(1, peer1.id)));
+  // The second message waits for the first to leave the uplink.
+  peer1.transport->Send(peer2.id, std::string(500, 'a'), nullptr);
+  peer1.transport->Send(peer2.id, std::string(1000, 'b'), nullptr);
+  network.RunUntilIdle();
+  ASSERT_EQ(2U, peer2.receive_times.size());
+  EXPECT_EQ(Duration(std::chrono::milliseconds(500)), peer2.receive_times.at(0));
+  EXPECT_EQ(Duration(std::chrono::milliseconds(1500)), peer2.receive_times.at(1));
+
+  SimulatedNetwork::Config lossy_config;
+  lossy_config.loss_rate = 1.0;
+  SimulatedNetwork lossy_network(lossy_config);
+  SimulatedPeer peer3(lossy_network, SimulatedNetwork::NatModel::kNone),
+                peer4(lossy_network, SimulatedNetwork::NatModel::kNone);
+  ASSERT_EQ(kSuccess, peer3.Bootstrap(lossy_network, std::vector<NodeId>(1, peer4.id)));
+  int sent_result(kSuccess);
+  peer3.transport->Send(peer4.id, "message", [&sent_result](int result) {
+                                                 sent_result = result;
+                                               });
+  lossy_network.RunUntilIdle();
+  EXPECT_EQ(rudp::kSendFailure, sent_result);
+  EXPECT_TRUE(peer4.received.empty());
+  EXPECT_EQ(lossy_config.retransmit_timeout * lossy_config.max_send_attempts,
+            lossy_network.Now());
+}
+
+TEST(SimulatedNetworkTest, BEH_NatModels) {
+  SimulatedNetwork network;
+  SimulatedPeer open(network, SimulatedNetwork::NatModel::kNone),
+                cone(network, SimulatedNetwork::NatModel::kFullCone),
+                symmetric1(network, SimulatedNetwork::NatModel::kSymmetric),
+                symmetric2(network, SimulatedNetwork::NatModel::kSymmetric);
+  // Only nodes not behind NAT can be bootstrapped from.
+  EXPECT_EQ(kNoOnlineBootstrapContacts,
+            symmetric1.Bootstrap(network, std::vector<NodeId>(1, cone.id)));
+  EXPECT_EQ(kSuccess, symmetric1.Bootstrap(network, std::vector<NodeId>(1, open.id)));
+  EXPECT_EQ(kSuccess, symmetric2.Bootstrap(network, std::vector<NodeId>(1, open.id)));
+  EXPECT_EQ(kSuccess, cone.Bootstrap(network, std::vector<NodeId>(1, open.id)));
+
+  rudp::EndpointPair peer_endpoints, endpoints1, endpoints2;
+  rudp::NatType nat_type;
+  EXPECT_EQ(rudp::kBootstrapConnectionAlreadyExists,
+            symmetric1.transport->GetAvailableEndpoint(open.id, peer_endpoints, endpoints1,
+                                                       nat_type));
+  EXPECT_EQ(kSuccess, symmetric1.transport->GetAvailableEndpoint(symmetric2.id, peer_endpoints,
+                                                                 endpoints1, nat_type));
+  EXPECT_EQ(rudp::NatType::kSymmetric, nat_type);
+  EXPECT_EQ(kSuccess, symmetric1.transport->GetAvailableEndpoint(cone.id, peer_endpoints,
+                                                                 endpoints2, nat_type));
+  EXPECT_EQ(endpoints1.external.address(), endpoints2.external.address());
+
+  // Symmetric NAT nodes can reach cone NAT nodes but not each other.
+  EXPECT_NE(kSuccess, symmetric1.transport->Add(symmetric2.id, peer_endpoints, "validation"));
+  EXPECT_EQ(kSuccess, symmetric1.transport->Add(cone.id, peer_endpoints, "validation"));
+  EXPECT_EQ(rudp::kUnvalidatedConnectionAlreadyExists,
+            symmetric1.transport->Add(cone.id, peer_endpoints, "validation"));
+  network.RunUntilIdle();
+  ASSERT_EQ(1U, cone.received.size());
+  EXPECT_EQ("validation", cone.received.front());
+  boost::asio::ip::udp::endpoint new_bootstrap_endpoint;
+  EXPECT_EQ(kSuccess, cone.transport->MarkConnectionAsValid(symmetric1.id,
+                                                            new_bootstrap_endpoint));
+  EXPECT_TRUE(new_bootstrap_endpoint.address().is_unspecified());
+
+  // Destroying a transport drops its connections.
+  symmetric1.transport.reset();
+  network.RunUntilIdle();
+  EXPECT_EQ(1U, open.lost.size());
+  EXPECT_EQ(1U, cone.lost.size());
+}
+
+}  // namespace test
+
+}  // namespace routing
+
+}  // namespace maidsafe
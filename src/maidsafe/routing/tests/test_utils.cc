@@ -204,6 +204,16 @@ bool CompareListOfNodeInfos(const std::vector<NodeInfo>& lhs, const std::vector<
   return true;
 }
 
+ScopedTuning::ScopedTuning(LiveTuning& live_tuning, const Tuning& tuning)
+    : live_tuning_(live_tuning),
+      previous_(*live_tuning.Get()) {
+  live_tuning_.Set(tuning);
+}
+
+ScopedTuning::~ScopedTuning() {
+  live_tuning_.Set(previous_);
+}
+
 }  // namespace test
 
 }  // namespace routing
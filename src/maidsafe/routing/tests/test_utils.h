@@ -29,6 +29,7 @@
 
 #include "maidsafe/passport/types.h"
 
+#include "maidsafe/routing/live_tuning.h"
 #include "maidsafe/routing/node_info.h"
 #include "maidsafe/routing/routing_table.h"
 
@@ -75,6 +76,20 @@ void SortNodeInfosFromTarget(const NodeId& target, std::vector<NodeInfo>& nodes)
 
 bool CompareListOfNodeInfos(const std::vector<NodeInfo>& lhs, const std::vector<NodeInfo>& rhs);
 
+// Sets 'live_tuning' to 'tuning' for the guard's lifetime, then restores the previous values.
+class ScopedTuning {
+ public:
+  ScopedTuning(LiveTuning& live_tuning, const Tuning& tuning);
+  ~ScopedTuning();
+
+ private:
+  ScopedTuning(const ScopedTuning&);
+  ScopedTuning& operator=(const ScopedTuning&);
+
+  LiveTuning& live_tuning_;
+  const Tuning previous_;
+};
+
 }  // namespace test
 
 }  // namespace routing
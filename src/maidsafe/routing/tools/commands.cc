@@ -19,6 +19,7 @@
 #include "maidsafe/routing/tools/commands.h"
 
 #include <algorithm>
+#include <fstream>
 #include <iostream> // NOLINT
 
 #include "boost/format.hpp"
@@ -34,6 +35,7 @@
 #include "boost/lexical_cast.hpp"
 #include "maidsafe/common/crypto.h"
 #include "maidsafe/common/utils.h"
+#include "maidsafe/routing/tools/load_generator.h"
 #include "maidsafe/routing/tools/shared_response.h"
 
 namespace fs = boost::filesystem;
@@ -213,7 +215,106 @@ void Commands::SendMessages(const int& id_index, const DestinationType& destinat
            <<std::endl;
 }
 
+void Commands::RunLoadTest(const Arguments& args) {
+  if (!demo_node_->joined()) {
+    std::cout << "Error : node must be joined before running a load test" << std::endl;
+    return;
+  }
+  LoadGenerator::Config config;
+  config.data_size = data_size_;
+  if (!LoadGenerator::ParseArguments(args, config)) {
+    std::cout << "Error : Try correct option" << std::endl;
+    LoadGenerator::PrintUsage(std::cout);
+    return;
+  }
+  std::vector<NodeId> destinations;
+  for (const auto& node_id : all_ids_) {
+    if (node_id != demo_node_->node_id())
+      destinations.push_back(node_id);
+  }
+  if (destinations.empty()) {
+    std::cout << "Error : no other vaults to send to" << std::endl;
+    return;
+  }
+
+  LoadGenerator load_generator(demo_node_, destinations, config);
+  std::cout << "Running load test ..." << std::endl;
+  load_generator.Run();
+  load_generator.PrintSummary(std::cout);
+  if (!config.json_path.empty()) {
+    std::ofstream json_file(config.json_path.c_str());
+    json_file << load_generator.ToJson();
+    if (json_file)
+      std::cout << "Results written to " << config.json_path << std::endl;
+    else
+      std::cout << "Error : failed to write " << config.json_path << std::endl;
+  }
+}
 
+void Commands::Tune(const Arguments& args) {
+  std::shared_ptr<Routing> routing(demo_node_->routing());
+  Tuning tuning(routing->GetTuning());
+  if (args.size() == 2) {
+    const std::string& name(args[0]);
+    int64_t value(0);
+    try {
+      value = boost::lexical_cast<int64_t>(args[1]);
+    }
+    catch(const boost::bad_lexical_cast&) {
+      std::cout << "Error : invalid value " << args[1] << std::endl;
+      return;
+    }
+    if (name == "response_timeout_ms") {
+      tuning.response_timeout = std::chrono::milliseconds(value);
+    } else if (name == "find_node_interval_s") {
+      tuning.find_node_interval = std::chrono::seconds(value);
+    } else if (name == "recovery_time_lag_s") {
+      tuning.recovery_time_lag = std::chrono::seconds(value);
+    } else if (name == "re_bootstrap_time_lag_ms") {
+      tuning.re_bootstrap_time_lag = bptime::milliseconds(value);
+    } else if (name == "find_close_node_interval_ms") {
+      tuning.find_close_node_interval = bptime::milliseconds(value);
+    } else if (name == "maximum_find_close_node_failures") {
+      tuning.maximum_find_close_node_failures = static_cast<uint16_t>(value);
+    } else if (name == "negative_cache_size") {
+      tuning.negative_cache_size = static_cast<uint16_t>(value);
+    } else if (name == "negative_cache_ttl_ms") {
+      tuning.negative_cache_ttl = std::chrono::milliseconds(value);
+    } else if (name == "route_cache_size") {
+      tuning.route_cache_size = static_cast<uint16_t>(value);
+    } else if (name == "route_cache_prefix_length") {
+      tuning.route_cache_prefix_length = static_cast<uint16_t>(value);
+    } else {
+      std::cout << "Error : unknown tuning " << name << std::endl;
+      return;
+    }
+    try {
+      routing->SetTuning(tuning);
+    }
+    catch(const std::exception& e) {
+      std::cout << "Error : " << e.what() << std::endl;
+      return;
+    }
+  } else if (!args.empty()) {
+    std::cout << "Error : Try correct option" << std::endl;
+    return;
+  }
+  std::cout << "response_timeout_ms " << std::chrono::duration_cast<std::chrono::milliseconds>(
+                   tuning.response_timeout).count() << "\n"
+            << "find_node_interval_s " << tuning.find_node_interval.count() << "\n"
+            << "recovery_time_lag_s " << tuning.recovery_time_lag.count() << "\n"
+            << "re_bootstrap_time_lag_ms " << tuning.re_bootstrap_time_lag.total_milliseconds()
+            << "\n"
+            << "find_close_node_interval_ms "
+            << tuning.find_close_node_interval.total_milliseconds() << "\n"
+            << "maximum_find_close_node_failures " << tuning.maximum_find_close_node_failures
+            << "\n"
+            << "negative_cache_size " << tuning.negative_cache_size << "\n"
+            << "negative_cache_ttl_ms " << std::chrono::duration_cast<std::chrono::milliseconds>(
+                   tuning.negative_cache_ttl).count() << "\n"
+            << "route_cache_size " << tuning.route_cache_size << "\n"
+            << "route_cache_prefix_length " << tuning.route_cache_prefix_length << std::endl;
+}
 
 uint16_t Commands::MakeMessage(const int& id_index, const DestinationType& destination_type,
                                std::vector<NodeId> &closest_nodes, NodeId &dest_id) {
@@ -343,6 +444,9 @@ void Commands::PrintUsage() {
             << " picked-up destination. -1 for infinite\n";
   std::cout << "\tdatasize <data_size> Set the data_size for the message.\n";
   std::cout << "\tdatarate <data_rate> Set the data_rate for the message.\n";
+  LoadGenerator::PrintUsage(std::cout);
+  std::cout << "\ttune [<name> <value>] Change one of this node's timeouts, retry limits or cache"
+            << " budgets while it runs, then print them all.\n";
   std::cout << "\nattype Print the NatType of this node.\n";
   std::cout << "\texit Exit application.\n";
 }
@@ -435,6 +539,10 @@ void Commands::ProcessCommand(const std::string &cmdline) {
       data_rate_ = atoi(args[0].c_str());
     else
       std::cout<< "Error : Try correct option" <<std::endl;
+  } else if (cmd == "loadtest") {
+    RunLoadTest(args);
+  } else if (cmd == "tune") {
+    Tune(args);
   } else if (cmd == "nattype") {
     std::cout << "NatType for this node is : " << demo_node_->nat_type() << std::endl;
   } else if (cmd == "exit") {
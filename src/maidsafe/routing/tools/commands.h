@@ -66,6 +66,8 @@ class Commands {
   void Validate(const NodeId& node_id, GivePublicKeyFunctor give_public_key);
   void SendMessages(const int& identity_index, const DestinationType& destination_type,
                     bool is_routing_req, int messages_count);
+  void RunLoadTest(const Arguments& args);
+  void Tune(const Arguments& args);
 
   NodeId CalculateClosests(const NodeId& target_id,
                            std::vector<NodeId>& closests,
@@ -0,0 +1,337 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/routing/tools/load_generator.h"
+
+#include <cassert>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+#include "boost/lexical_cast.hpp"
+
+#include "maidsafe/common/utils.h"
+
+#include "maidsafe/routing/parameters.h"
+#include "maidsafe/routing/tests/routing_network.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace test {
+
+namespace {
+
+double Milliseconds(uint64_t microseconds) {
+  return static_cast<double>(microseconds) / 1000.0;
+}
+
+}  // unnamed namespace
+
+LoadGenerator::Config::Config()
+    : arrivals(Arrivals::kConstant),
+      rate(10.0),
+      duration(std::chrono::seconds(10)),
+      count(0),
+      window(64),
+      group_fraction(0.0),
+      cacheable_fraction(0.0),
+      cacheable_keys(16),
+      data_size(1024),
+      seed(RandomUint32()),
+      json_path() {}
+
+bool LoadGenerator::ParseArguments(const std::vector<std::string>& arguments, Config& config) {
+  for (const auto& argument : arguments) {
+    size_t separator(argument.find('='));
+    if (separator == std::string::npos)
+      return false;
+    std::string key(argument.substr(0, separator)), value(argument.substr(separator + 1));
+    try {
+      if (key == "arrivals") {
+        if (value == "constant")
+          config.arrivals = Arrivals::kConstant;
+        else if (value == "poisson")
+          config.arrivals = Arrivals::kPoisson;
+        else
+          return false;
+      } else if (key == "rate") {
+        config.rate = boost::lexical_cast<double>(value);
+      } else if (key == "duration") {
+        config.duration = std::chrono::milliseconds(
+            static_cast<int64_t>(boost::lexical_cast<double>(value) * 1000));
+      } else if (key == "count") {
+        config.count = boost::lexical_cast<uint32_t>(value);
+      } else if (key == "window") {
+        config.window = boost::lexical_cast<uint32_t>(value);
+      } else if (key == "group") {
+        config.group_fraction = boost::lexical_cast<double>(value);
+      } else if (key == "cacheable") {
+        config.cacheable_fraction = boost::lexical_cast<double>(value);
+      } else if (key == "keys") {
+        config.cacheable_keys = boost::lexical_cast<uint32_t>(value);
+      } else if (key == "size") {
+        config.data_size = boost::lexical_cast<size_t>(value);
+      } else if (key == "seed") {
+        config.seed = boost::lexical_cast<uint32_t>(value);
+      } else if (key == "json") {
+        config.json_path = value;
+      } else {
+        return false;
+      }
+    }
+    catch(const boost::bad_lexical_cast&) {
+      return false;
+    }
+  }
+  return config.rate > 0.0 && config.window != 0 && config.cacheable_keys != 0 &&
+         config.group_fraction >= 0.0 && config.group_fraction <= 1.0 &&
+         config.cacheable_fraction >= 0.0 && config.cacheable_fraction <= 1.0;
+}
+
+void LoadGenerator::PrintUsage(std::ostream& stream) {
+  stream << "\tloadtest [key=value ...] Send an open-loop load and report latency percentiles.\n"
+         << "\t\tarrivals=constant|poisson (default constant), rate=<requests/s> (10),\n"
+         << "\t\tduration=<s> (10) or count=<requests>, window=<max in flight> (64),\n"
+         << "\t\tgroup=<fraction sent to groups> (0), cacheable=<fraction cacheable> (0),\n"
+         << "\t\tkeys=<distinct cacheable requests> (16), size=<bytes> (datasize),\n"
+         << "\t\tseed=<n>, json=<path to write results>\n";
+}
+
+LoadGenerator::LoadGenerator(std::shared_ptr<GenericNode> node,
+                             const std::vector<NodeId>& destinations,
+                             const Config& config)
+    : node_(node),
+      destinations_(destinations),
+      kConfig_(config),
+      payload_(RandomAlphaNumericString(config.data_size)),
+      random_(config.seed),
+      mutex_(),
+      condition_(),
+      in_flight_(0),
+      window_waits_(0),
+      elapsed_(0),
+      statistics_(),
+      all_latency_us_() {
+  assert(!destinations_.empty());
+}
+
+void LoadGenerator::Run() {
+  auto start(std::chrono::steady_clock::now());
+  auto end(start + kConfig_.duration);
+  auto scheduled(start);
+  for (uint32_t index(0); kConfig_.count != 0 ? index < kConfig_.count : scheduled < end;
+       ++index) {
+    std::this_thread::sleep_until(scheduled);
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (in_flight_ >= kConfig_.window) {
+        ++window_waits_;
+        condition_.wait(lock, [this] { return in_flight_ < kConfig_.window; });
+      }
+      ++in_flight_;
+    }
+    Send(index, scheduled);
+    scheduled += NextInterval();
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  condition_.wait(lock, [this] { return in_flight_ == 0; });
+  elapsed_ = std::chrono::steady_clock::now() - start;
+}
+
+std::chrono::steady_clock::duration LoadGenerator::NextInterval() {
+  std::chrono::duration<double> interval(1.0 / kConfig_.rate);
+  if (kConfig_.arrivals == Arrivals::kPoisson) {
+    std::exponential_distribution<double> exponential(kConfig_.rate);
+    interval = std::chrono::duration<double>(exponential(random_));
+  }
+  return std::chrono::duration_cast<std::chrono::steady_clock::duration>(interval);
+}
+
+void LoadGenerator::Send(uint32_t index, std::chrono::steady_clock::time_point scheduled) {
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  bool group(uniform(random_) < kConfig_.group_fraction);
+  bool cacheable(uniform(random_) < kConfig_.cacheable_fraction);
+  NodeId destination;
+  std::string data;
+  if (cacheable) {
+    // Repeating the same request to the same destination gives the caches something to hit.
+    uint32_t key(random_() % kConfig_.cacheable_keys);
+    destination = destinations_.at(key % destinations_.size());
+    data = "cacheable:" + std::to_string(key) + ":" + payload_;
+  } else {
+    destination = group ? NodeId(NodeId::kRandomId) :
+                          destinations_.at(random_() % destinations_.size());
+    data = ">:<" + std::to_string(index) + "<:>" + payload_;
+  }
+
+  TrafficClass traffic_class(group ? (cacheable ? kGroupCacheable : kGroup) :
+                                     (cacheable ? kDirectCacheable : kDirect));
+  std::shared_ptr<Request> request(
+      new Request(traffic_class, scheduled, group ? Parameters::node_group_size : 1));
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++statistics_[traffic_class].sent;
+  }
+  ResponseFunctor response_functor([this, request](std::string response) {
+                                     OnResponse(request, response);
+                                   });
+  if (group)
+    node_->SendGroup(destination, data, cacheable, response_functor);
+  else
+    node_->SendDirect(destination, data, cacheable, response_functor);
+}
+
+void LoadGenerator::OnResponse(const std::shared_ptr<Request>& request,
+                               const std::string& response) {
+  auto now(std::chrono::steady_clock::now());
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Routing invokes the functor once per expected response, with an empty one for each missing
+  // at timeout, so the request is complete when all have been seen.
+  if (response.empty())
+    request->failed = true;
+  if (--request->outstanding != 0)
+    return;
+  ClassStatistics& statistics(statistics_[request->traffic_class]);
+  if (request->failed) {
+    ++statistics.failed;
+  } else {
+    ++statistics.succeeded;
+    uint64_t latency(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(now - request->scheduled).count()));
+    statistics.latency_us.Record(latency);
+    all_latency_us_.Record(latency);
+  }
+  --in_flight_;
+  condition_.notify_all();
+}
+
+const char* LoadGenerator::TrafficClassName(int traffic_class) {
+  switch (traffic_class) {
+    case kDirect:
+      return "direct";
+    case kDirectCacheable:
+      return "direct_cacheable";
+    case kGroup:
+      return "group";
+    case kGroupCacheable:
+      return "group_cacheable";
+    default:
+      return "all";
+  }
+}
+
+void LoadGenerator::PrintSummary(std::ostream& stream) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::ios_base::fmtflags flags(stream.flags());
+  std::streamsize precision(stream.precision());
+  double seconds(std::chrono::duration<double>(elapsed_).count());
+  uint64_t total_sent(0), total_succeeded(0), total_failed(0);
+  stream << std::left << std::setw(18) << "class" << std::right << std::setw(9) << "sent"
+         << std::setw(11) << "succeeded" << std::setw(9) << "failed" << std::setw(11) << "p50 ms"
+         << std::setw(11) << "p99 ms" << std::setw(11) << "p99.9 ms" << std::setw(11) << "max ms"
+         << '\n' << std::fixed << std::setprecision(3);
+  for (int i(0); i <= kTrafficClassCount; ++i) {
+    uint64_t sent(total_sent), succeeded(total_succeeded), failed(total_failed);
+    HistogramSnapshot latency;
+    if (i == kTrafficClassCount) {
+      latency = all_latency_us_.Snapshot();
+    } else {
+      sent = statistics_[i].sent;
+      if (sent == 0)
+        continue;
+      succeeded = statistics_[i].succeeded;
+      failed = statistics_[i].failed;
+      latency = statistics_[i].latency_us.Snapshot();
+      total_sent += sent;
+      total_succeeded += succeeded;
+      total_failed += failed;
+    }
+    stream << std::left << std::setw(18) << TrafficClassName(i) << std::right << std::setw(9)
+           << sent << std::setw(11) << succeeded << std::setw(9) << failed << std::setw(11)
+           << Milliseconds(latency.Percentile(0.5)) << std::setw(11)
+           << Milliseconds(latency.Percentile(0.99)) << std::setw(11)
+           << Milliseconds(latency.Percentile(0.999)) << std::setw(11)
+           << Milliseconds(latency.max) << '\n';
+  }
+  stream << "Elapsed " << seconds << " s, throughput "
+         << (seconds > 0.0 ? static_cast<double>(total_succeeded) / seconds : 0.0)
+         << " requests/s, " << window_waits_ << " sends delayed by a full window" << std::endl;
+  stream.flags(flags);
+  stream.precision(precision);
+}
+
+std::string LoadGenerator::ToJson() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::ostringstream stream;
+  double seconds(std::chrono::duration<double>(elapsed_).count());
+  stream << "{\n  \"config\": {\"arrivals\": \""
+         << (kConfig_.arrivals == Arrivals::kPoisson ? "poisson" : "constant")
+         << "\", \"rate\": " << kConfig_.rate << ", \"duration_ms\": "
+         << kConfig_.duration.count() << ", \"count\": " << kConfig_.count << ", \"window\": "
+         << kConfig_.window << ", \"group_fraction\": " << kConfig_.group_fraction
+         << ", \"cacheable_fraction\": " << kConfig_.cacheable_fraction
+         << ", \"cacheable_keys\": " << kConfig_.cacheable_keys << ", \"data_size\": "
+         << kConfig_.data_size << ", \"seed\": " << kConfig_.seed << "},\n";
+  uint64_t total_sent(0), total_succeeded(0), total_failed(0);
+  stream << "  \"classes\": {";
+  bool first(true);
+  for (int i(0); i != kTrafficClassCount; ++i) {
+    const ClassStatistics& statistics(statistics_[i]);
+    total_sent += statistics.sent;
+    total_succeeded += statistics.succeeded;
+    total_failed += statistics.failed;
+    if (statistics.sent == 0)
+      continue;
+    stream << (first ? "\n" : ",\n") << "    \"" << TrafficClassName(i) << "\": ";
+    WriteStatistics(stream, statistics.sent, statistics.succeeded, statistics.failed,
+                    statistics.latency_us);
+    first = false;
+  }
+  stream << "\n  },\n  \"all\": ";
+  WriteStatistics(stream, total_sent, total_succeeded, total_failed, all_latency_us_);
+  stream << ",\n  \"elapsed_ms\": " << static_cast<uint64_t>(seconds * 1000)
+         << ",\n  \"throughput\": "
+         << (seconds > 0.0 ? static_cast<double>(total_succeeded) / seconds : 0.0)
+         << ",\n  \"window_waits\": " << window_waits_ << "\n}\n";
+  return stream.str();
+}
+
+void LoadGenerator::WriteStatistics(std::ostream& stream, uint64_t sent, uint64_t succeeded,
+                                    uint64_t failed, const Histogram& latency_us) const {
+  HistogramSnapshot latency(latency_us.Snapshot());
+  stream << "{\"sent\": " << sent << ", \"succeeded\": " << succeeded << ", \"failed\": "
+         << failed << ", \"latency_us\": {\"count\": " << latency.count << ", \"mean\": "
+         << (latency.count == 0 ? 0 : latency.sum / latency.count) << ", \"p50\": "
+         << latency.Percentile(0.5) << ", \"p90\": " << latency.Percentile(0.9) << ", \"p99\": "
+         << latency.Percentile(0.99) << ", \"p999\": " << latency.Percentile(0.999)
+         << ", \"max\": " << latency.max << ", \"buckets\": [";
+  for (size_t i(0); i != latency.buckets.size(); ++i) {
+    stream << (i == 0 ? "" : ", ") << '[' << latency.buckets[i].first << ", "
+           << latency.buckets[i].second << ']';
+  }
+  stream << "]}}";
+}
+
+}  // namespace test
+
+}  // namespace routing
+
+}  // namespace maidsafe
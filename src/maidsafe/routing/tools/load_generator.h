@@ -0,0 +1,137 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#ifndef MAIDSAFE_ROUTING_TOOLS_LOAD_GENERATOR_H_
+#define MAIDSAFE_ROUTING_TOOLS_LOAD_GENERATOR_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "maidsafe/common/node_id.h"
+
+#include "maidsafe/routing/metrics.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+namespace test {
+
+class GenericNode;
+
+// Open-loop load generator for the routing_node tool.  Requests are issued on a fixed schedule
+// (constant-rate or Poisson arrivals) regardless of how quickly responses return, with at most
+// 'window' requests in flight.  A request's latency runs from its scheduled send time to its final
+// response, so time spent waiting for a window slot is counted rather than hidden.
+class LoadGenerator {
+ public:
+  enum class Arrivals { kConstant, kPoisson };
+
+  struct Config {
+    Config();
+    Arrivals arrivals;
+    double rate;  // requests per second
+    // The run ends after 'count' requests if non-zero, otherwise after 'duration'.
+    std::chrono::milliseconds duration;
+    uint32_t count;
+    uint32_t window;
+    // Fraction of requests sent to a group rather than a single node, and fraction sent as
+    // cacheable.  Cacheable requests repeat one of 'cacheable_keys' destination/payload pairs.
+    double group_fraction, cacheable_fraction;
+    uint32_t cacheable_keys;
+    size_t data_size;
+    uint32_t seed;
+    // If not empty, the results are written here as JSON.
+    std::string json_path;
+  };
+
+  // Updates 'config' from "key=value" arguments.  Returns false if any is unrecognised or invalid.
+  static bool ParseArguments(const std::vector<std::string>& arguments, Config& config);
+  static void PrintUsage(std::ostream& stream);
+
+  // 'destinations' are the node IDs direct requests may be sent to.
+  LoadGenerator(std::shared_ptr<GenericNode> node,
+                const std::vector<NodeId>& destinations,
+                const Config& config);
+  // Issues all requests, then blocks until each has had all its responses or timed out.
+  void Run();
+  void PrintSummary(std::ostream& stream) const;
+  std::string ToJson() const;
+
+ private:
+  // Requests are classified by destination type and whether they were cacheable.
+  enum TrafficClass { kDirect, kDirectCacheable, kGroup, kGroupCacheable, kTrafficClassCount };
+
+  struct ClassStatistics {
+    ClassStatistics() : sent(0), succeeded(0), failed(0), latency_us() {}
+    uint64_t sent, succeeded, failed;
+    Histogram latency_us;
+  };
+
+  struct Request {
+    Request(TrafficClass traffic_class_in, std::chrono::steady_clock::time_point scheduled_in,
+            int outstanding_in)
+        : traffic_class(traffic_class_in),
+          scheduled(scheduled_in),
+          outstanding(outstanding_in),
+          failed(false) {}
+    TrafficClass traffic_class;
+    std::chrono::steady_clock::time_point scheduled;
+    int outstanding;
+    bool failed;
+  };
+
+  LoadGenerator(const LoadGenerator&);
+  LoadGenerator& operator=(const LoadGenerator&);
+
+  static const char* TrafficClassName(int traffic_class);
+  std::chrono::steady_clock::duration NextInterval();
+  void Send(uint32_t index, std::chrono::steady_clock::time_point scheduled);
+  void OnResponse(const std::shared_ptr<Request>& request, const std::string& response);
+  void WriteStatistics(std::ostream& stream, uint64_t sent, uint64_t succeeded, uint64_t failed,
+                       const Histogram& latency_us) const;
+
+  std::shared_ptr<GenericNode> node_;
+  std::vector<NodeId> destinations_;
+  const Config kConfig_;
+  std::string payload_;
+  std::mt19937 random_;
+  mutable std::mutex mutex_;
+  std::condition_variable condition_;
+  uint32_t in_flight_;
+  uint64_t window_waits_;
+  std::chrono::steady_clock::duration elapsed_;
+  ClassStatistics statistics_[kTrafficClassCount];
+  Histogram all_latency_us_;
+};
+
+}  // namespace test
+
+}  // namespace routing
+
+}  // namespace maidsafe
+
+#endif  // MAIDSAFE_ROUTING_TOOLS_LOAD_GENERATOR_H_
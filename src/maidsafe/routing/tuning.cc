@@ -0,0 +1,42 @@
+/*  Copyright 2012 MaidSafe.net limited
+
+    This MaidSafe Software is licensed to you under (1) the MaidSafe.net Commercial License,
+    version 1.0 or later, or (2) The General Public License (GPL), version 3, depending on which
+    licence you accepted on initial access to the Software (the "Licences").
+
+    By contributing code to the MaidSafe Software, or to this project generally, you agree to be
+    bound by the terms of the MaidSafe Contributor Agreement, version 1.0, found in the root
+    directory of this project at LICENSE, COPYING and CONTRIBUTOR respectively and also
+    available at: http://www.novinet.com/license
+
+    Unless required by applicable law or agreed to in writing, the MaidSafe Software distributed
+    under the GPL Licence is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS
+    OF ANY KIND, either express or implied.
+
+    See the Licences for the specific language governing permissions and limitations relating to
+    use of the MaidSafe Software.                                                                 */
+
+#include "maidsafe/routing/tuning.h"
+
+#include "maidsafe/routing/parameters.h"
+
+
+namespace maidsafe {
+
+namespace routing {
+
+Tuning::Tuning()
+    : response_timeout(Parameters::default_response_timeout),
+      find_node_interval(Parameters::find_node_interval),
+      recovery_time_lag(Parameters::recovery_time_lag),
+      re_bootstrap_time_lag(Parameters::re_bootstrap_time_lag),
+      find_close_node_interval(Parameters::find_close_node_interval),
+      maximum_find_close_node_failures(Parameters::maximum_find_close_node_failures),
+      negative_cache_size(Parameters::negative_cache_size),
+      negative_cache_ttl(Parameters::negative_cache_ttl),
+      route_cache_size(Parameters::route_cache_size),
+      route_cache_prefix_length(Parameters::route_cache_prefix_length) {}
+
+}  // namespace routing
+
+}  // namespace maidsafe
@@ -18,6 +18,8 @@
 
 #include <string>
 #include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <vector>
 
 #include "maidsafe/routing/utils.h"
@@ -39,6 +41,21 @@ namespace maidsafe {
 
 namespace routing {
 
+namespace {
+
+const size_t kTraceIdPrefixSize(4);
+
+int64_t MicrosecondsSinceEpoch(const std::chrono::system_clock::time_point& time_point) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             time_point.time_since_epoch()).count();
+}
+
+std::string TraceIdPrefix(const NodeId& node_id) {
+  return node_id.string().substr(0, kTraceIdPrefixSize);
+}
+
+}  // unnamed namespace
+
 int AddToRudp(NetworkUtils& network,
               const NodeId& this_node_id,
               const NodeId& this_connection_id,
@@ -268,6 +285,25 @@ bool ValidateMessage(const protobuf::Message &message) {
   return true;
 }
 
+void SignAndSendDirect(NetworkUtils& network,
+                       const protobuf::Message& message,
+                       const asymm::PrivateKey& private_key,
+                       const NodeId& peer_node_id,
+                       const NodeId& peer_connection_id) {
+  assert(message.data_size() != 0 && !message.data(0).empty());
+  network.signature_verifier().Sign(
+      private_key, message.data(0),
+      [&network, message, peer_node_id, peer_connection_id] (const std::string& signature) {
+        if (signature.empty()) {
+          LOG(kError) << "Not sending unsigned " << MessageTypeString(message);
+          return;
+        }
+        protobuf::Message signed_message(message);
+        signed_message.set_signature(signature);
+        network.SendToDirect(signed_message, peer_node_id, peer_connection_id);
+      });
+}
+
 void SetProtobufEndpoint(const boost::asio::ip::udp::endpoint& endpoint,
                          protobuf::Endpoint* pb_endpoint) {
   if (pb_endpoint) {
@@ -406,6 +442,57 @@ std::string SerializeNodeIdList(const std::vector<NodeId> &node_list) {
   return node_list_msg.SerializeAsString();
 }
 
+void AddTraceHop(protobuf::Message& message, const NodeId& this_node_id,
+                 std::chrono::steady_clock::time_point received) {
+  if (!message.trace() ||
+      message.trace_hops_size() >= static_cast<int>(Parameters::max_trace_hops))
+    return;
+  auto queue_wait(std::chrono::duration_cast<std::chrono::microseconds>(
+                      std::chrono::steady_clock::now() - received).count());
+  protobuf::TraceHop* hop(message.add_trace_hops());
+  hop->set_node_id_prefix(TraceIdPrefix(this_node_id));
+  hop->set_received(MicrosecondsSinceEpoch(std::chrono::system_clock::now()) - queue_wait);
+  hop->set_queue_wait(queue_wait);
+}
+
+void SetTraceNextHop(protobuf::Message& message, const NodeId& this_node_id,
+                     const NodeId& next_hop) {
+  if (!message.trace())
+    return;
+  int64_t now(MicrosecondsSinceEpoch(std::chrono::system_clock::now()));
+  protobuf::TraceHop* hop(nullptr);
+  if (message.trace_hops_size() != 0) {
+    hop = message.mutable_trace_hops(message.trace_hops_size() - 1);
+    if (hop->node_id_prefix() != TraceIdPrefix(this_node_id) || hop->has_next_hop_prefix())
+      hop = nullptr;
+  }
+  if (!hop) {
+    if (message.trace_hops_size() >= static_cast<int>(Parameters::max_trace_hops))
+      return;
+    hop = message.add_trace_hops();
+    hop->set_node_id_prefix(TraceIdPrefix(this_node_id));
+    hop->set_received(now);
+    hop->set_queue_wait(0);
+  }
+  hop->set_processing(std::max(int64_t(0), now - hop->received() - hop->queue_wait()));
+  hop->set_next_hop_prefix(TraceIdPrefix(next_hop));
+}
+
+std::vector<TraceHop> GetTraceHops(const protobuf::Message& message) {
+  std::vector<TraceHop> hops;
+  for (const auto& pb_hop : message.trace_hops()) {
+    TraceHop hop;
+    hop.node_id_prefix = pb_hop.node_id_prefix();
+    hop.received = std::chrono::system_clock::time_point(
+                       std::chrono::microseconds(pb_hop.received()));
+    hop.queue_wait = std::chrono::microseconds(pb_hop.queue_wait());
+    hop.processing = std::chrono::microseconds(pb_hop.processing());
+    hop.next_hop_prefix = pb_hop.next_hop_prefix();
+    hops.push_back(hop);
+  }
+  return hops;
+}
+
 }  // namespace routing
 
 }  // namespace maidsafe
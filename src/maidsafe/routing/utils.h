@@ -20,6 +20,7 @@
 #define MAIDSAFE_ROUTING_UTILS_H_
 
 
+#include <chrono>
 #include <string>
 #include <vector>
 
@@ -88,6 +89,14 @@ bool IsCacheableGet(const protobuf::Message& message);
 bool IsCacheablePut(const protobuf::Message& message);
 bool CheckId(const std::string& id_to_test);
 bool ValidateMessage(const protobuf::Message &message);
+// Signs the message's first data element, for the receiver to check once it has this node's key,
+// then sends the message direct to the peer.  The RSA signing is done on the network's signature
+// workers rather than the calling thread.  The message is dropped if it can't be signed.
+void SignAndSendDirect(NetworkUtils& network,
+                       const protobuf::Message& message,
+                       const asymm::PrivateKey& private_key,
+                       const NodeId& peer_node_id,
+                       const NodeId& peer_connection_id);
 void SetProtobufEndpoint(const boost::asio::ip::udp::endpoint& endpoint,
                          protobuf::Endpoint* pb_endpoint);
 boost::asio::ip::udp::endpoint GetEndpointFromProtobuf(const protobuf::Endpoint& pb_endpoint);
@@ -99,6 +108,14 @@ rudp::NatType NatTypeFromProtobuf(const protobuf::NatType& nat_type_proto);
 std::string PrintMessage(const protobuf::Message& message);
 std::vector<NodeId> DeserializeNodeIdList(const std::string &node_list_str);
 std::string SerializeNodeIdList(const std::vector<NodeId> &node_list);
+// Adds this node's hop to a traced message which was received at 'received'.
+void AddTraceHop(protobuf::Message& message, const NodeId& this_node_id,
+                 std::chrono::steady_clock::time_point received);
+// Completes this node's last hop of a traced message which is being sent on to 'next_hop', adding
+// the hop first if this node originated the message.
+void SetTraceNextHop(protobuf::Message& message, const NodeId& this_node_id,
+                     const NodeId& next_hop);
+std::vector<TraceHop> GetTraceHops(const protobuf::Message& message);
 }  // namespace routing
 
 }  // namespace maidsafe